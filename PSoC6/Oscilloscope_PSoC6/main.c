@@ -1,11 +1,21 @@
 /**********************************************************************************
 * File Name:   main.c
 *
-* Description: Code for Basic Oscilloscope implementation; ADC and DMA HAL drivers
-*              are configured to sample input voltage and the sampled input
-*              voltage is displayed on the UART. Better Serial Plotter is used
-*              to control time/amplitude divisions, analysis and visualization
-*              of the waveforms.
+* Description: Code for Basic Oscilloscope implementation; the ADC samples the
+*              input voltage continuously and DMA collects the samples into
+*              frames (scope_capture.c). Completed frames go through the trigger
+*              (scope_trigger.c) and every triggered window of the input
+*              voltage is displayed on the UART. The output can be switched
+*              to every sample, or averaged spectra (scope_spectrum.c), sent to
+*              the PC as binary packets (scope_link.c, decoded by
+*              tools/scope/stream_decode), or the measurements of every frame
+*              (scope_measure.c) as text, or the trigger windows as binary
+*              packets. Trigger windows can be averaged over several triggers
+*              (scope_average.c). Commands received on the same UART
+*              (scope_command.h) change the capture, the acquisition, the
+*              trigger and the output at runtime. Better
+*              Serial Plotter is used to control time/amplitude divisions,
+*              analysis and visualization of the waveforms.
 *
 * Related Document:
 * https://infineon.github.io/psoc6pdl/pdl_api_reference_manual/html/index.html
@@ -20,157 +30,579 @@
 #include "cyhal.h"
 #include "cybsp.h"
 #include "cy_retarget_io.h"
+#include "scope_capture.h"
+#include "scope_trigger.h"
+#include "scope_decimate.h"
+#include "scope_spectrum.h"
+#include "scope_measure.h"
+#include "scope_average.h"
+#include "scope_link.h"
+#include "scope_command.h"
+
+/* With SCOPE_DUAL_CORE this is the CM4 application; the CM0+ runs the capture
+ * (main_cm0p.c) */
+#if !defined(SCOPE_DUAL_CORE) || (CY_CPU_CORTEX_M4)
+
+/* Output at reset; "output" commands change it */
+#define SCOPE_OUTPUT                     (SCOPE_OUTPUT_STREAM)
+
+/* Samples per stream packet, of all channels */
+#define STREAM_PACKET_SAMPLES            (512u)
+
+/* Spectrum mode: 2048 points give 1024 bins of 244 Hz at 500 kS/s; about
+ * 30 spectra/s reach the PC */
+#define SPECTRUM_POINTS                  (2048u)
+#define SPECTRUM_AVERAGES                (8u)
+
+/* Measure mode: every frame is measured, every 50th record (about 10/s)
+ * is printed; a line fits the UART FIFO, so printing does not hold up the
+ * frames. Crossings with 64 codes of hysteresis at an automatic level. */
+#define MEASURE_REPORT_FRAMES            (50u)
+#define MEASURE_LEVEL_CODE               (0u)
+#define MEASURE_HYSTERESIS_CODES         (64u)
+
+/* Trigger setup: rising edge through mid-scale, a quarter of the window
+ * before the trigger point */
+#define TRIGGER_LEVEL_CODE               (2048u)
+#define TRIGGER_HYSTERESIS_CODES         (64u)
+#define TRIGGER_PRE_SAMPLES              (256u)
+#define TRIGGER_POST_SAMPLES             (768u)
+#define TRIGGER_AUTO_MS                  (100u)
+
+/* Window averaging at reset */
+#define AVERAGE_MODE                     (SCOPE_AVERAGE_OFF)
+#define AVERAGE_FRAMES                   (1u)
+
+/* Result of settings the acquisition or the trigger do not accept */
+#define SETTINGS_RSLT_INVALID            (CY_RSLT_CREATE(CY_RSLT_TYPE_ERROR, CY_RSLT_MODULE_MIDDLEWARE_BASE, 0x5Du))
+
+/* Runtime settings; every output keeps its state, so they can be switched */
+static scope_settings_t settings;
+static scope_command_t command;
+
+static scope_decimate_t decimate[SCOPE_CAPTURE_CHANNELS_MAX];
+static uint16_t decimated[SCOPE_CAPTURE_CHANNELS_MAX][SCOPE_DECIMATE_OUT_MAX(SCOPE_FRAME_SAMPLES, 1u)];
+static scope_trigger_t trigger;
+static uint32_t capture_lost;          /* capture frames lost so far */
+static uint16_t stream_samples[STREAM_PACKET_SAMPLES];   /* a block of stream_block per channel */
+static uint32_t stream_channels;
+static uint32_t stream_block;          /* samples per channel and packet */
+static uint32_t stream_fill;           /* samples in each block */
+static uint32_t stream_position;       /* stream samples produced, including lost ones */
+static scope_spectrum_t spectrum;
+static uint16_t spectrum_bins[SPECTRUM_POINTS / 2u];
+static uint32_t spectrum_count;
+static scope_measure_t measure;
+static scope_average_t average;
+static uint16_t window_samples[SCOPE_TRIGGER_HISTORY];
 
 
-/*  ADC Macros */
-#define VPLUS_CHANNEL_0  (P10_0)
-#define MICRO_TO_MILLI_CONV_RATIO        (1000u)
-#define ACQUISITION_TIME_NS              (100u)
-#define ADC_SCAN_DELAY_MS                (1u)
+/*****************************************************************************/
 
-/*  DMA Macros */
-#define DMA_HW    DMAC
-#define DMA_CHANNEL             (0u)
-#define DST_BUFFER_SIZE 2000
-#define BUFFER_SIZE     2000
-#define WS_NUM_DESCRIPTORS (2)
+/* The binary outputs own the UART at SCOPE_LINK_BAUD */
+static bool output_is_binary(uint8_t output)
+{
+    return (output == SCOPE_OUTPUT_STREAM) || (output == SCOPE_OUTPUT_SPECTRUM) ||
+           (output == SCOPE_OUTPUT_WINDOW);
+}
 
-/*****************************************************************************/
 
-cyhal_adc_t adc_obj;
-cyhal_adc_channel_t adc_chan_0_obj;
-
-uint16_t dstBuffer[DST_BUFFER_SIZE];
-uint16_t adcBuffer[BUFFER_SIZE];
-volatile uint32_t adcBufferIndex = 0;
-static cy_stc_dmac_descriptor_t WSDescriptors[WS_NUM_DESCRIPTORS];
-
-static void ws_dmac_init(void)
-{
-	cy_rslt_t result;
-
-    const cy_stc_dmac_descriptor_config_t WS_DMA_Descriptors_config =
-    {
-		.retrigger       = CY_DMAC_RETRIG_IM,
-		.interruptType   = CY_DMAC_DESCR_CHAIN,
-		.triggerOutType  = CY_DMAC_1ELEMENT,
-		.channelState    = CY_DMAC_CHANNEL_ENABLED,
-		.triggerInType   = CY_DMAC_1ELEMENT,
-		.dataSize        = CY_DMAC_BYTE,
-		.srcTransferSize = CY_DMAC_TRANSFER_SIZE_DATA,
-		.dstTransferSize = CY_DMAC_TRANSFER_SIZE_DATA,
-		.descriptorType  = CY_DMAC_1D_TRANSFER,
-		.srcAddress      = NULL,
-		.dstAddress      = NULL,
-		.srcXincrement   = 1L,
-		.dstXincrement   = 0L,
-		.xCount          = BUFFER_SIZE,
-		.srcYincrement   = 0L,
-		.dstYincrement   = 0L,
-		.yCount          = 1UL,
-		.nextDescriptor  = 0
-    };
+/*******************************************************************************
+ * Function Name: window_display
+ *******************************************************************************
+ *
+ * Summary:
+ *  Send a trigger window, in millivolts, to the serial plotter.
+ *
+ *******************************************************************************/
+static void window_display(const uint16_t *samples, const scope_trigger_window_t *window)
+{
+    for (uint32_t i = 0u; i < window->count; i++) {
+        printf("Data: %u\r\n", (unsigned int)scope_capture_code_to_mv(samples[i]));
+    }
+}
+
 
-    for(unsigned int i=0;i<WS_NUM_DESCRIPTORS;i++)
-    {
-        Cy_DMAC_Descriptor_Init(&WSDescriptors[i], &WS_DMA_Descriptors_config);
-        Cy_DMAC_Descriptor_SetSrcAddress(&WSDescriptors[i], (void *)adcBuffer);
-        Cy_DMAC_Descriptor_SetDstAddress(&WSDescriptors[i], (void *)&dstBuffer[i * DST_BUFFER_SIZE]);
-        Cy_DMAC_Descriptor_SetXloopDataCount(&WSDescriptors[i],BUFFER_SIZE); // the last
-        if (i < (WS_NUM_DESCRIPTORS  - 1)) {
-        Cy_DMAC_Descriptor_SetNextDescriptor(&WSDescriptors[i],&WSDescriptors[i+1]);}
+/*******************************************************************************
+ * Function Name: window_send
+ *******************************************************************************
+ *
+ * Summary:
+ *  Send a trigger window as packets of up to SCOPE_LINK_MAX_SAMPLES. The
+ *  positions are those of the trigger's samples; the packet holding the
+ *  trigger point carries its index.
+ *
+ *******************************************************************************/
+static void window_send(const uint16_t *samples, const scope_trigger_window_t *window)
+{
+    const uint32_t start = window->position - window->trigger_index;
+
+    for (uint32_t done = 0u; done < window->count; done += SCOPE_LINK_MAX_SAMPLES) {
+        uint32_t n = window->count - done;
+        scope_stream_header_t header = {
+            .flags          = (uint8_t)((uint32_t)settings.acquire_mode |
+                                        (window->forced ? SCOPE_STREAM_FLAG_FORCED : SCOPE_STREAM_FLAG_TRIGGERED)),
+            .sample_rate_hz = scope_capture_sample_rate(),
+            .factor         = (uint16_t)settings.acquire_factor,
+            .trigger_index  = SCOPE_STREAM_NO_TRIGGER,
+            .position       = start + done
+        };
+
+        if (n > SCOPE_LINK_MAX_SAMPLES) {
+            n = SCOPE_LINK_MAX_SAMPLES;
+        }
+        header.count = (uint16_t)n;
+        if (window->trigger_index >= done && (window->trigger_index - done) < n) {
+            header.trigger_index = (uint16_t)(window->trigger_index - done);
+        }
+        (void)scope_link_send(&header, &samples[done]);
+    }
+}
+
+
+/*******************************************************************************
+ * Function Name: trigger_process
+ *******************************************************************************
+ *
+ * Summary:
+ *  Feed samples to the trigger and output every window that completes on
+ *  the way, or every N-th averaged one. Forced windows have no trigger to
+ *  align them; they are output as they are and start the average over.
+ *
+ *******************************************************************************/
+static void trigger_process(const uint16_t *samples, uint32_t count)
+{
+    scope_trigger_window_t window;
+    uint32_t done = 0u;
+
+    while (done < count) {
+        done += scope_trigger_feed(&trigger, &samples[done], count - done);
+        if (scope_trigger_read(&trigger, window_samples, &window) != 0) {
+            continue;
+        }
+        if (window.forced) {
+            scope_average_reset(&average);
+        }
+        else if (scope_average_add(&average, window_samples, window.count, window_samples) != 0) {
+            continue;
+        }
+        if (settings.output == SCOPE_OUTPUT_WINDOW) {
+            window_send(window_samples, &window);
+        }
         else {
-                   Cy_DMAC_Descriptor_SetNextDescriptor(&WSDescriptors[i], NULL);
-               }
+            window_display(window_samples, &window);
+        }
     }
+}
 
-    /* DMA channel configuration */
-    const cy_stc_dmac_channel_config_t channelConfig = {
-		.descriptor  = &WSDescriptors[0],
-		.priority    = 3,
-		.enable      = false,
+
+/*******************************************************************************
+ * Function Name: stream_flush
+ *******************************************************************************
+ *
+ * Summary:
+ *  Send the collected stream samples as one packet, the blocks of the
+ *  channels one after the other; the blocks of a partial packet are moved
+ *  together first.
+ *
+ *******************************************************************************/
+static void stream_flush(void)
+{
+    scope_stream_header_t header = {
+        .flags          = (uint8_t)((uint32_t)settings.acquire_mode |
+                                    ((stream_channels - 1u) << SCOPE_STREAM_FLAG_CHANNELS_SHIFT)),
+        .count          = (uint16_t)(stream_fill * stream_channels),
+        .sample_rate_hz = scope_capture_sample_rate(),
+        .factor         = (uint16_t)settings.acquire_factor,
+        .trigger_index  = SCOPE_STREAM_NO_TRIGGER,
+        .position       = stream_position - stream_fill
     };
 
-    result = Cy_DMAC_Channel_Init(DMA_HW, DMA_CHANNEL, &channelConfig);
+    if (stream_fill == 0u) {
+        return;
+    }
+    for (uint32_t c = 1u; c < stream_channels && stream_fill < stream_block; c++) {
+        for (uint32_t i = 0u; i < stream_fill; i++) {
+            stream_samples[c * stream_fill + i] = stream_samples[c * stream_block + i];
+        }
+    }
+    (void)scope_link_send(&header, stream_samples);
+    stream_fill = 0u;
+}
+
 
-    if (result != CY_DMA_SUCCESS) {
-            printf("DMA Initialization failed...\r\n\n");
-            CY_ASSERT(0);
+/*******************************************************************************
+ * Function Name: stream_gap
+ *******************************************************************************
+ *
+ * Summary:
+ *  Capture frames were lost: end the current packet and advance the position
+ *  by the lost stream samples, so the PC sees the gap.
+ *
+ *******************************************************************************/
+static void stream_gap(uint32_t lost_frames)
+{
+    stream_flush();
+    stream_position += (lost_frames * SCOPE_FRAME_SAMPLES) / settings.acquire_factor;
+}
+
+
+/*******************************************************************************
+ * Function Name: stream_process
+ *******************************************************************************
+ *
+ * Summary:
+ *  Collect the samples of every channel into packets of
+ *  STREAM_PACKET_SAMPLES.
+ *
+ *******************************************************************************/
+static void stream_process(const uint16_t *const *planes, uint32_t count)
+{
+    for (uint32_t i = 0u; i < count; i++) {
+        for (uint32_t c = 0u; c < stream_channels; c++) {
+            stream_samples[c * stream_block + stream_fill] = planes[c][i];
+        }
+        stream_fill++;
+        stream_position++;
+        if (stream_fill == stream_block) {
+            stream_flush();
         }
-    printf("DMA initialized successfully.\r\n\n");
+    }
+}
+
 
-    Cy_DMAC_Channel_Enable(DMA_HW,DMA_CHANNEL);
+/*******************************************************************************
+ * Function Name: spectrum_process
+ *******************************************************************************
+ *
+ * Summary:
+ *  Feed samples to the spectrum analyzer and send every averaged spectrum
+ *  as one packet of bins.
+ *
+ *******************************************************************************/
+static void spectrum_process(const uint16_t *samples, uint32_t count)
+{
+    uint32_t done = 0u;
+
+    while (done < count) {
+        done += scope_spectrum_feed(&spectrum, &samples[done], count - done);
+        if (scope_spectrum_read(&spectrum, spectrum_bins) == 0) {
+            scope_stream_header_t header = {
+                .flags          = SCOPE_STREAM_FLAG_SPECTRUM,
+                .count          = (uint16_t)(SPECTRUM_POINTS / 2u),
+                .sample_rate_hz = scope_capture_sample_rate(),
+                .factor         = (uint16_t)settings.acquire_factor,
+                .trigger_index  = SCOPE_STREAM_NO_TRIGGER,
+                .position       = spectrum_count++
+            };
+
+            (void)scope_link_send(&header, spectrum_bins);
+        }
+    }
 }
 
+
 /*******************************************************************************
- * Function Name: adc_init
+ * Function Name: measure_process
  *******************************************************************************
  *
  * Summary:
- *  ADC single channel initialization function. This function initializes and
- *  configures channel 0 of ADC.
+ *  Measure the samples as one frame and print every MEASURE_REPORT_FRAMES-th
+ *  record: voltages in millivolts, frequency in hertz, duty cycle in
+ *  per mille.
  *
  *******************************************************************************/
-void adc_init(void) {
+static void measure_process(const uint16_t *samples, uint32_t count)
+{
+    scope_measure_record_t record;
+
+    scope_measure_frame(&measure, samples, count, &record);
+    if ((record.frame % MEASURE_REPORT_FRAMES) == 0u) {
+        printf("Vpp: %ld\tMean: %ld\tRMS: %ld\tAC RMS: %ld\tFreq: %lu.%03lu\tDuty: %u\r\n",
+               (long)record.vpp_mv, (long)record.mean_mv, (long)record.rms_mv,
+               (long)record.ac_rms_mv, (unsigned long)(record.frequency_mhz / 1000u),
+               (unsigned long)(record.frequency_mhz % 1000u), (unsigned int)record.duty_permille);
+    }
+}
 
-	/* Variable to capture return value of functions */
-    cy_rslt_t result;
 
-    /* Initialize ADC. The ADC block which can connect to the channel 0 input pin is selected */
-    result = cyhal_adc_init(&adc_obj, VPLUS_CHANNEL_0, NULL);
-    if (result != CY_RSLT_SUCCESS) {
-        printf("ADC initialization failed. Error: %ld\n", (long unsigned int)result);
-        CY_ASSERT(0);
+/*******************************************************************************
+ * Function Name: frame_process
+ *******************************************************************************
+ *
+ * Summary:
+ *  Process one completed frame: reduce its planes in the acquisition mode,
+ *  unless every sample is kept, and pass them on to the output. The stream
+ *  carries every channel, the other outputs work on the first one. Lost
+ *  frames are accounted for first.
+ *
+ *******************************************************************************/
+static void frame_process(const scope_frame_t *frame, uint32_t count)
+{
+    const uint16_t *planes[SCOPE_CAPTURE_CHANNELS_MAX] = { NULL };
+    const uint32_t channels = (settings.output == SCOPE_OUTPUT_STREAM) ? stream_channels : 1u;
+    scope_capture_stats_t stats;
+    uint32_t reduced = count;
+    uint32_t lost;
+
+    /* Nothing may span samples the capture lost: partial buckets and
+     * windows are dropped */
+    scope_capture_get_stats(&stats);
+    lost = stats.frames_dropped + stats.dma_overruns;
+    if (lost != capture_lost) {
+        for (uint32_t c = 0u; c < SCOPE_CAPTURE_CHANNELS_MAX; c++) {
+            scope_decimate_reset(&decimate[c]);
+        }
+        switch (settings.output) {
+        case SCOPE_OUTPUT_STREAM:
+            stream_gap(lost - capture_lost);
+            break;
+        case SCOPE_OUTPUT_SPECTRUM:
+            scope_spectrum_reset(&spectrum);
+            break;
+        case SCOPE_OUTPUT_MEASURE:
+            scope_measure_reset(&measure);
+            break;
+        default:
+            if (scope_trigger_state(&trigger) != SCOPE_TRIGGER_STOPPED) {
+                scope_trigger_arm(&trigger);
+            }
+            scope_average_reset(&average);
+            break;
+        }
+        capture_lost = lost;
+    }
+
+    /* The channels share the factor and the bucket positions, so their
+     * reduced planes stay aligned */
+    for (uint32_t c = 0u; c < channels; c++) {
+        planes[c] = frame->planes[c];
+        if (settings.acquire_factor > 1u) {
+            reduced = scope_decimate_run(&decimate[c], planes[c], count, decimated[c]);
+            planes[c] = decimated[c];
+        }
+    }
+    switch (settings.output) {
+    case SCOPE_OUTPUT_STREAM:
+        stream_process(planes, reduced);
+        break;
+    case SCOPE_OUTPUT_SPECTRUM:
+        spectrum_process(planes[0], reduced);
+        break;
+    case SCOPE_OUTPUT_MEASURE:
+        measure_process(planes[0], reduced);
+        break;
+    default:
+        trigger_process(planes[0], reduced);
+        break;
     }
+}
+
 
-    /* ADC channel configuration */
-    const cyhal_adc_channel_config_t channel_config = {
-        .enable_averaging = true,
-        .min_acquisition_ns = ACQUISITION_TIME_NS,
-        .enabled = true
+/*******************************************************************************
+ * Function Name: processing_restart
+ *******************************************************************************
+ *
+ * Summary:
+ *  Start the acquisition and the outputs over, after the capture or the
+ *  acquisition changed: nothing may span samples taken with different
+ *  settings. Measurements follow the rate of the acquired samples.
+ *
+ *******************************************************************************/
+static void processing_restart(void)
+{
+    const scope_measure_config_t measure_config = {
+        .sample_rate_hz  = scope_capture_sample_rate() / settings.acquire_factor,
+        .full_scale_mv   = SCOPE_ADC_FULL_SCALE_MV,
+        .resolution_bits = SCOPE_ADC_RESOLUTION_BITS,
+        .level           = MEASURE_LEVEL_CODE,
+        .hysteresis      = MEASURE_HYSTERESIS_CODES
     };
 
-    /* Initialize a channel 0 and configure it to scan the channel 0 input pin in single ended mode. */
-    result  = cyhal_adc_channel_init_diff(&adc_chan_0_obj, &adc_obj, VPLUS_CHANNEL_0,
-                                          CYHAL_ADC_VNEG, &channel_config);
+    for (uint32_t c = 0u; c < SCOPE_CAPTURE_CHANNELS_MAX; c++) {
+        scope_decimate_reset(&decimate[c]);
+    }
+    stream_channels = scope_capture_channels();
+    stream_block = STREAM_PACKET_SAMPLES / stream_channels;
+    stream_fill = 0u;
+    scope_spectrum_reset(&spectrum);
+    scope_measure_init(&measure, &measure_config);
+    scope_average_reset(&average);
+    scope_trigger_arm(&trigger);
+}
 
-    if (result != CY_RSLT_SUCCESS) {
-        printf("ADC single ended channel initialization failed. Error: %ld\n", (long unsigned int)result);
-        CY_ASSERT(0);
+
+static void settings_capture_config(scope_capture_config_t *config)
+{
+    config->sample_rate_hz = settings.sample_rate_hz;
+    for (uint32_t c = 0u; c < SCOPE_CAPTURE_CHANNELS_MAX; c++) {
+        config->acquisition_ns[c] = settings.acquisition_ns[c];
     }
-    printf("ADC initialized successfully.\r\n\n");
+    config->averaging = settings.averaging;
+    config->channel_mask = settings.channel_mask;
 }
 
 
 /*******************************************************************************
- * Function Name: adc_process
+ * Function Name: settings_apply
  *******************************************************************************
  *
  * Summary:
- *  ADC single channel process function. This function reads the input voltage,
- *  store it in the buffer and sends to serial prints the input voltage on plotter
- *  and UART every few samples.
+ *  Apply what a command changed, except the output, which is switched after
+ *  the reply (output_switch). The capture and the acquisition reject
+ *  settings the hardware cannot take.
  *
  *******************************************************************************/
-void adc_process(void) {
-    int32_t adc_result_0 = 0;
-    adc_result_0 = cyhal_adc_read_uv(&adc_chan_0_obj) / MICRO_TO_MILLI_CONV_RATIO;
-
-    // Store the ADC value in the buffer
-    adcBuffer[adcBufferIndex++] = adc_result_0;
-    if (adcBufferIndex >= BUFFER_SIZE) {
-        adcBufferIndex = 0;
-    }
-	// Send ADC buffer to serial plotter every few samples
-	if (adcBufferIndex % 20 == 1) {
-		printf("Data: %u\r\n", (unsigned int)adcBuffer[(adcBufferIndex - 1) % BUFFER_SIZE]);
-	}
-	cyhal_system_delay_ms(ADC_SCAN_DELAY_MS);
+static cy_rslt_t settings_apply(uint32_t changed)
+{
+    cy_rslt_t result;
+
+    if (changed & SCOPE_COMMAND_CHANGED_CAPTURE) {
+        scope_capture_config_t capture_config;
+
+        settings_capture_config(&capture_config);
+        result = scope_capture_configure(&capture_config);
+        if (result != CY_RSLT_SUCCESS) {
+            return result;
+        }
+    }
+    if (changed & SCOPE_COMMAND_CHANGED_ACQUIRE) {
+        for (uint32_t c = 0u; c < SCOPE_CAPTURE_CHANNELS_MAX; c++) {
+            if (scope_decimate_init(&decimate[c], settings.acquire_mode, settings.acquire_factor) != 0) {
+                return SETTINGS_RSLT_INVALID;
+            }
+        }
+    }
+    if (changed & SCOPE_COMMAND_CHANGED_TRIGGER) {
+        if (scope_trigger_init(&trigger, &settings.trigger) != 0) {
+            return SETTINGS_RSLT_INVALID;
+        }
+        scope_trigger_arm(&trigger);
+        scope_average_reset(&average);
+    }
+    if (changed & SCOPE_COMMAND_CHANGED_AVERAGE) {
+        if (scope_average_init(&average, settings.average_mode, settings.average_frames) != 0) {
+            return SETTINGS_RSLT_INVALID;
+        }
+    }
+    if (changed & (SCOPE_COMMAND_CHANGED_CAPTURE | SCOPE_COMMAND_CHANGED_ACQUIRE |
+                   SCOPE_COMMAND_CHANGED_OUTPUT)) {
+        processing_restart();
+    }
+    if (changed & SCOPE_COMMAND_ARM) {
+        scope_trigger_arm(&trigger);
+    }
+    return CY_RSLT_SUCCESS;
+}
+
+
+/*******************************************************************************
+ * Function Name: output_switch
+ *******************************************************************************
+ *
+ * Summary:
+ *  Move the UART between the text outputs at the retarget-io baud rate and
+ *  the binary packets at SCOPE_LINK_BAUD.
+ *
+ *******************************************************************************/
+static cy_rslt_t output_switch(uint8_t from, uint8_t to)
+{
+    if (output_is_binary(from) && !output_is_binary(to)) {
+        return scope_link_close();
+    }
+    if (!output_is_binary(from) && output_is_binary(to)) {
+        printf("Streaming binary packets at %lu baud.\r\n", (unsigned long)SCOPE_LINK_BAUD);
+        cyhal_system_delay_ms(20u);   /* let the text leave the UART FIFO */
+        return scope_link_init();
+    }
+    return CY_RSLT_SUCCESS;
+}
+
+
+/*******************************************************************************
+ * Function Name: command_poll
+ *******************************************************************************
+ *
+ * Summary:
+ *  Collect the characters received on the UART and execute every complete
+ *  command line. A command the hardware rejects leaves the previous
+ *  settings in place. The reply goes out at the baud rate the command came
+ *  in; the output is switched after it.
+ *
+ *******************************************************************************/
+static void command_poll(void)
+{
+    char reply[SCOPE_COMMAND_REPLY_MAX];
+    uint8_t c;
+
+    while (cyhal_uart_readable(&cy_retarget_io_uart_obj) != 0u) {
+        scope_settings_t previous;
+        uint32_t changed;
+
+        if (cyhal_uart_getc(&cy_retarget_io_uart_obj, &c, 0u) != CY_RSLT_SUCCESS ||
+            scope_command_input(&command, (char)c) == 0) {
+            continue;
+        }
+
+        if (settings.output == SCOPE_OUTPUT_STREAM) {
+            stream_flush();
+        }
+        previous = settings;
+        changed = scope_command_execute(&settings, command.line, reply);
+        if (changed != 0u && settings_apply(changed) != CY_RSLT_SUCCESS) {
+            settings = previous;
+            (void)settings_apply(changed);
+            (void)snprintf(reply, sizeof(reply), "ERR hardware");
+            changed = 0u;
+        }
+
+        if (output_is_binary(previous.output)) {
+            scope_link_drain();
+        }
+        printf("%s\r\n", reply);
+        if ((changed & SCOPE_COMMAND_CHANGED_OUTPUT) &&
+            output_switch(previous.output, settings.output) != CY_RSLT_SUCCESS) {
+            CY_ASSERT(0);
+        }
+    }
+}
+
+
+/* Settings at reset */
+static void settings_init(void)
+{
+    const scope_trigger_config_t trigger_config = {
+        .type         = SCOPE_TRIGGER_EDGE,
+        .slope        = SCOPE_TRIGGER_RISING,
+        .mode         = SCOPE_TRIGGER_AUTO,
+        .level        = TRIGGER_LEVEL_CODE,
+        .hysteresis   = TRIGGER_HYSTERESIS_CODES,
+        .pulse_min    = 0u,
+        .pulse_max    = 0u,
+        .pre          = TRIGGER_PRE_SAMPLES,
+        .post         = TRIGGER_POST_SAMPLES,
+        .auto_timeout = 0u
+    };
+
+    settings.sample_rate_hz = SCOPE_SAMPLE_RATE_HZ;
+    for (uint32_t c = 0u; c < SCOPE_COMMAND_SCAN_CHANNELS; c++) {
+        settings.acquisition_ns[c] = SCOPE_ACQUISITION_NS;
+    }
+    settings.averaging = 1u;
+    settings.channel_mask = 1u;
+    settings.output = SCOPE_OUTPUT;
+    scope_command_output_acquire(&settings, settings.output);
+    settings.trigger = trigger_config;
+    settings.auto_ms = TRIGGER_AUTO_MS;
+    settings.trigger.auto_timeout = scope_command_auto_samples(&settings);
+    settings.average_mode = AVERAGE_MODE;
+    settings.average_frames = AVERAGE_FRAMES;
 }
 
 
 int main(void){
     cy_rslt_t result;
+    scope_capture_config_t capture_config;
 
     result = cybsp_init();
     if (result != CY_RSLT_SUCCESS) {
@@ -187,11 +619,45 @@ int main(void){
     printf("\x1b[2J\x1b[;H");
     printf("Data Acquisition Started..\r\n\n");
 
-	adc_init();
-	ws_dmac_init();
+    settings_init();
+    scope_command_init(&command);
+
+    settings_capture_config(&capture_config);
+    result = scope_capture_init(&capture_config);
+    if (result != CY_RSLT_SUCCESS) {
+        printf("Capture initialization failed. Error: %lu\r\n", (unsigned long)result);
+        CY_ASSERT(0);
+    }
+    printf("ADC and DMA initialized, %lu samples/s.\r\n\n", (unsigned long)scope_capture_sample_rate());
+
+    if (scope_spectrum_init(&spectrum, SPECTRUM_POINTS, SPECTRUM_AVERAGES) != 0 ||
+        settings_apply(SCOPE_COMMAND_CHANGED_ACQUIRE | SCOPE_COMMAND_CHANGED_TRIGGER |
+                       SCOPE_COMMAND_CHANGED_AVERAGE) != CY_RSLT_SUCCESS) {
+        CY_ASSERT(0);
+    }
+    result = output_switch(SCOPE_OUTPUT_PLOTTER, settings.output);
+    if (result != CY_RSLT_SUCCESS) {
+        CY_ASSERT(0);
+    }
+    scope_capture_start();
 
 	for(;;){
-		adc_process();
+		/* Frames are processed in place and handed back to the capture */
+		const scope_frame_t *frame = scope_capture_acquire();
+
+		if (frame != NULL) {
+			frame_process(frame, SCOPE_FRAME_SAMPLES);
+			scope_capture_release(frame);
+		}
+		if (output_is_binary(settings.output)) {
+			scope_link_poll();
+		}
+		command_poll();
+		if (frame == NULL) {
+			scope_capture_wait();
+		}
 	}
 
 }
+
+#endif /* !SCOPE_DUAL_CORE || CY_CPU_CORTEX_M4 */
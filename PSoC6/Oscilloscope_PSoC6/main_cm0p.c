@@ -0,0 +1,36 @@
+/**********************************************************************************
+* File Name:   main_cm0p.c
+*
+* Description: CM0+ application of the dual-core oscilloscope (SCOPE_DUAL_CORE,
+*              built with CORE=CM0P). It starts the CM4 and then only serves
+*              the capture: the CM4 attaches it to the frame pool, and from
+*              then on the SAR, the DMA and the frame interrupt run here, so
+*              the timing of the capture does not depend on the load of the
+*              processing on the CM4 (scope_ipc.h).
+*
+***********************************************************************************/
+
+#include "cy_pdl.h"
+#include "cyhal.h"
+#include "scope_ipc.h"
+
+#if defined(SCOPE_DUAL_CORE) && (CY_CPU_CORTEX_M0P)
+
+int main(void)
+{
+    __enable_irq();
+
+    if (cyhal_hwmgr_init() != CY_RSLT_SUCCESS) {
+        CY_ASSERT(0);
+    }
+    scope_capture_server_init();
+
+    /* The CM4 configures the clocks and the board, then attaches the capture */
+    Cy_SysEnableCM4(CY_CORTEX_M4_APPL_ADDR);
+
+    for (;;) {
+        scope_capture_serve();
+    }
+}
+
+#endif /* SCOPE_DUAL_CORE && CY_CPU_CORTEX_M0P */
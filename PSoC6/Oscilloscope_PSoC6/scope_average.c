@@ -0,0 +1,128 @@
+/**********************************************************************************
+* File Name:   scope_average.c
+*
+* Description: Window averaging with integer accumulators. Each mode has its
+*              own loop over the window: one add per sample (COHERENT) or one
+*              shift and add (PERSIST); the division of COHERENT is only paid
+*              for the result.
+*
+***********************************************************************************/
+
+#include "scope_average.h"
+
+#define PERSIST_FRACTION_BITS        (16u)
+#define PERSIST_HALF                 (1u << (PERSIST_FRACTION_BITS - 1u))
+
+/*****************************************************************************/
+
+int scope_average_init(scope_average_t *average, scope_average_mode_t mode, uint32_t frames)
+{
+    uint32_t shift = 0u;
+
+    if (frames == 0u || frames > SCOPE_AVERAGE_MAX_FRAMES) {
+        return -1;
+    }
+    if (mode == SCOPE_AVERAGE_PERSIST) {
+        if ((frames & (frames - 1u)) != 0u) {
+            return -1;
+        }
+        while ((1u << shift) < frames) {
+            shift++;
+        }
+    }
+    average->mode = mode;
+    average->frames = frames;
+    average->shift = shift;
+    scope_average_reset(average);
+    return 0;
+}
+
+
+void scope_average_reset(scope_average_t *average)
+{
+    average->length = 0u;
+    average->count = 0u;
+}
+
+
+/*******************************************************************************
+ * Function Name: scope_average_add
+ *******************************************************************************
+ *
+ * Summary:
+ *  The first window after a reset loads the accumulators; later ones add to
+ *  them (COHERENT) or move them towards the window (PERSIST). Every N-th
+ *  window the rounded result is written, and COHERENT starts over.
+ *
+ *******************************************************************************/
+int scope_average_add(scope_average_t *average, const uint16_t *window, uint32_t length, uint16_t *out)
+{
+    uint32_t *acc = average->acc;
+
+    if (length == 0u || length > SCOPE_AVERAGE_MAX_SAMPLES) {
+        return -1;
+    }
+    if (average->mode == SCOPE_AVERAGE_OFF) {
+        for (uint32_t i = 0u; i < length; i++) {
+            out[i] = window[i];
+        }
+        return 0;
+    }
+
+    if (average->length != length) {
+        average->length = 0u;
+        average->count = 0u;
+    }
+
+    if (average->mode == SCOPE_AVERAGE_COHERENT) {
+        if (average->count == 0u) {
+            for (uint32_t i = 0u; i < length; i++) {
+                acc[i] = window[i];
+            }
+        }
+        else {
+            for (uint32_t i = 0u; i < length; i++) {
+                acc[i] += window[i];
+            }
+        }
+    }
+    else if (average->length == 0u) {
+        for (uint32_t i = 0u; i < length; i++) {
+            acc[i] = (uint32_t)window[i] << PERSIST_FRACTION_BITS;
+        }
+    }
+    else {
+        const uint32_t shift = average->shift;
+
+        for (uint32_t i = 0u; i < length; i++) {
+            uint32_t target = (uint32_t)window[i] << PERSIST_FRACTION_BITS;
+
+            if (target >= acc[i]) {
+                acc[i] += (target - acc[i]) >> shift;
+            }
+            else {
+                acc[i] -= (acc[i] - target) >> shift;
+            }
+        }
+    }
+    average->length = length;
+    average->count++;
+
+    if (average->count < average->frames) {
+        return -1;
+    }
+    average->count = 0u;
+    if (average->mode == SCOPE_AVERAGE_COHERENT) {
+        const uint32_t n = average->frames;
+
+        for (uint32_t i = 0u; i < length; i++) {
+            out[i] = (uint16_t)((acc[i] + (n / 2u)) / n);
+        }
+    }
+    else {
+        for (uint32_t i = 0u; i < length; i++) {
+            out[i] = (uint16_t)((acc[i] + PERSIST_HALF) >> PERSIST_FRACTION_BITS);
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,60 @@
+/**********************************************************************************
+* File Name:   scope_average.h
+*
+* Description: Averaging of trigger windows for noisy repetitive signals.
+*              Windows are added sample by sample to 32-bit accumulators of
+*              the window length:
+*                COHERENT  the sum of N windows; every N windows their mean
+*                          is the result and the sums start over. Noise that
+*                          is not locked to the trigger drops by sqrt(N).
+*                PERSIST   an exponential average, every window moves the
+*                          accumulators by 1/N towards it (16 fraction bits);
+*                          the result, every N windows, fades old windows out
+*                          over about N windows.
+*                OFF       every window is the result.
+*              Only one window in N produces a result, so the output carries
+*              1/N of the windows at a better signal-to-noise ratio. The
+*              averaging does not depend on the hardware.
+*
+***********************************************************************************/
+
+#ifndef SCOPE_AVERAGE_H
+#define SCOPE_AVERAGE_H
+
+#include <stdint.h>
+
+/* Longest window, SCOPE_TRIGGER_HISTORY */
+#define SCOPE_AVERAGE_MAX_SAMPLES    (4096u)
+
+/* Largest N; keeps the COHERENT sums of 15-bit codes within 32 bits */
+#define SCOPE_AVERAGE_MAX_FRAMES     (1024u)
+
+typedef enum {
+    SCOPE_AVERAGE_OFF,
+    SCOPE_AVERAGE_COHERENT,
+    SCOPE_AVERAGE_PERSIST
+} scope_average_mode_t;
+
+typedef struct {
+    scope_average_mode_t mode;
+    uint32_t frames;           /* N */
+    uint32_t shift;            /* PERSIST: log2(N) */
+    uint32_t length;           /* samples of the accumulated windows, 0 = none */
+    uint32_t count;            /* windows added since the last result */
+    uint32_t acc[SCOPE_AVERAGE_MAX_SAMPLES];
+} scope_average_t;
+
+/* Returns -1 for N of 0 or above SCOPE_AVERAGE_MAX_FRAMES, and for PERSIST
+ * with N not a power of two */
+int scope_average_init(scope_average_t *average, scope_average_mode_t mode, uint32_t frames);
+
+/* Drop the accumulated windows, e.g. when the window or the signal changed */
+void scope_average_reset(scope_average_t *average);
+
+/* Add a window of 'length' samples (up to SCOPE_AVERAGE_MAX_SAMPLES). A
+ * window of another length than the accumulated ones starts over. Returns 0
+ * with the result in 'out' (which may be 'window') every N windows, -1
+ * otherwise. */
+int scope_average_add(scope_average_t *average, const uint16_t *window, uint32_t length, uint16_t *out);
+
+#endif /* SCOPE_AVERAGE_H */
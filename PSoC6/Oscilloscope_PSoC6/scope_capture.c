@@ -0,0 +1,786 @@
+/**********************************************************************************
+* File Name:   scope_capture.c
+*
+* Description: Continuous SAR capture into DMA ping-pong frames. The SAR runs
+*              in continuous scanning mode at the configured rate and raises
+*              its end-of-scan trigger after every scan of its channels. The
+*              trigger is routed to DMAC channel 0, whose 2D descriptors
+*              de-interleave the scan: the X loop moves the result of every
+*              channel into its plane of the frame, the Y loop steps to the
+*              next sample. Two descriptors, chained in a circle, each fill
+*              one frame and
+*              interrupt when it is complete. The interrupt queues the filled
+*              frame for the application and points the descriptor at a free
+*              frame of the pool before the DMA comes back to it, one frame
+*              time later. Frames move between the DMA, the completed queue,
+*              the application and the free queue by index only.
+*
+*              A new configuration stops the channel, reconfigures the SAR
+*              through the HAL, re-initializes the channel and its descriptors
+*              on an empty pool and restarts it; the trigger routing and the
+*              interrupt stay as they are.
+*
+*              With SCOPE_DUAL_CORE the file is built for both cores: the CM0+
+*              half runs the ADC, the DMA and its interrupt on the pool the
+*              CM4 attaches it to, the CM4 half owns the pool and forwards
+*              init, configuration, start and stop over the IPC pipe
+*              (scope_ipc.h).
+*
+***********************************************************************************/
+
+#include "cy_pdl.h"
+#include "cyhal.h"
+#include "cybsp.h"
+#include "scope_capture.h"
+#include "scope_ipc.h"
+
+/* Role of this core: CAPTURE_HARDWARE runs the ADC and DMA, CAPTURE_CONSUMER
+ * owns the pool and hands its frames to the application */
+#if !defined(SCOPE_DUAL_CORE)
+#define CAPTURE_HARDWARE                 (1)
+#define CAPTURE_CONSUMER                 (1)
+#elif (CY_CPU_CORTEX_M0P)
+#define CAPTURE_HARDWARE                 (1)
+#define CAPTURE_CONSUMER                 (0)
+#else
+#define CAPTURE_HARDWARE                 (0)
+#define CAPTURE_CONSUMER                 (1)
+#endif
+
+/*  ADC Macros */
+#define VPLUS_CHANNEL_0                  (P10_0)
+#define ADC_INPUTS                       (8u)      /* P10_0 .. P10_7 */
+#define ADC_CHANNELS                     (SCOPE_CAPTURE_CHANNELS_MAX)
+#define ADC_RESOLUTION_BITS              (SCOPE_ADC_RESOLUTION_BITS)
+#define ADC_FULL_SCALE_MV                (SCOPE_ADC_FULL_SCALE_MV)
+
+/*  DMA Macros */
+#define DMA_HW                           DMAC
+#define DMA_CHANNEL                      (0u)
+#define DMA_PRIORITY                     (3u)
+#define DMA_INTR_PRIORITY                (3u)
+#if (CY_CPU_CORTEX_M0P)
+/* The CM0+ sees system interrupts through one of its eight NVIC inputs */
+#define DMA_IRQ                          NvicMux3_IRQn
+#define DMA_INTR_SRC                     ((NvicMux3_IRQn << CY_SYSINT_INTRSRC_MUXIRQ_SHIFT) | \
+                                          cpuss_interrupts_dmac_0_IRQn)
+#else
+#define DMA_IRQ                          cpuss_interrupts_dmac_0_IRQn
+#define DMA_INTR_SRC                     cpuss_interrupts_dmac_0_IRQn
+#endif
+
+/* SAR end-of-scan output to the DMAC channel 0 trigger input (trigger group 10
+ * of the PSoC 6 02 devices) */
+#define CAPTURE_TRIGGER_IN               TRIG_IN_MUX_10_PASS_TR_SAR_OUT
+#define CAPTURE_TRIGGER_OUT              TRIG_OUT_MUX_10_MDMA_TR_IN0
+
+#define CAPTURE_DESCRIPTORS              (2u)
+
+/* Result of a channel selection the SAR cannot scan into consecutive result
+ * registers */
+#define CAPTURE_RSLT_BAD_CHANNELS        (CY_RSLT_CREATE(CY_RSLT_TYPE_ERROR, CY_RSLT_MODULE_MIDDLEWARE_BASE, 0x5Eu))
+
+/*****************************************************************************/
+
+#if (CAPTURE_CONSUMER)
+static scope_capture_pool_t capture_pool;
+#endif
+static scope_capture_pool_t *pool;       /* frames, queues, statistics, configuration */
+
+#if (CAPTURE_HARDWARE)
+static const cyhal_gpio_t adc_inputs[ADC_INPUTS] = {
+    P10_0, P10_1, P10_2, P10_3, P10_4, P10_5, P10_6, P10_7
+};
+
+static cyhal_adc_t adc_obj;
+static cyhal_adc_channel_t adc_chan_obj[ADC_CHANNELS];
+static cyhal_gpio_t adc_chan_pin[ADC_CHANNELS];         /* inputs of the channels */
+static uint32_t adc_channels;                            /* channels that exist */
+static bool capture_running;
+
+static cy_stc_dmac_descriptor_t descriptors[CAPTURE_DESCRIPTORS];
+static uint8_t descriptor_frame[CAPTURE_DESCRIPTORS];   /* frame each descriptor fills */
+static uint32_t next_done;                               /* descriptor expected to complete next */
+#endif
+
+#if defined(SCOPE_DUAL_CORE)
+static scope_ipc_msg_t ipc_msg;          /* the message this core sends */
+#endif
+#if defined(SCOPE_DUAL_CORE) && (CAPTURE_HARDWARE)
+static volatile uint32_t pending_command;
+static scope_capture_pool_t *volatile pending_pool;
+#endif
+
+
+static bool ring_push(scope_frame_ring_t *ring, uint8_t frame)
+{
+    uint32_t head = ring->head;
+
+    if ((head - ring->tail) >= SCOPE_CAPTURE_FRAMES) {
+        return false;
+    }
+    ring->slots[head & (SCOPE_CAPTURE_FRAMES - 1u)] = frame;
+    __DMB();
+    ring->head = head + 1u;
+    return true;
+}
+
+
+static bool ring_pop(scope_frame_ring_t *ring, uint8_t *frame)
+{
+    uint32_t tail = ring->tail;
+
+    if (tail == ring->head) {
+        return false;
+    }
+    *frame = ring->slots[tail & (SCOPE_CAPTURE_FRAMES - 1u)];
+    __DMB();
+    ring->tail = tail + 1u;
+    return true;
+}
+
+
+#if (CAPTURE_HARDWARE)
+/*******************************************************************************
+ * Function Name: capture_adc_channels
+ *******************************************************************************
+ *
+ * Summary:
+ *  Create the channels of the selected inputs in ascending order. The DMA
+ *  reads the results of a scan as consecutive registers, so the HAL must
+ *  have given the channels consecutive indices from 0.
+ *
+ *******************************************************************************/
+static cy_rslt_t capture_adc_channels(const cyhal_gpio_t *pins, uint32_t count,
+                                      const cyhal_adc_channel_config_t *channel_config)
+{
+    cy_rslt_t result;
+
+    for (uint32_t i = 0u; i < adc_channels; i++) {
+        cyhal_adc_channel_free(&adc_chan_obj[i]);
+    }
+    adc_channels = 0u;
+
+    for (uint32_t i = 0u; i < count; i++) {
+        result = cyhal_adc_channel_init_diff(&adc_chan_obj[i], &adc_obj, pins[i],
+                                             CYHAL_ADC_VNEG, &channel_config[i]);
+        if (result != CY_RSLT_SUCCESS) {
+            return result;
+        }
+        adc_chan_pin[i] = pins[i];
+        adc_channels = i + 1u;
+        if ((uint32_t)adc_chan_obj[i].channel_idx != (uint32_t)adc_chan_obj[0].channel_idx + i) {
+            return CAPTURE_RSLT_BAD_CHANNELS;
+        }
+    }
+    return CY_RSLT_SUCCESS;
+}
+
+
+/*******************************************************************************
+ * Function Name: capture_adc_apply
+ *******************************************************************************
+ *
+ * Summary:
+ *  Set the SAR averaging, the channels of the selected inputs with their
+ *  acquisition times, and the sample rate. The channels are created again
+ *  only when the inputs change.
+ *
+ *******************************************************************************/
+static cy_rslt_t capture_adc_apply(const scope_capture_config_t *config)
+{
+    cy_rslt_t result;
+    cyhal_adc_channel_config_t channel_config[ADC_CHANNELS];
+    cyhal_gpio_t pins[ADC_CHANNELS];
+    uint32_t count = 0u;
+    bool same_inputs;
+
+    const cyhal_adc_config_t adc_config = {
+        .continuous_scanning = true,
+        .resolution          = ADC_RESOLUTION_BITS,
+        .average_count       = config->averaging,
+        .average_mode_flags  = (config->averaging > 1u) ? CYHAL_ADC_AVG_MODE_AVERAGE : 0u,
+        .ext_vref_mv         = 0u,
+        .vneg                = CYHAL_ADC_VNEG_VSSA,
+        .vref                = CYHAL_ADC_REF_VDDA,
+        .ext_vref            = NC,
+        .is_bypassed         = false,
+        .bypass_pin          = NC,
+    };
+
+    for (uint32_t i = 0u; i < ADC_INPUTS; i++) {
+        if (config->channel_mask & (1u << i)) {
+            if (count == ADC_CHANNELS) {
+                return CAPTURE_RSLT_BAD_CHANNELS;
+            }
+            pins[count] = adc_inputs[i];
+            channel_config[count].enable_averaging = (config->averaging > 1u);
+            channel_config[count].min_acquisition_ns = config->acquisition_ns[count];
+            channel_config[count].enabled = true;
+            count++;
+        }
+    }
+    if (count == 0u) {
+        return CAPTURE_RSLT_BAD_CHANNELS;
+    }
+
+    result = cyhal_adc_configure(&adc_obj, &adc_config);
+    if (result != CY_RSLT_SUCCESS) {
+        return result;
+    }
+
+    same_inputs = (count == adc_channels);
+    for (uint32_t i = 0u; same_inputs && i < count; i++) {
+        same_inputs = (pins[i] == adc_chan_pin[i]);
+    }
+    if (same_inputs) {
+        for (uint32_t i = 0u; i < count; i++) {
+            result = cyhal_adc_channel_configure(&adc_chan_obj[i], &channel_config[i]);
+            if (result != CY_RSLT_SUCCESS) {
+                return result;
+            }
+        }
+    }
+    else {
+        result = capture_adc_channels(pins, count, channel_config);
+        if (result != CY_RSLT_SUCCESS) {
+            return result;
+        }
+    }
+
+    return cyhal_adc_set_sample_rate(&adc_obj, config->sample_rate_hz);
+}
+
+
+/*******************************************************************************
+ * Function Name: capture_adc_init
+ *******************************************************************************
+ *
+ * Summary:
+ *  Configure the SAR for continuous scanning of one channel and enable its
+ *  end-of-scan trigger output.
+ *
+ *******************************************************************************/
+static cy_rslt_t capture_adc_init(const scope_capture_config_t *config)
+{
+    cy_rslt_t result;
+    cyhal_source_t eos_source;
+
+    result = cyhal_adc_init(&adc_obj, VPLUS_CHANNEL_0, NULL);
+    if (result != CY_RSLT_SUCCESS) {
+        return result;
+    }
+    adc_channels = 0u;
+
+    result = capture_adc_apply(config);
+    if (result != CY_RSLT_SUCCESS) {
+        return result;
+    }
+
+    /* End of scan: one trigger per sample of every channel */
+    return cyhal_adc_enable_output(&adc_obj, CYHAL_ADC_OUTPUT_SCAN_COMPLETE, &eos_source);
+}
+
+
+/*******************************************************************************
+ * Function Name: capture_frame_done
+ *******************************************************************************
+ *
+ * Summary:
+ *  A descriptor has filled its frame: queue the frame for the application and
+ *  give the descriptor a free one. Without a free frame (or room in the queue)
+ *  the frame is dropped and the descriptor fills it again.
+ *
+ *******************************************************************************/
+static void capture_frame_done(uint32_t descriptor)
+{
+    uint8_t next;
+
+    if ((pool->completed.head - pool->completed.tail) >= SCOPE_CAPTURE_FRAMES ||
+        !ring_pop(&pool->free, &next)) {
+        pool->stats.frames_dropped++;
+        return;
+    }
+    (void)ring_push(&pool->completed, descriptor_frame[descriptor]);
+    descriptor_frame[descriptor] = next;
+    Cy_DMAC_Descriptor_SetDstAddress(&descriptors[descriptor], (void *)pool->frames[next].planes[0]);
+    pool->stats.frames_captured++;
+
+#if defined(SCOPE_DUAL_CORE)
+    /* Wake the CM4; while it still has the last notification it will find
+     * this frame in the queue as well */
+    ipc_msg.client_id = SCOPE_IPC_CLIENT_ID;
+    ipc_msg.command = SCOPE_IPC_FRAME_READY;
+    ipc_msg.value = pool->stats.frames_captured;
+    (void)Cy_IPC_Pipe_SendMessage(CY_IPC_EP_CYPIPE_CM4_ADDR, CY_IPC_EP_CYPIPE_CM0_ADDR,
+                                  &ipc_msg, NULL);
+#endif
+}
+
+
+/*******************************************************************************
+ * Function Name: capture_dma_isr
+ *******************************************************************************
+ *
+ * Summary:
+ *  DMAC channel interrupt at the end of every descriptor. Completions
+ *  alternate between the two descriptors. If the channel is already back on
+ *  the descriptor expected to complete, the interrupt came more than a frame
+ *  late: that descriptor's frame is being overwritten, only the other one is
+ *  complete, and the loss is counted as an overrun.
+ *
+ *******************************************************************************/
+static void capture_dma_isr(void)
+{
+    uint32_t status = Cy_DMAC_Channel_GetInterruptStatusMasked(DMA_HW, DMA_CHANNEL);
+    uint32_t done = next_done;
+
+    Cy_DMAC_Channel_ClearInterrupt(DMA_HW, DMA_CHANNEL, status);
+
+    if ((status & CY_DMAC_INTR_COMPLETION) == 0u) {
+        pool->stats.dma_errors++;
+        return;
+    }
+
+    if (Cy_DMAC_Channel_GetCurrentDescriptor(DMA_HW, DMA_CHANNEL) == &descriptors[done]) {
+        pool->stats.dma_overruns++;
+        done ^= 1u;
+    }
+    else {
+        next_done ^= 1u;
+    }
+    capture_frame_done(done);
+}
+
+
+/*******************************************************************************
+ * Function Name: capture_dma_setup
+ *******************************************************************************
+ *
+ * Summary:
+ *  DMAC channel 0 setup: two 2D descriptors from the SAR result registers
+ *  into 16-bit frames, chained to each other in a circle, each with a
+ *  completion interrupt. One trigger runs one X loop, the scanned channels'
+ *  results into their planes; the Y loop counts the samples of the frame.
+ *  Frames 0 and 1 start in the descriptors, the rest of the pool is free.
+ *  The channel is left disabled.
+ *
+ *******************************************************************************/
+static cy_rslt_t capture_dma_setup(void)
+{
+    cy_rslt_t result;
+
+    const cy_stc_dmac_descriptor_config_t WS_DMA_Descriptors_config =
+    {
+        .retrigger       = CY_DMAC_RETRIG_IM,
+        .interruptType   = CY_DMAC_DESCR,
+        .triggerOutType  = CY_DMAC_1ELEMENT,
+        .channelState    = CY_DMAC_CHANNEL_ENABLED,
+        .triggerInType   = CY_DMAC_X_LOOP,
+        .dataSize        = CY_DMAC_HALFWORD,
+        .srcTransferSize = CY_DMAC_TRANSFER_SIZE_WORD,   /* result registers are 32-bit */
+        .dstTransferSize = CY_DMAC_TRANSFER_SIZE_DATA,
+        .descriptorType  = CY_DMAC_2D_TRANSFER,
+        .srcAddress      = (void *)&adc_obj.base->CHAN_RESULT[adc_chan_obj[0].channel_idx],
+        .dstAddress      = NULL,
+        .srcXincrement   = 1L,                           /* next channel's result */
+        .dstXincrement   = (int32_t)SCOPE_FRAME_SAMPLES, /* next plane */
+        .xCount          = adc_channels,
+        .srcYincrement   = 0L,                           /* the same results, next scan */
+        .dstYincrement   = 1L,                           /* next sample */
+        .yCount          = SCOPE_FRAME_SAMPLES,
+        .nextDescriptor  = NULL
+    };
+
+    const cy_stc_dmac_channel_config_t channelConfig = {
+        .descriptor  = &descriptors[0],
+        .priority    = DMA_PRIORITY,
+        .enable      = false,
+    };
+
+    pool->completed.head = pool->completed.tail = 0u;
+    pool->free.head = pool->free.tail = 0u;
+    for (uint8_t i = CAPTURE_DESCRIPTORS; i < SCOPE_CAPTURE_FRAMES; i++) {
+        (void)ring_push(&pool->free, i);
+    }
+
+    for (uint32_t i = 0u; i < CAPTURE_DESCRIPTORS; i++)
+    {
+        result = Cy_DMAC_Descriptor_Init(&descriptors[i], &WS_DMA_Descriptors_config);
+        if (result != CY_DMAC_SUCCESS) {
+            return result;
+        }
+        descriptor_frame[i] = (uint8_t)i;
+        Cy_DMAC_Descriptor_SetDstAddress(&descriptors[i], (void *)pool->frames[i].planes[0]);
+        Cy_DMAC_Descriptor_SetNextDescriptor(&descriptors[i],
+                                             &descriptors[(i + 1u) % CAPTURE_DESCRIPTORS]);
+    }
+    next_done = 0u;
+
+    result = Cy_DMAC_Channel_Init(DMA_HW, DMA_CHANNEL, &channelConfig);
+    if (result != CY_DMAC_SUCCESS) {
+        return result;
+    }
+    Cy_DMAC_Channel_SetInterruptMask(DMA_HW, DMA_CHANNEL, CY_DMAC_INTR_MASK);
+    return CY_RSLT_SUCCESS;
+}
+
+
+/*******************************************************************************
+ * Function Name: ws_dmac_init
+ *******************************************************************************
+ *
+ * Summary:
+ *  Set up the DMAC channel, trigger it by the SAR end of scan and enable its
+ *  interrupt.
+ *
+ *******************************************************************************/
+static cy_rslt_t ws_dmac_init(void)
+{
+    cy_rslt_t result;
+    cy_stc_sysint_t intr_config = {
+        .intrSrc      = DMA_INTR_SRC,
+        .intrPriority = DMA_INTR_PRIORITY
+    };
+
+    result = capture_dma_setup();
+    if (result != CY_RSLT_SUCCESS) {
+        return result;
+    }
+
+    result = Cy_TrigMux_Connect(CAPTURE_TRIGGER_IN, CAPTURE_TRIGGER_OUT, false, TRIGGER_TYPE_EDGE);
+    if (result != CY_TRIGMUX_SUCCESS) {
+        return result;
+    }
+
+    Cy_SysInt_Init(&intr_config, capture_dma_isr);
+    NVIC_EnableIRQ(DMA_IRQ);
+
+    Cy_DMAC_Enable(DMA_HW);
+    return CY_RSLT_SUCCESS;
+}
+
+
+/*******************************************************************************
+ * Function Name: capture_attach
+ *******************************************************************************
+ *
+ * Summary:
+ *  Set up the ADC and DMA to capture into 'capture' with its configuration.
+ *
+ *******************************************************************************/
+static cy_rslt_t capture_attach(scope_capture_pool_t *capture)
+{
+    cy_rslt_t result;
+
+    pool = capture;
+    capture_running = false;
+    pool->stats.frames_captured = 0u;
+    pool->stats.frames_dropped = 0u;
+    pool->stats.dma_overruns = 0u;
+    pool->stats.dma_errors = 0u;
+
+    result = capture_adc_init(&pool->config);
+    if (result != CY_RSLT_SUCCESS) {
+        return result;
+    }
+    return ws_dmac_init();
+}
+
+
+/*******************************************************************************
+ * Function Name: capture_configure
+ *******************************************************************************
+ *
+ * Summary:
+ *  Apply the configuration in the pool. The channel stops, so no transfer
+ *  or interrupt is in flight while the SAR and the descriptors change; new
+ *  inputs change the result registers and the planes of a scan. A running capture
+ *  starts again on the empty pool, with its statistics kept.
+ *
+ *******************************************************************************/
+static cy_rslt_t capture_configure(void)
+{
+    cy_rslt_t result;
+
+    Cy_DMAC_Channel_Disable(DMA_HW, DMA_CHANNEL);
+    NVIC_DisableIRQ(DMA_IRQ);
+
+    result = capture_adc_apply(&pool->config);
+    if (result == CY_RSLT_SUCCESS) {
+        result = capture_dma_setup();
+    }
+
+    Cy_DMAC_Channel_ClearInterrupt(DMA_HW, DMA_CHANNEL, CY_DMAC_INTR_MASK);
+    NVIC_ClearPendingIRQ(DMA_IRQ);
+    NVIC_EnableIRQ(DMA_IRQ);
+    if (result == CY_RSLT_SUCCESS && capture_running) {
+        Cy_DMAC_Channel_Enable(DMA_HW, DMA_CHANNEL);
+    }
+    return result;
+}
+
+
+static void capture_enable(bool enable)
+{
+    capture_running = enable;
+    if (enable) {
+        Cy_DMAC_Channel_Enable(DMA_HW, DMA_CHANNEL);
+    }
+    else {
+        Cy_DMAC_Channel_Disable(DMA_HW, DMA_CHANNEL);
+    }
+}
+#endif /* CAPTURE_HARDWARE */
+
+
+#if !defined(SCOPE_DUAL_CORE)
+cy_rslt_t scope_capture_init(const scope_capture_config_t *config)
+{
+    capture_pool.config = *config;
+    return capture_attach(&capture_pool);
+}
+
+
+cy_rslt_t scope_capture_configure(const scope_capture_config_t *config)
+{
+    pool->config = *config;
+    return capture_configure();
+}
+
+
+void scope_capture_start(void)
+{
+    capture_enable(true);
+}
+
+
+void scope_capture_stop(void)
+{
+    capture_enable(false);
+}
+
+#elif (CAPTURE_HARDWARE)
+/* CM0+: commands arrive in the pipe interrupt and are run by the main loop */
+static void capture_command_received(uint32_t *msg_data)
+{
+    const scope_ipc_msg_t *msg = (const scope_ipc_msg_t *)msg_data;
+
+    pending_pool = msg->pool;
+    pending_command = msg->command;
+}
+
+
+void scope_capture_server_init(void)
+{
+    pending_command = 0u;
+    (void)Cy_IPC_Pipe_RegisterCallback(CY_IPC_EP_CYPIPE_ADDR, capture_command_received,
+                                       SCOPE_IPC_CLIENT_ID);
+}
+
+
+/*******************************************************************************
+ * Function Name: scope_capture_serve
+ *******************************************************************************
+ *
+ * Summary:
+ *  Run a command of the CM4 and acknowledge it in the pool, or sleep until
+ *  the next interrupt. The check and the sleep happen with interrupts
+ *  masked, so a command that arrives in between still ends the sleep.
+ *
+ *******************************************************************************/
+void scope_capture_serve(void)
+{
+    scope_capture_pool_t *target;
+    cy_rslt_t result = CY_RSLT_SUCCESS;
+    uint32_t saved_intr = Cy_SysLib_EnterCriticalSection();
+    uint32_t command = pending_command;
+
+    pending_command = 0u;
+    if (command == 0u) {
+        __WFI();
+    }
+    Cy_SysLib_ExitCriticalSection(saved_intr);
+    if (command == 0u) {
+        return;
+    }
+
+    target = (command == SCOPE_IPC_CMD_ATTACH) ? pending_pool : pool;
+    switch (command) {
+    case SCOPE_IPC_CMD_ATTACH:
+        result = capture_attach(target);
+        break;
+    case SCOPE_IPC_CMD_CONFIGURE:
+        if (pool != NULL) {
+            result = capture_configure();
+        }
+        break;
+    case SCOPE_IPC_CMD_START:
+        capture_enable(true);
+        break;
+    case SCOPE_IPC_CMD_STOP:
+        capture_enable(false);
+        break;
+    default:
+        return;
+    }
+    if (target != NULL) {
+        target->command_result = result;
+        __DMB();
+        target->commands_done++;
+    }
+}
+
+#else
+/*******************************************************************************
+ * Function Name: capture_command
+ *******************************************************************************
+ *
+ * Summary:
+ *  CM4: send a command to the CM0+ and wait until it is acknowledged in the
+ *  pool. The pipe is busy while the CM0+ still holds an earlier message.
+ *
+ *******************************************************************************/
+static cy_rslt_t capture_command(uint8_t command)
+{
+    uint32_t done = capture_pool.commands_done;
+    uint32_t waited_ms = 0u;
+
+    ipc_msg.client_id = SCOPE_IPC_CLIENT_ID;
+    ipc_msg.command = command;
+    ipc_msg.value = 0u;
+    ipc_msg.pool = &capture_pool;
+    while (Cy_IPC_Pipe_SendMessage(CY_IPC_EP_CYPIPE_CM0_ADDR, CY_IPC_EP_CYPIPE_CM4_ADDR,
+                                   &ipc_msg, NULL) != CY_IPC_PIPE_SUCCESS) {
+        if (waited_ms++ == SCOPE_IPC_TIMEOUT_MS) {
+            return SCOPE_IPC_RSLT_TIMEOUT;
+        }
+        cyhal_system_delay_ms(1u);
+    }
+    while (capture_pool.commands_done == done) {
+        if (waited_ms++ == SCOPE_IPC_TIMEOUT_MS) {
+            return SCOPE_IPC_RSLT_TIMEOUT;
+        }
+        cyhal_system_delay_ms(1u);
+    }
+    __DMB();
+    return capture_pool.command_result;
+}
+
+
+/* CM4: the notification only ends scope_capture_wait() */
+static void capture_frame_ready(uint32_t *msg_data)
+{
+    (void)msg_data;
+}
+
+
+cy_rslt_t scope_capture_init(const scope_capture_config_t *config)
+{
+    pool = &capture_pool;
+    capture_pool.config = *config;
+    (void)Cy_IPC_Pipe_RegisterCallback(CY_IPC_EP_CYPIPE_ADDR, capture_frame_ready,
+                                       SCOPE_IPC_CLIENT_ID);
+    return capture_command(SCOPE_IPC_CMD_ATTACH);
+}
+
+
+cy_rslt_t scope_capture_configure(const scope_capture_config_t *config)
+{
+    capture_pool.config = *config;
+    return capture_command(SCOPE_IPC_CMD_CONFIGURE);
+}
+
+
+void scope_capture_start(void)
+{
+    (void)capture_command(SCOPE_IPC_CMD_START);
+}
+
+
+void scope_capture_stop(void)
+{
+    (void)capture_command(SCOPE_IPC_CMD_STOP);
+}
+#endif /* SCOPE_DUAL_CORE */
+
+
+#if (CAPTURE_CONSUMER)
+const scope_frame_t *scope_capture_acquire(void)
+{
+    uint8_t frame;
+
+    return ring_pop(&pool->completed, &frame) ? &pool->frames[frame] : NULL;
+}
+
+
+void scope_capture_release(const scope_frame_t *frame)
+{
+    uint32_t index;
+
+    if (frame == NULL) {
+        return;
+    }
+    index = (uint32_t)(frame - pool->frames);
+    if (index < SCOPE_CAPTURE_FRAMES) {
+        (void)ring_push(&pool->free, (uint8_t)index);
+    }
+}
+
+
+/*******************************************************************************
+ * Function Name: scope_capture_wait
+ *******************************************************************************
+ *
+ * Summary:
+ *  Sleep until the next interrupt unless a completed frame is waiting. The
+ *  check and the sleep happen with interrupts masked, so a frame completed
+ *  in between still ends the sleep.
+ *
+ *******************************************************************************/
+void scope_capture_wait(void)
+{
+    uint32_t saved_intr = cyhal_system_critical_section_enter();
+
+    if (pool->completed.head == pool->completed.tail) {
+        __WFI();
+    }
+    cyhal_system_critical_section_exit(saved_intr);
+}
+
+
+void scope_capture_get_stats(scope_capture_stats_t *stats)
+{
+    uint32_t saved_intr = cyhal_system_critical_section_enter();
+
+    stats->frames_captured = pool->stats.frames_captured;
+    stats->frames_dropped = pool->stats.frames_dropped;
+    stats->dma_overruns = pool->stats.dma_overruns;
+    stats->dma_errors = pool->stats.dma_errors;
+    cyhal_system_critical_section_exit(saved_intr);
+}
+
+
+uint32_t scope_capture_sample_rate(void)
+{
+    return pool->config.sample_rate_hz;
+}
+
+
+uint32_t scope_capture_channels(void)
+{
+    uint32_t count = 0u;
+
+    for (uint8_t mask = pool->config.channel_mask; mask != 0u; mask &= (uint8_t)(mask - 1u)) {
+        count++;
+    }
+    return count;
+}
+
+
+int32_t scope_capture_code_to_mv(uint16_t code)
+{
+    return ((int32_t)(code & ((1u << ADC_RESOLUTION_BITS) - 1u)) * ADC_FULL_SCALE_MV) >>
+           ADC_RESOLUTION_BITS;
+}
+#endif /* CAPTURE_CONSUMER */
@@ -0,0 +1,108 @@
+/**********************************************************************************
+* File Name:   scope_capture.h
+*
+* Description: Continuous ADC capture for the oscilloscope. The SAR scans one
+*              to SCOPE_CAPTURE_CHANNELS_MAX input channels continuously at a
+*              fixed sample rate; every end-of-scan trigger moves the results
+*              of all channels into a frame buffer by DMA. A frame keeps one
+*              plane of samples per channel (structure of arrays), so each
+*              channel is contiguous for processing, and sample i of every
+*              plane comes from the same scan.
+*              Two chained DMA descriptors fill frames in turn, ping-pong, and
+*              never stop. Completed frames are handed over to the application
+*              without copying:
+*                scope_capture_acquire()  takes the oldest completed frame
+*                scope_capture_release()  gives it back to the capture
+*              While the application holds frames the DMA continues into the
+*              remaining buffers of the pool; when none is free a frame is
+*              dropped (and counted) instead of overwriting one in use.
+*
+*              scope_capture_configure() changes the rate, acquisition time,
+*              averaging and input while the capture runs: the DMA stops, the
+*              SAR is reconfigured, the queues start over empty and the DMA
+*              resumes, without a reset. Frames completed before are discarded.
+*
+*              With SCOPE_DUAL_CORE the ADC and DMA run on the CM0+ and the
+*              same functions on the CM4 reach them over IPC (scope_ipc.h).
+*
+***********************************************************************************/
+
+#ifndef SCOPE_CAPTURE_H
+#define SCOPE_CAPTURE_H
+
+#include <stdint.h>
+#include "cy_result.h"
+
+/* Default SAR sample rate and acquisition time */
+#define SCOPE_SAMPLE_RATE_HZ     (500000u)
+#define SCOPE_ACQUISITION_NS     (100u)
+
+/* ADC codes: unsigned, full scale at the VDDA reference */
+#define SCOPE_ADC_RESOLUTION_BITS (12u)
+#define SCOPE_ADC_FULL_SCALE_MV  (3300)
+
+/* Samples per frame, the unit the DMA hands over */
+#define SCOPE_FRAME_SAMPLES      (1024u)
+
+/* Channels scanned at most; the SAR has four sample time registers, so each
+ * channel can have its own acquisition time */
+#define SCOPE_CAPTURE_CHANNELS_MAX (4u)
+
+/* Frame buffers in the pool: two are always owned by the DMA, the others can
+ * be held by the application or wait in the completed queue. Power of two. */
+#define SCOPE_CAPTURE_FRAMES     (4u)
+
+typedef struct {
+    uint32_t frames_captured;   /* frames handed to the completed queue */
+    uint32_t frames_dropped;    /* frames overwritten because no buffer was free */
+    uint32_t dma_overruns;      /* frames lost because the interrupt was late */
+    uint32_t dma_errors;        /* DMA channel error interrupts */
+} scope_capture_stats_t;
+
+/* Plane c holds the c-th scanned channel in ascending input order. Within a
+ * scan the SAR converts the channels one after the other, so plane c lags
+ * plane 0 by the acquisition and conversion times of the channels before it. */
+typedef struct {
+    uint16_t planes[SCOPE_CAPTURE_CHANNELS_MAX][SCOPE_FRAME_SAMPLES];
+} scope_frame_t;
+
+typedef struct {
+    uint32_t sample_rate_hz;    /* scans per second, every channel is sampled at this rate */
+    uint32_t acquisition_ns[SCOPE_CAPTURE_CHANNELS_MAX];   /* minimum SAR acquisition time, per plane */
+    uint16_t averaging;         /* SAR averages per sample, power of two, 1 = off */
+    uint8_t channel_mask;       /* bit n: input P10_n, up to SCOPE_CAPTURE_CHANNELS_MAX bits */
+} scope_capture_config_t;
+
+/* Configure the ADC for continuous scanning and the DMA that empties it.
+ * Capture starts stopped. */
+cy_rslt_t scope_capture_init(const scope_capture_config_t *config);
+
+/* Apply a new configuration; running capture continues with it. Call with
+ * all frames released. On failure the capture is stopped until a
+ * configuration succeeds. */
+cy_rslt_t scope_capture_configure(const scope_capture_config_t *config);
+
+void scope_capture_start(void);
+void scope_capture_stop(void);
+
+/* Oldest completed frame, or NULL: SCOPE_FRAME_SAMPLES 12-bit codes in each
+ * of the scope_capture_channels() first planes. The frame belongs to the
+ * caller until it is released. */
+const scope_frame_t *scope_capture_acquire(void);
+
+/* Return a frame obtained from scope_capture_acquire() */
+void scope_capture_release(const scope_frame_t *frame);
+
+/* Sleep until the next interrupt unless a completed frame is waiting */
+void scope_capture_wait(void);
+
+void scope_capture_get_stats(scope_capture_stats_t *stats);
+
+/* Sample rate and number of channels of the current configuration */
+uint32_t scope_capture_sample_rate(void);
+uint32_t scope_capture_channels(void);
+
+/* ADC code to millivolts */
+int32_t scope_capture_code_to_mv(uint16_t code);
+
+#endif /* SCOPE_CAPTURE_H */
@@ -0,0 +1,487 @@
+/**********************************************************************************
+* File Name:   scope_command.c
+*
+* Description: Command line parser of the runtime configuration. A command
+*              works on a copy of the settings, which replaces them only if
+*              every argument was valid.
+*
+***********************************************************************************/
+
+#include <stdio.h>
+#include <string.h>
+#include "scope_command.h"
+
+#define MAX_TOKENS                       (5u)
+
+typedef struct {
+    const char *name;
+    uint32_t value;
+} keyword_t;
+
+static const keyword_t commands[] = {
+    { "get", 0u }, { "rate", 0u }, { "acqtime", 0u }, { "avg", 0u },
+    { "channels", 0u }, { "output", 0u }, { "acquire", 0u }, { "average", 0u },
+    { NULL, 0u }
+};
+
+static const keyword_t outputs[] = {
+    { "plotter",  SCOPE_OUTPUT_PLOTTER },
+    { "stream",   SCOPE_OUTPUT_STREAM },
+    { "spectrum", SCOPE_OUTPUT_SPECTRUM },
+    { "measure",  SCOPE_OUTPUT_MEASURE },
+    { "window",   SCOPE_OUTPUT_WINDOW },
+    { NULL, 0u }
+};
+
+static const keyword_t acquire_modes[] = {
+    { "sample",  SCOPE_DECIMATE_SAMPLE },
+    { "average", SCOPE_DECIMATE_AVERAGE },
+    { "peak",    SCOPE_DECIMATE_PEAK },
+    { NULL, 0u }
+};
+
+static const keyword_t average_modes[] = {
+    { "off",      SCOPE_AVERAGE_OFF },
+    { "coherent", SCOPE_AVERAGE_COHERENT },
+    { "persist",  SCOPE_AVERAGE_PERSIST },
+    { NULL, 0u }
+};
+
+static const keyword_t trigger_types[] = {
+    { "edge",  SCOPE_TRIGGER_EDGE },
+    { "level", SCOPE_TRIGGER_LEVEL },
+    { "pulse", SCOPE_TRIGGER_PULSE },
+    { NULL, 0u }
+};
+
+static const keyword_t trigger_slopes[] = {
+    { "rising",  SCOPE_TRIGGER_RISING },
+    { "falling", SCOPE_TRIGGER_FALLING },
+    { NULL, 0u }
+};
+
+static const keyword_t trigger_modes[] = {
+    { "single", SCOPE_TRIGGER_SINGLE },
+    { "normal", SCOPE_TRIGGER_NORMAL },
+    { "auto",   SCOPE_TRIGGER_AUTO },
+    { NULL, 0u }
+};
+
+/*****************************************************************************/
+
+static int parse_keyword(const keyword_t *table, const char *text, uint32_t *value)
+{
+    for (; table->name != NULL; table++) {
+        if (strcmp(table->name, text) == 0) {
+            *value = table->value;
+            return 0;
+        }
+    }
+    return -1;
+}
+
+
+static const char *keyword_name(const keyword_t *table, uint32_t value)
+{
+    for (; table->name != NULL; table++) {
+        if (table->value == value) {
+            return table->name;
+        }
+    }
+    return "?";
+}
+
+
+/* Decimal number within [min, max] */
+static int parse_number(const char *text, uint32_t min, uint32_t max, uint32_t *value)
+{
+    uint32_t n = 0u;
+
+    if (*text == '\0') {
+        return -1;
+    }
+    for (; *text != '\0'; text++) {
+        if (*text < '0' || *text > '9' || n > (UINT32_MAX - 9u) / 10u) {
+            return -1;
+        }
+        n = n * 10u + (uint32_t)(*text - '0');
+    }
+    if (n < min || n > max) {
+        return -1;
+    }
+    *value = n;
+    return 0;
+}
+
+
+/* Comma-separated decimal numbers within [min, max], up to 'max_count' */
+static int parse_list(const char *text, uint32_t min, uint32_t max, uint32_t *values,
+                      uint32_t max_count, uint32_t *count)
+{
+    char item[SCOPE_COMMAND_LINE_MAX];
+    uint32_t n = 0u;
+
+    while (n < max_count) {
+        uint32_t length = 0u;
+
+        while (text[length] != ',' && text[length] != '\0') {
+            item[length] = text[length];
+            length++;
+        }
+        item[length] = '\0';
+        if (parse_number(item, min, max, &values[n]) != 0) {
+            return -1;
+        }
+        n++;
+        if (text[length] == '\0') {
+            *count = n;
+            return 0;
+        }
+        text += length + 1u;
+    }
+    return -1;
+}
+
+
+/* Comma-separated channel numbers to a mask */
+static int parse_channels(const char *text, uint8_t *mask)
+{
+    uint32_t channels[SCOPE_COMMAND_CHANNELS];
+    uint32_t count;
+    uint32_t bits = 0u;
+
+    if (parse_list(text, 0u, SCOPE_COMMAND_CHANNELS - 1u, channels, SCOPE_COMMAND_CHANNELS, &count) != 0) {
+        return -1;
+    }
+    for (uint32_t i = 0u; i < count; i++) {
+        bits |= 1u << channels[i];
+    }
+    *mask = (uint8_t)bits;
+    return 0;
+}
+
+
+static uint32_t channel_count(uint8_t mask)
+{
+    uint32_t count = 0u;
+
+    for (; mask != 0u; mask &= (uint8_t)(mask - 1u)) {
+        count++;
+    }
+    return count;
+}
+
+
+static void settings_format(const scope_settings_t *settings, char *reply)
+{
+    const scope_trigger_config_t *t = &settings->trigger;
+    char channels[2u * SCOPE_COMMAND_CHANNELS];
+    char times[SCOPE_COMMAND_SCAN_CHANNELS * 8u];
+    uint32_t n = 0u;
+    uint32_t length = 0u;
+
+    for (uint32_t i = 0u; i < SCOPE_COMMAND_CHANNELS; i++) {
+        if (settings->channel_mask & (1u << i)) {
+            if (n != 0u) {
+                channels[n++] = ',';
+            }
+            channels[n++] = (char)('0' + i);
+        }
+    }
+    channels[n] = '\0';
+
+    /* Acquisition times of the scanned channels */
+    times[0] = '\0';
+    for (uint32_t i = 0u; i < channel_count(settings->channel_mask); i++) {
+        length += (uint32_t)snprintf(&times[length], sizeof(times) - length, (i == 0u) ? "%lu" : ",%lu",
+                                     (unsigned long)settings->acquisition_ns[i]);
+    }
+
+    (void)snprintf(reply, SCOPE_COMMAND_REPLY_MAX,
+                   "rate %lu acqtime %s avg %u channels %s output %s acquire %s %lu "
+                   "trigger %s %s %s level %u %u pulse %lu %lu window %lu %lu auto %lu average %s %lu",
+                   (unsigned long)settings->sample_rate_hz, times,
+                   (unsigned int)settings->averaging, channels,
+                   keyword_name(outputs, settings->output),
+                   keyword_name(acquire_modes, settings->acquire_mode),
+                   (unsigned long)settings->acquire_factor,
+                   keyword_name(trigger_types, t->type), keyword_name(trigger_slopes, t->slope),
+                   keyword_name(trigger_modes, t->mode), (unsigned int)t->level,
+                   (unsigned int)t->hysteresis, (unsigned long)t->pulse_min,
+                   (unsigned long)t->pulse_max, (unsigned long)t->pre, (unsigned long)t->post,
+                   (unsigned long)settings->auto_ms,
+                   keyword_name(average_modes, settings->average_mode),
+                   (unsigned long)settings->average_frames);
+}
+
+
+/*******************************************************************************
+ * Function Name: command_trigger
+ *******************************************************************************
+ *
+ * Summary:
+ *  The "trigger" commands. Returns the changed flags, or 0 with the reason
+ *  in 'error'.
+ *
+ *******************************************************************************/
+static uint32_t command_trigger(scope_settings_t *next, char **tok, uint32_t count, const char **error)
+{
+    scope_trigger_config_t *t = &next->trigger;
+    uint32_t value, value2;
+
+    if (count == 2u && strcmp(tok[1], "arm") == 0) {
+        return SCOPE_COMMAND_ARM;
+    }
+    if (count < 3u) {
+        *error = "arguments";
+        return 0u;
+    }
+
+    if (strcmp(tok[1], "type") == 0 && count == 3u && parse_keyword(trigger_types, tok[2], &value) == 0) {
+        t->type = (scope_trigger_type_t)value;
+    }
+    else if (strcmp(tok[1], "slope") == 0 && count == 3u &&
+             parse_keyword(trigger_slopes, tok[2], &value) == 0) {
+        t->slope = (scope_trigger_slope_t)value;
+    }
+    else if (strcmp(tok[1], "mode") == 0 && count == 3u &&
+             parse_keyword(trigger_modes, tok[2], &value) == 0) {
+        t->mode = (scope_trigger_mode_t)value;
+    }
+    else if (strcmp(tok[1], "level") == 0 && count <= 4u &&
+             parse_number(tok[2], 0u, UINT16_MAX, &value) == 0 &&
+             (count == 3u || parse_number(tok[3], 0u, UINT16_MAX, &value2) == 0)) {
+        t->level = (uint16_t)value;
+        if (count == 4u) {
+            t->hysteresis = (uint16_t)value2;
+        }
+    }
+    else if (strcmp(tok[1], "pulse") == 0 && count == 4u &&
+             parse_number(tok[2], 0u, UINT32_MAX, &value) == 0 &&
+             parse_number(tok[3], 0u, UINT32_MAX, &value2) == 0) {
+        t->pulse_min = value;
+        t->pulse_max = value2;
+    }
+    else if (strcmp(tok[1], "window") == 0 && count == 4u &&
+             parse_number(tok[2], 0u, SCOPE_TRIGGER_HISTORY, &value) == 0 &&
+             parse_number(tok[3], 0u, SCOPE_TRIGGER_HISTORY, &value2) == 0) {
+        t->pre = value;
+        t->post = value2;
+    }
+    else if (strcmp(tok[1], "auto") == 0 && count == 3u &&
+             parse_number(tok[2], 1u, SCOPE_COMMAND_AUTO_MAX_MS, &value) == 0) {
+        next->auto_ms = value;
+    }
+    else {
+        *error = "arguments";
+        return 0u;
+    }
+
+    if (scope_trigger_check(t) != 0) {
+        *error = "trigger";
+        return 0u;
+    }
+    return SCOPE_COMMAND_CHANGED_TRIGGER;
+}
+
+
+void scope_command_init(scope_command_t *command)
+{
+    command->length = 0u;
+    command->overflow = 0u;
+}
+
+
+int scope_command_input(scope_command_t *command, char c)
+{
+    if (c == '\r' || c == '\n') {
+        int complete = (command->length != 0u && !command->overflow);
+
+        /* The LF of a CR LF ends an empty line and keeps the complete one */
+        if (complete) {
+            command->line[command->length] = '\0';
+        }
+        command->length = 0u;
+        command->overflow = 0u;
+        return complete;
+    }
+    if (command->length < SCOPE_COMMAND_LINE_MAX - 1u) {
+        command->line[command->length++] = c;
+    }
+    else {
+        command->overflow = 1u;
+    }
+    return 0;
+}
+
+
+void scope_command_output_acquire(scope_settings_t *settings, uint8_t output)
+{
+    /* The stream carries about 60 kS/s of 12-bit samples at the link rate,
+     * so it averages the ADC down by 10; the plotter keeps glitches with
+     * peak detection; spectrum and measurements want every sample */
+    switch (output) {
+    case SCOPE_OUTPUT_STREAM:
+        settings->acquire_mode = SCOPE_DECIMATE_AVERAGE;
+        settings->acquire_factor = 10u;
+        break;
+    case SCOPE_OUTPUT_PLOTTER:
+        settings->acquire_mode = SCOPE_DECIMATE_PEAK;
+        settings->acquire_factor = 1u;
+        break;
+    default:
+        settings->acquire_mode = SCOPE_DECIMATE_SAMPLE;
+        settings->acquire_factor = 1u;
+        break;
+    }
+}
+
+
+uint32_t scope_command_auto_samples(const scope_settings_t *settings)
+{
+    return (uint32_t)(((uint64_t)settings->sample_rate_hz * settings->auto_ms) /
+                      (1000u * settings->acquire_factor));
+}
+
+
+/*******************************************************************************
+ * Function Name: scope_command_execute
+ *******************************************************************************
+ *
+ * Summary:
+ *  Split the line into words, apply the command to a copy of the settings
+ *  and keep the copy if it is valid.
+ *
+ *******************************************************************************/
+uint32_t scope_command_execute(scope_settings_t *settings, const char *line, char *reply)
+{
+    char words[SCOPE_COMMAND_LINE_MAX];
+    char *tok[MAX_TOKENS];
+    uint32_t count = 0u;
+    scope_settings_t next = *settings;
+    const char *error = "arguments";
+    uint32_t changed = 0u;
+    uint32_t values[SCOPE_COMMAND_SCAN_CHANNELS];
+    uint32_t value;
+    char *p;
+
+    (void)strncpy(words, line, sizeof(words) - 1u);
+    words[sizeof(words) - 1u] = '\0';
+    for (p = words; *p != '\0';) {
+        while (*p == ' ' || *p == '\t') {
+            *p++ = '\0';
+        }
+        if (*p == '\0') {
+            break;
+        }
+        if (count == MAX_TOKENS) {
+            (void)snprintf(reply, SCOPE_COMMAND_REPLY_MAX, "ERR arguments");
+            return 0u;
+        }
+        tok[count++] = p;
+        while (*p != '\0' && *p != ' ' && *p != '\t') {
+            p++;
+        }
+    }
+    if (count == 0u) {
+        (void)snprintf(reply, SCOPE_COMMAND_REPLY_MAX, "ERR empty");
+        return 0u;
+    }
+
+    if (strcmp(tok[0], "get") == 0 && count == 1u) {
+        settings_format(settings, reply);
+        return 0u;
+    }
+    else if (strcmp(tok[0], "rate") == 0 && count == 2u &&
+             parse_number(tok[1], SCOPE_COMMAND_RATE_MIN_HZ, SCOPE_COMMAND_RATE_MAX_HZ, &value) == 0) {
+        next.sample_rate_hz = value;
+        changed = SCOPE_COMMAND_CHANGED_CAPTURE | SCOPE_COMMAND_CHANGED_TRIGGER;
+    }
+    else if (strcmp(tok[0], "acqtime") == 0 && count == 2u &&
+             parse_list(tok[1], SCOPE_COMMAND_ACQ_MIN_NS, SCOPE_COMMAND_ACQ_MAX_NS, values,
+                        SCOPE_COMMAND_SCAN_CHANNELS, &value) == 0) {
+        /* One time for every channel, or one per channel in scan order */
+        for (uint32_t i = 0u; i < SCOPE_COMMAND_SCAN_CHANNELS; i++) {
+            next.acquisition_ns[i] = values[(value == 1u) ? 0u : ((i < value) ? i : value - 1u)];
+        }
+        changed = SCOPE_COMMAND_CHANGED_CAPTURE;
+    }
+    else if (strcmp(tok[0], "avg") == 0 && count == 2u &&
+             parse_number(tok[1], 1u, SCOPE_COMMAND_AVG_MAX, &value) == 0) {
+        if ((value & (value - 1u)) != 0u) {
+            error = "power of two";
+        }
+        else {
+            next.averaging = (uint16_t)value;
+            changed = SCOPE_COMMAND_CHANGED_CAPTURE;
+        }
+    }
+    else if (strcmp(tok[0], "channels") == 0 && count == 2u &&
+             parse_channels(tok[1], &next.channel_mask) == 0) {
+        if (channel_count(next.channel_mask) > SCOPE_COMMAND_SCAN_CHANNELS) {
+            error = "too many channels";
+        }
+        else {
+            changed = SCOPE_COMMAND_CHANGED_CAPTURE;
+        }
+    }
+    else if (strcmp(tok[0], "output") == 0 && count == 2u &&
+             parse_keyword(outputs, tok[1], &value) == 0) {
+        next.output = (uint8_t)value;
+        scope_command_output_acquire(&next, next.output);
+        changed = SCOPE_COMMAND_CHANGED_OUTPUT | SCOPE_COMMAND_CHANGED_ACQUIRE |
+                  SCOPE_COMMAND_CHANGED_TRIGGER;
+    }
+    else if (strcmp(tok[0], "acquire") == 0 && count == 3u &&
+             parse_keyword(acquire_modes, tok[1], &value) == 0 &&
+             parse_number(tok[2], 1u, SCOPE_COMMAND_FACTOR_MAX, &next.acquire_factor) == 0) {
+        next.acquire_mode = (scope_decimate_mode_t)value;
+        if (next.acquire_mode == SCOPE_DECIMATE_PEAK &&
+            (next.output == SCOPE_OUTPUT_SPECTRUM || next.output == SCOPE_OUTPUT_MEASURE)) {
+            error = "peak needs plotter, stream or window";
+        }
+        else {
+            changed = SCOPE_COMMAND_CHANGED_ACQUIRE | SCOPE_COMMAND_CHANGED_TRIGGER;
+        }
+    }
+    else if (strcmp(tok[0], "average") == 0 && (count == 2u || count == 3u) &&
+             parse_keyword(average_modes, tok[1], &value) == 0 &&
+             (count == 2u || parse_number(tok[2], 1u, SCOPE_AVERAGE_MAX_FRAMES, &next.average_frames) == 0)) {
+        /* OFF takes no count; the others keep the last one */
+        next.average_mode = (scope_average_mode_t)value;
+        if (next.average_mode == SCOPE_AVERAGE_OFF) {
+            next.average_frames = 1u;
+        }
+        if (count == 3u && next.average_mode == SCOPE_AVERAGE_OFF) {
+            error = "arguments";
+        }
+        else if (next.average_mode == SCOPE_AVERAGE_PERSIST &&
+                 (next.average_frames < 2u || (next.average_frames & (next.average_frames - 1u)) != 0u)) {
+            error = "power of two";
+        }
+        else {
+            changed = SCOPE_COMMAND_CHANGED_AVERAGE;
+        }
+    }
+    else if (strcmp(tok[0], "trigger") == 0) {
+        changed = command_trigger(&next, tok, count, &error);
+    }
+    else {
+        error = (parse_keyword(commands, tok[0], &value) == 0) ? "arguments" : "unknown command";
+    }
+
+    /* The SAR converts the channels of a scan one after the other */
+    if ((changed & SCOPE_COMMAND_CHANGED_CAPTURE) &&
+        (uint64_t)next.sample_rate_hz * channel_count(next.channel_mask) > SCOPE_COMMAND_RATE_MAX_HZ) {
+        error = "rate too high for the channels";
+        changed = 0u;
+    }
+    if (changed == 0u) {
+        (void)snprintf(reply, SCOPE_COMMAND_REPLY_MAX, "ERR %s", error);
+        return 0u;
+    }
+    next.trigger.auto_timeout = scope_command_auto_samples(&next);
+    *settings = next;
+    (void)snprintf(reply, SCOPE_COMMAND_REPLY_MAX, "OK");
+    return changed;
+}
@@ -0,0 +1,109 @@
+/**********************************************************************************
+* File Name:   scope_command.h
+*
+* Description: Runtime configuration of the oscilloscope. The PC sends text
+*              commands over the debug UART, one per line; each one changes
+*              the settings below and is answered with one line: "OK", the
+*              settings for "get", or "ERR <reason>", in which case nothing
+*              changed. The caller applies what a command changed (the
+*              SCOPE_COMMAND_CHANGED_* flags) to the capture, the acquisition,
+*              the trigger and the output.
+*
+*                rate <hz>                       SAR scans per second
+*                acqtime <ns>[,<ns>...]          SAR acquisition time, for all
+*                                                channels or per channel
+*                avg <count>                     SAR averages per sample, 1 .. 256
+*                channels <n>[,<n>...]           SAR inputs P10_<n>, up to four
+*                output plotter|stream|spectrum|measure|window
+*                acquire sample|average|peak <factor>
+*                trigger type edge|level|pulse
+*                trigger slope rising|falling
+*                trigger mode single|normal|auto
+*                trigger level <code> [<hysteresis>]
+*                trigger pulse <min> <max>       widths in samples
+*                trigger window <pre> <post>
+*                trigger auto <ms>               AUTO timeout
+*                trigger arm
+*                average off|coherent|persist [<n>]   over n trigger windows
+*                get
+*
+*              "output" also sets the acquisition mode that suits the output;
+*              an "acquire" afterwards overrides it. Parsing does not depend
+*              on the hardware.
+*
+***********************************************************************************/
+
+#ifndef SCOPE_COMMAND_H
+#define SCOPE_COMMAND_H
+
+#include <stdint.h>
+#include "scope_decimate.h"
+#include "scope_trigger.h"
+#include "scope_average.h"
+
+/* Outputs of the scope */
+#define SCOPE_OUTPUT_PLOTTER             (0u)   /* trigger windows as text for the serial plotter */
+#define SCOPE_OUTPUT_STREAM              (1u)   /* every sample as binary packets */
+#define SCOPE_OUTPUT_SPECTRUM            (2u)   /* averaged spectra as binary packets */
+#define SCOPE_OUTPUT_MEASURE             (3u)   /* measurement records as text for the serial plotter */
+#define SCOPE_OUTPUT_WINDOW              (4u)   /* trigger windows as binary packets */
+
+/* Limits */
+#define SCOPE_COMMAND_LINE_MAX           (80u)
+#define SCOPE_COMMAND_REPLY_MAX          (256u)
+#define SCOPE_COMMAND_RATE_MIN_HZ        (1000u)
+#define SCOPE_COMMAND_RATE_MAX_HZ        (1000000u)   /* conversions per second of all channels */
+#define SCOPE_COMMAND_ACQ_MIN_NS         (50u)
+#define SCOPE_COMMAND_ACQ_MAX_NS         (100000u)
+#define SCOPE_COMMAND_AVG_MAX            (256u)
+#define SCOPE_COMMAND_CHANNELS           (8u)
+#define SCOPE_COMMAND_SCAN_CHANNELS      (4u)   /* channels scanned at a time, SCOPE_CAPTURE_CHANNELS_MAX */
+#define SCOPE_COMMAND_AUTO_MAX_MS        (10000u)
+#define SCOPE_COMMAND_FACTOR_MAX         (65535u)   /* the factor field of a stream packet */
+
+/* What a command changed */
+#define SCOPE_COMMAND_CHANGED_CAPTURE    (0x01u)   /* rate, acquisition time, averaging, channels */
+#define SCOPE_COMMAND_CHANGED_ACQUIRE    (0x02u)
+#define SCOPE_COMMAND_CHANGED_TRIGGER    (0x04u)
+#define SCOPE_COMMAND_CHANGED_OUTPUT     (0x08u)
+#define SCOPE_COMMAND_ARM                (0x10u)   /* re-arm the trigger */
+#define SCOPE_COMMAND_CHANGED_AVERAGE    (0x20u)   /* window averaging */
+
+typedef struct {
+    uint32_t sample_rate_hz;
+    uint32_t acquisition_ns[SCOPE_COMMAND_SCAN_CHANNELS];   /* per scanned channel */
+    uint16_t averaging;
+    uint8_t channel_mask;      /* bit n: P10_n */
+    uint8_t output;            /* SCOPE_OUTPUT_* */
+    scope_decimate_mode_t acquire_mode;
+    uint32_t acquire_factor;
+    scope_trigger_config_t trigger;   /* auto_timeout is set from auto_ms */
+    uint32_t auto_ms;
+    scope_average_mode_t average_mode;   /* of the trigger windows */
+    uint32_t average_frames;
+} scope_settings_t;
+
+typedef struct {
+    char line[SCOPE_COMMAND_LINE_MAX];
+    uint32_t length;
+    uint8_t overflow;          /* the line was too long, it is discarded */
+} scope_command_t;
+
+void scope_command_init(scope_command_t *command);
+
+/* Collect one received character. Returns 1 when a line is complete, in
+ * command->line; CR, LF or both end a line. */
+int scope_command_input(scope_command_t *command, char c);
+
+/* Execute a command line on 'settings' and write the reply line (without
+ * line end) to 'reply', which holds SCOPE_COMMAND_REPLY_MAX. Returns the
+ * SCOPE_COMMAND_CHANGED_* flags, 0 for errors and queries. */
+uint32_t scope_command_execute(scope_settings_t *settings, const char *line, char *reply);
+
+/* Acquisition mode and factor that suit an output */
+void scope_command_output_acquire(scope_settings_t *settings, uint8_t output);
+
+/* Trigger AUTO timeout in samples for the current rate and acquisition */
+uint32_t scope_command_auto_samples(const scope_settings_t *settings);
+
+#endif /* SCOPE_COMMAND_H */
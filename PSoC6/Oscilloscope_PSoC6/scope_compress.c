@@ -0,0 +1,141 @@
+/**********************************************************************************
+* File Name:   scope_compress.c
+*
+* Description: Delta, zigzag and group width packing of sample blocks, see
+*              scope_compress.h for the format. A group is first reduced to
+*              its zigzag differences and their OR, which gives the width;
+*              the values then go through a 32-bit bit accumulator that is
+*              written out a byte at a time.
+*
+***********************************************************************************/
+
+#include "scope_compress.h"
+
+#define COMPRESS_SAMPLE_MASK            (0xFFFu)
+#define COMPRESS_WIDTH_BITS             (4u)
+#define COMPRESS_WIDTH_MAX              (12u)
+
+/*****************************************************************************/
+
+typedef struct {
+    uint8_t *out;
+    uint32_t length;
+    uint32_t acc;
+    uint32_t bits;
+} bit_writer_t;
+
+
+static void bits_put(bit_writer_t *writer, uint32_t value, uint32_t width)
+{
+    writer->acc |= value << writer->bits;
+    writer->bits += width;
+    while (writer->bits >= 8u) {
+        writer->out[writer->length++] = (uint8_t)writer->acc;
+        writer->acc >>= 8;
+        writer->bits -= 8u;
+    }
+}
+
+
+/*******************************************************************************
+ * Function Name: scope_compress_encode
+ *******************************************************************************
+ *
+ * Summary:
+ *  Group by group: zigzag the differences modulo 4096, find the width from
+ *  their OR, check the limit and pack. The zigzag of a 12-bit difference d is
+ *  (d << 1) XOR (all ones if d is negative), kept to 12 bits.
+ *
+ *******************************************************************************/
+uint32_t scope_compress_encode(uint8_t *out, uint32_t limit, const uint16_t *samples, uint32_t count)
+{
+    bit_writer_t writer = { out, 0u, 0u, 0u };
+    uint16_t zigzag[SCOPE_COMPRESS_BLOCK];
+    uint32_t previous = 0u;
+
+    for (uint32_t start = 0u; start < count; start += SCOPE_COMPRESS_BLOCK) {
+        uint32_t n = count - start;
+        uint32_t any = 0u;
+        uint32_t width = 0u;
+
+        if (n > SCOPE_COMPRESS_BLOCK) {
+            n = SCOPE_COMPRESS_BLOCK;
+        }
+        for (uint32_t i = 0u; i < n; i++) {
+            uint32_t sample = samples[start + i] & COMPRESS_SAMPLE_MASK;
+            uint32_t d = (sample - previous) & COMPRESS_SAMPLE_MASK;
+            uint32_t z = ((d << 1) ^ (0u - (d >> 11))) & COMPRESS_SAMPLE_MASK;
+
+            zigzag[i] = (uint16_t)z;
+            any |= z;
+            previous = sample;
+        }
+        while ((any >> width) != 0u) {
+            width++;
+        }
+
+        if ((writer.length + ((writer.bits + COMPRESS_WIDTH_BITS + (width * n) + 7u) / 8u)) > limit) {
+            return 0u;
+        }
+        bits_put(&writer, width, COMPRESS_WIDTH_BITS);
+        if (width != 0u) {
+            for (uint32_t i = 0u; i < n; i++) {
+                bits_put(&writer, zigzag[i], width);
+            }
+        }
+    }
+
+    if (writer.bits != 0u) {
+        out[writer.length++] = (uint8_t)writer.acc;
+    }
+    return writer.length;
+}
+
+
+int32_t scope_compress_decode(const uint8_t *data, uint32_t length, uint16_t *samples, uint32_t count)
+{
+    uint32_t used = 0u;
+    uint32_t acc = 0u;
+    uint32_t bits = 0u;
+    uint32_t previous = 0u;
+
+    for (uint32_t start = 0u; start < count; start += SCOPE_COMPRESS_BLOCK) {
+        uint32_t n = count - start;
+        uint32_t width;
+
+        if (n > SCOPE_COMPRESS_BLOCK) {
+            n = SCOPE_COMPRESS_BLOCK;
+        }
+        while (bits < COMPRESS_WIDTH_BITS) {
+            if (used == length) {
+                return -1;
+            }
+            acc |= (uint32_t)data[used++] << bits;
+            bits += 8u;
+        }
+        width = acc & ((1u << COMPRESS_WIDTH_BITS) - 1u);
+        acc >>= COMPRESS_WIDTH_BITS;
+        bits -= COMPRESS_WIDTH_BITS;
+        if (width > COMPRESS_WIDTH_MAX) {
+            return -1;
+        }
+
+        for (uint32_t i = 0u; i < n; i++) {
+            uint32_t z;
+
+            while (bits < width) {
+                if (used == length) {
+                    return -1;
+                }
+                acc |= (uint32_t)data[used++] << bits;
+                bits += 8u;
+            }
+            z = acc & ((1u << width) - 1u);
+            acc >>= width;
+            bits -= width;
+            previous = (previous + ((z >> 1) ^ (0u - (z & 1u)))) & COMPRESS_SAMPLE_MASK;
+            samples[start + i] = (uint16_t)previous;
+        }
+    }
+    return (int32_t)used;
+}
@@ -0,0 +1,46 @@
+/**********************************************************************************
+* File Name:   scope_compress.h
+*
+* Description: Lossless compression of 12-bit sample blocks for the stream.
+*              Every sample is replaced by its difference to the previous one
+*              (modulo 4096, so any difference fits 12 bits signed), the
+*              difference is zigzag mapped to an unsigned value, and groups of
+*              SCOPE_COMPRESS_BLOCK values are packed at the width of the
+*              largest value of the group:
+*
+*                4 bits       width w of the group, 0 .. 12
+*                n x w bits   the zigzag differences, first sample first
+*
+*              Bits are packed from the least significant bit of every byte
+*              up. The first difference is taken to 0. A group of constant
+*              samples takes 4 bits; noise of +-k codes takes about
+*              log2(4k) bits per sample. The worst case is 12 bits per sample
+*              plus the group widths, SCOPE_COMPRESS_BYTES_MAX(), and the cost
+*              is a fixed amount of integer work per sample.
+*
+*              Encoding and decoding do not depend on the hardware; the host
+*              tools use this file.
+*
+***********************************************************************************/
+
+#ifndef SCOPE_COMPRESS_H
+#define SCOPE_COMPRESS_H
+
+#include <stdint.h>
+
+/* Samples per group with a common width */
+#define SCOPE_COMPRESS_BLOCK            (16u)
+
+/* Bytes that 'count' samples take at most */
+#define SCOPE_COMPRESS_BYTES_MAX(count) \
+    ((((((count) + SCOPE_COMPRESS_BLOCK - 1u) / SCOPE_COMPRESS_BLOCK) * 4u) + ((count) * 12u) + 7u) / 8u)
+
+/* Compress 'count' 12-bit samples into 'out'. Stops as soon as the result
+ * would exceed 'limit' bytes and returns 0; otherwise returns its length. */
+uint32_t scope_compress_encode(uint8_t *out, uint32_t limit, const uint16_t *samples, uint32_t count);
+
+/* Restore 'count' samples from the 'length' bytes at 'data'. Returns the
+ * bytes used, or -1 if the data ends early or holds a bad width. */
+int32_t scope_compress_decode(const uint8_t *data, uint32_t length, uint16_t *samples, uint32_t count);
+
+#endif /* SCOPE_COMPRESS_H */
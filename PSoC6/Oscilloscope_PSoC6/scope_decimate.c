@@ -0,0 +1,119 @@
+/**********************************************************************************
+* File Name:   scope_decimate.c
+*
+* Description: Streaming bucket reduction for the acquisition modes. Input is
+*              processed in runs up to the end of the current bucket, and
+*              each mode has its own loop over a run, so the per-sample work
+*              is one add (AVERAGE), two compares (PEAK) or nothing (SAMPLE
+*              only looks at the first sample of a bucket).
+*
+***********************************************************************************/
+
+#include "scope_decimate.h"
+
+
+static void bucket_clear(scope_decimate_t *decimate)
+{
+    decimate->fill = 0u;
+    decimate->sum = 0u;
+    decimate->min = UINT16_MAX;
+    decimate->max = 0u;
+}
+
+
+int scope_decimate_init(scope_decimate_t *decimate, scope_decimate_mode_t mode, uint32_t factor)
+{
+    if (factor == 0u || factor > SCOPE_DECIMATE_MAX_FACTOR) {
+        return -1;
+    }
+    decimate->mode = mode;
+    decimate->factor = factor;
+    bucket_clear(decimate);
+    return 0;
+}
+
+
+void scope_decimate_reset(scope_decimate_t *decimate)
+{
+    bucket_clear(decimate);
+}
+
+
+/*******************************************************************************
+ * Function Name: scope_decimate_run
+ *******************************************************************************
+ *
+ * Summary:
+ *  Add the input to the current bucket run by run; every time a bucket is
+ *  full its result is written and a new bucket starts.
+ *
+ *******************************************************************************/
+uint32_t scope_decimate_run(scope_decimate_t *decimate, const uint16_t *in, uint32_t count,
+                            uint16_t *out)
+{
+    uint32_t produced = 0u;
+    uint32_t i = 0u;
+
+    while (i < count) {
+        uint32_t n = decimate->factor - decimate->fill;
+        const uint16_t *p = &in[i];
+
+        if (n > (count - i)) {
+            n = count - i;
+        }
+
+        switch (decimate->mode) {
+        case SCOPE_DECIMATE_AVERAGE: {
+            uint32_t sum = decimate->sum;
+
+            for (uint32_t k = 0u; k < n; k++) {
+                sum += p[k];
+            }
+            decimate->sum = sum;
+            break;
+        }
+
+        case SCOPE_DECIMATE_PEAK: {
+            uint16_t min = decimate->min;
+            uint16_t max = decimate->max;
+
+            for (uint32_t k = 0u; k < n; k++) {
+                min = (p[k] < min) ? p[k] : min;
+                max = (p[k] > max) ? p[k] : max;
+            }
+            decimate->min = min;
+            decimate->max = max;
+            break;
+        }
+
+        default: /* SCOPE_DECIMATE_SAMPLE */
+            if (decimate->fill == 0u) {
+                decimate->min = p[0];
+            }
+            break;
+        }
+
+        i += n;
+        decimate->fill += n;
+        if (decimate->fill < decimate->factor) {
+            break;
+        }
+
+        switch (decimate->mode) {
+        case SCOPE_DECIMATE_AVERAGE:
+            out[produced++] = (uint16_t)((decimate->sum + (decimate->factor / 2u)) / decimate->factor);
+            break;
+
+        case SCOPE_DECIMATE_PEAK:
+            out[produced++] = decimate->min;
+            out[produced++] = decimate->max;
+            break;
+
+        default: /* SCOPE_DECIMATE_SAMPLE */
+            out[produced++] = decimate->min;
+            break;
+        }
+        bucket_clear(decimate);
+    }
+    return produced;
+}
@@ -0,0 +1,55 @@
+/**********************************************************************************
+* File Name:   scope_decimate.h
+*
+* Description: Acquisition modes for timebases slower than the ADC rate. The
+*              captured samples are reduced over buckets of 'factor' samples:
+*                SAMPLE   the first sample of each bucket
+*                AVERAGE  the rounded mean of each bucket
+*                PEAK     the minimum and then the maximum of each bucket, so
+*                         a glitch of a single sample still shows up
+*              The reduction streams: buckets may span frames, the state is
+*              carried over, and the cost per input sample is constant. The
+*              output is again a stream of ADC codes (two per bucket in PEAK
+*              mode) that can be fed to the trigger like captured frames.
+*
+***********************************************************************************/
+
+#ifndef SCOPE_DECIMATE_H
+#define SCOPE_DECIMATE_H
+
+#include <stdint.h>
+
+/* Largest bucket; keeps the AVERAGE sum of 16-bit codes within 32 bits */
+#define SCOPE_DECIMATE_MAX_FACTOR    (65536u)
+
+/* Output samples that 'count' input samples can produce at most */
+#define SCOPE_DECIMATE_OUT_MAX(count, factor)    (2u * (((count) / (factor)) + 1u))
+
+typedef enum {
+    SCOPE_DECIMATE_SAMPLE,
+    SCOPE_DECIMATE_AVERAGE,
+    SCOPE_DECIMATE_PEAK
+} scope_decimate_mode_t;
+
+typedef struct {
+    scope_decimate_mode_t mode;
+    uint32_t factor;           /* input samples per bucket */
+    uint32_t fill;             /* samples in the current bucket */
+    uint32_t sum;
+    uint16_t min;
+    uint16_t max;
+} scope_decimate_t;
+
+/* Returns -1 for a factor of 0 or above SCOPE_DECIMATE_MAX_FACTOR */
+int scope_decimate_init(scope_decimate_t *decimate, scope_decimate_mode_t mode, uint32_t factor);
+
+/* Drop a partly filled bucket, e.g. after samples were lost */
+void scope_decimate_reset(scope_decimate_t *decimate);
+
+/* Reduce 'count' samples. Completed buckets are written to 'out', which must
+ * hold SCOPE_DECIMATE_OUT_MAX(count, factor) samples; returns how many were
+ * written. */
+uint32_t scope_decimate_run(scope_decimate_t *decimate, const uint16_t *in, uint32_t count,
+                            uint16_t *out);
+
+#endif /* SCOPE_DECIMATE_H */
@@ -0,0 +1,77 @@
+/**********************************************************************************
+* File Name:   scope_ipc.h
+*
+* Description: Capture split between the cores (SCOPE_DUAL_CORE). The CM0+
+*              runs the ADC, the DMA and its interrupt; the CM4 owns the frame
+*              pool in its SRAM and does all processing. Both cores work on
+*              the same pool: frames and the queues of frame indices are
+*              shared, each queue index is written by one core only, and the
+*              PSoC 6 SRAM is not cached, so the barriers of the queue
+*              operations are all the cores need.
+*
+*              The system IPC pipe carries the messages between them. The CM4
+*              sends commands (attach to the pool, apply the configuration
+*              in the pool, start, stop), which the CM0+ executes outside the
+*              interrupt and acknowledges in the pool. The CM0+ rings the CM4 after every
+*              completed frame; the message only wakes the CM4, the frame
+*              itself is in the completed queue, so a notification that finds
+*              the pipe busy is skipped without losing the frame.
+*
+***********************************************************************************/
+
+#ifndef SCOPE_IPC_H
+#define SCOPE_IPC_H
+
+#include "cy_result.h"
+#include "scope_capture.h"
+
+/* Client of the system pipe on both cores (CY_SYS_CYPIPE_CLIENT_CNT) */
+#define SCOPE_IPC_CLIENT_ID          (4u)
+
+/* Commands (CM4 -> CM0+) and notifications (CM0+ -> CM4) */
+#define SCOPE_IPC_CMD_ATTACH         (1u)
+#define SCOPE_IPC_CMD_START          (2u)
+#define SCOPE_IPC_CMD_STOP           (3u)
+#define SCOPE_IPC_CMD_CONFIGURE      (4u)
+#define SCOPE_IPC_FRAME_READY        (5u)
+
+/* How long the CM4 waits for a command to be acknowledged */
+#define SCOPE_IPC_TIMEOUT_MS         (100u)
+
+/* Result of a command the CM0+ did not acknowledge in time */
+#define SCOPE_IPC_RSLT_TIMEOUT       (CY_RSLT_CREATE(CY_RSLT_TYPE_ERROR, CY_RSLT_MODULE_MIDDLEWARE_BASE, 0x5Cu))
+
+/* Single-producer/single-consumer ring of frame indices */
+typedef struct {
+    uint8_t slots[SCOPE_CAPTURE_FRAMES];
+    volatile uint32_t head;   /* written by the producer only */
+    volatile uint32_t tail;   /* written by the consumer only */
+} scope_frame_ring_t;
+
+typedef struct {
+    scope_frame_t frames[SCOPE_CAPTURE_FRAMES];
+    scope_frame_ring_t completed;             /* DMA interrupt -> application */
+    scope_frame_ring_t free;                  /* application -> DMA interrupt */
+    volatile scope_capture_stats_t stats;     /* written by the DMA interrupt */
+    scope_capture_config_t config;            /* written by the CM4 before ATTACH and CONFIGURE */
+    volatile uint32_t commands_done;          /* commands acknowledged by the CM0+ */
+    volatile cy_rslt_t command_result;        /* result of the last one */
+} scope_capture_pool_t;
+
+/* Pipe message; the first word is the client, the user code (command) and
+ * the release mask the pipe driver fills in */
+typedef struct {
+    uint8_t client_id;
+    uint8_t command;
+    uint16_t intr_mask;
+    uint32_t value;                           /* frames captured */
+    scope_capture_pool_t *pool;
+} scope_ipc_msg_t;
+
+/* CM0+: take commands from the pipe */
+void scope_capture_server_init(void);
+
+/* CM0+: execute a pending command, or sleep until the next interrupt */
+void scope_capture_serve(void);
+
+#endif /* SCOPE_IPC_H */
@@ -0,0 +1,149 @@
+/**********************************************************************************
+* File Name:   scope_link.c
+*
+* Description: Packet transmission through the HAL UART in DMA mode. A packet
+*              buffer is either free, queued or being sent; packets leave in
+*              the order they were queued, and the CPU is only involved to
+*              encode a packet and to start its transfer.
+*
+***********************************************************************************/
+
+#include "cy_pdl.h"
+#include "cyhal.h"
+#include "cy_retarget_io.h"
+#include "scope_link.h"
+
+#define LINK_BUFFERS                     (2u)
+#define LINK_BUFFER_BYTES                SCOPE_STREAM_PACKET_BYTES(SCOPE_LINK_MAX_SAMPLES)
+
+/*****************************************************************************/
+
+static uint8_t link_buffers[LINK_BUFFERS][LINK_BUFFER_BYTES];
+static uint32_t link_length[LINK_BUFFERS];   /* bytes of a queued packet, 0 = free */
+static uint32_t link_uncompressed[LINK_BUFFERS];
+static uint32_t link_sending;                /* buffer in transfer, LINK_BUFFERS = none */
+static uint32_t link_next;                   /* buffer queued last */
+static uint16_t link_sequence;
+static scope_link_stats_t link_stats;
+
+
+cy_rslt_t scope_link_init(void)
+{
+    cy_rslt_t result;
+    uint32_t actual_baud;
+
+    result = cyhal_uart_set_baud(&cy_retarget_io_uart_obj, SCOPE_LINK_BAUD, &actual_baud);
+    if (result != CY_RSLT_SUCCESS) {
+        return result;
+    }
+    result = cyhal_uart_set_async_mode(&cy_retarget_io_uart_obj, CYHAL_ASYNC_DMA,
+                                       CYHAL_DMA_PRIORITY_DEFAULT);
+    if (result != CY_RSLT_SUCCESS) {
+        return result;
+    }
+
+    for (uint32_t i = 0u; i < LINK_BUFFERS; i++) {
+        link_length[i] = 0u;
+    }
+    link_sending = LINK_BUFFERS;
+    link_next = 0u;
+    link_sequence = 0u;
+    link_stats.packets_sent = 0u;
+    link_stats.packets_dropped = 0u;
+    link_stats.bytes_sent = 0u;
+    link_stats.bytes_uncompressed = 0u;
+    return CY_RSLT_SUCCESS;
+}
+
+
+/*******************************************************************************
+ * Function Name: scope_link_poll
+ *******************************************************************************
+ *
+ * Summary:
+ *  Free the buffer of a finished transfer and start the queued packet. With
+ *  two buffers the queued packet is always the one queued last. A packet the
+ *  UART refuses is dropped.
+ *
+ *******************************************************************************/
+void scope_link_poll(void)
+{
+    if (link_sending != LINK_BUFFERS) {
+        if (cyhal_uart_is_tx_active(&cy_retarget_io_uart_obj)) {
+            return;
+        }
+        link_length[link_sending] = 0u;
+        link_sending = LINK_BUFFERS;
+    }
+
+    if (link_length[link_next] == 0u) {
+        return;
+    }
+    if (cyhal_uart_write_async(&cy_retarget_io_uart_obj, link_buffers[link_next],
+                               link_length[link_next]) == CY_RSLT_SUCCESS) {
+        link_sending = link_next;
+        link_stats.packets_sent++;
+        link_stats.bytes_sent += link_length[link_next];
+        link_stats.bytes_uncompressed += link_uncompressed[link_next];
+    }
+    else {
+        link_length[link_next] = 0u;
+        link_stats.packets_dropped++;
+    }
+}
+
+
+void scope_link_drain(void)
+{
+    while (link_sending != LINK_BUFFERS || link_length[link_next] != 0u) {
+        scope_link_poll();
+    }
+}
+
+
+cy_rslt_t scope_link_close(void)
+{
+    cy_rslt_t result;
+    uint32_t actual_baud;
+
+    scope_link_drain();
+    result = cyhal_uart_set_async_mode(&cy_retarget_io_uart_obj, CYHAL_ASYNC_SW,
+                                       CYHAL_DMA_PRIORITY_DEFAULT);
+    if (result != CY_RSLT_SUCCESS) {
+        return result;
+    }
+    return cyhal_uart_set_baud(&cy_retarget_io_uart_obj, CY_RETARGET_IO_BAUDRATE, &actual_baud);
+}
+
+
+bool scope_link_send(scope_stream_header_t *header, const uint16_t *samples)
+{
+    uint32_t buffer;
+
+    header->sequence = link_sequence++;
+#if SCOPE_LINK_COMPRESS
+    header->flags |= SCOPE_STREAM_FLAG_COMPRESSED;
+#endif
+    if (header->count > SCOPE_LINK_MAX_SAMPLES) {
+        link_stats.packets_dropped++;
+        return false;
+    }
+
+    scope_link_poll();
+    buffer = (link_next + 1u) % LINK_BUFFERS;
+    if (link_length[buffer] != 0u) {
+        link_stats.packets_dropped++;
+        return false;
+    }
+    link_length[buffer] = scope_stream_encode(link_buffers[buffer], header, samples);
+    link_uncompressed[buffer] = SCOPE_STREAM_PACKET_BYTES(header->count);
+    link_next = buffer;
+    scope_link_poll();
+    return true;
+}
+
+
+void scope_link_get_stats(scope_link_stats_t *stats)
+{
+    *stats = link_stats;
+}
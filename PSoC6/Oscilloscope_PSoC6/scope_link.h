@@ -0,0 +1,64 @@
+/**********************************************************************************
+* File Name:   scope_link.h
+*
+* Description: Sends waveform packets (scope_stream.h) to the PC over the
+*              debug UART. The UART opened by retarget-io is switched to
+*              SCOPE_LINK_BAUD and to DMA transfers; from then on it carries
+*              binary packets, and printf only after scope_link_drain(), which
+*              the packet decoder skips as bytes between packets;
+*              scope_link_close() returns the UART to retarget-io. Two packet
+*              buffers let one packet be encoded while the other is sent.
+*              When both are busy the new packet is dropped, its sequence
+*              number is skipped and the drop is counted. With
+*              SCOPE_LINK_COMPRESS the samples are sent compressed
+*              (scope_compress.h) whenever that makes a packet shorter.
+*
+***********************************************************************************/
+
+#ifndef SCOPE_LINK_H
+#define SCOPE_LINK_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "cy_result.h"
+#include "scope_stream.h"
+
+/* Highest rate the KitProg3 USB-UART bridge of the kit carries reliably */
+#define SCOPE_LINK_BAUD                 (1000000u)
+
+/* Samples per packet */
+#define SCOPE_LINK_MAX_SAMPLES          (1024u)
+
+/* Lossless compression of the samples; the Makefile sets it from SCOPE_COMPRESS */
+#ifndef SCOPE_LINK_COMPRESS
+#define SCOPE_LINK_COMPRESS             (1)
+#endif
+
+typedef struct {
+    uint32_t packets_sent;
+    uint32_t packets_dropped;
+    uint32_t bytes_sent;
+    uint32_t bytes_uncompressed;    /* what the packets sent would take packed at 12 bits */
+} scope_link_stats_t;
+
+/* Switch the retarget-io UART to the link. Call after cy_retarget_io_init()
+ * and after the last printf. */
+cy_rslt_t scope_link_init(void);
+
+/* Queue a packet of header->count samples (up to SCOPE_LINK_MAX_SAMPLES);
+ * the sequence number is filled in. Returns false if it had to be dropped. */
+bool scope_link_send(scope_stream_header_t *header, const uint16_t *samples);
+
+/* Start a queued packet once the previous one is out; call from the main loop */
+void scope_link_poll(void);
+
+/* Wait until all queued packets are out */
+void scope_link_drain(void);
+
+/* Drain the link and switch the UART back to the retarget-io baud rate and
+ * blocking transfers */
+cy_rslt_t scope_link_close(void);
+
+void scope_link_get_stats(scope_link_stats_t *stats);
+
+#endif /* SCOPE_LINK_H */
@@ -0,0 +1,36 @@
+/**********************************************************************************
+* File Name:   scope_math.h
+*
+* Description: Integer helpers shared by the measurement and spectrum stages.
+*
+***********************************************************************************/
+
+#ifndef SCOPE_MATH_H
+#define SCOPE_MATH_H
+
+#include <stdint.h>
+
+/* Integer square root, rounded down, by the bit-by-bit method: no multiply
+ * or divide, 32 iterations at most */
+static inline uint32_t scope_isqrt64(uint64_t value)
+{
+    uint64_t root = 0u;
+    uint64_t bit = 1ull << 62;
+
+    while (bit > value) {
+        bit >>= 2;
+    }
+    while (bit != 0u) {
+        if (value >= root + bit) {
+            value -= root + bit;
+            root = (root >> 1) + bit;
+        }
+        else {
+            root >>= 1;
+        }
+        bit >>= 2;
+    }
+    return (uint32_t)root;
+}
+
+#endif /* SCOPE_MATH_H */
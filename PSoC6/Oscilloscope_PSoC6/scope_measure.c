@@ -0,0 +1,217 @@
+/**********************************************************************************
+* File Name:   scope_measure.c
+*
+* Description: Streaming measurements. The per-sample work is a minimum and
+*              maximum compare, a sum, a 64-bit multiply-accumulate for the
+*              sum of squares and one compare against the hysteresis band;
+*              everything else happens at the crossings or once per frame.
+*              Crossing times are kept in 1/16 samples as wrapping 32-bit
+*              counts, so only differences between them are meaningful.
+*
+***********************************************************************************/
+
+#include <string.h>
+#include "scope_measure.h"
+#include "scope_math.h"
+
+#define STATE_UNKNOWN                    (0u)
+#define STATE_LOW                        (1u)
+#define STATE_HIGH                       (2u)
+
+#define SUBSAMPLE_BITS                   (4u)      /* crossing times in 1/16 samples */
+#define SUBSAMPLES                       (1u << SUBSAMPLE_BITS)
+
+#define LEVEL_TIMEOUT_FRAMES             (8u)      /* automatic level without crossings */
+
+/*****************************************************************************/
+
+static int32_t codes_to_mv(const scope_measure_t *measure, uint64_t codes, uint32_t extra_bits)
+{
+    return (int32_t)((codes * measure->config.full_scale_mv) >>
+                     (measure->config.resolution_bits + extra_bits));
+}
+
+
+/*******************************************************************************
+ * Function Name: crossing_time
+ *******************************************************************************
+ *
+ * Summary:
+ *  Time where the line from 'before' (sample index - 1) to 'after' (sample
+ *  index) passes 'edge', in 1/16 samples.
+ *
+ *******************************************************************************/
+static uint32_t crossing_time(uint32_t index, int32_t before, int32_t after, int32_t edge)
+{
+    int32_t span = after - before;
+    uint32_t fraction = 0u;
+
+    if (span != 0) {
+        fraction = (uint32_t)(((edge - before) * (int32_t)SUBSAMPLES) / span);
+    }
+    return ((index - 1u) << SUBSAMPLE_BITS) + fraction;
+}
+
+
+/* A rising crossing closes a period if a falling one came after the last rise */
+static void crossing_rise(scope_measure_t *measure, uint32_t time)
+{
+    if (measure->have_rise && measure->have_fall &&
+        (int32_t)(measure->last_fall - measure->last_rise) > 0) {
+        measure->period_sum += time - measure->last_rise;
+        measure->high_sum += measure->last_fall - measure->last_rise;
+        measure->periods++;
+    }
+    measure->last_rise = time;
+    measure->have_rise = 1u;
+}
+
+
+static void crossing_fall(scope_measure_t *measure, uint32_t time)
+{
+    measure->last_fall = time;
+    measure->have_fall = 1u;
+}
+
+
+void scope_measure_init(scope_measure_t *measure, const scope_measure_config_t *config)
+{
+    measure->config = *config;
+    measure->frame = 0u;
+    measure->level = config->level ? config->level : (uint16_t)(1u << (config->resolution_bits - 1u));
+    measure->period_ns = 0u;
+    measure->frequency_mhz = 0u;
+    measure->duty_permille = 0u;
+    scope_measure_reset(measure);
+}
+
+
+void scope_measure_reset(scope_measure_t *measure)
+{
+    measure->position = 0u;
+    measure->state = STATE_UNKNOWN;
+    measure->have_rise = 0u;
+    measure->have_fall = 0u;
+    measure->have_sample = 0u;
+    measure->period_sum = 0u;
+    measure->high_sum = 0u;
+    measure->periods = 0u;
+    measure->span_min = UINT16_MAX;
+    measure->span_max = 0u;
+    measure->span_frames = 0u;
+}
+
+
+/*******************************************************************************
+ * Function Name: scope_measure_frame
+ *******************************************************************************
+ *
+ * Summary:
+ *  One pass over the frame for the amplitude statistics and the crossings,
+ *  then the record: amplitudes from this frame, period, frequency and duty
+ *  cycle from the periods completed since the last record.
+ *
+ *******************************************************************************/
+void scope_measure_frame(scope_measure_t *measure, const uint16_t *samples, uint32_t count,
+                         scope_measure_record_t *record)
+{
+    const int32_t half_band = (int32_t)(measure->config.hysteresis / 2u);
+    const int32_t upper = (int32_t)measure->level + half_band;
+    const int32_t lower = (int32_t)measure->level - half_band;
+    uint32_t min = UINT16_MAX;
+    uint32_t max = 0u;
+    uint32_t sum = 0u;
+    uint64_t sum_squares = 0u;
+    uint32_t edges = 0u;
+    uint8_t state = measure->state;
+    int32_t previous;
+    uint64_t mean16;
+    uint64_t mean_square256;
+
+    if (count == 0u) {
+        memset(record, 0, sizeof(*record));
+        return;
+    }
+    previous = measure->have_sample ? (int32_t)measure->last_sample : (int32_t)samples[0];
+
+    for (uint32_t i = 0u; i < count; i++) {
+        const uint32_t x = samples[i];
+
+        min = (x < min) ? x : min;
+        max = (x > max) ? x : max;
+        sum += x;
+        sum_squares += (uint64_t)x * x;
+
+        if (state != STATE_HIGH) {
+            if ((int32_t)x >= upper) {
+                if (state == STATE_LOW) {
+                    crossing_rise(measure, crossing_time(measure->position + i, previous, (int32_t)x, upper));
+                    edges++;
+                }
+                state = STATE_HIGH;
+            }
+            else if ((int32_t)x < lower) {
+                state = STATE_LOW;
+            }
+        }
+        else if ((int32_t)x < lower) {
+            crossing_fall(measure, crossing_time(measure->position + i, previous, (int32_t)x, lower));
+            state = STATE_LOW;
+        }
+        previous = (int32_t)x;
+    }
+
+    measure->state = state;
+    measure->last_sample = (uint16_t)previous;
+    measure->have_sample = 1u;
+    measure->position += count;
+
+    /* Automatic level: the middle of the signal since the last update, taken
+     * when a period completes, or when the signal has not reached the level
+     * for LEVEL_TIMEOUT_FRAMES frames */
+    measure->span_min = (min < measure->span_min) ? (uint16_t)min : measure->span_min;
+    measure->span_max = (max > measure->span_max) ? (uint16_t)max : measure->span_max;
+    if (measure->span_frames < LEVEL_TIMEOUT_FRAMES) {
+        measure->span_frames++;
+    }
+    if (measure->config.level == 0u &&
+        (measure->periods != 0u ||
+         (measure->span_frames == LEVEL_TIMEOUT_FRAMES &&
+          (measure->level < measure->span_min || measure->level > measure->span_max))) &&
+        (uint32_t)(measure->span_max - measure->span_min) > measure->config.hysteresis) {
+        measure->level = (uint16_t)((measure->span_min + measure->span_max) / 2u);
+        measure->span_min = UINT16_MAX;
+        measure->span_max = 0u;
+        measure->span_frames = 0u;
+    }
+
+    if (measure->periods != 0u) {
+        const uint64_t rate = measure->config.sample_rate_hz;
+
+        measure->period_ns = (uint32_t)(((uint64_t)measure->period_sum * 1000000000ull) /
+                                        (rate * SUBSAMPLES * measure->periods));
+        measure->frequency_mhz = (uint32_t)((rate * 1000u * SUBSAMPLES * measure->periods) /
+                                            measure->period_sum);
+        measure->duty_permille = (uint16_t)(((uint64_t)measure->high_sum * 1000u) / measure->period_sum);
+        measure->period_sum = 0u;
+        measure->high_sum = 0u;
+        measure->periods = 0u;
+    }
+
+    /* Mean and mean square with 4 and 8 fraction bits */
+    mean16 = (((uint64_t)sum << SUBSAMPLE_BITS) + count / 2u) / count;
+    mean_square256 = (sum_squares << (2u * SUBSAMPLE_BITS)) / count;
+
+    record->frame = measure->frame++;
+    record->min = (uint16_t)min;
+    record->max = (uint16_t)max;
+    record->vpp_mv = codes_to_mv(measure, max - min, 0u);
+    record->mean_mv = codes_to_mv(measure, mean16, SUBSAMPLE_BITS);
+    record->rms_mv = codes_to_mv(measure, scope_isqrt64(mean_square256), SUBSAMPLE_BITS);
+    record->ac_rms_mv = codes_to_mv(measure, (mean_square256 > mean16 * mean16) ?
+                                    scope_isqrt64(mean_square256 - mean16 * mean16) : 0u, SUBSAMPLE_BITS);
+    record->frequency_mhz = measure->frequency_mhz;
+    record->period_ns = measure->period_ns;
+    record->duty_permille = measure->duty_permille;
+    record->edges = (uint16_t)edges;
+}
@@ -0,0 +1,81 @@
+/**********************************************************************************
+* File Name:   scope_measure.h
+*
+* Description: Waveform measurements, updated by one pass over every frame in
+*              integer arithmetic: minimum, maximum, Vpp, mean, RMS (total and
+*              AC), and from the crossings of a level with hysteresis the
+*              period, frequency and duty cycle. Each frame yields a small
+*              record. Crossings are followed across frames, so waveforms
+*              slower than a frame are measured too; until a full period has
+*              been seen the period fields keep their previous values.
+*
+*              The crossing level is fixed, or with a level of 0 follows the
+*              middle between minimum and maximum of the last period (or of
+*              the last frames, while the signal does not reach it). A rising
+*              crossing is counted when the signal reaches level + hysteresis
+*              / 2 after having been below level - hysteresis / 2, and the
+*              other way round; its time is interpolated between samples.
+*
+***********************************************************************************/
+
+#ifndef SCOPE_MEASURE_H
+#define SCOPE_MEASURE_H
+
+#include <stdint.h>
+
+typedef struct {
+    uint32_t sample_rate_hz;
+    uint32_t full_scale_mv;    /* voltage of code 2^resolution_bits */
+    uint8_t resolution_bits;
+    uint16_t level;            /* crossing level in codes, 0 = automatic */
+    uint16_t hysteresis;       /* width of the band around the level in codes */
+} scope_measure_config_t;
+
+typedef struct {
+    uint32_t frame;            /* record number */
+    uint16_t min;              /* codes */
+    uint16_t max;
+    int32_t vpp_mv;
+    int32_t mean_mv;
+    int32_t rms_mv;            /* sqrt of the mean square */
+    int32_t ac_rms_mv;         /* RMS with the mean removed */
+    uint32_t frequency_mhz;    /* 0 until a full period was seen */
+    uint32_t period_ns;
+    uint16_t duty_permille;    /* high time per period */
+    uint16_t edges;            /* rising crossings in this frame */
+} scope_measure_record_t;
+
+typedef struct {
+    scope_measure_config_t config;
+    uint32_t frame;
+    uint32_t position;         /* samples measured, the time base of the crossings */
+    uint16_t level;            /* crossing level for the next frame */
+    uint16_t span_min;         /* signal range since the last level update */
+    uint16_t span_max;
+    uint8_t span_frames;       /* frames since the last level update, saturating */
+    uint16_t last_sample;
+    uint8_t state;             /* below, above or not yet outside the band */
+    uint8_t have_rise;
+    uint8_t have_fall;
+    uint8_t have_sample;
+    uint32_t last_rise;        /* crossing times in 1/16 samples */
+    uint32_t last_fall;
+    uint32_t period_sum;       /* complete periods since the last update, 1/16 samples */
+    uint32_t high_sum;
+    uint32_t periods;
+    uint32_t period_ns;        /* last results */
+    uint32_t frequency_mhz;
+    uint16_t duty_permille;
+} scope_measure_t;
+
+void scope_measure_init(scope_measure_t *measure, const scope_measure_config_t *config);
+
+/* Forget the crossings, e.g. after samples were lost */
+void scope_measure_reset(scope_measure_t *measure);
+
+/* Measure one frame of ADC codes and fill in its record; an empty frame
+ * yields a zeroed record and leaves the crossings as they are */
+void scope_measure_frame(scope_measure_t *measure, const uint16_t *samples, uint32_t count,
+                         scope_measure_record_t *record);
+
+#endif /* SCOPE_MEASURE_H */
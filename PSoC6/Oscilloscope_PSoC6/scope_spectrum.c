@@ -0,0 +1,263 @@
+/**********************************************************************************
+* File Name:   scope_spectrum.c
+*
+* Description: Windowed q15 real FFT and magnitude averaging. Samples are
+*              centred, scaled to q15 and windowed as they are collected, so
+*              a full block goes straight into the FFT. Both FFTs scale their
+*              result to |X| / points: CMSIS-DSP by its fixed output format,
+*              the portable one by halving after every radix-2 stage and in
+*              the split of the real spectrum.
+*
+*              The portable FFT computes a complex FFT of points / 2 values
+*              (even samples as real, odd samples as imaginary part) and
+*              splits it into the spectrum of the real input.
+*
+***********************************************************************************/
+
+#include <math.h>
+#include "scope_spectrum.h"
+#include "scope_math.h"
+
+#define ADC_MIDSCALE                     (2048)
+#define ADC_TO_Q15_SHIFT                 (4u)      /* 12-bit code to q15 */
+#define BIN_MAX                          (4095u)   /* 12-bit stream packets */
+#define PI_F                             (3.14159265358979f)
+
+/* Window coherent gain 0.5 and |X| / points for amplitude A: A / 4 in q15,
+ * that is 4 per ADC code; bins are 1 / SCOPE_SPECTRUM_BIN_SCALE code */
+#define MAGNITUDE_PER_BIN                (4u / SCOPE_SPECTRUM_BIN_SCALE)
+
+/*****************************************************************************/
+
+#if !defined(SCOPE_SPECTRUM_USE_CMSIS_DSP)
+
+static int32_t mul_q15(int32_t value, int16_t factor)
+{
+    return (int32_t)(((int64_t)value * factor) >> 15);
+}
+
+
+/*******************************************************************************
+ * Function Name: spectrum_fft
+ *******************************************************************************
+ *
+ * Summary:
+ *  Portable real FFT of the windowed block; adds |X[k]| / points of the bins
+ *  0 .. points / 2 - 1 to the average.
+ *
+ *******************************************************************************/
+static void spectrum_fft(scope_spectrum_t *spectrum)
+{
+    const uint32_t m = spectrum->points / 2u;
+    const int16_t *tw = spectrum->twiddle;
+    int32_t *z = spectrum->work;
+    uint32_t bits = 0u;
+
+    while ((1u << bits) < m) {
+        bits++;
+    }
+
+    /* z[n] = x[2n] + i x[2n+1], in bit-reversed order */
+    for (uint32_t n = 0u; n < m; n++) {
+        uint32_t r = 0u;
+
+        for (uint32_t b = 0u; b < bits; b++) {
+            r |= ((n >> b) & 1u) << (bits - 1u - b);
+        }
+        z[2u * r] = spectrum->input[2u * n];
+        z[2u * r + 1u] = spectrum->input[2u * n + 1u];
+    }
+
+    /* Radix-2 stages, halved each: W_m^j = W_points^(2j) */
+    for (uint32_t len = 2u; len <= m; len <<= 1) {
+        const uint32_t half = len / 2u;
+        const uint32_t step = 2u * (m / len);
+
+        for (uint32_t i = 0u; i < m; i += len) {
+            for (uint32_t j = 0u; j < half; j++) {
+                const int16_t wr = tw[2u * j * step];
+                const int16_t wi = tw[2u * j * step + 1u];
+                int32_t *a = &z[2u * (i + j)];
+                int32_t *b = &z[2u * (i + j + half)];
+                int32_t tr = mul_q15(b[0], wr) - mul_q15(b[1], wi);
+                int32_t ti = mul_q15(b[0], wi) + mul_q15(b[1], wr);
+
+                b[0] = (a[0] - tr) >> 1;
+                b[1] = (a[1] - ti) >> 1;
+                a[0] = (a[0] + tr) >> 1;
+                a[1] = (a[1] + ti) >> 1;
+            }
+        }
+    }
+
+    /* X[k] = E[k] + W^k O[k] with E = (Z[k] + Z*[m-k]) / 2 and
+     * O = (Z[k] - Z*[m-k]) / 2i; this is 2 |X| / points */
+    for (uint32_t k = 0u; k < m; k++) {
+        const uint32_t c = (m - k) & (m - 1u);
+        const int32_t zr = z[2u * k];
+        const int32_t zi = z[2u * k + 1u];
+        const int32_t cr = z[2u * c];
+        const int32_t ci = -z[2u * c + 1u];
+        const int32_t er = (zr + cr) / 2;
+        const int32_t ei = (zi + ci) / 2;
+        const int32_t or_ = (zi - ci) / 2;
+        const int32_t oi = -(zr - cr) / 2;
+        const int64_t xr = er + mul_q15(or_, tw[2u * k]) - mul_q15(oi, tw[2u * k + 1u]);
+        const int64_t xi = ei + mul_q15(or_, tw[2u * k + 1u]) + mul_q15(oi, tw[2u * k]);
+
+        spectrum->sum[k] += scope_isqrt64((uint64_t)(xr * xr + xi * xi)) / 2u;
+    }
+}
+
+#endif /* !SCOPE_SPECTRUM_USE_CMSIS_DSP */
+
+
+static void spectrum_block(scope_spectrum_t *spectrum)
+{
+#if defined(SCOPE_SPECTRUM_USE_CMSIS_DSP)
+    const uint32_t bins = spectrum->points / 2u;
+
+    /* The input block is used as scratch by arm_rfft_q15 */
+    arm_rfft_q15(&spectrum->rfft, spectrum->input, spectrum->output);
+    arm_cmplx_mag_q15(spectrum->output, spectrum->magnitude, bins);
+    /* arm_cmplx_mag_q15 returns 2.14, that is half of |X| / points in q15 */
+    for (uint32_t k = 0u; k < bins; k++) {
+        spectrum->sum[k] += 2u * (uint16_t)spectrum->magnitude[k];
+    }
+#else
+    spectrum_fft(spectrum);
+#endif
+
+    spectrum->fill = 0u;
+    if (++spectrum->done == spectrum->averages) {
+        spectrum->ready = 1u;
+    }
+}
+
+
+int scope_spectrum_init(scope_spectrum_t *spectrum, uint32_t points, uint32_t averages)
+{
+    if (points < SCOPE_SPECTRUM_MIN_POINTS || points > SCOPE_SPECTRUM_MAX_POINTS ||
+        (points & (points - 1u)) != 0u || averages == 0u) {
+        return -1;
+    }
+
+    spectrum->points = points;
+    spectrum->averages = averages;
+
+    /* Hann window */
+    for (uint32_t n = 0u; n < points; n++) {
+        float w = 0.5f * (1.0f - cosf(2.0f * PI_F * (float)n / (float)points));
+
+        spectrum->window[n] = (int16_t)(w * 32767.0f + 0.5f);
+    }
+
+#if defined(SCOPE_SPECTRUM_USE_CMSIS_DSP)
+    if (arm_rfft_init_q15(&spectrum->rfft, points, 0u, 1u) != ARM_MATH_SUCCESS) {
+        return -1;
+    }
+#else
+    for (uint32_t k = 0u; k < points / 2u; k++) {
+        float angle = 2.0f * PI_F * (float)k / (float)points;
+
+        spectrum->twiddle[2u * k] = (int16_t)lrintf(cosf(angle) * 32767.0f);
+        spectrum->twiddle[2u * k + 1u] = (int16_t)lrintf(-sinf(angle) * 32767.0f);
+    }
+#endif
+
+    scope_spectrum_reset(spectrum);
+    return 0;
+}
+
+
+void scope_spectrum_reset(scope_spectrum_t *spectrum)
+{
+    spectrum->fill = 0u;
+    spectrum->done = 0u;
+    spectrum->ready = 0u;
+    for (uint32_t k = 0u; k < spectrum->points / 2u; k++) {
+        spectrum->sum[k] = 0u;
+    }
+}
+
+
+uint32_t scope_spectrum_feed(scope_spectrum_t *spectrum, const uint16_t *samples, uint32_t count)
+{
+    uint32_t i = 0u;
+
+    while (i < count && !spectrum->ready) {
+        uint32_t n = spectrum->points - spectrum->fill;
+        int16_t *in = &spectrum->input[spectrum->fill];
+        const int16_t *w = &spectrum->window[spectrum->fill];
+
+        if (n > (count - i)) {
+            n = count - i;
+        }
+        for (uint32_t k = 0u; k < n; k++) {
+            int32_t x = ((int32_t)(samples[i + k] & 0xFFFu) - ADC_MIDSCALE) << ADC_TO_Q15_SHIFT;
+
+            in[k] = (int16_t)((x * w[k]) >> 15);
+        }
+        i += n;
+        spectrum->fill += n;
+        if (spectrum->fill == spectrum->points) {
+            spectrum_block(spectrum);
+        }
+    }
+    return i;
+}
+
+
+int scope_spectrum_read(scope_spectrum_t *spectrum, uint16_t *bins)
+{
+    const uint32_t divisor = spectrum->averages * MAGNITUDE_PER_BIN;
+
+    if (!spectrum->ready) {
+        return -1;
+    }
+    for (uint32_t k = 0u; k < spectrum->points / 2u; k++) {
+        uint32_t bin = (spectrum->sum[k] + divisor / 2u) / divisor;
+
+        bins[k] = (uint16_t)((bin > BIN_MAX) ? BIN_MAX : bin);
+    }
+    scope_spectrum_reset(spectrum);
+    return 0;
+}
+
+
+/*******************************************************************************
+ * Function Name: scope_spectrum_peak
+ *******************************************************************************
+ *
+ * Summary:
+ *  Largest bin above DC, refined by a parabola through it and its
+ *  neighbours: offset p = (a - c) / 2(a - 2b + c), amplitude
+ *  b - (a - c) p / 4.
+ *
+ *******************************************************************************/
+uint32_t scope_spectrum_peak(const uint16_t *bins, uint32_t count, uint16_t *amplitude)
+{
+    uint32_t peak = 1u;
+    int32_t a, b, c, curve;
+    int32_t offset = 0;
+
+    if (count < 3u) {
+        *amplitude = (count > 1u) ? bins[1] : 0u;
+        return (count > 1u) ? 256u : 0u;
+    }
+    for (uint32_t k = 2u; k < count - 1u; k++) {
+        if (bins[k] > bins[peak]) {
+            peak = k;
+        }
+    }
+
+    a = bins[peak - 1u];
+    b = bins[peak];
+    c = bins[peak + 1u];
+    curve = a - 2 * b + c;
+    if (curve < 0) {
+        offset = (128 * (a - c)) / curve;
+    }
+    *amplitude = (uint16_t)(b - ((a - c) * offset) / 1024);
+    return (uint32_t)((int32_t)(peak * 256u) + offset);
+}
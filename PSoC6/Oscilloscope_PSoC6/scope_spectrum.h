@@ -0,0 +1,75 @@
+/**********************************************************************************
+* File Name:   scope_spectrum.h
+*
+* Description: Spectrum analyzer mode. Captured samples are collected into
+*              blocks of 512 to 4096 points; every block is Hann windowed and
+*              transformed by a fixed-point (q15) real FFT, and the magnitudes
+*              of 'averages' blocks are averaged into one spectrum of
+*              points / 2 bins. Bin k lies at k * sample_rate / points.
+*
+*              Bins are peak amplitudes in units of 1/SCOPE_SPECTRUM_BIN_SCALE
+*              ADC code, corrected for the window, so a full-scale sine reads
+*              about 4094 and fits the 12-bit stream packets.
+*
+*              With SCOPE_SPECTRUM_USE_CMSIS_DSP the FFT is the CMSIS-DSP
+*              arm_rfft_q15 (set in the Makefile for the CM4); without it a
+*              portable fixed-point FFT with the same scaling is used, which
+*              is what the host harness runs.
+*
+***********************************************************************************/
+
+#ifndef SCOPE_SPECTRUM_H
+#define SCOPE_SPECTRUM_H
+
+#include <stdint.h>
+
+#if defined(SCOPE_SPECTRUM_USE_CMSIS_DSP)
+#include "arm_math.h"
+#endif
+
+#define SCOPE_SPECTRUM_MIN_POINTS       (512u)
+#define SCOPE_SPECTRUM_MAX_POINTS       (4096u)
+
+/* Bin units per ADC code of amplitude */
+#define SCOPE_SPECTRUM_BIN_SCALE        (2u)
+
+typedef struct {
+    uint32_t points;           /* FFT length, power of two */
+    uint32_t averages;         /* blocks per spectrum */
+    uint32_t fill;             /* samples in the current block */
+    uint32_t done;             /* blocks in the current average */
+    uint8_t ready;             /* a spectrum waits to be read */
+    int16_t input[SCOPE_SPECTRUM_MAX_POINTS];
+    int16_t window[SCOPE_SPECTRUM_MAX_POINTS];
+    uint32_t sum[SCOPE_SPECTRUM_MAX_POINTS / 2u];
+#if defined(SCOPE_SPECTRUM_USE_CMSIS_DSP)
+    arm_rfft_instance_q15 rfft;
+    int16_t output[2u * SCOPE_SPECTRUM_MAX_POINTS];
+    int16_t magnitude[SCOPE_SPECTRUM_MAX_POINTS / 2u];
+#else
+    int32_t work[SCOPE_SPECTRUM_MAX_POINTS];              /* points / 2 complex values */
+    int16_t twiddle[SCOPE_SPECTRUM_MAX_POINTS];           /* exp(-2 pi i k / points), k < points / 2 */
+#endif
+} scope_spectrum_t;
+
+/* Returns -1 unless points is a power of two within the limits and
+ * averages is at least 1 */
+int scope_spectrum_init(scope_spectrum_t *spectrum, uint32_t points, uint32_t averages);
+
+/* Drop the current block and average, e.g. after samples were lost */
+void scope_spectrum_reset(scope_spectrum_t *spectrum);
+
+/* Feed 12-bit ADC codes; a block is transformed as soon as it is full.
+ * Returns how many samples were consumed: all of them, or fewer when a
+ * spectrum became ready; feed the rest after reading it. */
+uint32_t scope_spectrum_feed(scope_spectrum_t *spectrum, const uint16_t *samples, uint32_t count);
+
+/* Copy the ready spectrum (points / 2 bins) to 'bins' and start the next
+ * one. Returns -1 if none is ready. */
+int scope_spectrum_read(scope_spectrum_t *spectrum, uint16_t *bins);
+
+/* Strongest bin above DC, interpolated: returns its position in 1/256 bins
+ * and its amplitude in 'amplitude' */
+uint32_t scope_spectrum_peak(const uint16_t *bins, uint32_t count, uint16_t *amplitude);
+
+#endif /* SCOPE_SPECTRUM_H */
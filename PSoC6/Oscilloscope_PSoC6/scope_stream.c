@@ -0,0 +1,219 @@
+/**********************************************************************************
+* File Name:   scope_stream.c
+*
+* Description: Encoding and decoding of the binary waveform packets, see
+*              scope_stream.h for the layout. The CRC is table driven;
+*              compressed samples go through scope_compress.c.
+*
+***********************************************************************************/
+
+#include "scope_stream.h"
+#include "scope_compress.h"
+
+#define STREAM_LENGTH_BYTES             (2u)   /* length field of compressed samples */
+
+/* CRC-16/CCITT-FALSE, polynomial 0x1021 */
+static const uint16_t crc16_table[256] = {
+    0x0000u, 0x1021u, 0x2042u, 0x3063u, 0x4084u, 0x50A5u, 0x60C6u, 0x70E7u,
+    0x8108u, 0x9129u, 0xA14Au, 0xB16Bu, 0xC18Cu, 0xD1ADu, 0xE1CEu, 0xF1EFu,
+    0x1231u, 0x0210u, 0x3273u, 0x2252u, 0x52B5u, 0x4294u, 0x72F7u, 0x62D6u,
+    0x9339u, 0x8318u, 0xB37Bu, 0xA35Au, 0xD3BDu, 0xC39Cu, 0xF3FFu, 0xE3DEu,
+    0x2462u, 0x3443u, 0x0420u, 0x1401u, 0x64E6u, 0x74C7u, 0x44A4u, 0x5485u,
+    0xA56Au, 0xB54Bu, 0x8528u, 0x9509u, 0xE5EEu, 0xF5CFu, 0xC5ACu, 0xD58Du,
+    0x3653u, 0x2672u, 0x1611u, 0x0630u, 0x76D7u, 0x66F6u, 0x5695u, 0x46B4u,
+    0xB75Bu, 0xA77Au, 0x9719u, 0x8738u, 0xF7DFu, 0xE7FEu, 0xD79Du, 0xC7BCu,
+    0x48C4u, 0x58E5u, 0x6886u, 0x78A7u, 0x0840u, 0x1861u, 0x2802u, 0x3823u,
+    0xC9CCu, 0xD9EDu, 0xE98Eu, 0xF9AFu, 0x8948u, 0x9969u, 0xA90Au, 0xB92Bu,
+    0x5AF5u, 0x4AD4u, 0x7AB7u, 0x6A96u, 0x1A71u, 0x0A50u, 0x3A33u, 0x2A12u,
+    0xDBFDu, 0xCBDCu, 0xFBBFu, 0xEB9Eu, 0x9B79u, 0x8B58u, 0xBB3Bu, 0xAB1Au,
+    0x6CA6u, 0x7C87u, 0x4CE4u, 0x5CC5u, 0x2C22u, 0x3C03u, 0x0C60u, 0x1C41u,
+    0xEDAEu, 0xFD8Fu, 0xCDECu, 0xDDCDu, 0xAD2Au, 0xBD0Bu, 0x8D68u, 0x9D49u,
+    0x7E97u, 0x6EB6u, 0x5ED5u, 0x4EF4u, 0x3E13u, 0x2E32u, 0x1E51u, 0x0E70u,
+    0xFF9Fu, 0xEFBEu, 0xDFDDu, 0xCFFCu, 0xBF1Bu, 0xAF3Au, 0x9F59u, 0x8F78u,
+    0x9188u, 0x81A9u, 0xB1CAu, 0xA1EBu, 0xD10Cu, 0xC12Du, 0xF14Eu, 0xE16Fu,
+    0x1080u, 0x00A1u, 0x30C2u, 0x20E3u, 0x5004u, 0x4025u, 0x7046u, 0x6067u,
+    0x83B9u, 0x9398u, 0xA3FBu, 0xB3DAu, 0xC33Du, 0xD31Cu, 0xE37Fu, 0xF35Eu,
+    0x02B1u, 0x1290u, 0x22F3u, 0x32D2u, 0x4235u, 0x5214u, 0x6277u, 0x7256u,
+    0xB5EAu, 0xA5CBu, 0x95A8u, 0x8589u, 0xF56Eu, 0xE54Fu, 0xD52Cu, 0xC50Du,
+    0x34E2u, 0x24C3u, 0x14A0u, 0x0481u, 0x7466u, 0x6447u, 0x5424u, 0x4405u,
+    0xA7DBu, 0xB7FAu, 0x8799u, 0x97B8u, 0xE75Fu, 0xF77Eu, 0xC71Du, 0xD73Cu,
+    0x26D3u, 0x36F2u, 0x0691u, 0x16B0u, 0x6657u, 0x7676u, 0x4615u, 0x5634u,
+    0xD94Cu, 0xC96Du, 0xF90Eu, 0xE92Fu, 0x99C8u, 0x89E9u, 0xB98Au, 0xA9ABu,
+    0x5844u, 0x4865u, 0x7806u, 0x6827u, 0x18C0u, 0x08E1u, 0x3882u, 0x28A3u,
+    0xCB7Du, 0xDB5Cu, 0xEB3Fu, 0xFB1Eu, 0x8BF9u, 0x9BD8u, 0xABBBu, 0xBB9Au,
+    0x4A75u, 0x5A54u, 0x6A37u, 0x7A16u, 0x0AF1u, 0x1AD0u, 0x2AB3u, 0x3A92u,
+    0xFD2Eu, 0xED0Fu, 0xDD6Cu, 0xCD4Du, 0xBDAAu, 0xAD8Bu, 0x9DE8u, 0x8DC9u,
+    0x7C26u, 0x6C07u, 0x5C64u, 0x4C45u, 0x3CA2u, 0x2C83u, 0x1CE0u, 0x0CC1u,
+    0xEF1Fu, 0xFF3Eu, 0xCF5Du, 0xDF7Cu, 0xAF9Bu, 0xBFBAu, 0x8FD9u, 0x9FF8u,
+    0x6E17u, 0x7E36u, 0x4E55u, 0x5E74u, 0x2E93u, 0x3EB2u, 0x0ED1u, 0x1EF0u
+};
+
+/*****************************************************************************/
+
+static void put16(uint8_t *p, uint16_t v)
+{
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+}
+
+
+static void put32(uint8_t *p, uint32_t v)
+{
+    put16(p, (uint16_t)v);
+    put16(&p[2], (uint16_t)(v >> 16));
+}
+
+
+static uint16_t get16(const uint8_t *p)
+{
+    return (uint16_t)(p[0] | ((uint16_t)p[1] << 8));
+}
+
+
+static uint32_t get32(const uint8_t *p)
+{
+    return get16(p) | ((uint32_t)get16(&p[2]) << 16);
+}
+
+
+uint16_t scope_stream_crc16(uint16_t crc, const uint8_t *data, uint32_t length)
+{
+    for (uint32_t i = 0u; i < length; i++) {
+        crc = (uint16_t)((crc << 8) ^ crc16_table[((crc >> 8) ^ data[i]) & 0xFFu]);
+    }
+    return crc;
+}
+
+
+/*******************************************************************************
+ * Function Name: scope_stream_encode
+ *******************************************************************************
+ *
+ * Summary:
+ *  Write header, samples and CRC. Compression is tried first, limited to
+ *  the size of the packed samples; if it does not fit, the flag is cleared
+ *  and the samples are packed in pairs, an odd last sample paired with 0.
+ *
+ *******************************************************************************/
+uint32_t scope_stream_encode(uint8_t *out, const scope_stream_header_t *header, const uint16_t *samples)
+{
+    const uint32_t count = header->count;
+    const uint32_t packed_bytes = ((count + 1u) / 2u) * 3u;
+    uint8_t *p = &out[SCOPE_STREAM_HEADER_BYTES];
+    uint32_t compressed = 0u;
+    uint32_t i;
+
+    out[0] = SCOPE_STREAM_SYNC0;
+    out[1] = SCOPE_STREAM_SYNC1;
+    out[2] = SCOPE_STREAM_VERSION;
+    out[3] = header->flags;
+    put16(&out[4], header->sequence);
+    put16(&out[6], header->count);
+    put32(&out[8], header->sample_rate_hz);
+    put16(&out[12], header->factor);
+    put16(&out[14], header->trigger_index);
+    put32(&out[16], header->position);
+
+    if ((header->flags & SCOPE_STREAM_FLAG_COMPRESSED) && packed_bytes > STREAM_LENGTH_BYTES) {
+        compressed = scope_compress_encode(&p[STREAM_LENGTH_BYTES], packed_bytes - STREAM_LENGTH_BYTES,
+                                           samples, count);
+    }
+    if (compressed != 0u) {
+        put16(p, (uint16_t)compressed);
+        p += STREAM_LENGTH_BYTES + compressed;
+        put16(p, scope_stream_crc16(0xFFFFu, &out[2], (uint32_t)(p - &out[2])));
+        return (uint32_t)(p - out) + SCOPE_STREAM_CRC_BYTES;
+    }
+    out[3] = (uint8_t)(header->flags & ~SCOPE_STREAM_FLAG_COMPRESSED);
+
+    for (i = 0u; (i + 1u) < count; i += 2u) {
+        uint32_t a = samples[i] & 0xFFFu;
+        uint32_t b = samples[i + 1u] & 0xFFFu;
+
+        p[0] = (uint8_t)a;
+        p[1] = (uint8_t)((a >> 8) | (b << 4));
+        p[2] = (uint8_t)(b >> 4);
+        p += 3;
+    }
+    if (i < count) {
+        uint32_t a = samples[i] & 0xFFFu;
+
+        p[0] = (uint8_t)a;
+        p[1] = (uint8_t)(a >> 8);
+        p[2] = 0u;
+        p += 3;
+    }
+
+    put16(p, scope_stream_crc16(0xFFFFu, &out[2], (uint32_t)(p - &out[2])));
+    return (uint32_t)(p - out) + SCOPE_STREAM_CRC_BYTES;
+}
+
+
+int32_t scope_stream_decode(const uint8_t *data, uint32_t length, scope_stream_header_t *header,
+                            uint16_t *samples)
+{
+    const uint8_t *p = &data[SCOPE_STREAM_HEADER_BYTES];
+    uint32_t count;
+    uint32_t compressed = 0u;
+    uint32_t total;
+    uint32_t i;
+
+    if (length < 2u) {
+        return (length == 1u && data[0] != SCOPE_STREAM_SYNC0) ? SCOPE_STREAM_BAD_SYNC : SCOPE_STREAM_NEED_MORE;
+    }
+    if (data[0] != SCOPE_STREAM_SYNC0 || data[1] != SCOPE_STREAM_SYNC1) {
+        return SCOPE_STREAM_BAD_SYNC;
+    }
+    if (length < SCOPE_STREAM_HEADER_BYTES) {
+        return SCOPE_STREAM_NEED_MORE;
+    }
+
+    count = get16(&data[6]);
+    if (data[2] != SCOPE_STREAM_VERSION || count > SCOPE_STREAM_MAX_SAMPLES ||
+        (count % SCOPE_STREAM_CHANNELS(data[3])) != 0u) {
+        return SCOPE_STREAM_BAD_HEADER;
+    }
+    if (data[3] & SCOPE_STREAM_FLAG_COMPRESSED) {
+        if (length < (SCOPE_STREAM_HEADER_BYTES + STREAM_LENGTH_BYTES)) {
+            return SCOPE_STREAM_NEED_MORE;
+        }
+        compressed = get16(p);
+        if (compressed > SCOPE_COMPRESS_BYTES_MAX(count)) {
+            return SCOPE_STREAM_BAD_HEADER;
+        }
+        total = SCOPE_STREAM_HEADER_BYTES + STREAM_LENGTH_BYTES + compressed + SCOPE_STREAM_CRC_BYTES;
+    }
+    else {
+        total = SCOPE_STREAM_PACKET_BYTES(count);
+    }
+    if (length < total) {
+        return SCOPE_STREAM_NEED_MORE;
+    }
+    if (scope_stream_crc16(0xFFFFu, &data[2], total - 2u - SCOPE_STREAM_CRC_BYTES) !=
+        get16(&data[total - SCOPE_STREAM_CRC_BYTES])) {
+        return SCOPE_STREAM_BAD_CRC;
+    }
+
+    header->flags = data[3];
+    header->sequence = get16(&data[4]);
+    header->count = (uint16_t)count;
+    header->sample_rate_hz = get32(&data[8]);
+    header->factor = get16(&data[12]);
+    header->trigger_index = get16(&data[14]);
+    header->position = get32(&data[16]);
+
+    if (data[3] & SCOPE_STREAM_FLAG_COMPRESSED) {
+        if (scope_compress_decode(&p[STREAM_LENGTH_BYTES], compressed, samples, count) != (int32_t)compressed) {
+            return SCOPE_STREAM_BAD_HEADER;
+        }
+        return (int32_t)total;
+    }
+    for (i = 0u; i < count; i += 2u) {
+        samples[i] = (uint16_t)(p[0] | ((p[1] & 0x0Fu) << 8));
+        if ((i + 1u) < count) {
+            samples[i + 1u] = (uint16_t)((p[1] >> 4) | ((uint16_t)p[2] << 4));
+        }
+        p += 3;
+    }
+    return (int32_t)total;
+}
@@ -0,0 +1,115 @@
+/**********************************************************************************
+* File Name:   scope_stream.h
+*
+* Description: Binary waveform packets for the PC. A packet is a 20-byte
+*              header, the samples packed as 12-bit values (two samples in
+*              three bytes) and a CRC, all little-endian:
+*
+*                offset  size  field
+*                0       2     sync, 0xA5 0x5A
+*                2       1     version, SCOPE_STREAM_VERSION
+*                3       1     flags, SCOPE_STREAM_FLAG_*
+*                4       2     sequence number, +1 per packet sent or dropped
+*                6       2     sample count
+*                8       4     ADC sample rate in Hz
+*                12      2     decimation factor, 1 = every ADC sample
+*                14      2     index of the trigger point, SCOPE_STREAM_NO_TRIGGER
+*                16      4     stream position of the first sample
+*                20      n     samples: a0[7:0], a0[11:8] | b0[3:0] << 4, b0[11:4], ...
+*                20 + n  2     CRC-16/CCITT-FALSE of bytes 2 .. 19 + n
+*
+*              The position counts samples of the (decimated) stream, so the
+*              receiver sees lost samples as a jump in the position and lost
+*              packets as a jump in the sequence number.
+*
+*              A packet of several channels (SCOPE_STREAM_FLAG_CHANNELS_MASK)
+*              carries count / channels samples of each, one block per channel
+*              in scan order; samples at the same index of the blocks were
+*              taken in the same scan and share the position.
+*
+*              A compressed packet (SCOPE_STREAM_FLAG_COMPRESSED) carries the
+*              samples in the format of scope_compress.h instead of packed:
+*
+*                20      2     length m of the compressed samples
+*                22      m     compressed samples
+*                22 + m  2     CRC-16/CCITT-FALSE of bytes 2 .. 21 + m
+*
+*              The encoder only sends it when it is shorter than the packed
+*              samples, so no packet is longer than SCOPE_STREAM_PACKET_BYTES().
+*
+*              Spectrum packets (SCOPE_STREAM_FLAG_SPECTRUM) carry the bins of
+*              one averaged spectrum instead of samples; the position counts
+*              spectra and bin k lies at k * rate / factor / (2 * count) Hz
+*              (scope_spectrum.h).
+*
+*              Encoding and decoding do not depend on the hardware; the host
+*              decoder uses this file.
+*
+***********************************************************************************/
+
+#ifndef SCOPE_STREAM_H
+#define SCOPE_STREAM_H
+
+#include <stdint.h>
+
+#define SCOPE_STREAM_SYNC0              (0xA5u)
+#define SCOPE_STREAM_SYNC1              (0x5Au)
+#define SCOPE_STREAM_VERSION            (1u)
+
+#define SCOPE_STREAM_HEADER_BYTES       (20u)
+#define SCOPE_STREAM_CRC_BYTES          (2u)
+
+/* Samples per packet, limited by the 16-bit count */
+#define SCOPE_STREAM_MAX_SAMPLES        (4096u)
+
+/* Bytes of a packet with 'count' samples */
+#define SCOPE_STREAM_PACKET_BYTES(count) \
+    (SCOPE_STREAM_HEADER_BYTES + ((((count) + 1u) / 2u) * 3u) + SCOPE_STREAM_CRC_BYTES)
+
+/* Flags */
+#define SCOPE_STREAM_FLAG_MODE_MASK     (0x03u)   /* scope_decimate_mode_t of the samples */
+#define SCOPE_STREAM_FLAG_TRIGGERED     (0x04u)   /* a trigger window */
+#define SCOPE_STREAM_FLAG_FORCED        (0x08u)   /* an AUTO window without a trigger */
+#define SCOPE_STREAM_FLAG_SPECTRUM      (0x10u)   /* spectrum bins instead of samples */
+#define SCOPE_STREAM_FLAG_CHANNELS_MASK (0x60u)   /* channels in the packet - 1 */
+#define SCOPE_STREAM_FLAG_CHANNELS_SHIFT (5u)
+#define SCOPE_STREAM_FLAG_COMPRESSED    (0x80u)   /* samples compressed, scope_compress.h */
+
+/* Channels of a packet with 'flags' */
+#define SCOPE_STREAM_CHANNELS(flags) \
+    ((((uint32_t)(flags) & SCOPE_STREAM_FLAG_CHANNELS_MASK) >> SCOPE_STREAM_FLAG_CHANNELS_SHIFT) + 1u)
+
+#define SCOPE_STREAM_NO_TRIGGER         (0xFFFFu)
+
+typedef struct {
+    uint8_t flags;
+    uint16_t sequence;
+    uint16_t count;
+    uint32_t sample_rate_hz;
+    uint16_t factor;
+    uint16_t trigger_index;
+    uint32_t position;
+} scope_stream_header_t;
+
+/* Results of scope_stream_decode() besides the packet length */
+#define SCOPE_STREAM_NEED_MORE          (0)    /* incomplete, wait for more bytes */
+#define SCOPE_STREAM_BAD_SYNC           (-1)   /* no packet starts here, skip a byte */
+#define SCOPE_STREAM_BAD_HEADER         (-2)   /* unknown version, count or compressed data */
+#define SCOPE_STREAM_BAD_CRC            (-3)
+
+uint16_t scope_stream_crc16(uint16_t crc, const uint8_t *data, uint32_t length);
+
+/* Build a packet of header->count samples (12-bit codes) into 'out', which
+ * holds SCOPE_STREAM_PACKET_BYTES(header->count). With
+ * SCOPE_STREAM_FLAG_COMPRESSED in header->flags the samples are compressed
+ * unless that does not make the packet shorter; the flag in the packet tells
+ * which. Returns the packet length. */
+uint32_t scope_stream_encode(uint8_t *out, const scope_stream_header_t *header, const uint16_t *samples);
+
+/* Parse the packet at the start of 'data'. Returns its length with the
+ * header and up to SCOPE_STREAM_MAX_SAMPLES samples filled in, or one of the
+ * results above. Compressed samples are restored. */
+int32_t scope_stream_decode(const uint8_t *data, uint32_t length, scope_stream_header_t *header,
+                            uint16_t *samples);
+
+#endif /* SCOPE_STREAM_H */
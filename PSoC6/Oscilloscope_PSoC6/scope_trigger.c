@@ -0,0 +1,349 @@
+/**********************************************************************************
+* File Name:   scope_trigger.c
+*
+* Description: Trigger search and pre/post-trigger windows. The trigger
+*              condition is a small state machine whose every step waits for
+*              the first sample at or above, or below, a threshold. Those
+*              searches test four samples per iteration: two samples are
+*              loaded per 32-bit word and a bias added to both halfwords at
+*              once sets bit 15 of each halfword that is at or above the
+*              threshold, so a block without a crossing costs two loads, two
+*              adds and one test. Only the block with the crossing is looked
+*              at sample by sample.
+*
+***********************************************************************************/
+
+#include <string.h>
+#include "scope_trigger.h"
+
+#define HISTORY_MASK                     (SCOPE_TRIGGER_HISTORY - 1u)
+
+/* Samples are 15-bit at most, so biased halfwords never carry into each other */
+#define SAMPLE_MASK                      (0x7FFFu)
+#define LANE_MASK                        (0x7FFF7FFFu)
+#define LANE_SIGN                        (0x80008000u)
+#define LANE_ONES                        (0x00010001u)
+
+/* Steps of the trigger condition */
+#define PHASE_ARM                        (0u)   /* wait to be beyond the hysteresis band */
+#define PHASE_FIRE                       (1u)   /* wait for the level (PULSE: pulse start) */
+#define PHASE_PULSE_END                  (2u)   /* wait for the pulse to end */
+
+/*****************************************************************************/
+
+/*******************************************************************************
+ * Function Name: find_at_or_above
+ *******************************************************************************
+ *
+ * Summary:
+ *  Index of the first sample >= threshold, or count if there is none.
+ *
+ *******************************************************************************/
+static uint32_t find_at_or_above(const uint16_t *samples, uint32_t count, int32_t threshold)
+{
+    uint32_t bias;
+    uint32_t i = 0u;
+
+    if (threshold <= 0) {
+        return 0u;
+    }
+    if (threshold > (int32_t)SAMPLE_MASK) {
+        return count;
+    }
+
+    bias = (0x8000u - (uint32_t)threshold) * LANE_ONES;
+    for (; (i + 4u) <= count; i += 4u) {
+        uint32_t w[2];
+
+        memcpy(w, &samples[i], sizeof(w));
+        if ((((w[0] & LANE_MASK) + bias) | ((w[1] & LANE_MASK) + bias)) & LANE_SIGN) {
+            break;
+        }
+    }
+    for (; i < count; i++) {
+        if ((int32_t)(samples[i] & SAMPLE_MASK) >= threshold) {
+            return i;
+        }
+    }
+    return count;
+}
+
+
+/*******************************************************************************
+ * Function Name: find_below
+ *******************************************************************************
+ *
+ * Summary:
+ *  Index of the first sample < threshold, or count if there is none.
+ *
+ *******************************************************************************/
+static uint32_t find_below(const uint16_t *samples, uint32_t count, int32_t threshold)
+{
+    uint32_t bias;
+    uint32_t i = 0u;
+
+    if (threshold <= 0) {
+        return count;
+    }
+    if (threshold > (int32_t)SAMPLE_MASK) {
+        return 0u;
+    }
+
+    bias = (0x8000u - (uint32_t)threshold) * LANE_ONES;
+    for (; (i + 4u) <= count; i += 4u) {
+        uint32_t w[2];
+
+        memcpy(w, &samples[i], sizeof(w));
+        if ((((w[0] & LANE_MASK) + bias) & ((w[1] & LANE_MASK) + bias) & LANE_SIGN) != LANE_SIGN) {
+            break;
+        }
+    }
+    for (; i < count; i++) {
+        if ((int32_t)(samples[i] & SAMPLE_MASK) < threshold) {
+            return i;
+        }
+    }
+    return count;
+}
+
+
+/*******************************************************************************
+ * Function Name: trigger_scan
+ *******************************************************************************
+ *
+ * Summary:
+ *  Run the trigger condition over new samples, not yet in the history.
+ *  Returns the index of the sample the trigger fires on, or count. Triggers
+ *  before the pre-trigger samples are collected are passed over.
+ *
+ *******************************************************************************/
+static uint32_t trigger_scan(scope_trigger_t *trigger, const uint16_t *samples, uint32_t count)
+{
+    const scope_trigger_config_t *config = &trigger->config;
+    const int32_t level = (int32_t)config->level;
+    const int32_t below_band = level - (int32_t)config->hysteresis;
+    const int32_t above_band = level + (int32_t)config->hysteresis;
+    const uint8_t rising = (config->slope == SCOPE_TRIGGER_RISING);
+    uint32_t i = 0u;
+
+    while (i < count) {
+        const uint16_t *p = &samples[i];
+        const uint32_t n = count - i;
+        uint32_t width;
+
+        switch (trigger->phase) {
+        case PHASE_ARM:
+            i += rising ? find_below(p, n, below_band) : find_at_or_above(p, n, above_band);
+            if (i < count) {
+                trigger->phase = PHASE_FIRE;
+                i++;
+            }
+            break;
+
+        case PHASE_FIRE:
+            i += rising ? find_at_or_above(p, n, level) : find_below(p, n, level);
+            if (i == count) {
+                break;
+            }
+            if (config->type == SCOPE_TRIGGER_PULSE) {
+                trigger->pulse_start = trigger->head + i;
+                trigger->phase = PHASE_PULSE_END;
+                i++;
+                break;
+            }
+            /* An edge has to leave the band again, a level fires while it holds */
+            trigger->phase = (config->type == SCOPE_TRIGGER_EDGE) ? PHASE_ARM : PHASE_FIRE;
+            if ((trigger->since_arm + i) >= config->pre) {
+                return i;
+            }
+            i++;
+            break;
+
+        default: /* PHASE_PULSE_END */
+            i += rising ? find_below(p, n, below_band) : find_at_or_above(p, n, above_band);
+            if (i == count) {
+                break;
+            }
+            /* Back beyond the band: armed for the next pulse */
+            width = trigger->head + i - trigger->pulse_start;
+            trigger->phase = PHASE_FIRE;
+            if (width >= config->pulse_min && width <= config->pulse_max &&
+                (trigger->since_arm + i) >= config->pre) {
+                return i;
+            }
+            i++;
+            break;
+        }
+    }
+    return count;
+}
+
+
+static void history_append(scope_trigger_t *trigger, const uint16_t *samples, uint32_t count)
+{
+    uint32_t at;
+    uint32_t first;
+
+    trigger->since_arm = (count < UINT32_MAX - trigger->since_arm) ? trigger->since_arm + count : UINT32_MAX;
+
+    /* Only the newest samples fit */
+    if (count > SCOPE_TRIGGER_HISTORY) {
+        trigger->head += count - SCOPE_TRIGGER_HISTORY;
+        samples += count - SCOPE_TRIGGER_HISTORY;
+        count = SCOPE_TRIGGER_HISTORY;
+    }
+
+    at = trigger->head & HISTORY_MASK;
+    first = SCOPE_TRIGGER_HISTORY - at;
+    if (first > count) {
+        first = count;
+    }
+    memcpy(&trigger->history[at], samples, first * sizeof(uint16_t));
+    memcpy(&trigger->history[0], &samples[first], (count - first) * sizeof(uint16_t));
+    trigger->head += count;
+}
+
+
+static void trigger_fire(scope_trigger_t *trigger, uint8_t forced)
+{
+    trigger->trigger_pos = trigger->head;
+    trigger->forced = forced;
+    trigger->post_left = trigger->config.post;
+    trigger->state = (trigger->post_left != 0u) ? SCOPE_TRIGGER_TRIGGERED : SCOPE_TRIGGER_READY;
+}
+
+
+int scope_trigger_check(const scope_trigger_config_t *config)
+{
+    if (config->pre > SCOPE_TRIGGER_HISTORY || config->post > SCOPE_TRIGGER_HISTORY - config->pre ||
+        (config->pre + config->post) == 0u || config->level > SAMPLE_MASK ||
+        config->pulse_min > config->pulse_max) {
+        return -1;
+    }
+    return 0;
+}
+
+
+int scope_trigger_init(scope_trigger_t *trigger, const scope_trigger_config_t *config)
+{
+    if (scope_trigger_check(config) != 0) {
+        return -1;
+    }
+
+    trigger->config = *config;
+    trigger->state = SCOPE_TRIGGER_STOPPED;
+    trigger->head = 0u;
+    trigger->since_arm = 0u;
+    return 0;
+}
+
+
+void scope_trigger_arm(scope_trigger_t *trigger)
+{
+    /* The pre-trigger samples are taken after arming, so a window never
+     * spans samples lost while the previous one was being displayed */
+    trigger->phase = (trigger->config.type == SCOPE_TRIGGER_LEVEL) ? PHASE_FIRE : PHASE_ARM;
+    trigger->since_arm = 0u;
+    trigger->forced = 0u;
+    trigger->state = SCOPE_TRIGGER_ARMED;
+}
+
+
+void scope_trigger_stop(scope_trigger_t *trigger)
+{
+    trigger->state = SCOPE_TRIGGER_STOPPED;
+}
+
+
+uint32_t scope_trigger_feed(scope_trigger_t *trigger, const uint16_t *samples, uint32_t count)
+{
+    const scope_trigger_config_t *config = &trigger->config;
+    uint32_t done = 0u;
+
+    while (done < count) {
+        uint32_t n = count - done;
+        uint32_t hit;
+
+        switch (trigger->state) {
+        case SCOPE_TRIGGER_ARMED:
+            if (config->mode == SCOPE_TRIGGER_AUTO) {
+                /* Force a window auto_timeout samples after the pre-trigger
+                 * samples are in */
+                uint32_t deadline = (config->auto_timeout < UINT32_MAX - config->pre) ?
+                                    config->pre + config->auto_timeout : UINT32_MAX;
+
+                if (trigger->since_arm >= deadline) {
+                    trigger_fire(trigger, 1u);
+                    break;
+                }
+                if (n > deadline - trigger->since_arm) {
+                    n = deadline - trigger->since_arm;
+                }
+            }
+            hit = trigger_scan(trigger, &samples[done], n);
+            history_append(trigger, &samples[done], hit);
+            done += hit;
+            if (hit < n) {
+                trigger_fire(trigger, 0u);
+            }
+            break;
+
+        case SCOPE_TRIGGER_TRIGGERED:
+            if (n > trigger->post_left) {
+                n = trigger->post_left;
+            }
+            history_append(trigger, &samples[done], n);
+            done += n;
+            trigger->post_left -= n;
+            if (trigger->post_left == 0u) {
+                trigger->state = SCOPE_TRIGGER_READY;
+            }
+            break;
+
+        case SCOPE_TRIGGER_READY:
+            return done;
+
+        default: /* SCOPE_TRIGGER_STOPPED */
+            history_append(trigger, &samples[done], n);
+            done += n;
+            break;
+        }
+    }
+    return done;
+}
+
+
+int scope_trigger_read(scope_trigger_t *trigger, uint16_t *out, scope_trigger_window_t *window)
+{
+    const uint32_t pre = trigger->config.pre;
+    const uint32_t total = pre + trigger->config.post;
+    uint32_t at;
+    uint32_t first;
+
+    if (trigger->state != SCOPE_TRIGGER_READY) {
+        return -1;
+    }
+
+    at = (trigger->trigger_pos - pre) & HISTORY_MASK;
+    first = SCOPE_TRIGGER_HISTORY - at;
+    if (first > total) {
+        first = total;
+    }
+    memcpy(out, &trigger->history[at], first * sizeof(uint16_t));
+    memcpy(&out[first], &trigger->history[0], (total - first) * sizeof(uint16_t));
+
+    if (window != NULL) {
+        window->position = trigger->trigger_pos;
+        window->trigger_index = pre;
+        window->count = total;
+        window->forced = trigger->forced;
+    }
+
+    if (trigger->config.mode == SCOPE_TRIGGER_SINGLE) {
+        trigger->state = SCOPE_TRIGGER_STOPPED;
+    }
+    else {
+        scope_trigger_arm(trigger);
+    }
+    return 0;
+}
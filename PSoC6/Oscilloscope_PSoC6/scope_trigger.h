@@ -0,0 +1,123 @@
+/**********************************************************************************
+* File Name:   scope_trigger.h
+*
+* Description: Trigger stage of the oscilloscope. Captured frames are fed in
+*              as they complete; every sample is kept in a history ring and the
+*              new samples are searched for the trigger condition. Once the
+*              trigger has fired and the post-trigger samples have arrived, a
+*              window of pre + post samples around the trigger point can be
+*              read out of the history.
+*
+*              Trigger types (slope selects the polarity):
+*                EDGE   the signal crosses the level; it must have been beyond
+*                       the hysteresis band on the other side first
+*                LEVEL  the signal is at or above (rising) / below (falling)
+*                       the level
+*                PULSE  a positive (rising) / negative (falling) pulse through
+*                       the level, whose width in samples is within the
+*                       limits, ends; the trigger point is the end of the pulse
+*
+*              Modes:
+*                SINGLE  one window, then the trigger stops until re-armed
+*                NORMAL  a window for every trigger, re-armed after each read
+*                AUTO    as NORMAL, but without a trigger for auto_timeout
+*                        samples a window is taken anyway (marked forced)
+*
+*              The trigger works on unsigned ADC codes below 0x8000 and does
+*              not depend on the capture hardware.
+*
+***********************************************************************************/
+
+#ifndef SCOPE_TRIGGER_H
+#define SCOPE_TRIGGER_H
+
+#include <stdint.h>
+
+/* Samples of history kept; pre + post of a window must fit. Power of two. */
+#define SCOPE_TRIGGER_HISTORY    (4096u)
+
+typedef enum {
+    SCOPE_TRIGGER_EDGE,
+    SCOPE_TRIGGER_LEVEL,
+    SCOPE_TRIGGER_PULSE
+} scope_trigger_type_t;
+
+typedef enum {
+    SCOPE_TRIGGER_RISING,
+    SCOPE_TRIGGER_FALLING
+} scope_trigger_slope_t;
+
+typedef enum {
+    SCOPE_TRIGGER_SINGLE,
+    SCOPE_TRIGGER_NORMAL,
+    SCOPE_TRIGGER_AUTO
+} scope_trigger_mode_t;
+
+typedef enum {
+    SCOPE_TRIGGER_STOPPED,     /* history only, no search */
+    SCOPE_TRIGGER_ARMED,       /* searching for the trigger */
+    SCOPE_TRIGGER_TRIGGERED,   /* collecting the post-trigger samples */
+    SCOPE_TRIGGER_READY        /* window complete, waiting to be read */
+} scope_trigger_state_t;
+
+typedef struct {
+    scope_trigger_type_t type;
+    scope_trigger_slope_t slope;
+    scope_trigger_mode_t mode;
+    uint16_t level;            /* ADC code */
+    uint16_t hysteresis;       /* ADC codes, EDGE and PULSE */
+    uint32_t pulse_min;        /* PULSE: accepted widths in samples */
+    uint32_t pulse_max;
+    uint32_t pre;              /* samples before the trigger point */
+    uint32_t post;             /* samples from the trigger point on */
+    uint32_t auto_timeout;     /* AUTO: samples without a trigger before forcing */
+} scope_trigger_config_t;
+
+typedef struct {
+    uint32_t position;         /* sample count of the trigger point */
+    uint32_t trigger_index;    /* index of the trigger point in the window (= pre) */
+    uint32_t count;            /* samples in the window (pre + post) */
+    uint8_t forced;            /* AUTO window taken without a trigger */
+} scope_trigger_window_t;
+
+typedef struct {
+    scope_trigger_config_t config;
+    scope_trigger_state_t state;
+    uint8_t phase;             /* position in the trigger condition */
+    uint8_t forced;
+    uint32_t head;             /* samples written to the history */
+    uint32_t since_arm;        /* samples since arming, saturating */
+    uint32_t pulse_start;      /* sample count where the pulse began */
+    uint32_t trigger_pos;
+    uint32_t post_left;
+    uint16_t history[SCOPE_TRIGGER_HISTORY];
+} scope_trigger_t;
+
+/* Returns -1 if the window does not fit the history or the configuration is
+ * invalid, 0 otherwise */
+int scope_trigger_check(const scope_trigger_config_t *config);
+
+/* Set up the trigger, stopped. Returns -1 if the window does not fit the
+ * history or the configuration is invalid, 0 otherwise. */
+int scope_trigger_init(scope_trigger_t *trigger, const scope_trigger_config_t *config);
+
+/* Start searching; the window's pre-trigger samples are collected first */
+void scope_trigger_arm(scope_trigger_t *trigger);
+
+/* Stop searching, the history keeps filling */
+void scope_trigger_stop(scope_trigger_t *trigger);
+
+/* Feed captured samples. Returns how many were consumed: all of them, or
+ * fewer when a window became ready; feed the rest after reading it. */
+uint32_t scope_trigger_feed(scope_trigger_t *trigger, const uint16_t *samples, uint32_t count);
+
+static inline scope_trigger_state_t scope_trigger_state(const scope_trigger_t *trigger)
+{
+    return trigger->state;
+}
+
+/* Copy the ready window (pre + post samples) to 'out' and re-arm (NORMAL,
+ * AUTO) or stop (SINGLE). Returns -1 if no window is ready. */
+int scope_trigger_read(scope_trigger_t *trigger, uint16_t *out, scope_trigger_window_t *window);
+
+#endif /* SCOPE_TRIGGER_H */
@@ -1,13 +1,15 @@
 #include "stm32l476xx.h"
 #include "sensor_ADC_driver.h"
 #include "usart2_driver.h"
+#include "temperature_processing.h"
 #include "string.h"
 #include "stdio.h"
 
-char tempC_buffer[10]; // temperature buffer
+char tempC_buffer[TEMP_FORMAT_BUFFER_SIZE]; // temperature buffer
 uint32_t temperature_C; // temperature in Celsius
 float voltage_raw; // raw voltage value from sensor
 float voltage; // voltage in mV (stored after conversion)
+TEMP_Filter_t adc_filter; // moving average over the raw ADC codes
 
 
 void send_string_via_usart(const char *str) {
@@ -23,6 +25,8 @@ int main(void){
 	
 	const char *msg = "Temperature Sensor Initialized.\n\r";
 
+	TEMP_Filter_Init(&adc_filter, TEMP_FILTER_LENGTH);
+
 	// Initialize ADC: Set up ADC1 for sampling from external input channel PA1 (ADC1_IN6). 
 	// Configure for 12-bit resolution, right data alignment, single-ended, continuous mode, 
 	// and interrupt at the end of every conversion.
@@ -39,13 +43,13 @@ int main(void){
 		// Start ADC conversion
 		ADC1->CR |= ADC_CR_ADSTART;
 		
-		// Calculate temperature
-		voltage_raw = adc_result;
-	  voltage = (0.00081 * voltage_raw);
-	  temperature_C = (voltage - 0.5)*100;
+		// Calculate temperature (see temperature_processing.c, shared with tools/adc_replay)
+		voltage_raw = TEMP_Filter_Update(&adc_filter, adc_result);
+		voltage = TEMP_Code_To_Voltage(voltage_raw);
+		temperature_C = TEMP_Voltage_To_Celsius(voltage);
 		
 		//format the temperature and send over UART
-		sprintf(tempC_buffer, "%u\n\r", temperature_C);
+		TEMP_Format(tempC_buffer, sizeof(tempC_buffer), temperature_C);
 		send_string_via_usart(tempC_buffer);
 		
 		
@@ -0,0 +1,59 @@
+#include "temperature_processing.h"
+#include <stdio.h>
+
+//-------------------------------------------------------------------------------------------
+// Moving average filter
+// A running sum is kept so each update costs one add and one subtract regardless of length.
+//-------------------------------------------------------------------------------------------
+void TEMP_Filter_Init(TEMP_Filter_t *filter, uint32_t length){
+	uint32_t i;
+
+	if(length == 0){
+		length = 1;
+	}
+	if(length > TEMP_FILTER_MAX_LENGTH){
+		length = TEMP_FILTER_MAX_LENGTH;
+	}
+	for(i = 0; i < TEMP_FILTER_MAX_LENGTH; i++){
+		filter->window[i] = 0;
+	}
+	filter->sum = 0;
+	filter->length = length;
+	filter->index = 0;
+	filter->count = 0;
+}
+
+uint32_t TEMP_Filter_Update(TEMP_Filter_t *filter, uint32_t code){
+	// Replace the oldest code in the window with the new one
+	filter->sum -= filter->window[filter->index];
+	filter->window[filter->index] = code;
+	filter->sum += code;
+
+	filter->index++;
+	if(filter->index >= filter->length){
+		filter->index = 0;
+	}
+	// Until the window is full, average over the codes seen so far
+	if(filter->count < filter->length){
+		filter->count++;
+	}
+	return filter->sum / filter->count;
+}
+
+//-------------------------------------------------------------------------------------------
+// Conversions
+// Kept in the same floating point form the original main loop used so that
+// replayed traces produce exactly the same output as the board.
+//-------------------------------------------------------------------------------------------
+float TEMP_Code_To_Voltage(uint32_t code){
+	float voltage_raw = code;
+	return (0.00081 * voltage_raw);
+}
+
+uint32_t TEMP_Voltage_To_Celsius(float voltage){
+	return (voltage - 0.5)*100;
+}
+
+int TEMP_Format(char *buffer, size_t size, uint32_t temperature_C){
+	return snprintf(buffer, size, "%u\n\r", (unsigned int)temperature_C);
+}
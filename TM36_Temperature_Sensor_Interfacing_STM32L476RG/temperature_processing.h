@@ -0,0 +1,47 @@
+#ifndef __TEMPERATURE_PROCESSING_H
+#define __TEMPERATURE_PROCESSING_H
+
+// Hardware independent processing stages for the TMP36 sensor readings.
+// Nothing in here touches a register, so the same code is built into the
+// firmware and into the host-side replay tool (tools/adc_replay).
+
+#include <stdint.h>
+#include <stddef.h>
+
+// Length of the moving average applied to the raw ADC codes.
+// 1 means "no filtering", which is what the firmware ships with.
+#ifndef TEMP_FILTER_LENGTH
+#define TEMP_FILTER_LENGTH 1
+#endif
+
+// Largest moving average window supported by TEMP_Filter_Init()
+#define TEMP_FILTER_MAX_LENGTH 32
+
+// Size of the buffer needed for one formatted temperature line
+#define TEMP_FORMAT_BUFFER_SIZE 16
+
+// Moving average state over the last 'length' ADC codes
+typedef struct {
+	uint32_t window[TEMP_FILTER_MAX_LENGTH];
+	uint32_t sum;
+	uint32_t length;
+	uint32_t index;
+	uint32_t count;
+} TEMP_Filter_t;
+
+// Reset the filter; length is clamped to 1..TEMP_FILTER_MAX_LENGTH
+void TEMP_Filter_Init(TEMP_Filter_t *filter, uint32_t length);
+
+// Push one ADC code and return the filtered code
+uint32_t TEMP_Filter_Update(TEMP_Filter_t *filter, uint32_t code);
+
+// Convert a 12-bit ADC code to the sensor voltage in volts (3.3V / 4096 per LSB)
+float TEMP_Code_To_Voltage(uint32_t code);
+
+// Convert the TMP36 output voltage to degrees Celsius (10mV/C, 500mV offset)
+uint32_t TEMP_Voltage_To_Celsius(float voltage);
+
+// Format a temperature the way it is sent over USART2, returns the string length
+int TEMP_Format(char *buffer, size_t size, uint32_t temperature_C);
+
+#endif /* __TEMPERATURE_PROCESSING_H */
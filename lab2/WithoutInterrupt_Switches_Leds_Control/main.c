@@ -26,68 +26,148 @@ Hardware Connections(Circuit):
 
 
 #include "stm32l476xx.h"
+#include "lab_board.h"
+#include "lab_clock.h"
+#include "exti_pin.h"
+#include "sleep_monitor.h"
+#include "soft_pwm.h"
 
-#define PB4   4	//LED1
-#define PB5		5	//LED2
-#define	PC2		2	//SW1
-#define PC3		3	//SW2
+// 0: poll the switches in a busy loop (the lab as written)
+// 1: sleep in WFI; switch edges (EXTI) and a one-shot timer (TIM6) drive
+//    the same LED pattern while the core is otherwise idle
+#ifndef SWITCH_LED_SLEEP_MODE
+#define SWITCH_LED_SLEEP_MODE 0
+#endif
+
+// 1: each LED blinks on its own while its switch is high, scheduled by the
+//    software PWM on TIM7 (soft_pwm.c); switch edges start and stop the
+//    blinking and the main loop only sleeps. Takes precedence over sleep mode.
+#ifndef SWITCH_LED_SOFT_PWM_MODE
+#define SWITCH_LED_SOFT_PWM_MODE 0
+#endif
+
+// Blink delay of the sleep and soft PWM modes, about the length of the busy loop
+// 'for(i=0;i<100000;i++)' at the default 4MHz clock.
+#define BLINK_DELAY_MS 200
 
 
 void configure_LED_pin(){
-  // 1. Enable the clock to GPIO Port B	
-  RCC->AHB2ENR |= RCC_AHB2ENR_GPIOBEN;   
-		
-	// 2. Configure GPIO Mode to 'Output': Input(00), Output(01), AlterFunc(10), Analog(11)
-	GPIOB->MODER &= ~(3UL<<(2*PB4));  
-	GPIOB->MODER |=   1UL<<(2*PB4);      // Output(01)
-	GPIOB->MODER &= ~(3UL<<(2*PB5));  
-	GPIOB->MODER |=   1UL<<(2*PB5);      // Output(01)
-	
-	// 3. Configure GPIO Output Type to 'Push-Pull': Output push-pull (0), Output open drain (1) 
-	GPIOB->OTYPER &= ~(1<<PB4);      // Push-pull
-	GPIOB->OTYPER &= ~(1<<PB5);      // Push-pull
-	// 4. Configure GPIO Push-Pull to 'No Pull-up or Pull-down': No pull-up, pull-down (00), Pull-up (01), Pull-down (10), Reserved (11)
-	GPIOB->PUPDR  &= ~(3<<(2*PB4));  // No pull-up, no pull-down
-	GPIOB->PUPDR  &= ~(3<<(2*PB5));  // No pull-up, no pull-down
+	// Clock, mode (output), push-pull and no pull-up/pull-down come from the
+	// LED1/LED2 descriptors in lab_board.h
+	gpio_pin_configure(&LED1);
+	gpio_pin_configure(&LED2);
 }
 
 void configure_Push_Button_pin(){
-  // 1. Enable the clock to GPIO Port A	
-  RCC->AHB2ENR |= RCC_AHB2ENR_GPIOCEN;   
-		
-	// 2. Configure GPIO Mode to 'Input': Input(00), Output(01), AlterFunc(10), Analog(11)
-	GPIOC->MODER &= ~(3UL<<(2*PC2));  	// Input (00)
-	GPIOC->MODER &= ~(3UL<<(2*PC3));  	// Input (00)
-	
-	// 3. Configure GPIO Push-Pull to 'No Pull-up or Pull-down': No pull-up, pull-down (00), Pull-up (01), Pull-down (10), Reserved (11)
-	GPIOC->PUPDR  &= ~(3<<(2*PC2));  // No pull-up, no pull-down
-	GPIOC->PUPDR  &= ~(3<<(2*PC3));  // No pull-up, no pull-down
+	// Clock, mode (input) and no pull-up/pull-down come from the
+	// SW1/SW2 descriptors in lab_board.h
+	gpio_pin_configure(&SW1);
+	gpio_pin_configure(&SW2);
 }
 
-// Modular function to turn on the LD2 LED.
-void turn_on_LED1(){
-	GPIOB->ODR |= 1 << PB4;
+#if SWITCH_LED_SOFT_PWM_MODE
+#define LED2_BLINK 0	//soft PWM slot of LED2, blinks while SW1 is high
+#define LED1_BLINK 1	//soft PWM slot of LED1, blinks while SW2 is high
+
+void configure_blink_scheduler(void){
+	const soft_pwm_config_t led2_blink = { &LED2, 2 * BLINK_DELAY_MS, BLINK_DELAY_MS, 0 };
+	const soft_pwm_config_t led1_blink = { &LED1, 2 * BLINK_DELAY_MS, BLINK_DELAY_MS, 0 };
+
+	soft_pwm_init(1000);   // 1 ms ticks
+	soft_pwm_add(LED2_BLINK, &led2_blink);
+	soft_pwm_add(LED1_BLINK, &led1_blink);
 }
-void turn_on_LED2(){
-	GPIOB->ODR &= ~(1 << PB5);
+
+// Blink the LED of a switch while the switch is high
+void update_blink(const gpio_pin_t *sw, uint8_t slot){
+	if(gpio_pin_read(sw)){
+		soft_pwm_start(slot);
+	}
+	else{
+		soft_pwm_stop(slot);
+	}
 }
 
-// Modular function to turn off the LD2 LED.
-void turn_off_LED1(){
-	GPIOB->ODR &= ~(1 << PB4);
+// ISR (interrupt handler) for EXTI2: SW1 changed
+void EXTI2_IRQHandler(void) {
+	exti_pin_clear(&SW1);
+	update_blink(&SW1, LED2_BLINK);
 }
-void turn_off_LED2(){
-	GPIOB->ODR |= 1 << PB5;
+
+// ISR (interrupt handler) for EXTI3: SW2 changed
+void EXTI3_IRQHandler(void) {
+	exti_pin_clear(&SW2);
+	update_blink(&SW2, LED1_BLINK);
 }
 
-// Modular function to toggle the LD2 LED.
-void toggle_LED1(){
-	GPIOB->ODR ^= (1 << PB4);
+// ISR (interrupt handler) for TIM7: soft PWM tick
+void TIM7_IRQHandler(void) {
+	soft_pwm_isr();
 }
-void toggle_LED2(){
-	GPIOB->ODR ^= (1 << PB5);
+#elif SWITCH_LED_SLEEP_MODE
+static volatile uint8_t blink_stage;         // next check of the loop: 0 = SW1/LED2, 1 = SW2/LED1
+static volatile uint8_t blink_delay_active;  // TIM6 is timing a blink delay
+sleep_monitor_stats_t sleep_stats;           // asleep/awake time, watch in the debugger
+
+void configure_blink_timer(void){
+	// TIM6 counts 1 ms ticks and stops by itself after one period (one-pulse mode)
+	RCC->APB1ENR1 |= RCC_APB1ENR1_TIM6EN;
+	TIM6->CR1  = TIM_CR1_OPM | TIM_CR1_URS;   // URS: the UG below raises no interrupt
+	TIM6->PSC  = LAB_CORE_CLOCK_HZ / 1000 - 1;
+	TIM6->ARR  = BLINK_DELAY_MS - 1;
+	TIM6->EGR  = TIM_EGR_UG;
+	TIM6->SR   = 0;
+	TIM6->DIER = TIM_DIER_UIE;
+	NVIC_EnableIRQ(TIM6_DAC_IRQn);
 }
 
+// The polling loop below, resumed where its last delay left off. Instead of
+// spinning through a delay it starts TIM6 and returns. Like the loop it tests
+// both inputs for high, so the active-low SW2 keeps LED1 blinking while it is
+// released; only while neither input is high are the LEDs off and nothing
+// runs until the next rising edge.
+void run_switch_checks(void){
+	uint8_t checked;
+
+	for(checked = 0; checked < 2; checked++){
+		const gpio_pin_t *sw  = blink_stage ? &SW2 : &SW1;
+		const gpio_pin_t *led = blink_stage ? &LED1 : &LED2;
+
+		blink_stage ^= 1;
+		if(gpio_pin_read(sw)){
+			gpio_pin_toggle(led);
+			blink_delay_active = 1;
+			TIM6->CR1 |= TIM_CR1_CEN;
+			return;
+		}
+		gpio_pin_off(led);
+	}
+}
+
+// ISR (interrupt handler) for EXTI2: SW1 went high
+void EXTI2_IRQHandler(void) {
+	exti_pin_clear(&SW1);
+	if(!blink_delay_active){
+		run_switch_checks();
+	}
+}
+
+// ISR (interrupt handler) for EXTI3: SW2 went high
+void EXTI3_IRQHandler(void) {
+	exti_pin_clear(&SW2);
+	if(!blink_delay_active){
+		run_switch_checks();
+	}
+}
+
+// ISR (interrupt handler) for TIM6: a blink delay has elapsed
+void TIM6_DAC_IRQHandler(void) {
+	TIM6->SR = 0;
+	blink_delay_active = 0;
+	run_switch_checks();
+}
+#endif
+
 int main(void){
 	int i, n;
 	//1. Invoke configure_LED_pin() to initialize PA5 as an output pin, interfacing with the LD2 LED.
@@ -95,24 +175,51 @@ int main(void){
 	//2. Invoke configure_Push_Button_pin() to initialize PC13 as an input pin, interfacing with the USER push button.
 	configure_Push_Button_pin();
 	//3. Turn on the LD2 LED
-	turn_on_LED1();
-	turn_on_LED2();
+	gpio_pin_on(&LED1);
+	gpio_pin_on(&LED2);
+#if SWITCH_LED_SOFT_PWM_MODE
+	//4. Switch edges start and stop the blinking; TIM7 does the rest.
+	configure_blink_scheduler();
+	__disable_irq();
+	exti_pin_configure(&SW1, EXTI_EDGE_BOTH);
+	exti_pin_configure(&SW2, EXTI_EDGE_BOTH);
+	update_blink(&SW1, LED2_BLINK);   // a switch may already be high
+	update_blink(&SW2, LED1_BLINK);
+	__enable_irq();
+	while(1){
+		__WFI();
+	}
+#elif SWITCH_LED_SLEEP_MODE
+	//4. Wake on rising switch edges; TIM6 paces the blinking.
+	configure_blink_timer();
+	sleep_monitor_init();
+	__disable_irq();
+	exti_pin_configure(&SW1, EXTI_EDGE_RISING);
+	exti_pin_configure(&SW2, EXTI_EDGE_RISING);
+	run_switch_checks();   // a switch may already be high
+	__enable_irq();
+	while(1){
+		sleep_monitor_wfi();
+		sleep_monitor_read(&sleep_stats);
+	}
+#else
 	// Infinite loop to toggle the LED, making it blink at a specified frequency.
 	while(1){
-		if((GPIOC->IDR & 1<<PC2) == 1<<PC2){ //externally pull-down(0)
-				toggle_LED2();
+		if(gpio_pin_read(&SW1)){ //externally pull-down(0)
+				gpio_pin_toggle(&LED2);
 				for(i=0;i<100000;i++);
 		}
 		else{
-			turn_off_LED2();
+			gpio_pin_off(&LED2);
 		}
-		if((GPIOC->IDR & 1<<PC3) == 1<<PC3){ //externally pull-up(1)
-				toggle_LED1();
+		if(gpio_pin_read(&SW2)){ //externally pull-up(1)
+				gpio_pin_toggle(&LED1);
 				for(i=0;i<100000;i++);
 		}
 		else{
-			turn_off_LED1();
+			gpio_pin_off(&LED1);
 		}
 			
 	}
+#endif
 }
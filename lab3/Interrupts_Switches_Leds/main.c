@@ -24,66 +24,40 @@ Hardware Connections(Circuit):
 ************************************************************/
 
 #include "stm32l476xx.h"
+#include "lab_board.h"
+#include "exti_pin.h"
+#include "input_event_queue.h"
+#include "led_pwm.h"
 
-#define PB4   4	//LED1
-#define PB5		5	//LED2
-#define	PC2		2	//SW1
-#define PC3		3	//SW2
+// 1: the LEDs are driven by TIM3 PWM (led_pwm.c) and fade in and out
+//    instead of switching
+#ifndef LED_FADE_MODE
+#define LED_FADE_MODE 0
+#endif
 
+#define LED_FADE_MS 300	//duration of a fade in LED_FADE_MODE
 
-void configure_LED_pin(){
-  // 1. Enable the clock to GPIO Port B	
-  RCC->AHB2ENR |= RCC_AHB2ENR_GPIOBEN;   
-		
-	// 2. Configure GPIO Mode to 'Output': Input(00), Output(01), AlterFunc(10), Analog(11)
-	GPIOB->MODER &= ~(3UL<<(2*PB4));  
-	GPIOB->MODER |=   1UL<<(2*PB4);      // Output(01)
-	GPIOB->MODER &= ~(3UL<<(2*PB5));  
-	GPIOB->MODER |=   1UL<<(2*PB5);      // Output(01)
-	
-	// 3. Configure GPIO Output Type to 'Push-Pull': Output push-pull (0), Output open drain (1) 
-	GPIOB->OTYPER &= ~(1<<PB4);      // Push-pull
-	GPIOB->OTYPER &= ~(1<<PB5);      // Push-pull
-	// 4. Configure GPIO Push-Pull to 'No Pull-up or Pull-down': No pull-up, pull-down (00), Pull-up (01), Pull-down (10), Reserved (11)
-	GPIOB->PUPDR  &= ~(3<<(2*PB4));  // No pull-up, no pull-down
-	GPIOB->PUPDR  &= ~(3<<(2*PB5));  // No pull-up, no pull-down
-}
+// Switch edges, pushed by the EXTI handlers and handled in main()
+static input_event_queue_t switch_events;
 
-void configure_Push_Button_pin(){
-  // 1. Enable the clock to GPIO Port A	
-  RCC->AHB2ENR |= RCC_AHB2ENR_GPIOCEN;   
-		
-	// 2. Configure GPIO Mode to 'Input': Input(00), Output(01), AlterFunc(10), Analog(11)
-	GPIOC->MODER &= ~(3UL<<(2*PC2));  	// Input (00)
-	GPIOC->MODER &= ~(3UL<<(2*PC3));  	// Input (00)
-	
-	// 3. Configure GPIO Push-Pull to 'No Pull-up or Pull-down': No pull-up, pull-down (00), Pull-up (01), Pull-down (10), Reserved (11)
-	GPIOC->PUPDR  &= ~(3<<(2*PC2));  // No pull-up, no pull-down
-	GPIOC->PUPDR  &= ~(3<<(2*PC3));  // No pull-up, no pull-down
-}
+#if LED_FADE_MODE
+// Brightness each LED is fading towards: LED1 off, LED2 on
+static uint8_t led_target[LED_PWM_NUM_CHANNELS] = { 0, 255 };
+#endif
 
-// Modular function to turn on the LD2 LED.
-void turn_on_LED1(){
-	GPIOB->ODR |= 1 << PB4;
-}
-void turn_on_LED2(){
-	GPIOB->ODR &= ~(1 << PB5);
-}
 
-// Modular function to turn off the LD2 LED.
-void turn_off_LED1(){
-	GPIOB->ODR &= ~(1 << PB4);
-}
-void turn_off_LED2(){
-	GPIOB->ODR |= 1 << PB5;
+void configure_LED_pin(){
+	// Clock, mode (output), push-pull and no pull-up/pull-down come from the
+	// LED1/LED2 descriptors in lab_board.h
+	gpio_pin_configure(&LED1);
+	gpio_pin_configure(&LED2);
 }
 
-// Modular function to toggle the LD2 LED.
-void toggle_LED1(){
-	GPIOB->ODR ^= (1 << PB4);
-}
-void toggle_LED2(){
-	GPIOB->ODR ^= (1 << PB5);
+void configure_Push_Button_pin(){
+	// Clock, mode (input) and no pull-up/pull-down come from the
+	// SW1/SW2 descriptors in lab_board.h
+	gpio_pin_configure(&SW1);
+	gpio_pin_configure(&SW2);
 }
 
 void configure_EXTI2(void){
@@ -123,15 +97,16 @@ void configure_EXTI3(void){
 }
 
 // ISR (interrupt handler) for EXTI2. Interrupt handlers are initially defined in startup_stml476xx.s.
+// The handler only records the edge; the LED is toggled from the main loop.
 void EXTI2_IRQHandler(void) {  
-	EXTI->PR1 |= EXTI_PR1_PIF2;
-	toggle_LED1();
+	exti_pin_clear(&SW1);
+	input_event_push(&switch_events, &SW1, INPUT_EDGE_RISING);
 }
 
 // ISR (interrupt handler) for EXTI3. Interrupt handlers are initially defined in startup_stml476xx.s.
 void EXTI3_IRQHandler(void) {  
-	EXTI->PR1 |= EXTI_PR1_PIF3;
-	toggle_LED2();
+	exti_pin_clear(&SW2);
+	input_event_push(&switch_events, &SW2, INPUT_EDGE_FALLING);
 }
 
 int main(void){
@@ -141,9 +116,36 @@ int main(void){
 	//2. Invoke configure_Push_Button_pin() to initialize PC2 and PC3 as an input pin.
 	configure_Push_Button_pin();
 	
+	input_event_timestamp_init();
+	input_event_queue_init(&switch_events);
 	configure_EXTI2();
 	configure_EXTI3();
+#if LED_FADE_MODE
+	//3. Hand the LEDs to TIM3, starting in the same state as above (LED2 on)
+	led_pwm_init();
+	led_pwm_set(LED_PWM_CHANNEL_LED2, 255);
+#endif
 	
 	while(1){
+		input_event_t event;
+		
+		// SW1 (PC2) toggles LED1, SW2 (PC3) toggles LED2
+		while(input_event_pop(&switch_events, &event)){
+#if LED_FADE_MODE
+			uint8_t channel = (event.pin == PC2) ? LED_PWM_CHANNEL_LED1 : LED_PWM_CHANNEL_LED2;
+			
+			// A fade starts from the current brightness, so a press during
+			// a fade turns it around from where it has got to
+			led_target[channel] = 255 - led_target[channel];
+			led_pwm_fade(channel, led_target[channel], LED_FADE_MS);
+#else
+			if(event.pin == PC2){
+				gpio_pin_toggle(&LED1);
+			}
+			else{
+				gpio_pin_toggle(&LED2);
+			}
+#endif
+		}
 	}
 }
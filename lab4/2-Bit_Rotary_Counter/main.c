@@ -3,176 +3,200 @@ Title: Imeplementation of 2-bit Rotary Counter.
 Description: Imeplementation of 2-bit Rotary Counter which 
              utilizes interrupt. Switch1 increments from 0 to 
 	     3 and Switch2 decrements from 3 to 0. 
+	     The counter is table driven (rotary_counter.c): each
+	     step is a lookup and one BSRR store that updates
+	     both LEDs together.
+	     With COUNTER_USE_GESTURES the switches go through the
+	     gesture recognizer (button_gesture.c): a short press
+	     steps once, a double click twice, and holding a
+	     switch steps at LONG and then at every REPEAT.
 Hardware Connections(Circuit): Refer Lab2 
 ************************************************************/
 
 #include "stm32l476xx.h"
-
-
-#define PB4   4	//LED1
-#define PB5		5	//LED2
-#define	PC2		2	//SW1
-#define PC3		3	//SW2
-
-/*2-bit rotary counter*/
-static volatile int counter = 0;
+#include "lab_board.h"
+#include "lab_clock.h"
+#include "debounce.h"
+#include "rotary_counter.h"
+#include "quadrature_encoder.h"
+#include "input_event_queue.h"
+#include "button_gesture.h"
+
+// Counter input: 0 = SW1/SW2 on EXTI2/EXTI3 with debouncing,
+//                1 = quadrature encoder counted in hardware by TIM4 (PB6/PB7)
+#ifndef COUNTER_USE_ENCODER
+#define COUNTER_USE_ENCODER 0
+#endif
+
+// Switch presses: 0 = every press steps once,
+//                 1 = short, double, long and repeat gestures (button_gesture.c)
+#ifndef COUNTER_USE_GESTURES
+#define COUNTER_USE_GESTURES 0
+#endif
+
+#define SW1_DEBOUNCE 0	//debounce channel of SW1
+#define SW2_DEBOUNCE 1	//debounce channel of SW2
+
+#define COUNTER_BITS 2
+
+/*2-bit rotary counter: LED1 shows bit 1, LED2 shows bit 0*/
+static const gpio_pin_t *const counter_leds[COUNTER_BITS] = { &LED2, &LED1 };
+static rotary_counter_t counter;
+
+// Debounced switch edges, handled in main()
+static input_event_queue_t switch_events;
+
+void switch_event(uint8_t channel, debounce_event_t event);
+
+#if COUNTER_USE_GESTURES
+// Gesture times in DWT cycles, the timestamps of the input event queue
+#define GESTURE_MS(ms) ((uint32_t)(ms) * (LAB_CORE_CLOCK_HZ / 1000UL))
+
+static const gesture_timing_t gesture_timing = {
+	GESTURE_MS(500),	// long_press
+	GESTURE_MS(250),	// double_gap
+	GESTURE_MS(300),	// repeat_delay
+	GESTURE_MS(150),	// repeat_interval
+};
+
+// One recognizer per switch, indexed by debounce channel
+static button_gesture_t switch_gestures[2];
+
+// SW1 gestures count up, SW2 gestures count down
+static void counter_gesture(uint8_t channel, gesture_t gesture){
+	rotary_event_t step = (channel == SW1_DEBOUNCE) ? ROTARY_EVENT_UP : ROTARY_EVENT_DOWN;
+
+	switch(gesture){
+		case GESTURE_DOUBLE:
+			rotary_counter_step(&counter, step);
+			/* fall through */
+		case GESTURE_SHORT:
+		case GESTURE_LONG:
+		case GESTURE_REPEAT:
+			rotary_counter_step(&counter, step);
+			break;
+		default:
+			break;
+	}
+}
+#endif
 
 void configure_LED_pin(){
-  // 1. Enable the clock to GPIO Port B	
-  RCC->AHB2ENR |= RCC_AHB2ENR_GPIOBEN;   
-		
-	// 2. Configure GPIO Mode to 'Output': Input(00), Output(01), AlterFunc(10), Analog(11)
-	GPIOB->MODER &= ~(3UL<<(2*PB4));  
-	GPIOB->MODER |=   1UL<<(2*PB4);      // Output(01)
-	GPIOB->MODER &= ~(3UL<<(2*PB5));  
-	GPIOB->MODER |=   1UL<<(2*PB5);      // Output(01)
-	
-	// 3. Configure GPIO Output Type to 'Push-Pull': Output push-pull (0), Output open drain (1) 
-	GPIOB->OTYPER &= ~(1<<PB4);      // Push-pull
-	GPIOB->OTYPER &= ~(1<<PB5);      // Push-pull
-	// 4. Configure GPIO Push-Pull to 'No Pull-up or Pull-down': No pull-up, pull-down (00), Pull-up (01), Pull-down (10), Reserved (11)
-	GPIOB->PUPDR  &= ~(3<<(2*PB4));  // No pull-up, no pull-down
-	GPIOB->PUPDR  &= ~(3<<(2*PB5));  // No pull-up, no pull-down
+	// Clock, mode (output), push-pull and no pull-up/pull-down come from the
+	// LED1/LED2 descriptors in lab_board.h
+	gpio_pin_configure(&LED1);
+	gpio_pin_configure(&LED2);
 }
 
 void configure_Push_Button_pin(){
-  // 1. Enable the clock to GPIO Port A	
-  RCC->AHB2ENR |= RCC_AHB2ENR_GPIOCEN;   
-		
-	// 2. Configure GPIO Mode to 'Input': Input(00), Output(01), AlterFunc(10), Analog(11)
-	GPIOC->MODER &= ~(3UL<<(2*PC2));  	// Input (00)
-	GPIOC->MODER &= ~(3UL<<(2*PC3));  	// Input (00)
-	
-	// 3. Configure GPIO Push-Pull to 'No Pull-up or Pull-down': No pull-up, pull-down (00), Pull-up (01), Pull-down (10), Reserved (11)
-	GPIOC->PUPDR  &= ~(3<<(2*PC2));  // No pull-up, no pull-down
-	GPIOC->PUPDR  &= ~(3<<(2*PC3));  // No pull-up, no pull-down
+	// Clock, mode (input) and no pull-up/pull-down come from the
+	// SW1/SW2 descriptors in lab_board.h
+	gpio_pin_configure(&SW1);
+	gpio_pin_configure(&SW2);
 }
 
-// Modular function to turn on the LD2 LED.
-void turn_on_LED1(){
-	GPIOB->ODR |= 1 << PB4;
-}
-void turn_on_LED2(){
-	GPIOB->ODR &= ~(1 << PB5);
-}
+#if !COUNTER_USE_ENCODER
+// SW1 (PC2) counts up, SW2 (PC3) counts down. Both go through the debounce
+// service so a bouncing contact produces exactly one press.
+void configure_switch_debounce(void){
+	const debounce_config_t sw1_config = { &SW1, DEBOUNCE_DEFAULT_WINDOW_MS, switch_event };
+	const debounce_config_t sw2_config = { &SW2, DEBOUNCE_DEFAULT_WINDOW_MS, switch_event };
 
-// Modular function to turn off the LD2 LED.
-void turn_off_LED1(){
-	GPIOB->ODR &= ~(1 << PB4);
+	debounce_init();
+	debounce_add(SW1_DEBOUNCE, &sw1_config);
+	debounce_add(SW2_DEBOUNCE, &sw2_config);
 }
-void turn_off_LED2(){
-	GPIOB->ODR |= 1 << PB5;
-}
-
-// Modular function to toggle the LD2 LED.
-void toggle_LED1(){
-	GPIOB->ODR ^= (1 << PB4);
-}
-void toggle_LED2(){
-	GPIOB->ODR ^= (1 << PB5);
-}
-
-void configure_EXTI2(void){
 
-	//1. Enable the EXTI2 interrupt in NVIC using a function from CMSIS's core_cm4.h.
-	NVIC_EnableIRQ(EXTI2_IRQn); 
-	
-	//2. Configure the SYSCFG module to link EXTI line 2 to GPIO PC2
-	RCC->APB2ENR |= RCC_APB2ENR_SYSCFGEN;							// Enable the clock to SYSCFG
-	SYSCFG->EXTICR[0] &= ~SYSCFG_EXTICR1_EXTI2;     	// Clear the EXTI2 bits in SYSCFG's EXTICR0 register.
-	SYSCFG->EXTICR[0] |=  SYSCFG_EXTICR1_EXTI2_PC; 	// Set PC2 as the EXTI2 source in SYSCFG_EXTICR0.
-
-	// 3. Enable (unmask) the EXTI2 interrupt by setting its corresponding bit in the EXTI's IMR.
-	EXTI->IMR1 |= (1<<PC2);     //Interrupt Mask Register (IMR): 0 = marked, 1 = not masked (i.e., enabled)
-	
-	//4. Enable interrupt trigger for rising (button press) edge.
-	EXTI->RTSR1 |= (1<<PC2);  //Rising trigger selection register (RTSR):0 = disabled, 1 = enabled
-	//EXTI->FTSR1 |= (1<<PC2);  //Falling trigger selection register (FTSR): 0 = disabled, 1 = enabled
-}
-
-void configure_EXTI3(void){
-
-	//1. Enable the EXTI3 interrupt in NVIC using a function from CMSIS's core_cm4.h.
-	NVIC_EnableIRQ(EXTI3_IRQn); 
-	
-	//2. Configure the SYSCFG module to link EXTI line 3 to GPIO PC3
-	RCC->APB2ENR |= RCC_APB2ENR_SYSCFGEN;							// Enable the clock to SYSCFG
-	SYSCFG->EXTICR[0] &= ~SYSCFG_EXTICR1_EXTI3;     	// Clear the EXTI13 bits in SYSCFG's EXTICR4 register.
-	SYSCFG->EXTICR[0] |=  SYSCFG_EXTICR1_EXTI3_PC; 	// Set PC13 (0010) as the EXTI13 source in SYSCFG_EXTICR4.
-
-	// 3. Enable (unmask) the EXTI3 interrupt by setting its corresponding bit in the EXTI's IMR.
-	EXTI->IMR1 |= (1<<PC3);     //Interrupt Mask Register (IMR): 0 = marked, 1 = not masked (i.e., enabled)
-	
-	//4. Enable interrupt trigger for falling (button press) edge.
-	//EXTI->RTSR1 |= (1<<PC3);  //Rising trigger selection register (RTSR):0 = disabled, 1 = enabled
-	EXTI->FTSR1 |= (1<<PC3);  //Falling trigger selection register (FTSR): 0 = disabled, 1 = enabled
-	
+// Debounced switch events, called from the TIM2 interrupt. The confirmed
+// press or release is queued as the edge that led to it, with a timestamp,
+// and the counter is stepped from the main loop. The pin is not read again:
+// it may already be bouncing towards the next event.
+void switch_event(uint8_t channel, debounce_event_t event) {
+	const gpio_pin_t *sw = (channel == SW1_DEBOUNCE) ? &SW1 : &SW2;
+	uint8_t high = (uint8_t)((event == DEBOUNCE_PRESSED) ^ sw->active_low);
 
+	input_event_push(&switch_events, sw, high ? INPUT_EDGE_RISING : INPUT_EDGE_FALLING);
 }
 
 // ISR (interrupt handler) for EXTI2. Interrupt handlers are initially defined in startup_stml476xx.s.
 void EXTI2_IRQHandler(void) {  
-	EXTI->PR1 |= EXTI_PR1_PIF2;
-	
-	if(counter == 0){
-		turn_off_LED1();
-		turn_off_LED2();
-		counter++;
-	}
-	else if(counter == 1){
-		turn_off_LED1();
-		turn_on_LED2();
-		counter++;
-	}
-	else if(counter == 2){
-		turn_on_LED1();
-		turn_off_LED2();
-		counter++;
-	}
-	else if(counter == 3){
-		turn_on_LED1();
-		turn_on_LED2();
-		counter = 0;
-	}
+	debounce_edge(SW1_DEBOUNCE);
 }
 
 // ISR (interrupt handler) for EXTI3. Interrupt handlers are initially defined in startup_stml476xx.s.
 void EXTI3_IRQHandler(void) {  
-	EXTI->PR1 |= EXTI_PR1_PIF3;
-	
-	if(counter == 0){
-		turn_off_LED1();
-		turn_off_LED2();
-		counter = 3;
-	}
-	else if(counter == 1){
-		turn_off_LED1();
-		turn_on_LED2();
-		counter--;
-	}
-	else if(counter == 2){
-		turn_on_LED1();
-		turn_off_LED2();
-		counter--;
-	}
-	else if(counter == 3){
-		turn_on_LED1();
-		turn_on_LED2();
-		counter--;
-	}
+	debounce_edge(SW2_DEBOUNCE);
 }
 
+// ISR (interrupt handler) for TIM2, the debounce time base.
+void TIM2_IRQHandler(void) {
+	debounce_timer_isr();
+}
+#else
+// ISR (interrupt handler) for TIM4, encoder threshold compares.
+void TIM4_IRQHandler(void) {
+	encoder_isr();
+}
+#endif
+
 int main(void){
 	int i;
 	//1. Invoke configure_LED_pin() to initialize PA5 as an output pin, interfacing with the LD2 LED.
 	configure_LED_pin();
 	//2. Invoke configure_Push_Button_pin() to initialize PC2 and PC3 as an input pin.
 	configure_Push_Button_pin();
-	turn_on_LED1();
-	turn_on_LED2();
-	configure_EXTI2();
-	configure_EXTI3();
+	//3. Build the counter's transition table and show 0 on the LEDs.
+	rotary_counter_init(&counter, counter_leds, COUNTER_BITS, 0);
+#if COUNTER_USE_ENCODER
+	//4. Count detents in TIM4, wrapping at the same modulus as the counter.
+	encoder_init((1UL << COUNTER_BITS) * ENCODER_COUNTS_PER_DETENT, ENCODER_DEFAULT_FILTER, 0);
+#else
+	//4. Count debounced switch presses.
+	input_event_timestamp_init();
+	input_event_queue_init(&switch_events);
+#if COUNTER_USE_GESTURES
+	button_gesture_init(&switch_gestures[SW1_DEBOUNCE], &gesture_timing);
+	button_gesture_init(&switch_gestures[SW2_DEBOUNCE], &gesture_timing);
+#endif
+	configure_switch_debounce();
+#endif
 	
 	while(1){
+#if COUNTER_USE_ENCODER
+		// The count lives in TIM4; refresh the LEDs only when the detent changes
+		uint8_t value = (uint8_t)(encoder_count() / ENCODER_COUNTS_PER_DETENT);
+		if(value != rotary_counter_value(&counter)){
+			rotary_counter_set(&counter, value);
+		}
+#else
+		input_event_t event;
+		
+		// SW1 (PC2) presses count up, SW2 (PC3) presses count down
+		while(input_event_pop(&switch_events, &event)){
+			const gpio_pin_t *sw = (event.pin == PC2) ? &SW1 : &SW2;
+			
+#if COUNTER_USE_GESTURES
+			uint8_t channel = (sw == &SW1) ? SW1_DEBOUNCE : SW2_DEBOUNCE;
+			
+			counter_gesture(channel, button_gesture_edge(&switch_gestures[channel],
+			                                             input_event_activated(&event, sw), event.timestamp));
+#else
+			if(input_event_activated(&event, sw)){
+				rotary_counter_step(&counter, sw == &SW1 ? ROTARY_EVENT_UP : ROTARY_EVENT_DOWN);
+			}
+#endif
+		}
+#if COUNTER_USE_GESTURES
+		// Timeouts (SHORT after the double click gap, LONG, REPEAT). 'now' is
+		// read before the queue is checked, so an edge queued after the check
+		// has a later timestamp and cannot be overtaken by its own timeout.
+		uint32_t now = input_event_timestamp();
+		
+		if(input_event_pending(&switch_events) == 0){
+			counter_gesture(SW1_DEBOUNCE, button_gesture_timeout(&switch_gestures[SW1_DEBOUNCE], now));
+			counter_gesture(SW2_DEBOUNCE, button_gesture_timeout(&switch_gestures[SW2_DEBOUNCE], now));
+		}
+#endif
+#endif
 	}
  }
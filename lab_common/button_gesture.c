@@ -0,0 +1,114 @@
+#include "button_gesture.h"
+
+enum {
+	STATE_IDLE,          // released, nothing pending
+	STATE_FIRST_PRESS,   // pressed, waiting for release or long_press
+	STATE_WAIT_SECOND,   // released after a short press, waiting for double_gap
+	STATE_SECOND_PRESS,  // DOUBLE reported, waiting for release
+	STATE_HELD           // LONG reported, repeating while held
+};
+
+// Wrap-safe "a is at or after b" for free-running timestamps
+static uint8_t time_reached(uint32_t a, uint32_t b){
+	return (int32_t)(a - b) >= 0;
+}
+
+static void arm(button_gesture_t *b, uint32_t deadline){
+	b->deadline = deadline;
+	b->deadline_armed = 1;
+}
+
+void button_gesture_init(button_gesture_t *b, const gesture_timing_t *timing){
+	b->timing = timing;
+	b->deadline = 0;
+	b->state = STATE_IDLE;
+	b->deadline_armed = 0;
+}
+
+gesture_t button_gesture_timeout(button_gesture_t *b, uint32_t now){
+	const gesture_timing_t *t = b->timing;
+
+	if(!b->deadline_armed || !time_reached(now, b->deadline)){
+		return GESTURE_NONE;
+	}
+	b->deadline_armed = 0;
+
+	switch(b->state){
+		case STATE_FIRST_PRESS:
+			b->state = STATE_HELD;
+			if(t->repeat_interval != 0){
+				arm(b, b->deadline + t->repeat_delay);
+			}
+			return GESTURE_LONG;
+
+		case STATE_WAIT_SECOND:
+			b->state = STATE_IDLE;
+			return GESTURE_SHORT;
+
+		case STATE_HELD:
+			// Step from the previous deadline so the repeat rate does not drift;
+			// if several repeats were missed only one is reported.
+			arm(b, b->deadline + t->repeat_interval);
+			if(time_reached(now, b->deadline)){
+				arm(b, now + t->repeat_interval);
+			}
+			return GESTURE_REPEAT;
+
+		default:
+			return GESTURE_NONE;
+	}
+}
+
+gesture_t button_gesture_edge(button_gesture_t *b, uint8_t pressed, uint32_t now){
+	const gesture_timing_t *t = b->timing;
+	gesture_t expired = button_gesture_timeout(b, now);
+
+	if(pressed){
+		switch(b->state){
+			case STATE_IDLE:
+				b->state = STATE_FIRST_PRESS;
+				arm(b, now + t->long_press);
+				break;
+
+			case STATE_WAIT_SECOND:
+				b->state = STATE_SECOND_PRESS;
+				b->deadline_armed = 0;
+				return GESTURE_DOUBLE;
+
+			default:
+				// Repeated press without a release (lost edge): ignore
+				break;
+		}
+	}
+	else{
+		switch(b->state){
+			case STATE_FIRST_PRESS:
+				if(t->double_gap == 0){
+					b->state = STATE_IDLE;
+					b->deadline_armed = 0;
+					return GESTURE_SHORT;
+				}
+				b->state = STATE_WAIT_SECOND;
+				arm(b, now + t->double_gap);
+				break;
+
+			case STATE_SECOND_PRESS:
+			case STATE_HELD:
+				b->state = STATE_IDLE;
+				b->deadline_armed = 0;
+				break;
+
+			default:
+				break;
+		}
+	}
+	// Only timeouts report gestures on the paths that fall through here
+	return expired;
+}
+
+uint8_t button_gesture_deadline(const button_gesture_t *b, uint32_t *deadline){
+	if(b->deadline_armed){
+		*deadline = b->deadline;
+	}
+	return b->deadline_armed;
+}
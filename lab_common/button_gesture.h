@@ -0,0 +1,65 @@
+/***********************************************************
+Title: Button gesture recognizer.
+Description: Turns the press/release edges of one button into
+				short, long, double and repeat gestures:
+				SHORT   press and release, no second press
+				        within 'double_gap'
+				DOUBLE  second press within 'double_gap' of
+				        the first release
+				LONG    held for 'long_press'
+				REPEAT  still held 'repeat_delay' after LONG,
+				        then every 'repeat_interval'
+				The recognizer works on timestamps only. Edges
+				are fed with the time they happened (e.g. from
+				the input event queue); timeouts are resolved by
+				button_gesture_timeout() at the time reported by
+				button_gesture_deadline(), so a one-shot timer
+				can be armed instead of polling.
+				No hardware access: the same code runs on the
+				board and on the host. Each button needs one
+				button_gesture_t, nothing is allocated.
+************************************************************/
+
+#ifndef __LAB_BUTTON_GESTURE_H
+#define __LAB_BUTTON_GESTURE_H
+
+#include <stdint.h>
+
+typedef enum {
+	GESTURE_NONE = 0,
+	GESTURE_SHORT,
+	GESTURE_LONG,
+	GESTURE_DOUBLE,
+	GESTURE_REPEAT
+} gesture_t;
+
+// All times in timestamp units (ms, timer ticks or core cycles, as long as
+// they match the timestamps passed in). A zero double_gap disables DOUBLE
+// (SHORT is then reported on release), a zero repeat_interval disables REPEAT.
+typedef struct {
+	uint32_t long_press;
+	uint32_t double_gap;
+	uint32_t repeat_delay;
+	uint32_t repeat_interval;
+} gesture_timing_t;
+
+typedef struct {
+	const gesture_timing_t *timing;
+	uint32_t deadline;
+	uint8_t state;
+	uint8_t deadline_armed;
+} button_gesture_t;
+
+void button_gesture_init(button_gesture_t *b, const gesture_timing_t *timing);
+
+// Feed one edge (pressed = 1 for press, 0 for release) that happened at 'now'.
+// A timeout that expired before 'now' is resolved first.
+gesture_t button_gesture_edge(button_gesture_t *b, uint8_t pressed, uint32_t now);
+
+// Resolve a timeout; returns GESTURE_NONE if the deadline has not been reached
+gesture_t button_gesture_timeout(button_gesture_t *b, uint32_t now);
+
+// Returns 1 and the time of the next timeout if one is pending
+uint8_t button_gesture_deadline(const button_gesture_t *b, uint32_t *deadline);
+
+#endif /* __LAB_BUTTON_GESTURE_H */
@@ -0,0 +1,121 @@
+#include "debounce.h"
+#include "exti_pin.h"
+#include "lab_clock.h"
+
+typedef struct {
+	const gpio_pin_t *pin;
+	debounce_callback_t callback;
+	uint16_t window_ms;
+	volatile uint8_t stable;       // last confirmed logical level
+} debounce_channel_t;
+
+static debounce_channel_t channels[DEBOUNCE_MAX_CHANNELS];
+
+// CCR1..CCR4 are consecutive registers
+#define DEBOUNCE_CCR(channel)  ((&TIM2->CCR1)[channel])
+
+//-------------------------------------------------------------------------------------------
+// Arm the one-shot compare of a channel. The EXTI line stays masked until it fires.
+//-------------------------------------------------------------------------------------------
+static void debounce_arm(uint8_t channel){
+	debounce_channel_t *ch = &channels[channel];
+
+	exti_pin_mask(ch->pin);
+	DEBOUNCE_CCR(channel) = TIM2->CNT + ch->window_ms;
+	TIM2->SR = ~(TIM_SR_CC1IF << channel);   // SR is write-0-to-clear
+	TIM2->DIER |= TIM_DIER_CC1IE << channel;
+}
+
+//-------------------------------------------------------------------------------------------
+// The window has elapsed: sample the settled level and report a change.
+//-------------------------------------------------------------------------------------------
+static void debounce_confirm(uint8_t channel){
+	debounce_channel_t *ch = &channels[channel];
+	uint8_t level = (uint8_t)gpio_pin_is_active(ch->pin);
+
+	if(level != ch->stable){
+		ch->stable = level;
+		if(ch->callback != 0){
+			ch->callback(channel, level ? DEBOUNCE_PRESSED : DEBOUNCE_RELEASED);
+		}
+	}
+
+	// Listen for the next edge. An edge between the sample above and the
+	// unmask would be lost, so compare against the pin once more.
+	exti_pin_clear(ch->pin);
+	exti_pin_unmask(ch->pin);
+	if(gpio_pin_is_active(ch->pin) != ch->stable){
+		debounce_arm(channel);
+	}
+}
+
+void debounce_init(void){
+	uint8_t i;
+
+	for(i = 0; i < DEBOUNCE_MAX_CHANNELS; i++){
+		channels[i].pin = 0;
+		channels[i].callback = 0;
+	}
+
+	// TIM2 counts milliseconds over its full 32-bit range; compares wrap with it
+	RCC->APB1ENR1 |= RCC_APB1ENR1_TIM2EN;
+	TIM2->CR1 &= ~TIM_CR1_CEN;
+	TIM2->PSC  = LAB_CORE_CLOCK_HZ / DEBOUNCE_TICK_HZ - 1;
+	TIM2->ARR  = 0xFFFFFFFFUL;
+	TIM2->CNT  = 0;
+	TIM2->DIER = 0;
+	TIM2->EGR  = TIM_EGR_UG;   // load the prescaler now
+	TIM2->SR   = 0;
+	NVIC_EnableIRQ(TIM2_IRQn);
+	TIM2->CR1 |= TIM_CR1_CEN;
+}
+
+int debounce_add(uint8_t channel, const debounce_config_t *config){
+	debounce_channel_t *ch;
+
+	if(channel >= DEBOUNCE_MAX_CHANNELS || config->pin == 0){
+		return -1;
+	}
+	ch = &channels[channel];
+	ch->pin = config->pin;
+	ch->callback = config->callback;
+	debounce_set_window(channel, config->window_ms);
+	ch->stable = (uint8_t)gpio_pin_is_active(ch->pin);
+
+	exti_pin_configure(ch->pin, EXTI_EDGE_BOTH);
+	return 0;
+}
+
+void debounce_set_window(uint8_t channel, uint16_t window_ms){
+	if(channel < DEBOUNCE_MAX_CHANNELS){
+		// A zero window would only fire after the counter wrapped
+		channels[channel].window_ms = window_ms ? window_ms : 1;
+	}
+}
+
+uint8_t debounce_is_pressed(uint8_t channel){
+	return channel < DEBOUNCE_MAX_CHANNELS ? channels[channel].stable : 0;
+}
+
+void debounce_edge(uint8_t channel){
+	if(channel >= DEBOUNCE_MAX_CHANNELS || channels[channel].pin == 0){
+		return;
+	}
+	exti_pin_clear(channels[channel].pin);
+	debounce_arm(channel);
+}
+
+void debounce_timer_isr(void){
+	uint32_t pending = TIM2->SR & TIM2->DIER;
+	uint8_t i;
+
+	for(i = 0; i < DEBOUNCE_MAX_CHANNELS; i++){
+		uint32_t flag = TIM_SR_CC1IF << i;
+
+		if(pending & flag){
+			TIM2->SR = ~flag;
+			TIM2->DIER &= ~(TIM_DIER_CC1IE << i);
+			debounce_confirm(i);
+		}
+	}
+}
@@ -0,0 +1,70 @@
+/***********************************************************
+Title: Timer based switch debouncing for EXTI inputs.
+Description: The first edge on a switch masks its EXTI line
+				and arms a one-shot compare on TIM2. When the
+				compare fires the switch has had 'window_ms'
+				to settle; its level is sampled once and, if
+				it differs from the last confirmed level, a
+				press or release event is posted through the
+				channel's callback. Then the EXTI line is
+				unmasked again. Bounces inside the window never
+				reach the CPU and nothing busy waits.
+Timer:
+				TIM2 free-runs at DEBOUNCE_TICK_HZ; each of its
+				four compare channels is the one-shot of one
+				debounce channel, so every switch can have its
+				own window.
+Usage:
+				EXTIx_IRQHandler: debounce_edge(channel);
+				TIM2_IRQHandler:  debounce_timer_isr();
+				Keep those interrupts at the same priority.
+************************************************************/
+
+#ifndef __LAB_DEBOUNCE_H
+#define __LAB_DEBOUNCE_H
+
+#include "gpio_pin.h"
+
+// One debounce channel per TIM2 compare channel
+#define DEBOUNCE_MAX_CHANNELS 4
+
+// Debounce timer resolution: 1 tick = 1 ms
+#define DEBOUNCE_TICK_HZ 1000UL
+
+// Default settling time for mechanical switches
+#define DEBOUNCE_DEFAULT_WINDOW_MS 20
+
+typedef enum {
+	DEBOUNCE_RELEASED = 0,
+	DEBOUNCE_PRESSED  = 1
+} debounce_event_t;
+
+// Called from the TIM2 interrupt with the confirmed new state of the switch
+typedef void (*debounce_callback_t)(uint8_t channel, debounce_event_t event);
+
+typedef struct {
+	const gpio_pin_t *pin;         // switch input; polarity decides what "pressed" means
+	uint16_t window_ms;            // settling time, 1..65535 ms
+	debounce_callback_t callback;
+} debounce_config_t;
+
+// Start TIM2 as the free-running debounce time base
+void debounce_init(void);
+
+// Attach a switch to a channel (0..DEBOUNCE_MAX_CHANNELS-1) and enable its EXTI
+// line on both edges. Returns 0 on success, -1 for an invalid channel.
+int debounce_add(uint8_t channel, const debounce_config_t *config);
+
+// Change the settling time of a channel; used from the next edge on
+void debounce_set_window(uint8_t channel, uint16_t window_ms);
+
+// Last confirmed state of the switch (1 = pressed)
+uint8_t debounce_is_pressed(uint8_t channel);
+
+// To be called from the EXTI interrupt of the channel's pin
+void debounce_edge(uint8_t channel);
+
+// To be called from TIM2_IRQHandler
+void debounce_timer_isr(void);
+
+#endif /* __LAB_DEBOUNCE_H */
@@ -0,0 +1,79 @@
+/***********************************************************
+Title: EXTI line helpers for GPIO pin descriptors.
+Description: EXTI line n is routed from pin n of one GPIO
+				port (selected in SYSCFG_EXTICRx), so a pin
+				descriptor is enough to configure its line.
+				Pending bits are cleared with a plain store:
+				PR1 is write-1-to-clear, and 'PR1 |= bit'
+				would also clear every other pending line.
+************************************************************/
+
+#ifndef __LAB_EXTI_PIN_H
+#define __LAB_EXTI_PIN_H
+
+#include "gpio_pin.h"
+
+// Edge selection for exti_pin_configure()
+#define EXTI_EDGE_RISING   1U
+#define EXTI_EDGE_FALLING  2U
+#define EXTI_EDGE_BOTH     (EXTI_EDGE_RISING | EXTI_EDGE_FALLING)
+
+// NVIC interrupt shared by the pin's EXTI line
+static inline IRQn_Type exti_pin_irqn(const gpio_pin_t *p){
+	if(p->pin <= 4){
+		return (IRQn_Type)(EXTI0_IRQn + p->pin);
+	}
+	if(p->pin <= 9){
+		return EXTI9_5_IRQn;
+	}
+	return EXTI15_10_IRQn;
+}
+
+static inline void exti_pin_clear(const gpio_pin_t *p){
+	EXTI->PR1 = gpio_pin_mask(p);
+}
+
+static inline uint32_t exti_pin_pending(const gpio_pin_t *p){
+	return EXTI->PR1 & gpio_pin_mask(p);
+}
+
+static inline void exti_pin_mask(const gpio_pin_t *p){
+	EXTI->IMR1 &= ~gpio_pin_mask(p);
+}
+
+static inline void exti_pin_unmask(const gpio_pin_t *p){
+	EXTI->IMR1 |= gpio_pin_mask(p);
+}
+
+// Link the EXTI line to the pin's port, select the trigger edges,
+// unmask the line and enable its interrupt in the NVIC.
+static inline void exti_pin_configure(const gpio_pin_t *p, uint32_t edges){
+	uint32_t shift = 4 * (p->pin & 3U);
+	uint32_t mask = gpio_pin_mask(p);
+
+	// 1. Configure the SYSCFG module to link the EXTI line to the GPIO port
+	RCC->APB2ENR |= RCC_APB2ENR_SYSCFGEN;
+	SYSCFG->EXTICR[p->pin >> 2] &= ~(0x7UL << shift);
+	SYSCFG->EXTICR[p->pin >> 2] |=  gpio_pin_port_index(p) << shift;
+
+	// 2. Rising/falling trigger selection
+	if(edges & EXTI_EDGE_RISING){
+		EXTI->RTSR1 |= mask;
+	}
+	else{
+		EXTI->RTSR1 &= ~mask;
+	}
+	if(edges & EXTI_EDGE_FALLING){
+		EXTI->FTSR1 |= mask;
+	}
+	else{
+		EXTI->FTSR1 &= ~mask;
+	}
+
+	// 3. Drop any stale pending edge, unmask the line and enable it in the NVIC
+	exti_pin_clear(p);
+	exti_pin_unmask(p);
+	NVIC_EnableIRQ(exti_pin_irqn(p));
+}
+
+#endif /* __LAB_EXTI_PIN_H */
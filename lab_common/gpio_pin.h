@@ -0,0 +1,144 @@
+/***********************************************************
+Title: GPIO pin descriptors.
+Description: Header-only pin abstraction shared by the
+				STM32L476RG lab projects. A pin is described
+				once (port, pin, mode, pull, polarity) and the
+				inline helpers below turn every on/off into a
+				single store to the port's BSRR register:
+				- BSRR[15:0]  = 1 sets the output bit
+				- BSRR[31:16] = 1 resets the output bit
+				Unlike 'ODR |= ...' this is not a read-modify-
+				write, so an ISR touching another pin of the
+				same port can never lose an update.
+				Polarity is part of the descriptor, so active-
+				low (sink configuration) LEDs and pull-up
+				switches are handled in one place.
+************************************************************/
+
+#ifndef __LAB_GPIO_PIN_H
+#define __LAB_GPIO_PIN_H
+
+#include "stm32l476xx.h"
+#include <stdint.h>
+
+// MODER values: Input(00), Output(01), AlterFunc(10), Analog(11)
+#define GPIO_MODE_INPUT    0U
+#define GPIO_MODE_OUTPUT   1U
+#define GPIO_MODE_ALTFUNC  2U
+#define GPIO_MODE_ANALOG   3U
+
+// PUPDR values: No pull-up, pull-down (00), Pull-up (01), Pull-down (10)
+#define GPIO_PULL_NONE     0U
+#define GPIO_PULL_UP       1U
+#define GPIO_PULL_DOWN     2U
+
+// Positive logic: high = on/pressed. Negative logic: low = on/pressed.
+#define GPIO_ACTIVE_HIGH   0U
+#define GPIO_ACTIVE_LOW    1U
+
+typedef struct {
+	GPIO_TypeDef *port;
+	uint8_t pin;
+	uint8_t mode;
+	uint8_t pull;
+	uint8_t active_low;
+	uint8_t af;          // alternate function number, only used with GPIO_MODE_ALTFUNC
+} gpio_pin_t;
+
+// Descriptor initializers. Declare descriptors as 'static const' so the
+// compiler folds port, mask and polarity into the instructions.
+#define GPIO_PIN(port, pin, mode, pull, polarity, af) \
+	{ (port), (pin), (mode), (pull), (polarity), (af) }
+#define GPIO_OUTPUT_PIN(port, pin, polarity) \
+	GPIO_PIN(port, pin, GPIO_MODE_OUTPUT, GPIO_PULL_NONE, polarity, 0U)
+#define GPIO_INPUT_PIN(port, pin, pull, polarity) \
+	GPIO_PIN(port, pin, GPIO_MODE_INPUT, pull, polarity, 0U)
+#define GPIO_AF_PIN(port, pin, af) \
+	GPIO_PIN(port, pin, GPIO_MODE_ALTFUNC, GPIO_PULL_NONE, GPIO_ACTIVE_HIGH, af)
+
+// Every output change is a store of a BSRR word through this macro. A host
+// build can route it to a register model instead (see tools/lab_sim).
+#ifndef GPIO_BSRR_STORE
+#define GPIO_BSRR_STORE(port, word) ((port)->BSRR = (word))
+#endif
+
+// BSRR words for a pin, usable to build combined multi-pin writes
+#define GPIO_BSRR_SET(pin)    (1UL << (pin))
+#define GPIO_BSRR_RESET(pin)  (1UL << ((pin) + 16U))
+
+static inline uint32_t gpio_pin_mask(const gpio_pin_t *p){
+	return 1UL << p->pin;
+}
+
+// BSRR word that drives the pin to its active (on) level
+static inline uint32_t gpio_pin_on_word(const gpio_pin_t *p){
+	return p->active_low ? GPIO_BSRR_RESET(p->pin) : GPIO_BSRR_SET(p->pin);
+}
+
+// BSRR word that drives the pin to its inactive (off) level
+static inline uint32_t gpio_pin_off_word(const gpio_pin_t *p){
+	return p->active_low ? GPIO_BSRR_SET(p->pin) : GPIO_BSRR_RESET(p->pin);
+}
+
+// Port number of the pin: GPIOA = 0, GPIOB = 1, ... (ports are 0x400 apart)
+static inline uint32_t gpio_pin_port_index(const gpio_pin_t *p){
+	return (uint32_t)(((uintptr_t)p->port - (uintptr_t)GPIOA) /
+	                  ((uintptr_t)GPIOB - (uintptr_t)GPIOA));
+}
+
+// Configure the pin from its descriptor. Meant for start-up code: the
+// configuration registers are still updated read-modify-write.
+static inline void gpio_pin_configure(const gpio_pin_t *p){
+	// 1. Enable the clock to the GPIO port (GPIOAEN..GPIOHEN are consecutive bits)
+	RCC->AHB2ENR |= RCC_AHB2ENR_GPIOAEN << gpio_pin_port_index(p);
+
+	// 2. Configure GPIO Mode
+	p->port->MODER &= ~(3UL << (2 * p->pin));
+	p->port->MODER |=  (uint32_t)p->mode << (2 * p->pin);
+
+	// 3. Configure GPIO Output Type to 'Push-Pull'
+	p->port->OTYPER &= ~(1UL << p->pin);
+
+	// 4. Configure GPIO pull-up/pull-down
+	p->port->PUPDR &= ~(3UL << (2 * p->pin));
+	p->port->PUPDR |=  (uint32_t)p->pull << (2 * p->pin);
+
+	// 5. Select the alternate function (AFR[0] for pins 0-7, AFR[1] for pins 8-15)
+	if(p->mode == GPIO_MODE_ALTFUNC){
+		p->port->AFR[p->pin >> 3] &= ~(0xFUL << (4 * (p->pin & 7U)));
+		p->port->AFR[p->pin >> 3] |=  (uint32_t)p->af << (4 * (p->pin & 7U));
+	}
+}
+
+// Single BSRR store: LED on / switch asserted
+static inline void gpio_pin_on(const gpio_pin_t *p){
+	GPIO_BSRR_STORE(p->port, gpio_pin_on_word(p));
+}
+
+// Single BSRR store: LED off / switch released
+static inline void gpio_pin_off(const gpio_pin_t *p){
+	GPIO_BSRR_STORE(p->port, gpio_pin_off_word(p));
+}
+
+static inline void gpio_pin_write(const gpio_pin_t *p, int on){
+	GPIO_BSRR_STORE(p->port, on ? gpio_pin_on_word(p) : gpio_pin_off_word(p));
+}
+
+// Toggle through BSRR: ODR is only read, the write touches this pin alone
+static inline void gpio_pin_toggle(const gpio_pin_t *p){
+	uint32_t mask = gpio_pin_mask(p);
+	uint32_t odr = p->port->ODR;
+	GPIO_BSRR_STORE(p->port, ((odr & mask) << 16) | (~odr & mask));
+}
+
+// Raw electrical level of the pin (1 = high)
+static inline uint32_t gpio_pin_read(const gpio_pin_t *p){
+	return (p->port->IDR >> p->pin) & 1UL;
+}
+
+// Logical level of the pin with polarity applied (1 = on/pressed)
+static inline uint32_t gpio_pin_is_active(const gpio_pin_t *p){
+	return gpio_pin_read(p) ^ p->active_low;
+}
+
+#endif /* __LAB_GPIO_PIN_H */
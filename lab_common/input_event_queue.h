@@ -0,0 +1,106 @@
+/***********************************************************
+Title: Timestamped input event queue.
+Description: Fixed-size, lock-free single-producer/single-
+				consumer ring that carries input edges from the
+				EXTI interrupt handlers to the main loop. Each
+				entry records the pin, the edge and the DWT
+				cycle counter at the time of the interrupt, so
+				the handler only has to push and return: its
+				latency stays short and bounded, and the main
+				loop still knows when every edge happened.
+Concurrency:
+				The producer side only writes 'head', the
+				consumer side only writes 'tail'. Several EXTI
+				handlers may push into one queue as long as
+				they run at the same priority (they cannot
+				preempt each other, so they act as one
+				producer). When the ring is full the new event
+				is dropped and counted in 'dropped'.
+************************************************************/
+
+#ifndef __LAB_INPUT_EVENT_QUEUE_H
+#define __LAB_INPUT_EVENT_QUEUE_H
+
+#include "gpio_pin.h"
+
+// Ring size, must be a power of two
+#ifndef INPUT_EVENT_QUEUE_SIZE
+#define INPUT_EVENT_QUEUE_SIZE 16U
+#endif
+
+#define INPUT_EDGE_FALLING 0U
+#define INPUT_EDGE_RISING  1U
+
+typedef struct {
+	uint32_t timestamp;   // DWT->CYCCNT when the interrupt ran (core clock cycles)
+	uint8_t port;         // GPIO port index, 0 = GPIOA
+	uint8_t pin;          // pin number, equal to the EXTI line
+	uint8_t edge;         // INPUT_EDGE_RISING or INPUT_EDGE_FALLING
+} input_event_t;
+
+typedef struct {
+	input_event_t events[INPUT_EVENT_QUEUE_SIZE];
+	volatile uint32_t head;      // next slot to write, producer only
+	volatile uint32_t tail;      // next slot to read, consumer only
+	volatile uint32_t dropped;   // events lost because the ring was full
+} input_event_queue_t;
+
+// Start the DWT cycle counter used for timestamps
+static inline void input_event_timestamp_init(void){
+	CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+	DWT->CYCCNT = 0;
+	DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+}
+
+static inline uint32_t input_event_timestamp(void){
+	return DWT->CYCCNT;
+}
+
+static inline void input_event_queue_init(input_event_queue_t *q){
+	q->head = 0;
+	q->tail = 0;
+	q->dropped = 0;
+}
+
+// Producer (interrupt) side. Returns 0 if the event was queued, -1 if dropped.
+static inline int input_event_push(input_event_queue_t *q, const gpio_pin_t *p, uint8_t edge){
+	uint32_t head = q->head;
+	input_event_t *e;
+
+	if(head - q->tail >= INPUT_EVENT_QUEUE_SIZE){
+		q->dropped++;
+		return -1;
+	}
+	e = &q->events[head & (INPUT_EVENT_QUEUE_SIZE - 1U)];
+	e->timestamp = input_event_timestamp();
+	e->port = (uint8_t)gpio_pin_port_index(p);
+	e->pin = p->pin;
+	e->edge = edge;
+	__DMB();              // entry is complete before the consumer can see it
+	q->head = head + 1U;
+	return 0;
+}
+
+// Consumer (main loop) side. Returns 1 and fills 'event' if one was waiting.
+static inline int input_event_pop(input_event_queue_t *q, input_event_t *event){
+	uint32_t tail = q->tail;
+
+	if(tail == q->head){
+		return 0;
+	}
+	*event = q->events[tail & (INPUT_EVENT_QUEUE_SIZE - 1U)];
+	__DMB();              // entry is copied out before the slot is handed back
+	q->tail = tail + 1U;
+	return 1;
+}
+
+// 1 if the edge moved the pin to its active level (switch pressed), using the pin's polarity
+static inline uint8_t input_event_activated(const input_event_t *event, const gpio_pin_t *p){
+	return (uint8_t)((event->edge == INPUT_EDGE_RISING) ^ p->active_low);
+}
+
+static inline uint32_t input_event_pending(const input_event_queue_t *q){
+	return q->head - q->tail;
+}
+
+#endif /* __LAB_INPUT_EVENT_QUEUE_H */
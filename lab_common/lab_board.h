@@ -0,0 +1,35 @@
+/***********************************************************
+Title: Lab board pin map.
+Description: LEDs and switches wired up in lab2 and reused
+				by lab3 and lab4.
+Hardware Connections(Circuit):
+				LED1 (PB4)
+				Positive Logic("Direct Drive")
+				Output High, LED On
+				LED2 (PB5)
+				Negative Logic("Sink Configuration")
+				Output Low, LED On
+				SW1 (PC2)
+				Positive Logic (external pull-down)
+				pressed, 3.3V, digital '1'
+				SW2 (PC3)
+				Negative Logic (external pull-up)
+				pressed, 0V, digital '0'
+************************************************************/
+
+#ifndef __LAB_BOARD_H
+#define __LAB_BOARD_H
+
+#include "gpio_pin.h"
+
+#define PB4   4	//LED1
+#define PB5		5	//LED2
+#define	PC2		2	//SW1
+#define PC3		3	//SW2
+
+static const gpio_pin_t LED1 = GPIO_OUTPUT_PIN(GPIOB, PB4, GPIO_ACTIVE_HIGH);
+static const gpio_pin_t LED2 = GPIO_OUTPUT_PIN(GPIOB, PB5, GPIO_ACTIVE_LOW);
+static const gpio_pin_t SW1  = GPIO_INPUT_PIN(GPIOC, PC2, GPIO_PULL_NONE, GPIO_ACTIVE_HIGH);
+static const gpio_pin_t SW2  = GPIO_INPUT_PIN(GPIOC, PC3, GPIO_PULL_NONE, GPIO_ACTIVE_LOW);
+
+#endif /* __LAB_BOARD_H */
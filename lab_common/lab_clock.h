@@ -0,0 +1,10 @@
+#ifndef __LAB_CLOCK_H
+#define __LAB_CLOCK_H
+
+// The lab projects do not call SystemInit(), so the core, AHB and APB
+// clocks all run from the default 4MHz MSI oscillator.
+#ifndef LAB_CORE_CLOCK_HZ
+#define LAB_CORE_CLOCK_HZ 4000000UL
+#endif
+
+#endif /* __LAB_CLOCK_H */
@@ -0,0 +1,220 @@
+#include <stddef.h>
+#include "led_pwm.h"
+#include "lab_board.h"
+#include "lab_clock.h"
+
+// Timer counts per PWM period, and the length of one fade step
+#define LED_PWM_PERIOD   (LAB_CORE_CLOCK_HZ / LED_PWM_HZ)
+#define LED_PWM_STEP_MS  (1000UL / LED_PWM_HZ)
+
+// DMA burst through DMAR: LED_PWM_NUM_CHANNELS transfers starting at CCR1
+#define LED_PWM_DCR  ((uint32_t)(offsetof(TIM_TypeDef, CCR1) / 4U) | \
+                      ((uint32_t)(LED_PWM_NUM_CHANNELS - 1) << 8))
+
+// DMA1 channel 3 request 5 is TIM3_UP
+#define LED_PWM_DMA_REQUEST 5UL
+
+// round(65535 * (i / 255)^2.2)
+static const uint16_t gamma_table[256] = {
+	    0,     0,     2,     4,     7,    11,    17,    24,
+	   32,    42,    53,    65,    79,    94,   111,   129,
+	  148,   169,   192,   216,   242,   270,   299,   330,
+	  362,   396,   432,   469,   508,   549,   591,   635,
+	  681,   729,   779,   830,   883,   938,   995,  1053,
+	 1113,  1175,  1239,  1305,  1373,  1443,  1514,  1587,
+	 1663,  1740,  1819,  1900,  1983,  2068,  2155,  2243,
+	 2334,  2427,  2521,  2618,  2717,  2817,  2920,  3024,
+	 3131,  3240,  3350,  3463,  3578,  3694,  3813,  3934,
+	 4057,  4182,  4309,  4438,  4570,  4703,  4838,  4976,
+	 5115,  5257,  5401,  5547,  5695,  5845,  5998,  6152,
+	 6309,  6468,  6629,  6792,  6957,  7124,  7294,  7466,
+	 7640,  7816,  7994,  8175,  8358,  8543,  8730,  8919,
+	 9111,  9305,  9501,  9699,  9900, 10102, 10307, 10515,
+	10724, 10936, 11150, 11366, 11585, 11806, 12029, 12254,
+	12482, 12712, 12944, 13179, 13416, 13655, 13896, 14140,
+	14386, 14635, 14885, 15138, 15394, 15652, 15912, 16174,
+	16439, 16706, 16975, 17247, 17521, 17798, 18077, 18358,
+	18642, 18928, 19216, 19507, 19800, 20095, 20393, 20694,
+	20996, 21301, 21609, 21919, 22231, 22546, 22863, 23182,
+	23504, 23829, 24156, 24485, 24817, 25151, 25487, 25826,
+	26168, 26512, 26858, 27207, 27558, 27912, 28268, 28627,
+	28988, 29351, 29717, 30086, 30457, 30830, 31206, 31585,
+	31966, 32349, 32735, 33124, 33514, 33908, 34304, 34702,
+	35103, 35507, 35913, 36321, 36732, 37146, 37562, 37981,
+	38402, 38825, 39252, 39680, 40112, 40546, 40982, 41421,
+	41862, 42306, 42753, 43202, 43654, 44108, 44565, 45025,
+	45487, 45951, 46418, 46888, 47360, 47835, 48313, 48793,
+	49275, 49761, 50249, 50739, 51232, 51728, 52226, 52727,
+	53230, 53736, 54245, 54756, 55270, 55787, 56306, 56828,
+	57352, 57879, 58409, 58941, 59476, 60014, 60554, 61097,
+	61642, 62190, 62741, 63295, 63851, 64410, 64971, 65535,
+};
+
+typedef struct {
+	uint16_t from;    // brightness in 8.8 fixed point at the start of the fade
+	uint16_t to;      // target brightness, 8.8
+	uint16_t steps;   // PWM periods from 'from' to 'to', 0 = steady at 'to'
+} led_fade_t;
+
+static led_fade_t fades[LED_PWM_NUM_CHANNELS];
+
+// CCR1/CCR2 pair for every step, in the order the DMA burst writes them
+static uint16_t fade_table[LED_PWM_FADE_MAX_STEPS][LED_PWM_NUM_CHANNELS];
+static uint16_t fade_steps;   // steps in the table loaded into the DMA
+
+uint16_t led_pwm_gamma(uint8_t brightness){
+	return gamma_table[brightness];
+}
+
+// Compare value for an 8.8 brightness. The gamma table is interpolated, so
+// slow fades at low brightness do not move in visible steps.
+static uint16_t compare_value(uint16_t level){
+	uint8_t i = (uint8_t)(level >> 8);
+	uint32_t duty = gamma_table[i];
+
+	if(i < 255){
+		duty += ((gamma_table[i + 1] - duty) * (level & 0xFFU)) >> 8;
+	}
+	// 65535 maps to LED_PWM_PERIOD, above ARR: the output stays active
+	return (uint16_t)((duty * LED_PWM_PERIOD + 0x8000UL) >> 16);
+}
+
+static uint16_t fade_level(const led_fade_t *f, uint16_t step){
+	if(step >= f->steps){
+		return f->to;
+	}
+	return (uint16_t)(f->from + ((int32_t)f->to - (int32_t)f->from) * step / f->steps);
+}
+
+// Steps of the loaded table that have fully reached the timer
+static uint16_t fade_steps_done(void){
+	if(!(DMA1_Channel3->CCR & DMA_CCR_EN)){
+		return fade_steps;
+	}
+	return (uint16_t)(fade_steps - (DMA1_Channel3->CNDTR + LED_PWM_NUM_CHANNELS - 1) / LED_PWM_NUM_CHANNELS);
+}
+
+// Stop the DMA and restate every fade from the point it has reached
+static void fade_stop(void){
+	uint16_t done = fade_steps_done();
+	uint8_t c;
+
+	DMA1_Channel3->CCR &= ~DMA_CCR_EN;
+	for(c = 0; c < LED_PWM_NUM_CHANNELS; c++){
+		led_fade_t *f = &fades[c];
+
+		f->from = fade_level(f, done);
+		f->steps = (f->steps > done) ? (uint16_t)(f->steps - done) : 0;
+	}
+	fade_steps = 0;
+}
+
+// Build the compare table for the fades and hand it to the DMA
+static void fade_start(void){
+	uint16_t steps = 0;
+	uint16_t i;
+	uint8_t c;
+
+	for(c = 0; c < LED_PWM_NUM_CHANNELS; c++){
+		if(fades[c].steps > steps){
+			steps = fades[c].steps;
+		}
+	}
+	if(steps == 0){
+		TIM3->CCR1 = compare_value(fades[LED_PWM_CHANNEL_LED1].to);
+		TIM3->CCR2 = compare_value(fades[LED_PWM_CHANNEL_LED2].to);
+		return;
+	}
+	for(i = 0; i < steps; i++){
+		for(c = 0; c < LED_PWM_NUM_CHANNELS; c++){
+			fade_table[i][c] = compare_value(fade_level(&fades[c], (uint16_t)(i + 1)));
+		}
+	}
+	fade_steps = steps;
+	DMA1_Channel3->CMAR = (uint32_t)(uintptr_t)fade_table;
+	DMA1_Channel3->CNDTR = (uint32_t)steps * LED_PWM_NUM_CHANNELS;
+	DMA1_Channel3->CCR |= DMA_CCR_EN;
+}
+
+void led_pwm_init(void){
+	// The LED pins as described in lab_board.h, switched to TIM3 (AF2)
+	gpio_pin_t led1 = LED1;
+	gpio_pin_t led2 = LED2;
+	uint8_t c;
+
+	led1.mode = GPIO_MODE_ALTFUNC;
+	led1.af = 2;
+	led2.mode = GPIO_MODE_ALTFUNC;
+	led2.af = 2;
+	gpio_pin_configure(&led1);
+	gpio_pin_configure(&led2);
+
+	for(c = 0; c < LED_PWM_NUM_CHANNELS; c++){
+		fades[c].from = 0;
+		fades[c].to = 0;
+		fades[c].steps = 0;
+	}
+	fade_steps = 0;
+
+	RCC->APB1ENR1 |= RCC_APB1ENR1_TIM3EN;
+	RCC->AHB1ENR |= RCC_AHB1ENR_DMA1EN;
+
+	// 1. Up-counting from the core clock, preloaded period
+	TIM3->CR1 = TIM_CR1_ARPE;
+	TIM3->PSC = 0;
+	TIM3->ARR = LED_PWM_PERIOD - 1;
+
+	// 2. PWM mode 1 (OCxM = 110) with preload: compare values change at the update
+	TIM3->CCMR1 = TIM_CCMR1_OC1M_2 | TIM_CCMR1_OC1M_1 | TIM_CCMR1_OC1PE |
+	              TIM_CCMR1_OC2M_2 | TIM_CCMR1_OC2M_1 | TIM_CCMR1_OC2PE;
+	TIM3->CCR1 = 0;
+	TIM3->CCR2 = 0;
+
+	// 3. Enable the outputs; an active low LED gets an active low channel
+	TIM3->CCER = TIM_CCER_CC1E | TIM_CCER_CC2E |
+	             (LED1.active_low ? TIM_CCER_CC1P : 0) |
+	             (LED2.active_low ? TIM_CCER_CC2P : 0);
+
+	// 4. Every update requests a DMA burst into CCR1, CCR2
+	TIM3->DCR = LED_PWM_DCR;
+	TIM3->DIER = TIM_DIER_UDE;
+
+	// 5. DMA1 channel 3: 16-bit table entries to the 32-bit DMAR, memory to peripheral
+	DMA1_Channel3->CCR = 0;
+	DMA1_CSELR->CSELR = (DMA1_CSELR->CSELR & ~DMA_CSELR_C3S) | (LED_PWM_DMA_REQUEST << 8);
+	DMA1_Channel3->CPAR = (uint32_t)(uintptr_t)&TIM3->DMAR;
+	DMA1_Channel3->CCR = DMA_CCR_DIR | DMA_CCR_MINC | DMA_CCR_MSIZE_0 | DMA_CCR_PSIZE_1;
+
+	TIM3->EGR = TIM_EGR_UG;
+	TIM3->CR1 |= TIM_CR1_CEN;
+}
+
+void led_pwm_fade(uint8_t channel, uint8_t brightness, uint32_t duration_ms){
+	uint32_t steps = duration_ms / LED_PWM_STEP_MS;
+
+	if(channel >= LED_PWM_NUM_CHANNELS){
+		return;
+	}
+	if(steps > LED_PWM_FADE_MAX_STEPS){
+		steps = LED_PWM_FADE_MAX_STEPS;
+	}
+	fade_stop();
+	fades[channel].to = (uint16_t)(brightness << 8);
+	fades[channel].steps = (uint16_t)steps;
+	fade_start();
+}
+
+void led_pwm_set(uint8_t channel, uint8_t brightness){
+	led_pwm_fade(channel, brightness, 0);
+}
+
+uint8_t led_pwm_brightness(uint8_t channel){
+	if(channel >= LED_PWM_NUM_CHANNELS){
+		return 0;
+	}
+	return (uint8_t)(fade_level(&fades[channel], fade_steps_done()) >> 8);
+}
+
+uint8_t led_pwm_fading(void){
+	return (DMA1_Channel3->CCR & DMA_CCR_EN) && DMA1_Channel3->CNDTR != 0;
+}
@@ -0,0 +1,64 @@
+/***********************************************************
+Title: TIM3 PWM brightness driver for the lab LEDs.
+Description: LED1 (PB4) and LED2 (PB5) are switched to their
+				alternate function 2, TIM3_CH1 and TIM3_CH2, and
+				driven by hardware PWM. Brightness is 0..255 and
+				goes through a gamma 2.2 table to a 16-bit duty
+				cycle, so equal steps look equal to the eye.
+				The LED polarity from lab_board.h selects the
+				output polarity of the channel.
+Fades:
+				A fade is precomputed into a compare table that
+				DMA1 channel 3 copies into CCR1/CCR2 on every
+				TIM3 update (DMA burst through DMAR), one step
+				per PWM period. The CPU only builds the table;
+				the fade itself needs no interrupts. Starting a
+				fade on one LED keeps the other LED's running
+				fade going from where it is.
+Timer:
+				TIM3 runs from the core clock at LED_PWM_HZ.
+				A step lasts one PWM period (4 ms at 250 Hz),
+				LED_PWM_FADE_MAX_STEPS limits fades to about
+				2 s; longer fades are shortened to that.
+				Call the functions below from one context,
+				e.g. the main loop.
+************************************************************/
+
+#ifndef __LAB_LED_PWM_H
+#define __LAB_LED_PWM_H
+
+#include "gpio_pin.h"
+
+#define LED_PWM_CHANNEL_LED1 0   // PB4, TIM3_CH1
+#define LED_PWM_CHANNEL_LED2 1   // PB5, TIM3_CH2
+#define LED_PWM_NUM_CHANNELS 2
+
+// PWM frequency; the duty resolution is LAB_CORE_CLOCK_HZ / LED_PWM_HZ steps
+#ifndef LED_PWM_HZ
+#define LED_PWM_HZ 250UL
+#endif
+
+// Length of the fade table (one entry per channel per PWM period)
+#ifndef LED_PWM_FADE_MAX_STEPS
+#define LED_PWM_FADE_MAX_STEPS 512
+#endif
+
+// Gamma 2.2 corrected duty for a brightness, 0..65535
+uint16_t led_pwm_gamma(uint8_t brightness);
+
+// Switch the LED pins to TIM3 and start the PWM with both LEDs off
+void led_pwm_init(void);
+
+// Set a brightness at once (from the next PWM period)
+void led_pwm_set(uint8_t channel, uint8_t brightness);
+
+// Fade from the current brightness to 'brightness' over 'duration_ms'
+void led_pwm_fade(uint8_t channel, uint8_t brightness, uint32_t duration_ms);
+
+// Current brightness, following a running fade
+uint8_t led_pwm_brightness(uint8_t channel);
+
+// 1 while a fade is running on any channel
+uint8_t led_pwm_fading(void);
+
+#endif /* __LAB_LED_PWM_H */
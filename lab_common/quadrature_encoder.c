@@ -0,0 +1,84 @@
+#include "quadrature_encoder.h"
+
+// TIM4_CH1/TIM4_CH2 are alternate function 2 on PB6/PB7
+static const gpio_pin_t ENCODER_A = GPIO_PIN(GPIOB, 6, GPIO_MODE_ALTFUNC, GPIO_PULL_UP, GPIO_ACTIVE_HIGH, 2);
+static const gpio_pin_t ENCODER_B = GPIO_PIN(GPIOB, 7, GPIO_MODE_ALTFUNC, GPIO_PULL_UP, GPIO_ACTIVE_HIGH, 2);
+
+static encoder_callback_t threshold_callbacks[ENCODER_NUM_THRESHOLDS];
+
+void encoder_init(uint32_t modulus, uint8_t filter, uint16_t initial){
+	uint8_t i;
+
+	for(i = 0; i < ENCODER_NUM_THRESHOLDS; i++){
+		threshold_callbacks[i] = 0;
+	}
+	if(modulus < 2 || modulus > 0x10000UL){
+		modulus = 0x10000UL;
+	}
+	filter &= 0xF;
+
+	// 1. Clocks and pins
+	RCC->APB1ENR1 |= RCC_APB1ENR1_TIM4EN;
+	gpio_pin_configure(&ENCODER_A);
+	gpio_pin_configure(&ENCODER_B);
+
+	TIM4->CR1 &= ~TIM_CR1_CEN;
+
+	// 2. CC1S = 01: IC1 mapped on TI1, CC2S = 01: IC2 mapped on TI2, with input filters
+	TIM4->CCMR1 = TIM_CCMR1_CC1S_0 | TIM_CCMR1_CC2S_0 |
+	              ((uint32_t)filter << 4) | ((uint32_t)filter << 12);
+	// Channels 3/4 stay in frozen output compare mode, used only as thresholds
+	TIM4->CCMR2 = 0;
+
+	// 3. Non-inverted inputs (CC1P/CC1NP = CC2P/CC2NP = 0)
+	TIM4->CCER = 0;
+
+	// 4. SMS = 011: encoder mode 3, count on both TI1 and TI2 edges
+	TIM4->SMCR &= ~TIM_SMCR_SMS;
+	TIM4->SMCR |= TIM_SMCR_SMS_1 | TIM_SMCR_SMS_0;
+
+	// 5. Wrap the count at the modulus
+	TIM4->PSC = 0;
+	TIM4->ARR = modulus - 1;
+	TIM4->EGR = TIM_EGR_UG;
+	TIM4->CNT = initial % modulus;
+	TIM4->SR = 0;
+	TIM4->DIER = 0;
+
+	NVIC_EnableIRQ(TIM4_IRQn);
+	TIM4->CR1 |= TIM_CR1_CEN;
+}
+
+void encoder_set_threshold(uint8_t threshold, uint16_t count, encoder_callback_t callback){
+	if(threshold >= ENCODER_NUM_THRESHOLDS){
+		return;
+	}
+	threshold_callbacks[threshold] = callback;
+	(&TIM4->CCR3)[threshold] = count;
+	TIM4->SR = ~(TIM_SR_CC3IF << threshold);
+	TIM4->DIER |= TIM_DIER_CC3IE << threshold;
+}
+
+void encoder_clear_threshold(uint8_t threshold){
+	if(threshold >= ENCODER_NUM_THRESHOLDS){
+		return;
+	}
+	TIM4->DIER &= ~(TIM_DIER_CC3IE << threshold);
+	threshold_callbacks[threshold] = 0;
+}
+
+void encoder_isr(void){
+	uint32_t pending = TIM4->SR & TIM4->DIER;
+	uint8_t i;
+
+	for(i = 0; i < ENCODER_NUM_THRESHOLDS; i++){
+		uint32_t flag = TIM_SR_CC3IF << i;
+
+		if(pending & flag){
+			TIM4->SR = ~flag;
+			if(threshold_callbacks[i] != 0){
+				threshold_callbacks[i](i, encoder_count());
+			}
+		}
+	}
+}
@@ -0,0 +1,59 @@
+/***********************************************************
+Title: Hardware quadrature encoder on TIM4.
+Description: TIM4 runs in encoder mode 3: channel A on TI1
+				(PB6) and channel B on TI2 (PB7) both clock the
+				counter, and the phase between them sets the
+				count direction. Every edge is counted by the
+				timer itself, with the input filter rejecting
+				contact noise, so the CPU is not interrupted per
+				step and high rate encoders that EXTI cannot keep
+				up with still count correctly.
+				The count wraps at 'modulus', which lets it map
+				straight onto an N-bit rotary counter. Two
+				compare thresholds (CCR3/CCR4) can raise an
+				interrupt when the count reaches them.
+Hardware Connections(Circuit):
+				Encoder A -> PB6 (TIM4_CH1, AF2), pull-up
+				Encoder B -> PB7 (TIM4_CH2, AF2), pull-up
+				Encoder C -> GND
+************************************************************/
+
+#ifndef __LAB_QUADRATURE_ENCODER_H
+#define __LAB_QUADRATURE_ENCODER_H
+
+#include "gpio_pin.h"
+
+// Counts per detent of a typical mechanical encoder (x4 decoding)
+#define ENCODER_COUNTS_PER_DETENT 4
+
+// Input filter IC1F/IC2F: 0 = off ... 15 = fDTS/32 with 8 samples
+#define ENCODER_DEFAULT_FILTER 0xF
+
+// Compare thresholds
+#define ENCODER_NUM_THRESHOLDS 2
+
+// Called from the TIM4 interrupt when the count reaches a threshold
+typedef void (*encoder_callback_t)(uint8_t threshold, uint16_t count);
+
+// Start counting. 'modulus' is the number of counts before wrapping (2..65536),
+// 'filter' the IC1F/IC2F input filter setting.
+void encoder_init(uint32_t modulus, uint8_t filter, uint16_t initial);
+
+// Current count, 0..modulus-1
+static inline uint16_t encoder_count(void){
+	return (uint16_t)TIM4->CNT;
+}
+
+// Last counting direction: 1 = down (B leads A), 0 = up
+static inline uint8_t encoder_direction_down(void){
+	return (TIM4->CR1 & TIM_CR1_DIR) ? 1 : 0;
+}
+
+// Interrupt when the count equals 'count' (threshold 0 or 1)
+void encoder_set_threshold(uint8_t threshold, uint16_t count, encoder_callback_t callback);
+void encoder_clear_threshold(uint8_t threshold);
+
+// To be called from TIM4_IRQHandler
+void encoder_isr(void);
+
+#endif /* __LAB_QUADRATURE_ENCODER_H */
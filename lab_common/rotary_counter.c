@@ -0,0 +1,50 @@
+#include "rotary_counter.h"
+
+//-------------------------------------------------------------------------------------------
+// BSRR word that shows 'value' on the LEDs. Each LED gets exactly one of its
+// set/reset bits, so the word drives every LED of the counter in one store.
+//-------------------------------------------------------------------------------------------
+static uint32_t rotary_counter_pattern(const gpio_pin_t *const leds[], uint8_t bits, uint32_t value){
+	uint32_t word = 0;
+	uint8_t i;
+
+	for(i = 0; i < bits; i++){
+		word |= (value & (1U << i)) ? gpio_pin_on_word(leds[i]) : gpio_pin_off_word(leds[i]);
+	}
+	return word;
+}
+
+int rotary_counter_init(rotary_counter_t *rc, const gpio_pin_t *const leds[],
+                        uint8_t bits, uint8_t initial){
+	uint32_t states;
+	uint32_t s;
+	uint8_t i;
+
+	if(bits == 0 || bits > ROTARY_COUNTER_MAX_BITS){
+		return -1;
+	}
+	for(i = 1; i < bits; i++){
+		if(leds[i]->port != leds[0]->port){
+			return -1;
+		}
+	}
+
+	states = 1U << bits;
+	rc->port = leds[0]->port;
+	rc->num_states = (uint8_t)states;
+
+	for(s = 0; s < states; s++){
+		uint32_t up = (s + 1) & (states - 1);
+		uint32_t down = (s + states - 1) & (states - 1);
+
+		rc->display[s] = rotary_counter_pattern(leds, bits, s);
+
+		rc->table[s][ROTARY_EVENT_UP].next = (uint8_t)up;
+		rc->table[s][ROTARY_EVENT_UP].bsrr = rotary_counter_pattern(leds, bits, up);
+		rc->table[s][ROTARY_EVENT_DOWN].next = (uint8_t)down;
+		rc->table[s][ROTARY_EVENT_DOWN].bsrr = rotary_counter_pattern(leds, bits, down);
+	}
+
+	rotary_counter_set(rc, initial);
+	return 0;
+}
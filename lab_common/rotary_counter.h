@@ -0,0 +1,75 @@
+/***********************************************************
+Title: Table driven N-bit rotary counter.
+Description: The counter is a state machine whose transition
+				table is indexed by (state, event). Every entry
+				holds the next state and a precomputed BSRR word
+				that shows the next state on the LEDs, so a step
+				is one table lookup and one store that updates
+				all LEDs at once (no read-modify-write on ODR).
+				The table is built at start-up from a list of
+				LED descriptors: leds[i] displays bit i of the
+				count, with each LED's own polarity. All LEDs
+				must be on the same GPIO port.
+************************************************************/
+
+#ifndef __LAB_ROTARY_COUNTER_H
+#define __LAB_ROTARY_COUNTER_H
+
+#include "gpio_pin.h"
+
+// Largest counter width; the table has 2^bits * ROTARY_NUM_EVENTS entries
+#ifndef ROTARY_COUNTER_MAX_BITS
+#define ROTARY_COUNTER_MAX_BITS 4
+#endif
+#define ROTARY_COUNTER_MAX_STATES (1U << ROTARY_COUNTER_MAX_BITS)
+
+typedef enum {
+	ROTARY_EVENT_UP   = 0,
+	ROTARY_EVENT_DOWN = 1,
+	ROTARY_NUM_EVENTS
+} rotary_event_t;
+
+typedef struct {
+	uint32_t bsrr;       // LED pattern of 'next', ready to store into BSRR
+	uint8_t next;
+} rotary_transition_t;
+
+typedef struct {
+	GPIO_TypeDef *port;
+	volatile uint8_t state;
+	uint8_t num_states;
+	rotary_transition_t table[ROTARY_COUNTER_MAX_STATES][ROTARY_NUM_EVENTS];
+	uint32_t display[ROTARY_COUNTER_MAX_STATES];   // BSRR word showing each state
+} rotary_counter_t;
+
+// Build the transition table for a 'bits' wide counter shown on leds[0..bits-1]
+// (leds[0] is the least significant bit) and show 'initial' on the LEDs.
+// Returns 0 on success, -1 if the width is unsupported or the LEDs span ports.
+int rotary_counter_init(rotary_counter_t *rc, const gpio_pin_t *const leds[],
+                        uint8_t bits, uint8_t initial);
+
+// One counter step: a table lookup and a single BSRR store. Anything but
+// UP or DOWN leaves the count and the LEDs as they are.
+static inline void rotary_counter_step(rotary_counter_t *rc, rotary_event_t event){
+	const rotary_transition_t *t;
+
+	if((uint32_t)event >= ROTARY_NUM_EVENTS){
+		return;
+	}
+	t = &rc->table[rc->state][event];
+	GPIO_BSRR_STORE(rc->port, t->bsrr);
+	rc->state = t->next;
+}
+
+// Jump to a given count, e.g. one read back from a hardware counter
+static inline void rotary_counter_set(rotary_counter_t *rc, uint32_t value){
+	uint8_t state = (uint8_t)(value & (rc->num_states - 1U));
+	GPIO_BSRR_STORE(rc->port, rc->display[state]);
+	rc->state = state;
+}
+
+static inline uint8_t rotary_counter_value(const rotary_counter_t *rc){
+	return rc->state;
+}
+
+#endif /* __LAB_ROTARY_COUNTER_H */
@@ -0,0 +1,43 @@
+#include "sleep_monitor.h"
+#include "stm32l476xx.h"
+
+static uint32_t start_tick;
+static volatile uint32_t asleep_ticks;
+static volatile uint32_t wakeups;
+
+void sleep_monitor_init(void){
+	RCC->APB1ENR1 |= RCC_APB1ENR1_TIM5EN;
+	TIM5->CR1 &= ~TIM_CR1_CEN;
+	TIM5->PSC = 0;
+	TIM5->ARR = 0xFFFFFFFFUL;
+	TIM5->EGR = TIM_EGR_UG;
+	TIM5->CR1 |= TIM_CR1_CEN;
+
+	asleep_ticks = 0;
+	wakeups = 0;
+	start_tick = TIM5->CNT;
+}
+
+void sleep_monitor_wfi(void){
+	uint32_t entry;
+
+	// A pending interrupt still ends WFI with PRIMASK set; it is taken
+	// once interrupts are enabled again, after the wake-up timestamp.
+	__disable_irq();
+	entry = TIM5->CNT;
+	__WFI();
+	asleep_ticks += TIM5->CNT - entry;
+	wakeups++;
+	__enable_irq();
+}
+
+void sleep_monitor_read(sleep_monitor_stats_t *stats){
+	uint32_t elapsed;
+
+	__disable_irq();
+	elapsed = TIM5->CNT - start_tick;
+	stats->asleep_ticks = asleep_ticks;
+	stats->wakeups = wakeups;
+	__enable_irq();
+	stats->awake_ticks = elapsed - stats->asleep_ticks;
+}
@@ -0,0 +1,32 @@
+/***********************************************************
+Title: Sleep/awake time measurement.
+Description: Measurement hook for event driven main loops.
+				sleep_monitor_wfi() replaces a bare __WFI() and
+				timestamps entry and wake-up on TIM5, a 32-bit
+				timer that keeps counting while the core sleeps
+				(the DWT cycle counter does not). Interrupts are
+				held off across the WFI so the handler that woke
+				the core is charged to "awake", not "asleep".
+************************************************************/
+
+#ifndef __LAB_SLEEP_MONITOR_H
+#define __LAB_SLEEP_MONITOR_H
+
+#include <stdint.h>
+
+typedef struct {
+	uint32_t asleep_ticks;   // time spent inside WFI, in TIM5 ticks (core clock)
+	uint32_t awake_ticks;    // everything else since sleep_monitor_init()
+	uint32_t wakeups;
+} sleep_monitor_stats_t;
+
+// Start TIM5 free-running at the core clock
+void sleep_monitor_init(void);
+
+// Sleep until the next interrupt and account for the time spent asleep
+void sleep_monitor_wfi(void);
+
+// Snapshot of the counters; wraps after 2^32 core clock ticks (~18 min at 4MHz)
+void sleep_monitor_read(sleep_monitor_stats_t *stats);
+
+#endif /* __LAB_SLEEP_MONITOR_H */
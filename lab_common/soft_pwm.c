@@ -0,0 +1,145 @@
+#include "soft_pwm.h"
+#include "lab_clock.h"
+
+// GPIOA..GPIOH
+#define SOFT_PWM_NUM_PORTS 8
+
+typedef struct {
+	uint32_t on_word;             // BSRR words of the pin, polarity applied
+	uint32_t off_word;
+	volatile uint16_t period;
+	volatile uint16_t duty;
+	uint16_t phase;
+	uint16_t count;               // position in the cycle, ISR only
+	uint8_t port;                 // index into ports[]
+} soft_pwm_output_t;
+
+static soft_pwm_output_t outputs[SOFT_PWM_MAX_OUTPUTS];
+static GPIO_TypeDef *ports[SOFT_PWM_NUM_PORTS];
+static volatile uint32_t active;  // outputs that are running
+static uint32_t levels;           // outputs currently on, cleared by soft_pwm_start()
+
+void soft_pwm_init(uint32_t tick_hz){
+	active = 0;
+	levels = 0;
+
+	// 1 us timer ticks, one update interrupt per scheduler tick
+	RCC->APB1ENR1 |= RCC_APB1ENR1_TIM7EN;
+	TIM7->CR1  = TIM_CR1_URS;     // URS: the UG below raises no interrupt
+	TIM7->PSC  = LAB_CORE_CLOCK_HZ / 1000000UL - 1;
+	TIM7->ARR  = 1000000UL / tick_hz - 1;
+	TIM7->EGR  = TIM_EGR_UG;
+	TIM7->SR   = 0;
+	TIM7->DIER = TIM_DIER_UIE;
+	NVIC_EnableIRQ(TIM7_IRQn);
+	TIM7->CR1 |= TIM_CR1_CEN;
+}
+
+int soft_pwm_add(uint8_t slot, const soft_pwm_config_t *config){
+	soft_pwm_output_t *out;
+	uint8_t port;
+
+	if(slot >= SOFT_PWM_MAX_OUTPUTS || config->pin == 0 || config->period == 0){
+		return -1;
+	}
+	soft_pwm_stop(slot);
+
+	port = (uint8_t)gpio_pin_port_index(config->pin);
+	ports[port] = config->pin->port;
+	out = &outputs[slot];
+	out->on_word = gpio_pin_on_word(config->pin);
+	out->off_word = gpio_pin_off_word(config->pin);
+	out->period = config->period;
+	out->duty = config->duty;
+	out->phase = config->phase;
+	out->port = port;
+	return 0;
+}
+
+void soft_pwm_start(uint8_t slot){
+	soft_pwm_output_t *out;
+	uint32_t bit = 1UL << slot;
+	uint32_t primask;
+
+	if(slot >= SOFT_PWM_MAX_OUTPUTS || outputs[slot].period == 0 || (active & bit)){
+		return;
+	}
+	out = &outputs[slot];
+	out->count = (uint16_t)(out->phase % out->period);
+	// The TIM7 interrupt read-modify-writes 'levels' and other interrupts may
+	// start or stop outputs, so both masks are updated with interrupts masked.
+	// PRIMASK is restored, not cleared, so this also works from an interrupt.
+	primask = __get_PRIMASK();
+	__disable_irq();
+	levels &= ~bit;
+	active |= bit;
+	__set_PRIMASK(primask);
+}
+
+void soft_pwm_stop(uint8_t slot){
+	uint32_t bit = 1UL << slot;
+	uint32_t primask;
+
+	if(slot >= SOFT_PWM_MAX_OUTPUTS){
+		return;
+	}
+	// Once the bit is clear the ISR leaves the pin alone
+	primask = __get_PRIMASK();
+	__disable_irq();
+	active &= ~bit;
+	__set_PRIMASK(primask);
+	if(outputs[slot].period != 0){
+		GPIO_BSRR_STORE(ports[outputs[slot].port], outputs[slot].off_word);
+	}
+}
+
+void soft_pwm_set(uint8_t slot, uint16_t period, uint16_t duty){
+	if(slot >= SOFT_PWM_MAX_OUTPUTS || period == 0){
+		return;
+	}
+	// The ISR compares against the current values every tick and wraps with
+	// '>=', so a tick between these two stores cannot run past the period.
+	outputs[slot].duty = duty;
+	outputs[slot].period = period;
+}
+
+void soft_pwm_isr(void){
+	uint32_t bsrr[SOFT_PWM_NUM_PORTS];
+	uint32_t touched = 0;
+	uint32_t pending;
+	uint8_t i;
+
+	TIM7->SR = 0;
+
+	// The level of every running output is recomputed from its position, so
+	// changes to period or duty take effect at once; only changes are written.
+	for(pending = active; pending != 0; pending &= pending - 1U){
+		soft_pwm_output_t *out;
+		uint32_t bit;
+		uint8_t on;
+
+		i = (uint8_t)__builtin_ctz(pending);
+		bit = 1UL << i;
+		out = &outputs[i];
+
+		on = out->count < out->duty;
+		if(on != ((levels & bit) != 0)){
+			if(!(touched & (1UL << out->port))){
+				touched |= 1UL << out->port;
+				bsrr[out->port] = 0;
+			}
+			bsrr[out->port] |= on ? out->on_word : out->off_word;
+			levels ^= bit;
+		}
+		if(++out->count >= out->period){
+			out->count = 0;
+		}
+	}
+
+	// One store per port that has a change
+	for(i = 0; touched != 0; i++, touched >>= 1){
+		if(touched & 1U){
+			GPIO_BSRR_STORE(ports[i], bsrr[i]);
+		}
+	}
+}
@@ -0,0 +1,60 @@
+/***********************************************************
+Title: Software PWM / blink scheduler.
+Description: Drives up to 32 GPIO outputs from one timer
+				interrupt. Every output has its own period,
+				on time (duty) and phase, counted in ticks, so
+				one scheduler can blink a status LED at 2 Hz
+				and dim another one at the same time. Each
+				tick the outputs that change level are
+				collected per port and written with a single
+				BSRR store per port; ports without a change
+				are not touched. The main loop only starts,
+				stops or retunes outputs.
+Timer:
+				TIM7 (basic timer) counts 1 us ticks and
+				interrupts every 1/tick_hz. At 1 kHz a period
+				of 400 is a 400 ms blink; for flicker-free
+				dimming use a faster tick and short periods
+				(e.g. 10 kHz and a period of 100 = 100 Hz).
+Usage:
+				TIM7_IRQHandler: soft_pwm_isr();
+				The calls below may also be made from
+				interrupts at the same priority as TIM7.
+************************************************************/
+
+#ifndef __LAB_SOFT_PWM_H
+#define __LAB_SOFT_PWM_H
+
+#include "gpio_pin.h"
+
+// One bit per output in the active mask
+#define SOFT_PWM_MAX_OUTPUTS 32
+
+typedef struct {
+	const gpio_pin_t *pin;   // configured output; duty is the time the LED is on
+	uint16_t period;         // ticks per cycle, >= 1
+	uint16_t duty;           // on ticks per cycle: 0 = off, >= period = on
+	uint16_t phase;          // ticks the cycle is advanced by when started
+} soft_pwm_config_t;
+
+// Start TIM7 interrupting at tick_hz (16 Hz .. 1 MHz)
+void soft_pwm_init(uint32_t tick_hz);
+
+// Attach an output to a slot (0..SOFT_PWM_MAX_OUTPUTS-1). The output is left
+// stopped. Returns 0 on success, -1 for an invalid slot or period.
+int soft_pwm_add(uint8_t slot, const soft_pwm_config_t *config);
+
+// Begin the cycle at the configured phase; the output follows from the next tick
+void soft_pwm_start(uint8_t slot);
+
+// Stop the output and turn it off
+void soft_pwm_stop(uint8_t slot);
+
+// Change period and on time of a running or stopped output. The new values
+// apply from the next tick; the position in the cycle is kept.
+void soft_pwm_set(uint8_t slot, uint16_t period, uint16_t duty);
+
+// To be called from TIM7_IRQHandler
+void soft_pwm_isr(void);
+
+#endif /* __LAB_SOFT_PWM_H */
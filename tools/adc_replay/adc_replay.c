@@ -0,0 +1,337 @@
+/***********************************************************
+Title: ADC trace replay and benchmark harness.
+Description: Feeds recorded ADC codes through the same
+				filter, conversion and formatting code the
+				TMP36 firmware runs (temperature_processing.c),
+				reports per-stage cost and throughput, and
+				compares the formatted output with a golden file.
+Usage:
+				adc_replay [options] <trace>
+				-b         trace is raw binary (little-endian uint16 codes)
+				-c <col>   CSV column holding the ADC code (default 0)
+				-n <len>   moving average length (default TEMP_FILTER_LENGTH)
+				-r <count> replay the trace <count> times for timing (default 1)
+				-o <file>  write the formatted output to <file>
+				-g <file>  compare the formatted output with <file>
+************************************************************/
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <stdint.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "temperature_processing.h"
+
+#define MAX_REPORTED_DIFFS 10
+
+enum {
+	STAGE_FILTER,
+	STAGE_VOLTAGE,
+	STAGE_CELSIUS,
+	STAGE_FORMAT,
+	NUM_STAGES
+};
+
+static const char *stage_names[NUM_STAGES] = {
+	"filter", "voltage", "celsius", "format"
+};
+
+typedef struct {
+	uint32_t *codes;
+	size_t count;
+	size_t capacity;
+} trace_t;
+
+static uint64_t now_ns(void){
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+static void trace_push(trace_t *trace, uint32_t code){
+	if(trace->count == trace->capacity){
+		trace->capacity = trace->capacity ? trace->capacity * 2 : 4096;
+		trace->codes = realloc(trace->codes, trace->capacity * sizeof(uint32_t));
+		if(trace->codes == NULL){
+			fprintf(stderr, "out of memory\n");
+			exit(2);
+		}
+	}
+	trace->codes[trace->count++] = code;
+}
+
+// Raw binary traces are a plain dump of 16-bit little-endian ADC codes
+static int load_binary(FILE *f, trace_t *trace){
+	uint8_t sample[2];
+
+	while(fread(sample, 1, sizeof(sample), f) == sizeof(sample)){
+		trace_push(trace, (uint32_t)sample[0] | ((uint32_t)sample[1] << 8));
+	}
+	return 0;
+}
+
+// CSV traces: one sample per line, the code is taken from 'column'.
+// Blank lines, '#' comments and header lines starting with a letter are skipped.
+static int load_csv(FILE *f, trace_t *trace, int column){
+	char line[512];
+	unsigned long line_no = 0;
+
+	while(fgets(line, sizeof(line), f) != NULL){
+		char *p = line;
+		char *end;
+		int field;
+		unsigned long code;
+
+		line_no++;
+		while(isspace((unsigned char)*p)){
+			p++;
+		}
+		if(*p == '\0' || *p == '#' || isalpha((unsigned char)*p)){
+			continue;
+		}
+		for(field = 0; field < column; field++){
+			p = strchr(p, ',');
+			if(p == NULL){
+				fprintf(stderr, "line %lu: no column %d\n", line_no, column);
+				return -1;
+			}
+			p++;
+		}
+		code = strtoul(p, &end, 0);
+		if(end == p){
+			fprintf(stderr, "line %lu: bad ADC code\n", line_no);
+			return -1;
+		}
+		trace_push(trace, (uint32_t)code);
+	}
+	return 0;
+}
+
+// Golden files are UART captures: records separated by '\n', '\r' and empty records are ignored
+static char **load_golden(const char *path, size_t *count){
+	FILE *f = fopen(path, "rb");
+	char **lines = NULL;
+	size_t capacity = 0;
+	char line[512];
+
+	*count = 0;
+	if(f == NULL){
+		perror(path);
+		return NULL;
+	}
+	while(fgets(line, sizeof(line), f) != NULL){
+		size_t len = strlen(line);
+		size_t start = 0;
+
+		while(len > 0 && (line[len - 1] == '\n' || line[len - 1] == '\r')){
+			line[--len] = '\0';
+		}
+		while(line[start] == '\r'){
+			start++;
+		}
+		if(line[start] == '\0'){
+			continue;
+		}
+		if(*count == capacity){
+			capacity = capacity ? capacity * 2 : 1024;
+			lines = realloc(lines, capacity * sizeof(char *));
+			if(lines == NULL){
+				fprintf(stderr, "out of memory\n");
+				exit(2);
+			}
+		}
+		lines[*count] = strdup(&line[start]);
+		if(lines[*count] == NULL){
+			fprintf(stderr, "out of memory\n");
+			exit(2);
+		}
+		(*count)++;
+	}
+	fclose(f);
+	// An empty golden file is an empty list of records, not an error
+	if(lines == NULL){
+		lines = malloc(sizeof(char *));
+		if(lines == NULL){
+			fprintf(stderr, "out of memory\n");
+			exit(2);
+		}
+	}
+	return lines;
+}
+
+static void strip_record(char *record){
+	size_t len = strlen(record);
+
+	while(len > 0 && (record[len - 1] == '\n' || record[len - 1] == '\r')){
+		record[--len] = '\0';
+	}
+}
+
+static void usage(const char *prog){
+	fprintf(stderr,
+		"usage: %s [-b] [-c column] [-n filter_length] [-r repeat]"
+		" [-o output] [-g golden] trace\n", prog);
+}
+
+int main(int argc, char *argv[]){
+	int binary = 0;
+	int column = 0;
+	int filter_length = TEMP_FILTER_LENGTH;
+	long repeat = 1;
+	const char *output_path = NULL;
+	const char *golden_path = NULL;
+	trace_t trace = {0};
+	uint32_t *filtered;
+	float *voltages;
+	uint32_t *temperatures;
+	char (*records)[TEMP_FORMAT_BUFFER_SIZE];
+	uint64_t stage_ns[NUM_STAGES] = {0};
+	uint64_t total_ns = 0;
+	volatile uint32_t sink = 0;
+	TEMP_Filter_t filter;
+	FILE *f;
+	size_t i;
+	long r;
+	int opt;
+	int status = 0;
+
+	while((opt = getopt(argc, argv, "bc:n:r:o:g:h")) != -1){
+		switch(opt){
+			case 'b': binary = 1; break;
+			case 'c': column = atoi(optarg); break;
+			case 'n': filter_length = atoi(optarg); break;
+			case 'r': repeat = atol(optarg); break;
+			case 'o': output_path = optarg; break;
+			case 'g': golden_path = optarg; break;
+			default:
+				usage(argv[0]);
+				return 2;
+		}
+	}
+	if(optind != argc - 1 || repeat < 1 || column < 0){
+		usage(argv[0]);
+		return 2;
+	}
+
+	f = fopen(argv[optind], binary ? "rb" : "r");
+	if(f == NULL){
+		perror(argv[optind]);
+		return 2;
+	}
+	if((binary ? load_binary(f, &trace) : load_csv(f, &trace, column)) != 0){
+		fclose(f);
+		return 2;
+	}
+	fclose(f);
+	if(trace.count == 0){
+		fprintf(stderr, "%s: no samples\n", argv[optind]);
+		return 2;
+	}
+
+	filtered = malloc(trace.count * sizeof(*filtered));
+	voltages = malloc(trace.count * sizeof(*voltages));
+	temperatures = malloc(trace.count * sizeof(*temperatures));
+	records = malloc(trace.count * sizeof(*records));
+	if(filtered == NULL || voltages == NULL || temperatures == NULL || records == NULL){
+		fprintf(stderr, "out of memory\n");
+		return 2;
+	}
+
+	// Each stage runs over the whole trace in turn so the clock is read
+	// once per stage rather than once per sample.
+	for(r = 0; r < repeat; r++){
+		uint64_t t0, t1, t2, t3, t4;
+
+		TEMP_Filter_Init(&filter, filter_length);
+		t0 = now_ns();
+		for(i = 0; i < trace.count; i++){
+			filtered[i] = TEMP_Filter_Update(&filter, trace.codes[i]);
+		}
+		t1 = now_ns();
+		for(i = 0; i < trace.count; i++){
+			voltages[i] = TEMP_Code_To_Voltage(filtered[i]);
+		}
+		t2 = now_ns();
+		for(i = 0; i < trace.count; i++){
+			temperatures[i] = TEMP_Voltage_To_Celsius(voltages[i]);
+		}
+		t3 = now_ns();
+		for(i = 0; i < trace.count; i++){
+			sink += TEMP_Format(records[i], sizeof(records[i]), temperatures[i]);
+		}
+		t4 = now_ns();
+
+		stage_ns[STAGE_FILTER]  += t1 - t0;
+		stage_ns[STAGE_VOLTAGE] += t2 - t1;
+		stage_ns[STAGE_CELSIUS] += t3 - t2;
+		stage_ns[STAGE_FORMAT]  += t4 - t3;
+		total_ns += t4 - t0;
+	}
+	(void)sink;
+
+	printf("samples:    %zu x %ld\n", trace.count, repeat);
+	printf("filter:     %d\n", filter_length);
+	for(i = 0; i < NUM_STAGES; i++){
+		printf("%-10s  %8.2f ns/sample\n", stage_names[i],
+		       (double)stage_ns[i] / ((double)trace.count * repeat));
+	}
+	printf("throughput: %.0f samples/s\n",
+	       (double)trace.count * repeat * 1e9 / (double)(total_ns ? total_ns : 1));
+
+	if(output_path != NULL){
+		FILE *out = fopen(output_path, "wb");
+
+		if(out == NULL){
+			perror(output_path);
+			return 2;
+		}
+		for(i = 0; i < trace.count; i++){
+			fputs(records[i], out);
+		}
+		fclose(out);
+	}
+
+	if(golden_path != NULL){
+		size_t golden_count;
+		size_t diffs = 0;
+		char **golden = load_golden(golden_path, &golden_count);
+
+		if(golden == NULL){
+			return 2;
+		}
+		for(i = 0; i < trace.count && i < golden_count; i++){
+			strip_record(records[i]);
+			if(strcmp(records[i], golden[i]) != 0){
+				if(diffs < MAX_REPORTED_DIFFS){
+					printf("diff sample %zu: code %u expected '%s' got '%s'\n",
+					       i, (unsigned int)trace.codes[i], golden[i], records[i]);
+				}
+				diffs++;
+			}
+		}
+		if(golden_count != trace.count){
+			printf("diff length: golden has %zu records, trace produced %zu\n",
+			       golden_count, trace.count);
+			diffs++;
+		}
+		printf("golden:     %s (%zu differences)\n", diffs ? "FAIL" : "match", diffs);
+		status = diffs ? 1 : 0;
+
+		for(i = 0; i < golden_count; i++){
+			free(golden[i]);
+		}
+		free(golden);
+	}
+
+	free(records);
+	free(temperatures);
+	free(voltages);
+	free(filtered);
+	free(trace.codes);
+	return status;
+}
@@ -0,0 +1,200 @@
+/***********************************************************
+Title: Gesture check for the button gesture recognizer.
+Description: Feeds scripted press/release edges and timeout
+				polls with synthetic timestamps into
+				button_gesture.c and checks the gesture each
+				call returns: short press, long press, double
+				click, repeat while held, the timeouts between
+				them (reached, one tick early, resolved by the
+				next edge, missed repeats), the disabled DOUBLE
+				and REPEAT variants, a lost edge and timestamps
+				that wrap around zero. Also checks the deadline
+				reported for a one-shot timer. Exits with 1 on
+				any mismatch.
+Usage:
+				gesture_check [-v]
+				-v          print every checked step
+************************************************************/
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "button_gesture.h"
+
+// Script steps: an edge or a timeout poll at time 't' (relative to the
+// scenario's start) and the gesture it must return, or the deadline that
+// must be armed
+typedef enum {
+	STEP_PRESS,
+	STEP_RELEASE,
+	STEP_TIMEOUT,
+	STEP_DEADLINE,      // 't' must be the armed deadline
+	STEP_NO_DEADLINE,
+	STEP_END
+} step_op_t;
+
+typedef struct {
+	step_op_t op;
+	uint32_t t;
+	gesture_t expect;
+} step_t;
+
+typedef struct {
+	const char *name;
+	const gesture_timing_t *timing;
+	uint32_t start;
+	step_t steps[16];
+} scenario_t;
+
+#define PRESS(t, g)    { STEP_PRESS, (t), (g) }
+#define RELEASE(t, g)  { STEP_RELEASE, (t), (g) }
+#define TIMEOUT(t, g)  { STEP_TIMEOUT, (t), (g) }
+#define DEADLINE(t)    { STEP_DEADLINE, (t), GESTURE_NONE }
+#define NO_DEADLINE    { STEP_NO_DEADLINE, 0, GESTURE_NONE }
+#define END            { STEP_END, 0, GESTURE_NONE }
+
+// long_press, double_gap, repeat_delay, repeat_interval
+static const gesture_timing_t timing = { 500, 250, 300, 100 };
+static const gesture_timing_t no_double = { 500, 0, 300, 100 };
+static const gesture_timing_t no_repeat = { 500, 250, 300, 0 };
+
+static const scenario_t scenarios[] = {
+	{ "short press", &timing, 0, {
+		PRESS(0, GESTURE_NONE), DEADLINE(500),
+		RELEASE(100, GESTURE_NONE), DEADLINE(350),
+		TIMEOUT(349, GESTURE_NONE),
+		TIMEOUT(350, GESTURE_SHORT), NO_DEADLINE,
+		TIMEOUT(1000, GESTURE_NONE), END } },
+	{ "short press resolved by the next press", &timing, 0, {
+		PRESS(0, GESTURE_NONE), RELEASE(100, GESTURE_NONE),
+		PRESS(400, GESTURE_SHORT), DEADLINE(900),
+		RELEASE(450, GESTURE_NONE),
+		TIMEOUT(699, GESTURE_NONE), TIMEOUT(700, GESTURE_SHORT), END } },
+	{ "double click", &timing, 0, {
+		PRESS(0, GESTURE_NONE), RELEASE(100, GESTURE_NONE),
+		PRESS(349, GESTURE_DOUBLE), NO_DEADLINE,
+		TIMEOUT(2000, GESTURE_NONE),
+		RELEASE(2100, GESTURE_NONE), TIMEOUT(3000, GESTURE_NONE), END } },
+	{ "long press", &timing, 0, {
+		PRESS(0, GESTURE_NONE),
+		TIMEOUT(499, GESTURE_NONE), TIMEOUT(500, GESTURE_LONG), DEADLINE(800),
+		RELEASE(600, GESTURE_NONE), NO_DEADLINE,
+		TIMEOUT(2000, GESTURE_NONE), END } },
+	{ "long press resolved by the release", &timing, 0, {
+		PRESS(0, GESTURE_NONE), RELEASE(700, GESTURE_LONG), NO_DEADLINE,
+		TIMEOUT(2000, GESTURE_NONE), END } },
+	{ "repeat while held", &timing, 0, {
+		PRESS(0, GESTURE_NONE), TIMEOUT(500, GESTURE_LONG),
+		TIMEOUT(799, GESTURE_NONE), TIMEOUT(800, GESTURE_REPEAT), DEADLINE(900),
+		TIMEOUT(899, GESTURE_NONE), TIMEOUT(900, GESTURE_REPEAT),
+		TIMEOUT(1000, GESTURE_REPEAT),
+		RELEASE(1050, GESTURE_NONE), NO_DEADLINE,
+		TIMEOUT(5000, GESTURE_NONE), END } },
+	{ "missed repeats are reported once", &timing, 0, {
+		PRESS(0, GESTURE_NONE), TIMEOUT(500, GESTURE_LONG),
+		TIMEOUT(800, GESTURE_REPEAT),
+		TIMEOUT(1250, GESTURE_REPEAT), DEADLINE(1350),
+		TIMEOUT(1349, GESTURE_NONE), TIMEOUT(1350, GESTURE_REPEAT), END } },
+	{ "no double gap: short on release", &no_double, 0, {
+		PRESS(0, GESTURE_NONE), RELEASE(100, GESTURE_SHORT), NO_DEADLINE,
+		PRESS(150, GESTURE_NONE), RELEASE(200, GESTURE_SHORT),
+		TIMEOUT(1000, GESTURE_NONE), END } },
+	{ "no repeat interval: long only", &no_repeat, 0, {
+		PRESS(0, GESTURE_NONE), TIMEOUT(500, GESTURE_LONG), NO_DEADLINE,
+		TIMEOUT(5000, GESTURE_NONE), RELEASE(6000, GESTURE_NONE), END } },
+	{ "lost release: second press ignored", &timing, 0, {
+		PRESS(0, GESTURE_NONE), PRESS(50, GESTURE_NONE), DEADLINE(500),
+		RELEASE(100, GESTURE_NONE), TIMEOUT(350, GESTURE_SHORT), END } },
+	{ "release while idle", &timing, 0, {
+		RELEASE(0, GESTURE_NONE), NO_DEADLINE, TIMEOUT(1000, GESTURE_NONE), END } },
+	{ "timestamps wrapping around zero", &timing, 0xFFFFFF00u, {
+		PRESS(0, GESTURE_NONE), TIMEOUT(499, GESTURE_NONE), TIMEOUT(500, GESTURE_LONG),
+		TIMEOUT(800, GESTURE_REPEAT), RELEASE(850, GESTURE_NONE),
+		PRESS(1000, GESTURE_NONE), RELEASE(1100, GESTURE_NONE),
+		PRESS(1200, GESTURE_DOUBLE), RELEASE(1300, GESTURE_NONE), END } },
+};
+
+static const char *const gesture_names[] = { "none", "short", "long", "double", "repeat" };
+static const char *const op_names[] = { "press", "release", "timeout", "deadline", "no deadline" };
+
+static int verbose;
+static int failures;
+static int checks;
+
+static void check(int ok, const scenario_t *s, const step_t *step, const char *got){
+	checks++;
+	if(!ok){
+		failures++;
+		printf("FAIL %s: %s at %u: expected %s, got %s\n", s->name, op_names[step->op], step->t,
+		       step->op == STEP_DEADLINE ? "armed deadline" :
+		       step->op == STEP_NO_DEADLINE ? "no deadline" : gesture_names[step->expect], got);
+	}
+	else if(verbose){
+		printf("ok   %s: %s at %u\n", s->name, op_names[step->op], step->t);
+	}
+}
+
+static void run_scenario(const scenario_t *s){
+	button_gesture_t b;
+	uint32_t deadline;
+	uint8_t armed;
+	char got[32];
+
+	button_gesture_init(&b, s->timing);
+	for(const step_t *step = s->steps; step->op != STEP_END; step++){
+		gesture_t g = GESTURE_NONE;
+
+		switch(step->op){
+			case STEP_PRESS:
+			case STEP_RELEASE:
+			case STEP_TIMEOUT:
+				if(step->op == STEP_TIMEOUT){
+					g = button_gesture_timeout(&b, s->start + step->t);
+				}
+				else{
+					g = button_gesture_edge(&b, step->op == STEP_PRESS, s->start + step->t);
+				}
+				check(g == step->expect, s, step, gesture_names[g]);
+				break;
+
+			case STEP_DEADLINE:
+			case STEP_NO_DEADLINE:
+				armed = button_gesture_deadline(&b, &deadline);
+				if(armed){
+					snprintf(got, sizeof(got), "deadline at %u", (unsigned)(deadline - s->start));
+				}
+				else{
+					snprintf(got, sizeof(got), "no deadline");
+				}
+				check(step->op == STEP_DEADLINE ? armed && deadline == s->start + step->t : !armed,
+				      s, step, got);
+				break;
+
+			default:
+				break;
+		}
+	}
+}
+
+int main(int argc, char *argv[]){
+	int opt;
+
+	while((opt = getopt(argc, argv, "vh")) != -1){
+		switch(opt){
+			case 'v': verbose = 1; break;
+			default:
+				fprintf(stderr, "usage: %s [-v]\n", argv[0]);
+				return 2;
+		}
+	}
+
+	for(size_t i = 0; i < sizeof(scenarios) / sizeof(scenarios[0]); i++){
+		run_scenario(&scenarios[i]);
+	}
+
+	printf("%d of %d checks passed\n", checks - failures, checks);
+	return failures != 0;
+}
@@ -0,0 +1,69 @@
+/***********************************************************
+Title: Host replacement of the CMSIS Cortex-M4 core header.
+Description: Included by the unchanged stm32l476xx.h when a
+				lab is built for lab_sim. Core peripherals
+				are plain structs and the intrinsics call
+				into the simulator: interrupt masking
+				blocks the simulated interrupt signal, WFI
+				waits for it and NVIC_EnableIRQ records
+				which interrupts may be raised.
+************************************************************/
+
+#ifndef __LAB_SIM_CORE_CM4_H
+#define __LAB_SIM_CORE_CM4_H
+
+#include <stdint.h>
+#include "lab_sim.h"
+
+#define __I     volatile const
+#define __O     volatile
+#define __IO    volatile
+#define __IM    volatile const
+#define __OM    volatile
+#define __IOM   volatile
+
+#define __STATIC_INLINE static inline
+
+typedef struct {
+	__IOM uint32_t CPUID, ICSR, VTOR, AIRCR, SCR, CCR;
+} SCB_Type;
+
+typedef struct {
+	__IOM uint32_t CTRL, CYCCNT;
+} DWT_Type;
+
+typedef struct {
+	__IOM uint32_t DHCSR, DCRSR, DCRDR, DEMCR;
+} CoreDebug_Type;
+
+extern SCB_Type sim_scb;
+extern DWT_Type sim_dwt;
+extern CoreDebug_Type sim_core_debug;
+
+#define SCB        (&sim_scb)
+#define DWT        (&sim_dwt)
+#define CoreDebug  (&sim_core_debug)
+
+#define SCB_SCR_SLEEPONEXIT_Msk      (1UL << 1)
+#define SCB_SCR_SLEEPDEEP_Msk        (1UL << 2)
+#define SCB_SCR_SEVONPEND_Msk        (1UL << 4)
+#define DWT_CTRL_CYCCNTENA_Msk       (1UL << 0)
+#define CoreDebug_DEMCR_TRCENA_Msk   (1UL << 24)
+
+static inline void NVIC_EnableIRQ(IRQn_Type irq){ sim_nvic_enable((int)irq, 1); }
+static inline void NVIC_DisableIRQ(IRQn_Type irq){ sim_nvic_enable((int)irq, 0); }
+static inline void NVIC_SetPriority(IRQn_Type irq, uint32_t priority){ (void)irq; (void)priority; }
+static inline void NVIC_ClearPendingIRQ(IRQn_Type irq){ (void)irq; }
+
+static inline void __disable_irq(void){ sim_set_primask(1); }
+static inline void __enable_irq(void){ sim_set_primask(0); }
+static inline uint32_t __get_PRIMASK(void){ return sim_get_primask(); }
+static inline void __set_PRIMASK(uint32_t primask){ sim_set_primask(primask & 1U); }
+static inline void __WFI(void){ sim_wfi(); }
+static inline void __WFE(void){ sim_wfi(); }
+static inline void __NOP(void){ }
+static inline void __DMB(void){ __sync_synchronize(); }
+static inline void __DSB(void){ __sync_synchronize(); }
+static inline void __ISB(void){ __sync_synchronize(); }
+
+#endif /* __LAB_SIM_CORE_CM4_H */
@@ -0,0 +1,25 @@
+/***********************************************************
+Title: lab_sim hooks.
+Description: The calls the host core header makes into the
+				simulator, and the BSRR store hook for
+				gpio_pin.h. This header is force-included in
+				every lab translation unit of a lab_sim build
+				(-include lab_sim.h), so it cannot depend on
+				the device header.
+************************************************************/
+
+#ifndef __LAB_SIM_H
+#define __LAB_SIM_H
+
+#include <stdint.h>
+
+void sim_nvic_enable(int irq, int enable);
+void sim_set_primask(uint32_t primask);
+uint32_t sim_get_primask(void);
+void sim_wfi(void);
+
+// BSRR is write-only on the device: route stores to the model so ODR follows
+void sim_gpio_bsrr(volatile void *port, uint32_t word);
+#define GPIO_BSRR_STORE(port, word) sim_gpio_bsrr((port), (word))
+
+#endif /* __LAB_SIM_H */
@@ -0,0 +1,9 @@
+/* Host build: the labs never call SystemInit(), the core runs from MSI at 4 MHz */
+#ifndef __LAB_SIM_SYSTEM_STM32L4XX_H
+#define __LAB_SIM_SYSTEM_STM32L4XX_H
+
+#include <stdint.h>
+
+extern uint32_t SystemCoreClock;
+
+#endif /* __LAB_SIM_SYSTEM_STM32L4XX_H */
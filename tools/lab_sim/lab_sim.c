@@ -0,0 +1,765 @@
+/***********************************************************
+Title: Host GPIO/EXTI edge-injection simulator for the labs.
+Description: Runs a lab's unchanged main.c on the PC against
+				simulated peripherals and replays a trace of
+				switch edges into it:
+				- The peripheral address range of the
+				  STM32L476 is mapped as plain memory at its
+				  device address, so stm32l476xx.h and the
+				  lab code are used as they are. GPIO outputs
+				  are taken from the BSRR stores (gpio_pin.h
+				  GPIO_BSRR_STORE hook).
+				- main() runs in its own thread. Interrupts
+				  are delivered to that thread as a signal, so
+				  a handler preempts the main loop like on the
+				  device; __disable_irq() blocks the signal.
+				- Trace edges update IDR and go through the
+				  EXTI model (EXTICR routing, RTSR/FTSR, IMR,
+				  NVIC enable). TIM2..TIM7 count in simulated
+				  time with prescaler, auto-reload, one-pulse
+				  mode and compare flags; SR is write-0-to-
+				  clear. Encoder/slave modes are not modelled.
+				After each trace step the LED states can be
+				checked, and the host cost of every interrupt
+				handler is reported at the end.
+Usage:
+				<lab>_sim [options] <trace>
+				-v         print the LED states after every event
+				-t <ms>    real time the main loop gets to update the
+				           LEDs before an expect fails (default 100)
+				-q <us>    real time given to the main loop after each
+				           interrupt (default 50)
+************************************************************/
+
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <errno.h>
+#include <signal.h>
+#include <pthread.h>
+#include <semaphore.h>
+#include <sys/mman.h>
+#include <time.h>
+#include <unistd.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define COST_UNIT "host cycles"
+#else
+#define COST_UNIT "host ns"
+#endif
+
+#include "stm32l476xx.h"
+#include "lab_board.h"
+#include "lab_clock.h"
+
+#define SIM_IRQ_SIGNAL      SIGUSR1
+#define SIM_NUM_IRQS        128
+#define SIM_STEP_CYCLES     (LAB_CORE_CLOCK_HZ / 1000000UL)   // one simulated microsecond
+#define SIM_PERIPH_SIZE     (AHB2PERIPH_BASE + 0x2000U - PERIPH_BASE)   // up to GPIOH
+#define SIM_SETTLE_US       20000     // real time main() gets for its initialisation
+#define MAX_GENERIC_PINS    32
+
+int lab_main(void);
+
+SCB_Type sim_scb;
+DWT_Type sim_dwt;
+CoreDebug_Type sim_core_debug;
+uint32_t SystemCoreClock = LAB_CORE_CLOCK_HZ;
+
+//-------------------------------------------------------------------------------------------
+// Interrupt handlers. Those the lab does not define stay null.
+//-------------------------------------------------------------------------------------------
+#define SIM_HANDLERS(X) \
+	X(EXTI0) X(EXTI1) X(EXTI2) X(EXTI3) X(EXTI4) X(EXTI9_5) X(EXTI15_10) \
+	X(TIM2) X(TIM3) X(TIM4) X(TIM5) X(TIM6_DAC) X(TIM7)
+
+#define DECLARE_HANDLER(name) void name##_IRQHandler(void) __attribute__((weak));
+SIM_HANDLERS(DECLARE_HANDLER)
+
+typedef struct {
+	IRQn_Type irq;
+	const char *name;
+	void (*handler)(void);
+	uint32_t calls;
+	uint64_t cost_total;
+	uint64_t cost_min;
+	uint64_t cost_max;
+} sim_vector_t;
+
+#define VECTOR_ENTRY(name) { name##_IRQn, #name "_IRQHandler", name##_IRQHandler, 0, 0, 0, 0 },
+static sim_vector_t vectors[] = { SIM_HANDLERS(VECTOR_ENTRY) };
+#define NUM_VECTORS (sizeof(vectors) / sizeof(vectors[0]))
+
+static volatile uint8_t nvic_enabled[SIM_NUM_IRQS];
+static volatile uint8_t irq_pending[SIM_NUM_IRQS];
+static uint32_t irqs_not_enabled;     // raised while disabled in the NVIC, dropped
+static pthread_t lab_thread;
+static sem_t irq_done;
+static volatile uint32_t primask;
+
+//-------------------------------------------------------------------------------------------
+// Timer model
+//-------------------------------------------------------------------------------------------
+typedef struct {
+	TIM_TypeDef *tim;
+	IRQn_Type irq;
+	uint8_t channels;      // compare channels (0 for the basic timers)
+	uint32_t prescale;     // core cycles counted towards the next tick
+	uint32_t sr;           // status flags as the model sees them
+} sim_timer_t;
+
+static sim_timer_t timers[] = {
+	{ TIM2, TIM2_IRQn,     4, 0, 0 },
+	{ TIM3, TIM3_IRQn,     4, 0, 0 },
+	{ TIM4, TIM4_IRQn,     4, 0, 0 },
+	{ TIM5, TIM5_IRQn,     4, 0, 0 },
+	{ TIM6, TIM6_DAC_IRQn, 0, 0, 0 },
+	{ TIM7, TIM7_IRQn,     0, 0, 0 },
+};
+#define NUM_TIMERS (sizeof(timers) / sizeof(timers[0]))
+
+static uint64_t sim_time_us;
+
+//-------------------------------------------------------------------------------------------
+// Trace
+//-------------------------------------------------------------------------------------------
+enum {
+	EVENT_SET,      // drive an input level
+	EVENT_EXPECT,   // check the logical state of a pin
+	EVENT_RUN       // only advance the time
+};
+
+typedef struct {
+	uint64_t time_us;
+	uint32_t order;       // position in the trace, keeps equal times in order
+	int line;
+	uint8_t type;
+	uint8_t level;
+	const gpio_pin_t *pin;
+} sim_event_t;
+
+typedef struct {
+	sim_event_t *events;
+	size_t count;
+	size_t capacity;
+} sim_trace_t;
+
+typedef struct {
+	const char *name;
+	const gpio_pin_t *pin;
+} sim_pin_name_t;
+
+static const sim_pin_name_t board_pins[] = {
+	{ "LED1", &LED1 }, { "LED2", &LED2 }, { "SW1", &SW1 }, { "SW2", &SW2 }
+};
+
+static gpio_pin_t generic_pins[MAX_GENERIC_PINS];
+static char generic_names[MAX_GENERIC_PINS][8];
+static size_t num_generic_pins;
+
+static int verbose;
+static uint32_t expect_timeout_ms = 100;
+static uint32_t irq_quantum_us = 50;
+
+static uint64_t cost_now(void){
+#if defined(__x86_64__) || defined(__i386__)
+	return __rdtsc();
+#else
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+#endif
+}
+
+static void sleep_us(uint32_t us){
+	struct timespec ts;
+	ts.tv_sec = us / 1000000U;
+	ts.tv_nsec = (long)(us % 1000000U) * 1000L;
+	while(nanosleep(&ts, &ts) != 0 && errno == EINTR){
+	}
+}
+
+static uint64_t real_time_us(void){
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000ull + (uint64_t)ts.tv_nsec / 1000U;
+}
+
+//-------------------------------------------------------------------------------------------
+// Hooks called from the lab code (lab_sim.h / core_cm4.h)
+//-------------------------------------------------------------------------------------------
+void sim_nvic_enable(int irq, int enable){
+	if(irq >= 0 && irq < SIM_NUM_IRQS){
+		nvic_enabled[irq] = (uint8_t)(enable != 0);
+	}
+}
+
+void sim_set_primask(uint32_t value){
+	sigset_t set;
+
+	sigemptyset(&set);
+	sigaddset(&set, SIM_IRQ_SIGNAL);
+	primask = value;
+	pthread_sigmask(value ? SIG_BLOCK : SIG_UNBLOCK, &set, NULL);
+}
+
+uint32_t sim_get_primask(void){
+	return primask;
+}
+
+// WFI returns on a pending interrupt. With PRIMASK set the interrupt stays
+// pending and is taken at __enable_irq(), as on the device.
+void sim_wfi(void){
+	sigset_t set;
+
+	if(primask){
+		for(;;){
+			sigpending(&set);
+			if(sigismember(&set, SIM_IRQ_SIGNAL)){
+				return;
+			}
+			sleep_us(10);
+		}
+	}
+	pthread_sigmask(SIG_BLOCK, NULL, &set);
+	sigdelset(&set, SIM_IRQ_SIGNAL);
+	sigsuspend(&set);
+}
+
+// BSRR: set bits win over reset bits. The update is a compare-and-swap so a
+// handler interrupting a main loop store cannot lose either write.
+void sim_gpio_bsrr(volatile void *port, uint32_t word){
+	uint32_t *odr = (uint32_t *)&((GPIO_TypeDef *)port)->ODR;
+	uint32_t old = __atomic_load_n(odr, __ATOMIC_SEQ_CST);
+	uint32_t next;
+
+	do{
+		next = (old & ~(word >> 16)) | (word & 0xFFFFU);
+	}while(!__atomic_compare_exchange_n(odr, &old, next, 0, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST));
+}
+
+//-------------------------------------------------------------------------------------------
+// Interrupt delivery
+//-------------------------------------------------------------------------------------------
+static sim_vector_t *find_vector(int irq){
+	size_t i;
+
+	for(i = 0; i < NUM_VECTORS; i++){
+		if((int)vectors[i].irq == irq){
+			return &vectors[i];
+		}
+	}
+	return NULL;
+}
+
+// Runs in the lab thread: the signal preempts main() like an exception
+static void irq_signal(int sig){
+	int irq;
+
+	(void)sig;
+	for(irq = 0; irq < SIM_NUM_IRQS; irq++){
+		sim_vector_t *v;
+		uint64_t start, cost;
+
+		if(!irq_pending[irq]){
+			continue;
+		}
+		irq_pending[irq] = 0;
+		v = find_vector(irq);
+		if(v == NULL || v->handler == NULL){
+			continue;
+		}
+		start = cost_now();
+		v->handler();
+		cost = cost_now() - start;
+
+		if(v->calls == 0 || cost < v->cost_min){
+			v->cost_min = cost;
+		}
+		if(cost > v->cost_max){
+			v->cost_max = cost;
+		}
+		v->cost_total += cost;
+		v->calls++;
+	}
+	sem_post(&irq_done);
+}
+
+// Raise an interrupt and wait until its handler has returned
+static void raise_irq(int irq){
+	if(!nvic_enabled[irq]){
+		irqs_not_enabled++;
+		return;
+	}
+	irq_pending[irq] = 1;
+	pthread_kill(lab_thread, SIM_IRQ_SIGNAL);
+	while(sem_wait(&irq_done) != 0 && errno == EINTR){
+	}
+	if(irq_quantum_us != 0){
+		sleep_us(irq_quantum_us);
+	}
+}
+
+//-------------------------------------------------------------------------------------------
+// Peripheral models
+//-------------------------------------------------------------------------------------------
+static GPIO_TypeDef *gpio_port(uint32_t index){
+	return (GPIO_TypeDef *)(uintptr_t)(GPIOA_BASE + index * (GPIOB_BASE - GPIOA_BASE));
+}
+
+static uint8_t pin_active(const gpio_pin_t *p){
+	uint32_t reg = (p->mode == GPIO_MODE_OUTPUT) ? p->port->ODR : p->port->IDR;
+	return (uint8_t)(((reg >> p->pin) & 1U) ^ p->active_low);
+}
+
+static IRQn_Type exti_irq(uint8_t line){
+	if(line <= 4){
+		return (IRQn_Type)(EXTI0_IRQn + line);
+	}
+	return line <= 9 ? EXTI9_5_IRQn : EXTI15_10_IRQn;
+}
+
+// Drive an input. An edge on a line routed to this port, with its trigger
+// selected and the line unmasked, sets PR1 and raises the EXTI interrupt.
+static void drive_pin(const gpio_pin_t *p, uint8_t level){
+	uint32_t mask = 1UL << p->pin;
+	uint32_t old = p->port->IDR;
+	uint32_t source = (SYSCFG->EXTICR[p->pin >> 2] >> ((p->pin & 3U) * 4U)) & 0x7U;
+	uint8_t rising;
+
+	if(((old & mask) != 0) == (level != 0)){
+		return;
+	}
+	p->port->IDR = level ? (old | mask) : (old & ~mask);
+	rising = level != 0;
+
+	if(source != (uint32_t)gpio_pin_port_index(p) || !(EXTI->IMR1 & mask)){
+		return;
+	}
+	if(!((rising ? EXTI->RTSR1 : EXTI->FTSR1) & mask)){
+		return;
+	}
+	EXTI->PR1 = mask;
+	raise_irq(exti_irq(p->pin));
+	EXTI->PR1 = 0;   // PR1 is write-1-to-clear: one request per edge
+}
+
+// The lab writes ~flag (or 0) to clear SR flags: a value that differs from
+// what the model last stored is taken as such a write.
+static void timer_sync_sr(sim_timer_t *t){
+	uint32_t sr = t->tim->SR;
+
+	if(sr != t->sr){
+		t->sr &= sr;
+		t->tim->SR = t->sr;
+	}
+}
+
+static void timer_tick(sim_timer_t *t){
+	TIM_TypeDef *tim = t->tim;
+	uint64_t cnt = (uint64_t)tim->CNT + 1U;
+	uint8_t ch;
+
+	if(cnt > tim->ARR){
+		cnt = 0;
+		t->sr |= TIM_SR_UIF;
+		if(tim->CR1 & TIM_CR1_OPM){
+			tim->CR1 &= ~TIM_CR1_CEN;
+		}
+	}
+	tim->CNT = (uint32_t)cnt;
+	for(ch = 0; ch < t->channels; ch++){
+		if((uint32_t)cnt == (&tim->CCR1)[ch]){
+			t->sr |= TIM_SR_CC1IF << ch;
+		}
+	}
+}
+
+static void timers_step(uint32_t cycles){
+	size_t i;
+
+	for(i = 0; i < NUM_TIMERS; i++){
+		sim_timer_t *t = &timers[i];
+		TIM_TypeDef *tim = t->tim;
+		uint32_t raised = 0;
+
+		timer_sync_sr(t);
+		if(tim->EGR & TIM_EGR_UG){
+			// Update generation: restart the count and the prescaler
+			tim->EGR = 0;
+			tim->CNT = 0;
+			t->prescale = 0;
+		}
+		if((tim->CR1 & TIM_CR1_CEN) && !(tim->SMCR & TIM_SMCR_SMS)){
+			t->prescale += cycles;
+			while(t->prescale > tim->PSC && (tim->CR1 & TIM_CR1_CEN)){
+				t->prescale -= tim->PSC + 1U;
+				timer_tick(t);
+			}
+			tim->SR = t->sr;
+		}
+
+		// The handler runs once per step; flags it leaves set raise it again next step
+		if(t->sr & tim->DIER & 0xFFU){
+			raise_irq(t->irq);
+			raised = 1;
+		}
+		if(raised){
+			timer_sync_sr(t);
+		}
+	}
+}
+
+static void advance_to(uint64_t time_us){
+	while(sim_time_us < time_us){
+		timers_step(SIM_STEP_CYCLES);
+		if((CoreDebug->DEMCR & CoreDebug_DEMCR_TRCENA_Msk) && (DWT->CTRL & DWT_CTRL_CYCCNTENA_Msk)){
+			DWT->CYCCNT += SIM_STEP_CYCLES;
+		}
+		sim_time_us++;
+	}
+}
+
+static int map_peripherals(void){
+	void *base = (void *)(uintptr_t)PERIPH_BASE;
+	void *map = mmap(base, SIM_PERIPH_SIZE, PROT_READ | PROT_WRITE,
+	                 MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE | MAP_FIXED_NOREPLACE, -1, 0);
+	size_t i;
+
+	if(map != base){
+		fprintf(stderr, "cannot map the peripherals at 0x%08lx\n", (unsigned long)PERIPH_BASE);
+		return -1;
+	}
+	// Reset values that differ from zero and matter to the model
+	for(i = 0; i < NUM_TIMERS; i++){
+		timers[i].tim->ARR = (timers[i].tim == TIM2 || timers[i].tim == TIM5) ? 0xFFFFFFFFUL : 0xFFFFUL;
+	}
+	return 0;
+}
+
+//-------------------------------------------------------------------------------------------
+// Trace parsing
+//-------------------------------------------------------------------------------------------
+static const gpio_pin_t *lookup_pin(const char *name){
+	size_t i;
+	char *end;
+	unsigned long pin;
+
+	for(i = 0; i < sizeof(board_pins) / sizeof(board_pins[0]); i++){
+		if(strcmp(name, board_pins[i].name) == 0){
+			return board_pins[i].pin;
+		}
+	}
+	for(i = 0; i < num_generic_pins; i++){
+		if(strcmp(name, generic_names[i]) == 0){
+			return &generic_pins[i];
+		}
+	}
+	// Generic pins (PA0..PH15) are inputs, active high
+	if(name[0] != 'P' || name[1] < 'A' || name[1] > 'H' || num_generic_pins == MAX_GENERIC_PINS){
+		return NULL;
+	}
+	pin = strtoul(name + 2, &end, 10);
+	if(end == name + 2 || *end != '\0' || pin > 15){
+		return NULL;
+	}
+	generic_pins[num_generic_pins] = (gpio_pin_t)GPIO_INPUT_PIN(gpio_port((uint32_t)(name[1] - 'A')),
+	                                                          (uint8_t)pin, GPIO_PULL_NONE, GPIO_ACTIVE_HIGH);
+	snprintf(generic_names[num_generic_pins], sizeof(generic_names[0]), "%s", name);
+	return &generic_pins[num_generic_pins++];
+}
+
+static const char *pin_name(const gpio_pin_t *p){
+	size_t i;
+
+	for(i = 0; i < sizeof(board_pins) / sizeof(board_pins[0]); i++){
+		if(board_pins[i].pin == p){
+			return board_pins[i].name;
+		}
+	}
+	return generic_names[p - generic_pins];
+}
+
+static void trace_push(sim_trace_t *trace, const sim_event_t *event){
+	if(trace->count == trace->capacity){
+		trace->capacity = trace->capacity ? trace->capacity * 2 : 256;
+		trace->events = realloc(trace->events, trace->capacity * sizeof(sim_event_t));
+		if(trace->events == NULL){
+			fprintf(stderr, "out of memory\n");
+			exit(2);
+		}
+	}
+	trace->events[trace->count] = *event;
+	trace->events[trace->count].order = (uint32_t)trace->count;
+	trace->count++;
+}
+
+static int parse_level(const char *text, uint8_t *level){
+	if(strcmp(text, "1") == 0 || strcmp(text, "on") == 0){
+		*level = 1;
+	}
+	else if(strcmp(text, "0") == 0 || strcmp(text, "off") == 0){
+		*level = 0;
+	}
+	else{
+		return -1;
+	}
+	return 0;
+}
+
+// One trace line: <time_ms> <command> <args...>
+//   set    <pin> <0|1>                           drive an input
+//   bounce <pin> <0|1> <transitions> <period_us> chatter, then settle at the level
+//   expect <pin>=<on|off> ...                    logical state (pin polarity applied)
+//   run                                          advance the time only
+static int parse_line(sim_trace_t *trace, char *text, int line){
+	char *words[16];
+	int count = 0;
+	char *word, *end;
+	double time_ms;
+	sim_event_t event;
+
+	memset(&event, 0, sizeof(event));
+	for(word = strtok(text, " \t\r\n"); word != NULL && count < 16; word = strtok(NULL, " \t\r\n")){
+		if(word[0] == '#'){
+			break;
+		}
+		words[count++] = word;
+	}
+	if(count == 0){
+		return 0;
+	}
+	time_ms = strtod(words[0], &end);
+	if(count < 2 || *end != '\0' || time_ms < 0){
+		fprintf(stderr, "line %d: expected '<time_ms> <command> ...'\n", line);
+		return -1;
+	}
+	event.time_us = (uint64_t)(time_ms * 1000.0 + 0.5);
+	event.line = line;
+
+	if(strcmp(words[1], "set") == 0 && count == 4){
+		event.type = EVENT_SET;
+		event.pin = lookup_pin(words[2]);
+		if(event.pin == NULL || parse_level(words[3], &event.level) != 0){
+			fprintf(stderr, "line %d: bad pin or level\n", line);
+			return -1;
+		}
+		trace_push(trace, &event);
+	}
+	else if(strcmp(words[1], "bounce") == 0 && count == 6){
+		unsigned long transitions = strtoul(words[4], NULL, 10);
+		unsigned long period = strtoul(words[5], NULL, 10);
+		uint8_t level;
+		unsigned long i;
+
+		event.type = EVENT_SET;
+		event.pin = lookup_pin(words[2]);
+		if(event.pin == NULL || parse_level(words[3], &level) != 0 || period == 0){
+			fprintf(stderr, "line %d: bad bounce\n", line);
+			return -1;
+		}
+		// Alternate starting with the new level, end on it
+		for(i = 0; i <= transitions; i++){
+			event.level = (i == transitions) ? level : (uint8_t)(level ^ (i & 1U));
+			trace_push(trace, &event);
+			event.time_us += period;
+		}
+	}
+	else if(strcmp(words[1], "expect") == 0 && count >= 3){
+		int i;
+
+		event.type = EVENT_EXPECT;
+		for(i = 2; i < count; i++){
+			char *eq = strchr(words[i], '=');
+
+			if(eq == NULL){
+				fprintf(stderr, "line %d: expected <pin>=<on|off>\n", line);
+				return -1;
+			}
+			*eq = '\0';
+			event.pin = lookup_pin(words[i]);
+			if(event.pin == NULL || parse_level(eq + 1, &event.level) != 0){
+				fprintf(stderr, "line %d: bad pin or state\n", line);
+				return -1;
+			}
+			trace_push(trace, &event);
+		}
+	}
+	else if(strcmp(words[1], "run") == 0 && count == 2){
+		event.type = EVENT_RUN;
+		trace_push(trace, &event);
+	}
+	else{
+		fprintf(stderr, "line %d: unknown command '%s'\n", line, words[1]);
+		return -1;
+	}
+	return 0;
+}
+
+static int compare_events(const void *a, const void *b){
+	const sim_event_t *x = a, *y = b;
+
+	if(x->time_us != y->time_us){
+		return x->time_us < y->time_us ? -1 : 1;
+	}
+	return x->order < y->order ? -1 : (x->order > y->order);
+}
+
+static int load_trace(const char *path, sim_trace_t *trace){
+	FILE *f = fopen(path, "r");
+	char text[256];
+	int line = 0;
+	int status = 0;
+
+	if(f == NULL){
+		perror(path);
+		return -1;
+	}
+	while(status == 0 && fgets(text, sizeof(text), f) != NULL){
+		status = parse_line(trace, text, ++line);
+	}
+	fclose(f);
+	qsort(trace->events, trace->count, sizeof(sim_event_t), compare_events);
+	return status;
+}
+
+//-------------------------------------------------------------------------------------------
+// Replay
+//-------------------------------------------------------------------------------------------
+static void print_leds(void){
+	printf("%9.3f ms  LED1=%s LED2=%s\n", (double)sim_time_us / 1000.0,
+	       pin_active(&LED1) ? "on " : "off", pin_active(&LED2) ? "on " : "off");
+}
+
+// The main loop runs in real time: give it until the timeout to reach the state
+static int check_expect(const sim_event_t *event){
+	uint64_t deadline = real_time_us() + (uint64_t)expect_timeout_ms * 1000U;
+
+	while(pin_active(event->pin) != event->level){
+		if(real_time_us() >= deadline){
+			printf("FAIL line %d at %.3f ms: %s is %s, expected %s\n", event->line,
+			       (double)sim_time_us / 1000.0, pin_name(event->pin),
+			       event->level ? "off" : "on", event->level ? "on" : "off");
+			return -1;
+		}
+		sleep_us(50);
+	}
+	return 0;
+}
+
+static void *run_lab(void *arg){
+	(void)arg;
+	lab_main();
+	return NULL;
+}
+
+static void print_costs(void){
+	size_t i;
+
+	printf("\n%-22s %8s %12s %12s %12s   (%s)\n", "handler", "calls", "min", "avg", "max", COST_UNIT);
+	for(i = 0; i < NUM_VECTORS; i++){
+		const sim_vector_t *v = &vectors[i];
+
+		if(v->calls == 0){
+			continue;
+		}
+		printf("%-22s %8u %12llu %12llu %12llu\n", v->name, v->calls,
+		       (unsigned long long)v->cost_min,
+		       (unsigned long long)(v->cost_total / v->calls),
+		       (unsigned long long)v->cost_max);
+	}
+	if(irqs_not_enabled != 0){
+		printf("%u interrupt requests dropped (not enabled in the NVIC)\n", irqs_not_enabled);
+	}
+}
+
+static void usage(const char *name){
+	fprintf(stderr, "usage: %s [-v] [-t expect_timeout_ms] [-q irq_quantum_us] trace\n", name);
+}
+
+int main(int argc, char **argv){
+	sim_trace_t trace = { NULL, 0, 0 };
+	struct sigaction action;
+	sigset_t set;
+	size_t i;
+	int opt, failures = 0, expects = 0;
+
+	while((opt = getopt(argc, argv, "vt:q:")) != -1){
+		switch(opt){
+			case 'v': verbose = 1; break;
+			case 't': expect_timeout_ms = (uint32_t)strtoul(optarg, NULL, 10); break;
+			case 'q': irq_quantum_us = (uint32_t)strtoul(optarg, NULL, 10); break;
+			default: usage(argv[0]); return 2;
+		}
+	}
+	if(optind != argc - 1){
+		usage(argv[0]);
+		return 2;
+	}
+	if(map_peripherals() != 0 || load_trace(argv[optind], &trace) != 0){
+		return 2;
+	}
+
+	// Levels set at time 0 are the reset levels: applied before main() starts, no edges
+	for(i = 0; i < trace.count && trace.events[i].time_us == 0 && trace.events[i].type == EVENT_SET; i++){
+		const gpio_pin_t *p = trace.events[i].pin;
+		p->port->IDR = trace.events[i].level ? (p->port->IDR | (1UL << p->pin))
+		                                     : (p->port->IDR & ~(1UL << p->pin));
+	}
+
+	sem_init(&irq_done, 0, 0);
+	memset(&action, 0, sizeof(action));
+	action.sa_handler = irq_signal;
+	sigemptyset(&action.sa_mask);
+	sigaction(SIM_IRQ_SIGNAL, &action, NULL);
+
+	// The lab thread starts with the interrupt signal unblocked (PRIMASK = 0),
+	// this thread blocks it afterwards; signals are sent to the lab thread only.
+	if(pthread_create(&lab_thread, NULL, run_lab, NULL) != 0){
+		fprintf(stderr, "cannot start the lab thread\n");
+		return 2;
+	}
+	sigemptyset(&set);
+	sigaddset(&set, SIM_IRQ_SIGNAL);
+	pthread_sigmask(SIG_BLOCK, &set, NULL);
+	sleep_us(SIM_SETTLE_US);
+	if(verbose){
+		print_leds();
+	}
+
+	for(; i < trace.count; i++){
+		const sim_event_t *event = &trace.events[i];
+
+		advance_to(event->time_us);
+		switch(event->type){
+			case EVENT_SET:
+				drive_pin(event->pin, event->level);
+				if(verbose){
+					printf("%9.3f ms  %s=%u\n", (double)sim_time_us / 1000.0, pin_name(event->pin), event->level);
+				}
+				break;
+			case EVENT_EXPECT:
+				expects++;
+				if(check_expect(event) != 0){
+					failures++;
+				}
+				break;
+			default:
+				break;
+		}
+		if(verbose && (i + 1 == trace.count || trace.events[i + 1].time_us != event->time_us)){
+			sleep_us(irq_quantum_us);
+			print_leds();
+		}
+	}
+
+	print_costs();
+	printf("\n%d of %d expectations met, %.3f ms simulated\n", expects - failures, expects,
+	       (double)sim_time_us / 1000.0);
+	free(trace.events);
+	// The lab's main() never returns: leave without joining it
+	return failures ? 1 : 0;
+}
@@ -0,0 +1,149 @@
+/***********************************************************
+Title: Transition check for the table driven rotary counter.
+Description: Builds rotary_counter.c tables for every width
+				from 1 to ROTARY_COUNTER_MAX_BITS bits on LED
+				maps with mixed polarities and checks every
+				(state, event) pair: UP and DOWN must reach
+				the next and previous count, wrapping at both
+				ends, with one BSRR store that drives each LED
+				of the counter exactly once to the level of
+				its bit; an invalid event must change neither
+				the count nor the LEDs. Also checks that
+				unsupported widths and LEDs on different ports
+				are refused. Exits with 1 on any mismatch.
+Usage:
+				rotary_check [-v]
+				-v          print every checked transition
+************************************************************/
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "stm32l476xx.h"
+#include "rotary_counter.h"
+
+// LEDs for the widest counter: bit i on PA(i + 4), every other one active low
+static const gpio_pin_t leds_a[ROTARY_COUNTER_MAX_BITS] = {
+	GPIO_OUTPUT_PIN(GPIOA, 4, GPIO_ACTIVE_HIGH),
+	GPIO_OUTPUT_PIN(GPIOA, 5, GPIO_ACTIVE_LOW),
+	GPIO_OUTPUT_PIN(GPIOA, 6, GPIO_ACTIVE_HIGH),
+	GPIO_OUTPUT_PIN(GPIOA, 7, GPIO_ACTIVE_LOW),
+};
+static const gpio_pin_t led_b = GPIO_OUTPUT_PIN(GPIOB, 4, GPIO_ACTIVE_HIGH);
+
+// The BSRR stores the counter made since the last check
+static volatile void *store_port;
+static uint32_t store_word;
+static uint32_t stores;
+static int verbose;
+static int failures;
+static int checks;
+
+void sim_gpio_bsrr(volatile void *port, uint32_t word){
+	store_port = port;
+	store_word = word;
+	stores++;
+}
+
+static void check(int ok, const char *what, uint8_t bits, uint32_t state, const char *event){
+	checks++;
+	if(!ok){
+		failures++;
+		printf("FAIL %u bits, state %u, %s: %s\n", bits, state, event, what);
+	}
+	else if(verbose){
+		printf("ok   %u bits, state %u, %s\n", bits, state, event);
+	}
+}
+
+// BSRR word expected to show 'value' on the first 'bits' LEDs of leds_a,
+// written out per LED rather than with gpio_pin.h's helpers
+static uint32_t expected_word(uint8_t bits, uint32_t value){
+	uint32_t word = 0;
+
+	for(uint8_t i = 0; i < bits; i++){
+		int high = ((value >> i) & 1U) ^ leds_a[i].active_low;
+
+		word |= high ? (1UL << leds_a[i].pin) : (1UL << (leds_a[i].pin + 16U));
+	}
+	return word;
+}
+
+static void check_width(uint8_t bits){
+	const gpio_pin_t *leds[ROTARY_COUNTER_MAX_BITS];
+	uint32_t states = 1U << bits;
+	rotary_counter_t rc;
+
+	for(uint8_t i = 0; i < bits; i++){
+		leds[i] = &leds_a[i];
+	}
+	stores = 0;
+	check(rotary_counter_init(&rc, leds, bits, (uint8_t)(states - 1U)) == 0, "init refused", bits, 0, "init");
+	check(rotary_counter_value(&rc) == states - 1U && stores == 1 &&
+	      store_word == expected_word(bits, states - 1U), "initial count not shown", bits, states - 1U, "init");
+
+	for(uint32_t s = 0; s < states; s++){
+		static const struct {
+			rotary_event_t event;
+			const char *name;
+			int delta;
+		} events[] = {
+			{ ROTARY_EVENT_UP,   "up",   1 },
+			{ ROTARY_EVENT_DOWN, "down", -1 },
+			{ ROTARY_NUM_EVENTS, "invalid", 0 },
+			{ (rotary_event_t)0xFF, "invalid 0xff", 0 },
+		};
+
+		for(size_t e = 0; e < sizeof(events) / sizeof(events[0]); e++){
+			uint32_t next = (s + states + (uint32_t)events[e].delta) & (states - 1U);
+
+			rotary_counter_set(&rc, s);
+			store_word = 0;
+			stores = 0;
+			rotary_counter_step(&rc, events[e].event);
+			check(rotary_counter_value(&rc) == next, "wrong next count", bits, s, events[e].name);
+			if(events[e].delta == 0){
+				check(stores == 0, "LEDs written", bits, s, events[e].name);
+			}
+			else{
+				check(stores == 1 && store_port == GPIOA && store_word == expected_word(bits, next),
+				      "not one store of the next count's LEDs", bits, s, events[e].name);
+			}
+		}
+	}
+}
+
+int main(int argc, char *argv[]){
+	const gpio_pin_t *leds[ROTARY_COUNTER_MAX_BITS + 1];
+	rotary_counter_t rc;
+	int opt;
+
+	while((opt = getopt(argc, argv, "vh")) != -1){
+		switch(opt){
+			case 'v': verbose = 1; break;
+			default:
+				fprintf(stderr, "usage: %s [-v]\n", argv[0]);
+				return 2;
+		}
+	}
+
+	for(uint8_t bits = 1; bits <= ROTARY_COUNTER_MAX_BITS; bits++){
+		check_width(bits);
+	}
+
+	for(int i = 0; i < ROTARY_COUNTER_MAX_BITS; i++){
+		leds[i] = &leds_a[i];
+	}
+	leds[ROTARY_COUNTER_MAX_BITS] = &leds_a[0];
+	check(rotary_counter_init(&rc, leds, 0, 0) == -1, "0 bits accepted", 0, 0, "init");
+	check(rotary_counter_init(&rc, leds, ROTARY_COUNTER_MAX_BITS + 1, 0) == -1, "too many bits accepted",
+	      ROTARY_COUNTER_MAX_BITS + 1, 0, "init");
+	leds[1] = &led_b;
+	check(rotary_counter_init(&rc, leds, 2, 0) == -1, "LEDs on two ports accepted", 2, 0, "init");
+
+	printf("%d of %d checks passed\n", checks - failures, checks);
+	return failures != 0;
+}
@@ -0,0 +1,39 @@
+/***********************************************************
+Title: Host replacement of FreeRTOS.h.
+Description: The types and configuration of the FreeRTOS
+				subset sim_freertos.c implements: tasks run as
+				host threads of which only the one the
+				scheduler picked executes, with priorities,
+				a 1 ms tick of simulated time and queues.
+************************************************************/
+
+#ifndef __PSOC_SIM_FREERTOS_H
+#define __PSOC_SIM_FREERTOS_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "psoc_sim.h"
+
+typedef long BaseType_t;
+typedef unsigned long UBaseType_t;
+typedef uint32_t TickType_t;
+typedef uint16_t configSTACK_DEPTH_TYPE;
+
+#define configTICK_RATE_HZ          (1000U)
+#define configMAX_PRIORITIES        (7U)
+#define configMINIMAL_STACK_SIZE    (128U)
+
+#define portMAX_DELAY               ((TickType_t)0xFFFFFFFFUL)
+#define portTICK_PERIOD_MS          ((TickType_t)1000U / configTICK_RATE_HZ)
+#define pdMS_TO_TICKS(ms)           ((TickType_t)(((TickType_t)(ms) * (TickType_t)configTICK_RATE_HZ) / (TickType_t)1000U))
+
+#define pdFALSE                     ((BaseType_t)0)
+#define pdTRUE                      ((BaseType_t)1)
+#define pdFAIL                      (pdFALSE)
+#define pdPASS                      (pdTRUE)
+#define errQUEUE_EMPTY              ((BaseType_t)0)
+#define errQUEUE_FULL               ((BaseType_t)0)
+
+#define configASSERT(x) do{ if(!(x)) sim_assert_failed(__FILE__, __LINE__); }while(0)
+
+#endif /* __PSOC_SIM_FREERTOS_H */
@@ -0,0 +1,8 @@
+/***********************************************************
+Title: Case alias of DHT_Task.h.
+Description: The DHT-11 application includes its headers in
+				lower case ("dht_task.h"), which only resolves
+				on a case-insensitive file system.
+************************************************************/
+
+#include "DHT_Task.h"
@@ -0,0 +1,8 @@
+/***********************************************************
+Title: Case alias of Print_Task.h.
+Description: The DHT-11 application includes its headers in
+				lower case ("print_task.h"), which only
+				resolves on a case-insensitive file system.
+************************************************************/
+
+#include "Print_Task.h"
@@ -0,0 +1,88 @@
+/***********************************************************
+Title: Host replacement of the CAPSENSE middleware API.
+Description: The calls the CAPSENSE application makes, on a
+				model of its widgets (sim_capsense.c): the
+				buttons and the slider take the touches of
+				the trace, a scan takes SIM_CAPSENSE_SCAN_US of
+				simulated time and ends in the CSD interrupt,
+				whose handler calls the end-of-scan callback.
+				A slider keeps its last position after the
+				finger leaves it, with no touch reported.
+				There are no raw counts, baselines or tuning
+				parameters.
+************************************************************/
+
+#ifndef __PSOC_SIM_CY_CAPSENSE_H
+#define __PSOC_SIM_CY_CAPSENSE_H
+
+#include <stdint.h>
+#include "cy_pdl.h"
+
+#define CY_CAPSENSE_STATUS_SUCCESS         (0x00U)
+#define CY_CAPSENSE_STATUS_BAD_PARAM       (0x01U)
+#define CY_CAPSENSE_STATUS_HW_BUSY         (0x80U)
+#define CY_CAPSENSE_NOT_BUSY               (0x00U)
+#define CY_CAPSENSE_BUSY                   (0x80U)
+
+#define SIM_CAPSENSE_SCAN_US               (2000U)
+#define SIM_CAPSENSE_WIDGETS               (3U)
+
+typedef uint32_t cy_capsense_status_t;
+
+typedef enum {
+	CY_CAPSENSE_START_SAMPLE_E = 0x01U,
+	CY_CAPSENSE_END_OF_SCAN_E = 0x02U
+} cy_en_capsense_callback_event_t;
+
+typedef struct {
+	uint32_t widgetIndex;
+	uint32_t sensorIndex;
+} cy_stc_active_scan_sns_t;
+
+typedef void (*cy_capsense_callback_t)(cy_stc_active_scan_sns_t *ptrActiveScan);
+
+typedef struct {
+	uint16_t x;
+	uint16_t y;
+	uint16_t z;
+	uint16_t id;
+} cy_stc_capsense_position_t;
+
+typedef struct {
+	cy_stc_capsense_position_t *ptrPosition;
+	uint8_t numPosition;
+} cy_stc_capsense_touch_t;
+
+typedef struct {
+	uint32_t status;
+	uint32_t active[SIM_CAPSENSE_WIDGETS];
+	cy_stc_capsense_position_t position[SIM_CAPSENSE_WIDGETS];
+	cy_stc_capsense_touch_t touch[SIM_CAPSENSE_WIDGETS];
+	cy_capsense_callback_t end_of_scan;
+	cy_capsense_callback_t start_sample;
+	cy_stc_active_scan_sns_t active_scan;
+	uint8_t enabled;
+} cy_stc_capsense_context_t;
+
+// What the tuner reads over EZI2C: the widget states
+typedef struct {
+	uint32_t status;
+	uint32_t active[SIM_CAPSENSE_WIDGETS];
+	cy_stc_capsense_position_t position[SIM_CAPSENSE_WIDGETS];
+} cy_stc_capsense_tuner_t;
+
+cy_capsense_status_t Cy_CapSense_Init(cy_stc_capsense_context_t *context);
+cy_capsense_status_t Cy_CapSense_Enable(cy_stc_capsense_context_t *context);
+cy_capsense_status_t Cy_CapSense_RegisterCallback(cy_en_capsense_callback_event_t callbackType,
+                                                  cy_capsense_callback_t callbackFunction,
+                                                  cy_stc_capsense_context_t *context);
+cy_capsense_status_t Cy_CapSense_ScanAllWidgets(cy_stc_capsense_context_t *context);
+uint32_t Cy_CapSense_IsBusy(const cy_stc_capsense_context_t *context);
+cy_capsense_status_t Cy_CapSense_ProcessAllWidgets(cy_stc_capsense_context_t *context);
+uint32_t Cy_CapSense_IsSensorActive(uint32_t widgetId, uint32_t sensorId, const cy_stc_capsense_context_t *context);
+uint32_t Cy_CapSense_IsWidgetActive(uint32_t widgetId, const cy_stc_capsense_context_t *context);
+cy_stc_capsense_touch_t *Cy_CapSense_GetTouchInfo(uint32_t widgetId, const cy_stc_capsense_context_t *context);
+uint32_t Cy_CapSense_RunTuner(cy_stc_capsense_context_t *context);
+void Cy_CapSense_InterruptHandler(const CSD_Type *base, cy_stc_capsense_context_t *context);
+
+#endif /* __PSOC_SIM_CY_CAPSENSE_H */
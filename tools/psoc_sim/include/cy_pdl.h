@@ -0,0 +1,273 @@
+/***********************************************************
+Title: Host replacement of cy_pdl.h.
+Description: The part of the PSoC 6 peripheral driver
+				library, the device header and the CMSIS core
+				the applications use, built on the psoc_sim
+				models: interrupt masking, WFI and the NVIC go
+				to the simulated interrupt controller, the
+				SysLib delays advance the simulated time, the
+				SAR result registers are plain memory the ADC
+				model fills, and the DMAC and trigger
+				multiplexer functions drive the DMA model
+				(sim_adc.c). The application sees the CM4 of
+				a single-core build.
+************************************************************/
+
+#ifndef __PSOC_SIM_CY_PDL_H
+#define __PSOC_SIM_CY_PDL_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <string.h>
+#include "cy_result.h"
+#include "psoc_sim.h"
+
+#define CY_CPU_CORTEX_M0P                  (0)
+#define CY_CPU_CORTEX_M4                   (1)
+
+//-------------------------------------------------------------------------------------------
+// SysLib types and asserts
+//-------------------------------------------------------------------------------------------
+typedef uint8_t   uint8;
+typedef uint16_t  uint16;
+typedef uint32_t  uint32;
+typedef int8_t    int8;
+typedef int16_t   int16;
+typedef int32_t   int32;
+
+#define CY_RET_SUCCESS                     (0x00U)
+#define CYRET_SUCCESS                      (0x00U)
+#define CYRET_BAD_PARAM                    (0x01U)
+
+#define CY_ASSERT(x) do{ if(!(x)) sim_assert_failed(__FILE__, __LINE__); }while(0)
+#define CY_UNUSED_PARAMETER(x)             ((void)(x))
+
+//-------------------------------------------------------------------------------------------
+// Core: interrupt masking, barriers and the NVIC
+//-------------------------------------------------------------------------------------------
+typedef enum {
+	ioss_interrupts_gpio_0_IRQn = 0,
+	scb_5_interrupt_IRQn = 8,
+	tcpwm_0_interrupts_0_IRQn = 16,        // one per HAL timer or PWM, up to 8
+	pass_interrupt_sar_IRQn = 32,
+	cpuss_interrupts_dmac_0_IRQn = 40,
+	cpuss_interrupts_dmac_1_IRQn = 41,
+	cpuss_interrupts_dmac_2_IRQn = 42,
+	cpuss_interrupts_dmac_3_IRQn = 43,
+	csd_interrupt_IRQn = 48,
+	NvicMux3_IRQn = 56                     // CM0+ only, never raised
+} IRQn_Type;
+
+static inline void __enable_irq(void){ sim_irq_restore(0U); }
+static inline void __disable_irq(void){ (void)sim_irq_disable(); }
+static inline void __WFI(void){ sim_wfi(); }
+static inline void __WFE(void){ sim_wfi(); }
+static inline void __DMB(void){ __atomic_thread_fence(__ATOMIC_SEQ_CST); }
+static inline void __DSB(void){ __atomic_thread_fence(__ATOMIC_SEQ_CST); }
+static inline void __ISB(void){ __atomic_thread_fence(__ATOMIC_SEQ_CST); }
+static inline void __NOP(void){ }
+
+static inline void NVIC_EnableIRQ(IRQn_Type irq){ sim_irq_enable((int)irq, 1); }
+static inline void NVIC_DisableIRQ(IRQn_Type irq){ sim_irq_enable((int)irq, 0); }
+static inline void NVIC_SetPendingIRQ(IRQn_Type irq){ sim_irq_raise((int)irq); }
+static inline void NVIC_ClearPendingIRQ(IRQn_Type irq){ sim_irq_clear((int)irq); }
+
+static inline uint32_t Cy_SysLib_EnterCriticalSection(void){ return sim_irq_disable(); }
+static inline void Cy_SysLib_ExitCriticalSection(uint32_t savedIntrStatus){ sim_irq_restore(savedIntrStatus); }
+
+// Busy waits: the CPU is held for the time, interrupts still run
+static inline void Cy_SysLib_Delay(uint32_t milliseconds){
+	sim_advance_by((uint64_t)milliseconds * SIM_NS_PER_MS);
+}
+
+static inline void Cy_SysLib_DelayUs(uint16_t microseconds){
+	sim_advance_by((uint64_t)microseconds * SIM_NS_PER_US + sim_delay_us_overhead_ns);
+}
+
+//-------------------------------------------------------------------------------------------
+// SysInt
+//-------------------------------------------------------------------------------------------
+#define CY_SYSINT_INTRSRC_MUXIRQ_SHIFT     (16U)
+
+typedef void (*cy_israddress)(void);
+
+typedef struct {
+	IRQn_Type intrSrc;
+	uint32_t intrPriority;
+} cy_stc_sysint_t;
+
+typedef enum {
+	CY_SYSINT_SUCCESS = 0x00U,
+	CY_SYSINT_BAD_PARAM = 0x01U
+} cy_en_sysint_status_t;
+
+static inline cy_en_sysint_status_t Cy_SysInt_Init(const cy_stc_sysint_t *config, cy_israddress userIsr){
+	if(config == NULL || userIsr == NULL){
+		return CY_SYSINT_BAD_PARAM;
+	}
+	sim_irq_register((int)config->intrSrc, NULL, userIsr, config->intrPriority);
+	return CY_SYSINT_SUCCESS;
+}
+
+//-------------------------------------------------------------------------------------------
+// SAR: only the result registers, which the ADC model writes after every scan
+//-------------------------------------------------------------------------------------------
+#define CY_SAR_MAX_NUM_CHANNELS            (16U)
+
+typedef struct {
+	volatile uint32_t CHAN_RESULT[CY_SAR_MAX_NUM_CHANNELS];
+	volatile uint32_t CHAN_RESULT_UPDATED;
+} SAR_Type;
+
+extern SAR_Type sim_sar0;
+#define SAR0                               (&sim_sar0)
+
+//-------------------------------------------------------------------------------------------
+// DMAC
+//-------------------------------------------------------------------------------------------
+#define CY_DMAC_CH_NR                      (4U)
+#define CY_DMAC_LOOP_COUNT_MAX             (65536UL)
+
+#define CY_DMAC_INTR_COMPLETION            (0x01UL)
+#define CY_DMAC_INTR_SRC_BUS_ERROR         (0x02UL)
+#define CY_DMAC_INTR_DST_BUS_ERROR         (0x04UL)
+#define CY_DMAC_INTR_SRC_MISAL             (0x08UL)
+#define CY_DMAC_INTR_DST_MISAL             (0x10UL)
+#define CY_DMAC_INTR_CURR_PTR_NULL         (0x20UL)
+#define CY_DMAC_INTR_ACTIVE_CH_DISABLED    (0x40UL)
+#define CY_DMAC_INTR_DESCR_BUS_ERROR       (0x80UL)
+#define CY_DMAC_INTR_MASK                  (0xFFUL)
+
+typedef struct {
+	uint32_t CTL;
+} DMAC_Type;
+
+extern DMAC_Type sim_dmac0;
+#define DMAC                               (&sim_dmac0)
+
+typedef enum {
+	CY_DMAC_SUCCESS = 0x00UL,
+	CY_DMAC_BAD_PARAM = 0x01UL
+} cy_en_dmac_status_t;
+
+typedef enum { CY_DMAC_RETRIG_IM, CY_DMAC_RETRIG_4CYC, CY_DMAC_RETRIG_16CYC, CY_DMAC_WAIT_FOR_REACT } cy_en_dmac_retrigger_t;
+typedef enum { CY_DMAC_1ELEMENT, CY_DMAC_X_LOOP, CY_DMAC_DESCR, CY_DMAC_DESCR_CHAIN } cy_en_dmac_trigger_type_t;
+typedef enum { CY_DMAC_CHANNEL_ENABLED, CY_DMAC_CHANNEL_DISABLED } cy_en_dmac_channel_state_t;
+typedef enum { CY_DMAC_BYTE, CY_DMAC_HALFWORD, CY_DMAC_WORD } cy_en_dmac_data_size_t;
+typedef enum { CY_DMAC_TRANSFER_SIZE_DATA, CY_DMAC_TRANSFER_SIZE_WORD } cy_en_dmac_transfer_size_t;
+typedef enum {
+	CY_DMAC_SINGLE_TRANSFER, CY_DMAC_1D_TRANSFER, CY_DMAC_2D_TRANSFER,
+	CY_DMAC_MEMORY_COPY, CY_DMAC_SCATTER_TRANSFER
+} cy_en_dmac_descriptor_type_t;
+
+// Only the DMA model reads a descriptor, so it keeps the configuration as given
+typedef struct cy_stc_dmac_descriptor {
+	cy_en_dmac_trigger_type_t interruptType;
+	cy_en_dmac_channel_state_t channelState;
+	cy_en_dmac_trigger_type_t triggerInType;
+	cy_en_dmac_data_size_t dataSize;
+	cy_en_dmac_transfer_size_t srcTransferSize;
+	cy_en_dmac_transfer_size_t dstTransferSize;
+	cy_en_dmac_descriptor_type_t descriptorType;
+	const void *src;
+	void *dst;
+	int32_t srcXincrement, dstXincrement;
+	uint32_t xCount;
+	int32_t srcYincrement, dstYincrement;
+	uint32_t yCount;
+	struct cy_stc_dmac_descriptor *next;
+} cy_stc_dmac_descriptor_t;
+
+typedef struct {
+	cy_en_dmac_retrigger_t retrigger;
+	cy_en_dmac_trigger_type_t interruptType;
+	cy_en_dmac_trigger_type_t triggerOutType;
+	cy_en_dmac_channel_state_t channelState;
+	cy_en_dmac_trigger_type_t triggerInType;
+	bool dataPrefetch;
+	cy_en_dmac_data_size_t dataSize;
+	cy_en_dmac_transfer_size_t srcTransferSize;
+	cy_en_dmac_transfer_size_t dstTransferSize;
+	cy_en_dmac_descriptor_type_t descriptorType;
+	void *srcAddress;
+	void *dstAddress;
+	int32_t srcXincrement;
+	int32_t dstXincrement;
+	uint32_t xCount;
+	int32_t srcYincrement;
+	int32_t dstYincrement;
+	uint32_t yCount;
+	cy_stc_dmac_descriptor_t *nextDescriptor;
+} cy_stc_dmac_descriptor_config_t;
+
+typedef struct {
+	cy_stc_dmac_descriptor_t *descriptor;
+	uint32_t priority;
+	bool enable;
+	bool bufferable;
+} cy_stc_dmac_channel_config_t;
+
+cy_en_dmac_status_t Cy_DMAC_Descriptor_Init(cy_stc_dmac_descriptor_t *descriptor,
+                                            const cy_stc_dmac_descriptor_config_t *config);
+void Cy_DMAC_Descriptor_SetSrcAddress(cy_stc_dmac_descriptor_t *descriptor, const void *srcAddress);
+void Cy_DMAC_Descriptor_SetDstAddress(cy_stc_dmac_descriptor_t *descriptor, const void *dstAddress);
+void Cy_DMAC_Descriptor_SetNextDescriptor(cy_stc_dmac_descriptor_t *descriptor,
+                                          const cy_stc_dmac_descriptor_t *nextDescriptor);
+void Cy_DMAC_Descriptor_SetXloopDataCount(cy_stc_dmac_descriptor_t *descriptor, uint32_t xCount);
+void Cy_DMAC_Descriptor_SetYloopDataCount(cy_stc_dmac_descriptor_t *descriptor, uint32_t yCount);
+
+cy_en_dmac_status_t Cy_DMAC_Channel_Init(DMAC_Type *base, uint32_t channel,
+                                         const cy_stc_dmac_channel_config_t *config);
+void Cy_DMAC_Channel_DeInit(DMAC_Type *base, uint32_t channel);
+void Cy_DMAC_Channel_SetDescriptor(DMAC_Type *base, uint32_t channel,
+                                   const cy_stc_dmac_descriptor_t *descriptor);
+void Cy_DMAC_Channel_Enable(DMAC_Type *base, uint32_t channel);
+void Cy_DMAC_Channel_Disable(DMAC_Type *base, uint32_t channel);
+void Cy_DMAC_Channel_SetPriority(DMAC_Type *base, uint32_t channel, uint32_t priority);
+cy_stc_dmac_descriptor_t *Cy_DMAC_Channel_GetCurrentDescriptor(const DMAC_Type *base, uint32_t channel);
+uint32_t Cy_DMAC_Channel_GetInterruptStatus(const DMAC_Type *base, uint32_t channel);
+void Cy_DMAC_Channel_ClearInterrupt(DMAC_Type *base, uint32_t channel, uint32_t interrupt);
+void Cy_DMAC_Channel_SetInterrupt(DMAC_Type *base, uint32_t channel, uint32_t interrupt);
+uint32_t Cy_DMAC_Channel_GetInterruptMask(const DMAC_Type *base, uint32_t channel);
+void Cy_DMAC_Channel_SetInterruptMask(DMAC_Type *base, uint32_t channel, uint32_t interrupt);
+uint32_t Cy_DMAC_Channel_GetInterruptStatusMasked(const DMAC_Type *base, uint32_t channel);
+void Cy_DMAC_Enable(DMAC_Type *base);
+void Cy_DMAC_Disable(DMAC_Type *base);
+
+//-------------------------------------------------------------------------------------------
+// Trigger multiplexer: the SAR end-of-scan output and the DMAC channel inputs
+//-------------------------------------------------------------------------------------------
+#define TRIG_IN_MUX_10_PASS_TR_SAR_OUT     (0x40000A10UL)
+#define TRIG_OUT_MUX_10_MDMA_TR_IN0        (0x40100A00UL)
+#define TRIG_OUT_MUX_10_MDMA_TR_IN1        (0x40100A01UL)
+#define TRIG_OUT_MUX_10_MDMA_TR_IN2        (0x40100A02UL)
+#define TRIG_OUT_MUX_10_MDMA_TR_IN3        (0x40100A03UL)
+
+#define CY_TRIGGER_TWO_CYCLES              (2UL)
+
+typedef enum { TRIGGER_TYPE_LEVEL = 0U, TRIGGER_TYPE_EDGE = 1U } en_trig_type_t;
+
+typedef enum {
+	CY_TRIGMUX_SUCCESS = 0x00U,
+	CY_TRIGMUX_BAD_PARAM = 0x01U
+} cy_en_trigmux_status_t;
+
+cy_en_trigmux_status_t Cy_TrigMux_Connect(uint32_t inTrig, uint32_t outTrig, bool invert, en_trig_type_t trigType);
+cy_en_trigmux_status_t Cy_TrigMux_SwTrigger(uint32_t trigLine, uint32_t cycles);
+
+//-------------------------------------------------------------------------------------------
+// Blocks the applications only name
+//-------------------------------------------------------------------------------------------
+typedef struct {
+	uint32_t CONFIG;
+} CSD_Type;
+
+extern CSD_Type sim_csd0;
+#define CSD0                               (&sim_csd0)
+
+typedef struct {
+	uint32_t state;
+} cy_stc_scb_ezi2c_context_t;
+
+#endif /* __PSOC_SIM_CY_PDL_H */
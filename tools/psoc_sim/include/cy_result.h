@@ -0,0 +1,43 @@
+/***********************************************************
+Title: Host replacement of cy_result.h.
+Description: Result codes of the PDL and the HAL, laid out
+				as in the ModusToolbox core library: type,
+				module and code in one 32-bit value.
+************************************************************/
+
+#ifndef __PSOC_SIM_CY_RESULT_H
+#define __PSOC_SIM_CY_RESULT_H
+
+#include <stdint.h>
+
+typedef uint32_t cy_rslt_t;
+
+#define CY_RSLT_SUCCESS                     ((cy_rslt_t)0x00000000U)
+
+#define CY_RSLT_CODE_POSITION               (0U)
+#define CY_RSLT_CODE_WIDTH                  (16U)
+#define CY_RSLT_TYPE_POSITION               (16U)
+#define CY_RSLT_TYPE_WIDTH                  (2U)
+#define CY_RSLT_MODULE_POSITION             (18U)
+#define CY_RSLT_MODULE_WIDTH                (14U)
+
+#define CY_RSLT_TYPE_INFO                   (0U)
+#define CY_RSLT_TYPE_WARNING                (1U)
+#define CY_RSLT_TYPE_ERROR                  (2U)
+#define CY_RSLT_TYPE_FATAL                  (3U)
+
+#define CY_RSLT_MODULE_DRIVERS_PDL_BASE     (0x0000U)
+#define CY_RSLT_MODULE_ABSTRACTION_HAL_BASE (0x0100U)
+#define CY_RSLT_MODULE_BOARD_LIB_RETARGET_IO (0x01A1U)
+#define CY_RSLT_MODULE_MIDDLEWARE_BASE      (0x0200U)
+
+#define CY_RSLT_CREATE(type, module, code) \
+	((((module) & 0x3FFFU) << CY_RSLT_MODULE_POSITION) | \
+	 (((code) & 0xFFFFU) << CY_RSLT_CODE_POSITION) | \
+	 (((type) & 0x3U) << CY_RSLT_TYPE_POSITION))
+
+#define CY_RSLT_GET_TYPE(x)   (((x) >> CY_RSLT_TYPE_POSITION) & 0x3U)
+#define CY_RSLT_GET_MODULE(x) (((x) >> CY_RSLT_MODULE_POSITION) & 0x3FFFU)
+#define CY_RSLT_GET_CODE(x)   (((x) >> CY_RSLT_CODE_POSITION) & 0xFFFFU)
+
+#endif /* __PSOC_SIM_CY_RESULT_H */
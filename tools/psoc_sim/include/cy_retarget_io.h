@@ -0,0 +1,29 @@
+/***********************************************************
+Title: Host replacement of cy_retarget_io.h.
+Description: retarget-io sends the standard output of the
+				application over the debug UART; here printf
+				of every file that includes this header goes
+				to the simulated UART (sim_uart.c), blocking
+				while its FIFO is full like the device.
+************************************************************/
+
+#ifndef __PSOC_SIM_CY_RETARGET_IO_H
+#define __PSOC_SIM_CY_RETARGET_IO_H
+
+#include <stdio.h>
+#include "cy_result.h"
+#include "cyhal.h"
+
+#define CY_RETARGET_IO_BAUDRATE     (115200U)
+
+extern cyhal_uart_t cy_retarget_io_uart_obj;
+
+cy_rslt_t cy_retarget_io_init(cyhal_gpio_t tx, cyhal_gpio_t rx, uint32_t baudrate);
+cy_rslt_t cy_retarget_io_init_fc(cyhal_gpio_t tx, cyhal_gpio_t rx, cyhal_gpio_t cts, cyhal_gpio_t rts,
+                                 uint32_t baudrate);
+void cy_retarget_io_deinit(void);
+
+int sim_uart_printf(const char *format, ...) __attribute__((format(printf, 1, 2)));
+#define printf(...) sim_uart_printf(__VA_ARGS__)
+
+#endif /* __PSOC_SIM_CY_RETARGET_IO_H */
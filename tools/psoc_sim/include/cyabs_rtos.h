@@ -0,0 +1,16 @@
+/***********************************************************
+Title: Host replacement of cyabs_rtos.h.
+Description: The RTOS abstraction layer; the applications
+				include it but call FreeRTOS directly, so only
+				the FreeRTOS headers are pulled in.
+************************************************************/
+
+#ifndef __PSOC_SIM_CYABS_RTOS_H
+#define __PSOC_SIM_CYABS_RTOS_H
+
+#include "cy_result.h"
+#include "FreeRTOS.h"
+#include "task.h"
+#include "queue.h"
+
+#endif /* __PSOC_SIM_CYABS_RTOS_H */
@@ -0,0 +1,49 @@
+/***********************************************************
+Title: Host replacement of cybsp.h.
+Description: The board the applications are built for,
+				CY8CPROTO-062S2-43439 (TARGET in their
+				Makefiles), with the pins of its design.modus.
+				The user LED is active low.
+************************************************************/
+
+#ifndef __PSOC_SIM_CYBSP_H
+#define __PSOC_SIM_CYBSP_H
+
+#include "cy_result.h"
+#include "cy_pdl.h"
+#include "cyhal.h"
+
+#define CYBSP_LED_STATE_ON          (0U)
+#define CYBSP_LED_STATE_OFF         (1U)
+#define CYBSP_BTN_PRESSED           (0U)
+#define CYBSP_BTN_OFF               (1U)
+
+#define CYBSP_USER_LED              (P13_7)
+#define CYBSP_USER_LED1             (P13_7)
+#define CYBSP_LED4                  (P13_7)
+#define CYBSP_USER_BTN              (P0_4)
+
+#define CYBSP_DEBUG_UART_RX         (P5_0)
+#define CYBSP_DEBUG_UART_TX         (P5_1)
+// The debug UART of this board has no flow control lines
+#define CYBSP_DEBUG_UART_RTS        (NC)
+#define CYBSP_DEBUG_UART_CTS        (NC)
+
+#define CYBSP_I2C_SCL               (P6_0)
+#define CYBSP_I2C_SDA               (P6_1)
+
+#define CYBSP_CSD_TX                (P1_0)
+#define CYBSP_CSD_BTN0              (P8_1)
+#define CYBSP_CSD_BTN1              (P8_2)
+#define CYBSP_CSD_SLD0              (P8_3)
+#define CYBSP_CSD_SLD1              (P8_4)
+#define CYBSP_CSD_SLD2              (P8_5)
+#define CYBSP_CSD_SLD3              (P8_6)
+#define CYBSP_CSD_SLD4              (P8_7)
+#define CYBSP_CSD_HW                CSD0
+
+static inline cy_rslt_t cybsp_init(void){
+	return CY_RSLT_SUCCESS;
+}
+
+#endif /* __PSOC_SIM_CYBSP_H */
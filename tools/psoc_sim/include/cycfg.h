@@ -0,0 +1,14 @@
+/***********************************************************
+Title: Host replacement of the generated cycfg.h.
+Description: The Device Configurator output the CAPSENSE
+				application includes. The pins come from
+				cybsp.h; nothing else is configured.
+************************************************************/
+
+#ifndef __PSOC_SIM_CYCFG_H
+#define __PSOC_SIM_CYCFG_H
+
+#include "cy_pdl.h"
+#include "cybsp.h"
+
+#endif /* __PSOC_SIM_CYCFG_H */
@@ -0,0 +1,27 @@
+/***********************************************************
+Title: Host replacement of the generated cycfg_capsense.h.
+Description: The widgets of the board's design.cycapsense
+				(Button0, Button1, LinearSlider0) and the
+				middleware context and tuner objects.
+************************************************************/
+
+#ifndef __PSOC_SIM_CYCFG_CAPSENSE_H
+#define __PSOC_SIM_CYCFG_CAPSENSE_H
+
+#include "cy_capsense.h"
+
+#define CY_CAPSENSE_BUTTON0_WDGT_ID        (0U)
+#define CY_CAPSENSE_BUTTON1_WDGT_ID        (1U)
+#define CY_CAPSENSE_LINEARSLIDER0_WDGT_ID  (2U)
+
+#define CY_CAPSENSE_BUTTON0_SNS0_ID        (0U)
+#define CY_CAPSENSE_BUTTON1_SNS0_ID        (0U)
+#define CY_CAPSENSE_LINEARSLIDER0_SNS0_ID  (0U)
+
+// Positions of the slider run from 0 to this
+#define CY_CAPSENSE_LINEARSLIDER0_X_RESOLUTION (300U)
+
+extern cy_stc_capsense_context_t cy_capsense_context;
+extern cy_stc_capsense_tuner_t cy_capsense_tuner;
+
+#endif /* __PSOC_SIM_CYCFG_CAPSENSE_H */
@@ -0,0 +1,313 @@
+/***********************************************************
+Title: Host replacement of cyhal.h.
+Description: The subset of the PSoC 6 hardware abstraction
+				layer the applications use: GPIO, SAR ADC,
+				UART, timer, PWM, EZI2C and the system
+				functions. The objects keep what the models
+				need; the calls are implemented by the
+				psoc_sim models (sim_gpio.c, sim_adc.c,
+				sim_uart.c, sim_timer.c, sim_capsense.c).
+************************************************************/
+
+#ifndef __PSOC_SIM_CYHAL_H
+#define __PSOC_SIM_CYHAL_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "cy_result.h"
+#include "cy_pdl.h"
+
+#define CYHAL_RSLT_MODULE_SIM              (CY_RSLT_MODULE_ABSTRACTION_HAL_BASE + 0x80U)
+#define CYHAL_RSLT_ERR_BAD_ARGUMENT        CY_RSLT_CREATE(CY_RSLT_TYPE_ERROR, CYHAL_RSLT_MODULE_SIM, 1U)
+#define CYHAL_RSLT_ERR_RESOURCE_IN_USE     CY_RSLT_CREATE(CY_RSLT_TYPE_ERROR, CYHAL_RSLT_MODULE_SIM, 2U)
+#define CYHAL_RSLT_ERR_TIMEOUT             CY_RSLT_CREATE(CY_RSLT_TYPE_ERROR, CYHAL_RSLT_MODULE_SIM, 3U)
+#define CYHAL_RSLT_ERR_BUSY                CY_RSLT_CREATE(CY_RSLT_TYPE_ERROR, CYHAL_RSLT_MODULE_SIM, 4U)
+#define CYHAL_RSLT_ERR_BAD_CLOCK           CY_RSLT_CREATE(CY_RSLT_TYPE_ERROR, CYHAL_RSLT_MODULE_SIM, 5U)
+
+typedef struct {
+	uint32_t frequency_hz;
+} cyhal_clock_t;
+
+typedef uint32_t cyhal_source_t;
+
+//-------------------------------------------------------------------------------------------
+// GPIO: pin n of port p is (p << 3) + n, as in the HAL
+//-------------------------------------------------------------------------------------------
+#define SIM_PORT_PINS(p) \
+	P##p##_0 = ((p) << 3), P##p##_1, P##p##_2, P##p##_3, P##p##_4, P##p##_5, P##p##_6, P##p##_7
+
+typedef enum {
+	SIM_PORT_PINS(0), SIM_PORT_PINS(1), SIM_PORT_PINS(2), SIM_PORT_PINS(3), SIM_PORT_PINS(4),
+	SIM_PORT_PINS(5), SIM_PORT_PINS(6), SIM_PORT_PINS(7), SIM_PORT_PINS(8), SIM_PORT_PINS(9),
+	SIM_PORT_PINS(10), SIM_PORT_PINS(11), SIM_PORT_PINS(12), SIM_PORT_PINS(13), SIM_PORT_PINS(14),
+	NC = 0xFF
+} cyhal_gpio_t;
+
+#define SIM_NUM_PINS                       (15U * 8U)
+
+typedef enum {
+	CYHAL_GPIO_DIR_INPUT,
+	CYHAL_GPIO_DIR_OUTPUT,
+	CYHAL_GPIO_DIR_BIDIRECTIONAL
+} cyhal_gpio_direction_t;
+
+typedef enum {
+	CYHAL_GPIO_DRIVE_NONE,
+	CYHAL_GPIO_DRIVE_ANALOG,
+	CYHAL_GPIO_DRIVE_PULLUP,
+	CYHAL_GPIO_DRIVE_PULLDOWN,
+	CYHAL_GPIO_DRIVE_OPENDRAINDRIVESLOW,
+	CYHAL_GPIO_DRIVE_OPENDRAINDRIVESHIGH,
+	CYHAL_GPIO_DRIVE_STRONG,
+	CYHAL_GPIO_DRIVE_PULLUPDOWN,
+	CYHAL_GPIO_DRIVE_PULL_NONE
+} cyhal_gpio_drive_mode_t;
+
+cy_rslt_t cyhal_gpio_init(cyhal_gpio_t pin, cyhal_gpio_direction_t direction,
+                          cyhal_gpio_drive_mode_t drive_mode, bool init_val);
+void cyhal_gpio_free(cyhal_gpio_t pin);
+void cyhal_gpio_write(cyhal_gpio_t pin, bool value);
+bool cyhal_gpio_read(cyhal_gpio_t pin);
+void cyhal_gpio_toggle(cyhal_gpio_t pin);
+
+//-------------------------------------------------------------------------------------------
+// SAR ADC
+//-------------------------------------------------------------------------------------------
+// Negative input of a single-ended channel: the vneg of the ADC configuration
+#define CYHAL_ADC_VNEG                     ((cyhal_gpio_t)0xFE)
+
+#define CYHAL_ADC_AVG_MODE_AVERAGE         (1U)
+#define CYHAL_ADC_AVG_MODE_ACCUMULATE      (2U)
+#define CYHAL_ADC_AVG_MODE_INTERLEAVED     (4U)
+
+#define CYHAL_ADC_MAX_CHANNELS             (CY_SAR_MAX_NUM_CHANNELS)
+
+typedef enum {
+	CYHAL_ADC_REF_INTERNAL,
+	CYHAL_ADC_REF_EXTERNAL,
+	CYHAL_ADC_REF_VDDA,
+	CYHAL_ADC_REF_VDDA_DIV_2
+} cyhal_adc_vref_t;
+
+typedef enum {
+	CYHAL_ADC_VNEG_VSSA,
+	CYHAL_ADC_VNEG_VREF
+} cyhal_adc_vneg_t;
+
+typedef enum {
+	CYHAL_ADC_OUTPUT_SCAN_COMPLETE
+} cyhal_adc_output_t;
+
+typedef struct {
+	bool continuous_scanning;
+	uint8_t resolution;
+	uint16_t average_count;
+	uint32_t average_mode_flags;
+	uint32_t ext_vref_mv;
+	cyhal_adc_vneg_t vneg;
+	cyhal_adc_vref_t vref;
+	cyhal_gpio_t ext_vref;
+	bool is_bypassed;
+	cyhal_gpio_t bypass_pin;
+} cyhal_adc_config_t;
+
+typedef struct {
+	bool enabled;
+	bool enable_averaging;
+	uint32_t min_acquisition_ns;
+} cyhal_adc_channel_config_t;
+
+struct cyhal_adc_channel_s;
+
+typedef struct {
+	SAR_Type *base;
+	cyhal_adc_config_t config;
+	struct cyhal_adc_channel_s *channel_config[CYHAL_ADC_MAX_CHANNELS];
+	uint32_t sample_rate_hz;
+	bool eos_output;
+} cyhal_adc_t;
+
+typedef struct cyhal_adc_channel_s {
+	cyhal_adc_t *adc;
+	cyhal_gpio_t vplus;
+	cyhal_gpio_t vminus;
+	uint8_t channel_idx;
+	uint32_t minimum_acquisition_ns;
+	bool avg_enabled;
+	bool enabled;
+} cyhal_adc_channel_t;
+
+cy_rslt_t cyhal_adc_init(cyhal_adc_t *obj, cyhal_gpio_t pin, const cyhal_clock_t *clk);
+void cyhal_adc_free(cyhal_adc_t *obj);
+cy_rslt_t cyhal_adc_configure(cyhal_adc_t *obj, const cyhal_adc_config_t *config);
+cy_rslt_t cyhal_adc_set_sample_rate(cyhal_adc_t *obj, uint32_t desired_sample_rate_hz);
+cy_rslt_t cyhal_adc_channel_init_diff(cyhal_adc_channel_t *obj, cyhal_adc_t *adc, cyhal_gpio_t vplus,
+                                      cyhal_gpio_t vminus, const cyhal_adc_channel_config_t *cfg);
+cy_rslt_t cyhal_adc_channel_configure(cyhal_adc_channel_t *obj, const cyhal_adc_channel_config_t *config);
+void cyhal_adc_channel_free(cyhal_adc_channel_t *obj);
+int32_t cyhal_adc_read(const cyhal_adc_channel_t *obj);
+uint16_t cyhal_adc_read_u16(const cyhal_adc_channel_t *obj);
+int32_t cyhal_adc_read_uv(const cyhal_adc_channel_t *obj);
+cy_rslt_t cyhal_adc_enable_output(cyhal_adc_t *obj, cyhal_adc_output_t output, cyhal_source_t *source);
+cy_rslt_t cyhal_adc_disable_output(cyhal_adc_t *obj, cyhal_adc_output_t output);
+
+//-------------------------------------------------------------------------------------------
+// UART
+//-------------------------------------------------------------------------------------------
+#define CYHAL_DMA_PRIORITY_DEFAULT         (3U)
+
+typedef enum {
+	CYHAL_ASYNC_SW,
+	CYHAL_ASYNC_DMA
+} cyhal_async_mode_t;
+
+typedef struct {
+	cyhal_gpio_t tx, rx, cts, rts;
+	uint32_t baud;
+	cyhal_async_mode_t async_mode;
+	bool open;
+} cyhal_uart_t;
+
+// getc: timeout in ms, 0 waits for ever
+cy_rslt_t cyhal_uart_getc(cyhal_uart_t *obj, uint8_t *value, uint32_t timeout);
+cy_rslt_t cyhal_uart_putc(cyhal_uart_t *obj, uint32_t value);
+uint32_t cyhal_uart_readable(cyhal_uart_t *obj);
+uint32_t cyhal_uart_writable(cyhal_uart_t *obj);
+cy_rslt_t cyhal_uart_clear(cyhal_uart_t *obj);
+cy_rslt_t cyhal_uart_write(cyhal_uart_t *obj, void *tx, size_t *tx_length);
+cy_rslt_t cyhal_uart_read(cyhal_uart_t *obj, void *rx, size_t *rx_length);
+cy_rslt_t cyhal_uart_write_async(cyhal_uart_t *obj, void *tx, size_t length);
+bool cyhal_uart_is_tx_active(cyhal_uart_t *obj);
+cy_rslt_t cyhal_uart_set_baud(cyhal_uart_t *obj, uint32_t baudrate, uint32_t *actualbaud);
+cy_rslt_t cyhal_uart_set_async_mode(cyhal_uart_t *obj, cyhal_async_mode_t mode, uint8_t dma_priority);
+
+//-------------------------------------------------------------------------------------------
+// Timer
+//-------------------------------------------------------------------------------------------
+typedef enum {
+	CYHAL_TIMER_DIR_UP,
+	CYHAL_TIMER_DIR_DOWN,
+	CYHAL_TIMER_DIR_UP_DOWN
+} cyhal_timer_direction_t;
+
+typedef enum {
+	CYHAL_TIMER_IRQ_NONE = 0,
+	CYHAL_TIMER_IRQ_TERMINAL_COUNT = 1,
+	CYHAL_TIMER_IRQ_CAPTURE_COMPARE = 2,
+	CYHAL_TIMER_IRQ_ALL = 3
+} cyhal_timer_event_t;
+
+typedef void (*cyhal_timer_event_callback_t)(void *callback_arg, cyhal_timer_event_t event);
+
+typedef struct {
+	bool is_continuous;
+	cyhal_timer_direction_t direction;
+	bool is_compare;
+	uint32_t period;
+	uint32_t compare_value;
+	uint32_t value;
+} cyhal_timer_cfg_t;
+
+typedef struct {
+	int index;                          // slot in the timer model, -1 if free
+} cyhal_timer_t;
+
+cy_rslt_t cyhal_timer_init(cyhal_timer_t *obj, cyhal_gpio_t pin, const cyhal_clock_t *clk);
+void cyhal_timer_free(cyhal_timer_t *obj);
+cy_rslt_t cyhal_timer_configure(cyhal_timer_t *obj, const cyhal_timer_cfg_t *cfg);
+cy_rslt_t cyhal_timer_set_frequency(cyhal_timer_t *obj, uint32_t hz);
+cy_rslt_t cyhal_timer_start(cyhal_timer_t *obj);
+cy_rslt_t cyhal_timer_stop(cyhal_timer_t *obj);
+cy_rslt_t cyhal_timer_reset(cyhal_timer_t *obj);
+uint32_t cyhal_timer_read(const cyhal_timer_t *obj);
+void cyhal_timer_register_callback(cyhal_timer_t *obj, cyhal_timer_event_callback_t callback, void *callback_arg);
+void cyhal_timer_enable_event(cyhal_timer_t *obj, cyhal_timer_event_t event, uint8_t intr_priority, bool enable);
+
+//-------------------------------------------------------------------------------------------
+// PWM: an output pin with a duty cycle, no interrupts
+//-------------------------------------------------------------------------------------------
+typedef struct {
+	cyhal_gpio_t pin;
+	float duty_cycle;                   // percent of the period the pin is high
+	uint32_t frequency_hz;
+	bool running;
+} cyhal_pwm_t;
+
+cy_rslt_t cyhal_pwm_init(cyhal_pwm_t *obj, cyhal_gpio_t pin, const cyhal_clock_t *clk);
+void cyhal_pwm_free(cyhal_pwm_t *obj);
+cy_rslt_t cyhal_pwm_set_duty_cycle(cyhal_pwm_t *obj, float duty_cycle, uint32_t frequencyhal_hz);
+cy_rslt_t cyhal_pwm_start(cyhal_pwm_t *obj);
+cy_rslt_t cyhal_pwm_stop(cyhal_pwm_t *obj);
+
+//-------------------------------------------------------------------------------------------
+// EZI2C: the configuration is accepted, no I2C master is simulated
+//-------------------------------------------------------------------------------------------
+typedef enum {
+	CYHAL_EZI2C_DATA_RATE_100KHZ = 100000,
+	CYHAL_EZI2C_DATA_RATE_400KHZ = 400000,
+	CYHAL_EZI2C_DATA_RATE_1MHZ = 1000000
+} cyhal_ezi2c_data_rate_t;
+
+typedef enum {
+	CYHAL_EZI2C_SUB_ADDR8_BITS,
+	CYHAL_EZI2C_SUB_ADDR16_BITS
+} cyhal_ezi2c_sub_addr_size_t;
+
+typedef struct {
+	uint8_t slave_address;
+	uint8_t *buf;
+	uint32_t buf_size;
+	uint32_t buf_rw_boundary;
+} cyhal_ezi2c_slave_cfg_t;
+
+typedef struct {
+	bool two_addresses;
+	bool enable_wake_from_sleep;
+	cyhal_ezi2c_data_rate_t data_rate;
+	cyhal_ezi2c_slave_cfg_t slave1_cfg;
+	cyhal_ezi2c_slave_cfg_t slave2_cfg;
+	cyhal_ezi2c_sub_addr_size_t sub_address_size;
+} cyhal_ezi2c_cfg_t;
+
+typedef struct {
+	cyhal_ezi2c_cfg_t cfg;
+	cyhal_gpio_t sda, scl;
+} cyhal_ezi2c_t;
+
+cy_rslt_t cyhal_ezi2c_init(cyhal_ezi2c_t *obj, cyhal_gpio_t sda, cyhal_gpio_t scl, const cyhal_clock_t *clk,
+                           const cyhal_ezi2c_cfg_t *cfg);
+void cyhal_ezi2c_free(cyhal_ezi2c_t *obj);
+
+//-------------------------------------------------------------------------------------------
+// System
+//-------------------------------------------------------------------------------------------
+static inline cy_rslt_t cyhal_system_delay_ms(uint32_t milliseconds){
+	Cy_SysLib_Delay(milliseconds);
+	return CY_RSLT_SUCCESS;
+}
+
+static inline void cyhal_system_delay_us(uint16_t microseconds){
+	Cy_SysLib_DelayUs(microseconds);
+}
+
+static inline uint32_t cyhal_system_critical_section_enter(void){
+	return sim_irq_disable();
+}
+
+static inline void cyhal_system_critical_section_exit(uint32_t old_state){
+	sim_irq_restore(old_state);
+}
+
+static inline cy_rslt_t cyhal_system_set_isr(int32_t irq_num, int32_t irq_src, uint8_t priority,
+                                             cy_israddress handler){
+	(void)irq_src;
+	sim_irq_register((int)irq_num, NULL, handler, priority);
+	return CY_RSLT_SUCCESS;
+}
+
+static inline cy_rslt_t cyhal_hwmgr_init(void){
+	return CY_RSLT_SUCCESS;
+}
+
+#endif /* __PSOC_SIM_CYHAL_H */
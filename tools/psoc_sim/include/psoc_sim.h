@@ -0,0 +1,115 @@
+/***********************************************************
+Title: psoc_sim core.
+Description: The virtual clock, the interrupt controller
+				and the trace interface shared by the host
+				headers (cy_pdl.h, cyhal.h, ...) and the
+				peripheral models. Application code runs in
+				zero simulated time; time only advances in
+				the calls that wait or take time on the
+				device (delays, WFI, blocking UART transfers,
+				busy status polls), and every peripheral event
+				and interrupt falls at its exact simulated
+				time, so a run is repeatable.
+************************************************************/
+
+#ifndef __PSOC_SIM_H
+#define __PSOC_SIM_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#define SIM_NS_PER_MS       1000000ull
+#define SIM_NS_PER_US       1000ull
+#define SIM_NEVER           UINT64_MAX
+
+// What a busy status poll (cyhal_uart_is_tx_active(), Cy_CapSense_IsBusy())
+// costs, so a loop waiting on it lets the simulated time advance
+#define SIM_POLL_NS         1000ull
+
+// Interrupt vectors of the simulation; the numbers only identify them
+#define SIM_NUM_IRQS        64
+
+//-------------------------------------------------------------------------------------------
+// Clock and interrupts
+//-------------------------------------------------------------------------------------------
+uint64_t sim_now(void);
+
+// Run the peripherals up to 'time_ns', taking interrupts as they are raised
+void sim_advance_to(uint64_t time_ns);
+void sim_advance_by(uint64_t ns);
+
+// Run until an interrupt is raised (taken unless PRIMASK is set)
+void sim_wfi(void);
+
+// Run to the next event of any peripheral or of the trace, at most to 'limit';
+// ends the run if nothing can happen any more
+void sim_wait(uint64_t limit);
+
+uint32_t sim_irq_disable(void);        // returns the previous PRIMASK
+void sim_irq_restore(uint32_t primask);
+void sim_irq_register(int irq, const char *name, void (*handler)(void), uint32_t priority);
+void sim_irq_enable(int irq, int enable);
+void sim_irq_raise(int irq);
+void sim_irq_clear(int irq);
+
+void sim_assert_failed(const char *file, int line);
+
+//-------------------------------------------------------------------------------------------
+// Peripheral models: the core asks each for its next event and runs it
+//-------------------------------------------------------------------------------------------
+typedef struct {
+	const char *name;
+	uint64_t (*next_event)(void);          // SIM_NEVER if none
+	void (*run)(uint64_t now);             // handle the events due at 'now'
+	void (*report)(void);                  // statistics at the end, may be NULL
+} sim_model_t;
+
+extern const sim_model_t sim_adc_model;
+extern const sim_model_t sim_timer_model;
+extern const sim_model_t sim_uart_model;
+extern const sim_model_t sim_gpio_model;
+extern const sim_model_t sim_capsense_model;
+
+//-------------------------------------------------------------------------------------------
+// Trace commands. A handler checks its arguments when the trace is loaded
+// (apply = 0) and acts when the simulated time reaches the line (apply = 1).
+// It returns -1 on bad arguments, or when applied, on a failed check.
+//-------------------------------------------------------------------------------------------
+typedef int (*sim_command_fn)(int argc, char **argv, int apply);
+
+int sim_gpio_command_set(int argc, char **argv, int apply);
+int sim_gpio_command_expect(int argc, char **argv, int apply);
+int sim_gpio_command_dht(int argc, char **argv, int apply);
+int sim_adc_command_signal(int argc, char **argv, int apply);
+int sim_uart_command_send(int argc, char **argv, int apply);
+int sim_uart_command_sent(int argc, char **argv, int apply);
+int sim_capsense_command_touch(int argc, char **argv, int apply);
+int sim_capsense_command_slider(int argc, char **argv, int apply);
+
+//-------------------------------------------------------------------------------------------
+// Options and output shared by the models
+//-------------------------------------------------------------------------------------------
+extern int sim_verbose;
+extern uint64_t sim_delay_us_overhead_ns;
+
+// A timestamped line on stderr for -v
+void sim_log(const char *format, ...) __attribute__((format(printf, 1, 2)));
+
+// What a command handler found wrong, printed with the trace line
+void sim_check_failed(const char *format, ...) __attribute__((format(printf, 1, 2)));
+
+// Parse a pin name, "P6_3" or a board alias ("USER_LED"); -1 if unknown.
+// 'active_low' is set for the LEDs of the board.
+int sim_parse_pin(const char *name, int *active_low);
+
+// UART backend (sim_uart.c), opened by main() before the application starts:
+// a pseudo-terminal, the file 'output_path' or the standard output
+int sim_uart_open(const char *output_path, int use_pty);
+
+// The RTOS model (sim_freertos.c), linked only into the FreeRTOS applications:
+// the core offers it a task switch after every advance of the clock outside
+// the handlers and asks it for its statistics at the end
+void sim_rtos_preempt(void) __attribute__((weak));
+void sim_rtos_report(void) __attribute__((weak));
+
+#endif /* __PSOC_SIM_H */
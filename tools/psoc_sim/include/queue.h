@@ -0,0 +1,27 @@
+/***********************************************************
+Title: Host replacement of the FreeRTOS queue.h.
+Description: Queues of fixed-size items copied in and out.
+				A task blocks on a full or empty queue for up
+				to its timeout in ticks; the FromISR calls
+				never block.
+************************************************************/
+
+#ifndef __PSOC_SIM_QUEUE_H
+#define __PSOC_SIM_QUEUE_H
+
+#include "FreeRTOS.h"
+#include "task.h"
+
+typedef struct sim_queue *QueueHandle_t;
+
+QueueHandle_t xQueueCreate(UBaseType_t uxQueueLength, UBaseType_t uxItemSize);
+void vQueueDelete(QueueHandle_t xQueue);
+BaseType_t xQueueSendToBack(QueueHandle_t xQueue, const void *pvItemToQueue, TickType_t xTicksToWait);
+BaseType_t xQueueSendToFront(QueueHandle_t xQueue, const void *pvItemToQueue, TickType_t xTicksToWait);
+BaseType_t xQueueReceive(QueueHandle_t xQueue, void *pvBuffer, TickType_t xTicksToWait);
+BaseType_t xQueueSendFromISR(QueueHandle_t xQueue, const void *pvItemToQueue, BaseType_t *pxHigherPriorityTaskWoken);
+UBaseType_t uxQueueMessagesWaiting(QueueHandle_t xQueue);
+
+#define xQueueSend(queue, item, ticks)  xQueueSendToBack((queue), (item), (ticks))
+
+#endif /* __PSOC_SIM_QUEUE_H */
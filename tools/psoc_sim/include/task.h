@@ -0,0 +1,35 @@
+/***********************************************************
+Title: Host replacement of the FreeRTOS task.h.
+Description: Task creation, the scheduler, delays in ticks
+				of simulated time and critical sections.
+				A critical section masks the simulated
+				interrupts and holds off task switches; it
+				nests as on the CM4 port.
+************************************************************/
+
+#ifndef __PSOC_SIM_TASK_H
+#define __PSOC_SIM_TASK_H
+
+#include "FreeRTOS.h"
+
+typedef struct sim_task *TaskHandle_t;
+typedef void (*TaskFunction_t)(void *);
+
+BaseType_t xTaskCreate(TaskFunction_t pxTaskCode, const char *pcName, configSTACK_DEPTH_TYPE usStackDepth,
+                       void *pvParameters, UBaseType_t uxPriority, TaskHandle_t *pxCreatedTask);
+void vTaskDelete(TaskHandle_t xTaskToDelete);
+void vTaskStartScheduler(void);
+void vTaskDelay(TickType_t xTicksToDelay);
+void vTaskDelayUntil(TickType_t *pxPreviousWakeTime, TickType_t xTimeIncrement);
+TickType_t xTaskGetTickCount(void);
+void vTaskYield(void);
+void vTaskEnterCritical(void);
+void vTaskExitCritical(void);
+
+#define taskYIELD()                 vTaskYield()
+#define taskENTER_CRITICAL()        vTaskEnterCritical()
+#define taskEXIT_CRITICAL()         vTaskExitCritical()
+#define taskDISABLE_INTERRUPTS()    ((void)sim_irq_disable())
+#define taskENABLE_INTERRUPTS()     sim_irq_restore(0U)
+
+#endif /* __PSOC_SIM_TASK_H */
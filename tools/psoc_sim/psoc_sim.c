@@ -0,0 +1,744 @@
+/***********************************************************
+Title: Host simulation of the PSoC 6 HAL for the PSoC6
+				applications.
+Description: Runs an application's unchanged sources on the
+				PC against host replacements of cy_pdl.h,
+				cyhal.h, cybsp.h, retarget-io, FreeRTOS and
+				the CAPSENSE middleware, and models of the
+				peripherals behind them:
+				- A virtual clock in nanoseconds. Application
+				  code takes no simulated time; delays, WFI,
+				  blocking UART output and busy status polls
+				  advance it, and every peripheral event falls
+				  at its exact time, so a run is repeatable.
+				  A loop that calls nothing waits for the next
+				  interrupt, see __sanitizer_cov_trace_pc().
+				- An interrupt controller: handlers run when
+				  their interrupt is raised, in priority
+				  order, unless PRIMASK is set; WFI runs the
+				  peripherals up to the next interrupt.
+				- The SAR ADC scanning synthetic waveforms,
+				  the DMAC executing the descriptors and the
+				  trigger routing (sim_adc.c), the UART on a
+				  pseudo-terminal or a file (sim_uart.c), the
+				  TCPWM timers (sim_timer.c), GPIO, PWM and a
+				  DHT-11 sensor (sim_gpio.c), the CAPSENSE
+				  widgets (sim_capsense.c), FreeRTOS tasks and
+				  queues (sim_freertos.c).
+				A trace drives the inputs and checks outputs
+				at simulated times. At the end the host cost
+				of every interrupt handler and of the code
+				outside them is reported, with the statistics
+				of every peripheral.
+Usage:
+				<app>_sim [options] [trace]
+				-p          connect the UART to a pseudo-terminal
+				            (its name is printed) and run in real
+				            time unless -s says otherwise
+				-o <file>   write what the UART sends to <file>
+				            (default: standard output, unless -p)
+				-s <factor> simulated time runs <factor> times as fast
+				            as real time, 0 = as fast as possible
+				            (default 0, 1 with -p)
+				-t <ms>     stop after <ms> of simulated time
+				            (default: at the last line of the trace)
+				-d <ns>     simulated time a cyhal_system_delay_us()
+				            call takes besides its delay (default 1000)
+				-w <s>      give up when the simulated time has not
+				            advanced for <s> real seconds (default 10,
+				            0 = never)
+				-v          log inputs, outputs and checks on stderr
+************************************************************/
+
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <string.h>
+#include <errno.h>
+#include <signal.h>
+#include <pthread.h>
+#include <time.h>
+#include <unistd.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define COST_UNIT "host cycles"
+#else
+#define COST_UNIT "host ns"
+#endif
+
+#include "psoc_sim.h"
+
+#define MAX_WORDS           64
+#define TRACE_LINE_MAX      512
+#define PACE_SLACK_NS       1000000ull     // sleep only when this far ahead of real time
+#define PACE_SLEEP_MAX_NS   100000000ull   // longest sleep, so the watch sees progress
+#define STALL_CHECK_NS      100000000ull   // how often the watch looks at the clock
+#define SPIN_BLOCKS         100000u        // application blocks without a call: the CPU spins
+
+int app_main(void);
+
+int sim_verbose;
+uint64_t sim_delay_us_overhead_ns = 1000;
+
+//-------------------------------------------------------------------------------------------
+// Interrupt controller
+//-------------------------------------------------------------------------------------------
+typedef struct {
+	const char *name;
+	void (*handler)(void);
+	uint32_t priority;
+	uint8_t enabled;
+	uint8_t pending;
+	uint32_t calls;
+	uint64_t cost_total;
+	uint64_t cost_min;
+	uint64_t cost_max;
+} sim_vector_t;
+
+static sim_vector_t vectors[SIM_NUM_IRQS];
+static volatile uint32_t primask;
+static int in_handler;
+static uint32_t irqs_raised;          // interrupts that became pending while enabled
+static uint32_t spins;                // waits in loops, see __sanitizer_cov_trace_pc()
+
+// Depth of simulator calls on this thread; the library is built with
+// -finstrument-functions, the application is not
+static __thread uint32_t sim_depth;
+// Basic blocks of application code since this thread last called the simulator
+static __thread uint32_t app_blocks;
+
+__attribute__((no_instrument_function)) void __cyg_profile_func_enter(void *fn, void *site){
+	(void)fn;
+	(void)site;
+	if(sim_depth++ == 0){
+		app_blocks = 0;
+	}
+}
+
+__attribute__((no_instrument_function)) void __cyg_profile_func_exit(void *fn, void *site){
+	(void)fn;
+	(void)site;
+	sim_depth--;
+}
+
+static char irq_names[SIM_NUM_IRQS][16];
+
+static const struct {
+	int irq;
+	const char *name;
+} known_irqs[] = {
+	{ 8,  "scb_5_interrupt" },
+	{ 32, "pass_interrupt_sar" },
+	{ 40, "cpuss_interrupts_dmac_0" },
+	{ 41, "cpuss_interrupts_dmac_1" },
+	{ 42, "cpuss_interrupts_dmac_2" },
+	{ 43, "cpuss_interrupts_dmac_3" },
+	{ 48, "csd_interrupt" },
+};
+
+//-------------------------------------------------------------------------------------------
+// Clock, models and trace
+//-------------------------------------------------------------------------------------------
+static const sim_model_t *const models[] = {
+	&sim_gpio_model, &sim_adc_model, &sim_timer_model, &sim_uart_model, &sim_capsense_model
+};
+#define NUM_MODELS (sizeof(models) / sizeof(models[0]))
+
+static uint64_t now_ns;
+static uint64_t end_ns = SIM_NEVER;
+static double pace_factor = -1.0;     // < 0: not given
+static uint32_t stall_s = 10;
+static volatile sig_atomic_t stop_requested;
+static volatile uint64_t progress;    // advances of the clock, for the stall check
+
+typedef struct {
+	const char *name;
+	sim_command_fn fn;
+	int is_check;
+} sim_command_t;
+
+static int command_run(int argc, char **argv, int apply){
+	(void)argv;
+	(void)apply;
+	return argc == 1 ? 0 : -1;
+}
+
+static const sim_command_t commands[] = {
+	{ "run",    command_run,                 0 },
+	{ "set",    sim_gpio_command_set,        0 },
+	{ "dht",    sim_gpio_command_dht,        0 },
+	{ "signal", sim_adc_command_signal,      0 },
+	{ "send",   sim_uart_command_send,       0 },
+	{ "touch",  sim_capsense_command_touch,  0 },
+	{ "slider", sim_capsense_command_slider, 0 },
+	{ "expect", sim_gpio_command_expect,     1 },
+	{ "sent",   sim_uart_command_sent,       1 },
+};
+#define NUM_COMMANDS (sizeof(commands) / sizeof(commands[0]))
+
+typedef struct {
+	uint64_t time_ns;
+	uint32_t order;          // position in the trace, keeps equal times in order
+	int line;
+	const sim_command_t *command;
+	int argc;
+	char **argv;
+} sim_event_t;
+
+static sim_event_t *events;
+static size_t num_events;
+static size_t next_trace_event;
+static int checks, failures;
+static char check_message[256];
+
+//-------------------------------------------------------------------------------------------
+// Host cost
+//-------------------------------------------------------------------------------------------
+static uint64_t run_cost_start;
+static uint64_t sim_cost;             // inside the simulator, handlers excluded
+static uint64_t real_start_ns;
+
+static uint64_t cost_now(void){
+#if defined(__x86_64__) || defined(__i386__)
+	return __rdtsc();
+#else
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+#endif
+}
+
+static uint64_t real_time_ns(void){
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+static void sleep_ns(uint64_t ns){
+	struct timespec ts;
+	ts.tv_sec = (time_t)(ns / 1000000000ull);
+	ts.tv_nsec = (long)(ns % 1000000000ull);
+	while(nanosleep(&ts, &ts) != 0 && errno == EINTR && !stop_requested){
+	}
+}
+
+void sim_log(const char *format, ...){
+	va_list args;
+
+	fprintf(stderr, "%12.3f ms  ", (double)now_ns / 1e6);
+	va_start(args, format);
+	vfprintf(stderr, format, args);
+	va_end(args);
+	fputc('\n', stderr);
+}
+
+void sim_check_failed(const char *format, ...){
+	va_list args;
+
+	va_start(args, format);
+	vsnprintf(check_message, sizeof(check_message), format, args);
+	va_end(args);
+}
+
+uint64_t sim_now(void){
+	return now_ns;
+}
+
+//-------------------------------------------------------------------------------------------
+// Report
+//-------------------------------------------------------------------------------------------
+static void print_report(const char *reason){
+	uint64_t total = cost_now() - run_cost_start;
+	uint64_t handlers = 0;
+	uint64_t real = real_time_ns() - real_start_ns;
+	size_t i;
+
+	fprintf(stderr, "\n%s at %.3f ms simulated, %.3f s real", reason, (double)now_ns / 1e6, (double)real / 1e9);
+	if(real != 0){
+		fprintf(stderr, " (%.1fx real time)", (double)now_ns / (double)real);
+	}
+	fprintf(stderr, "\n\n%-28s %9s %12s %12s %12s   (%s)\n", "handler", "calls", "min", "avg", "max", COST_UNIT);
+	for(i = 0; i < SIM_NUM_IRQS; i++){
+		const sim_vector_t *v = &vectors[i];
+
+		if(v->calls == 0){
+			continue;
+		}
+		handlers += v->cost_total;
+		fprintf(stderr, "%-28s %9u %12llu %12llu %12llu\n", v->name, v->calls,
+		        (unsigned long long)v->cost_min, (unsigned long long)(v->cost_total / v->calls),
+		        (unsigned long long)v->cost_max);
+	}
+	if(total > sim_cost + handlers && now_ns != 0){
+		uint64_t app = total - sim_cost - handlers;
+
+		fprintf(stderr, "%-28s %9s %12s %12.0f %12s   (per simulated ms)\n", "outside the handlers", "", "",
+		        (double)app * 1e6 / (double)now_ns, "");
+	}
+	if(spins != 0){
+		fprintf(stderr, "%u waits in loops that call nothing, their real time counted outside the handlers\n", spins);
+	}
+	fprintf(stderr, "\n");
+	if(sim_rtos_report != NULL){
+		sim_rtos_report();
+	}
+	for(i = 0; i < NUM_MODELS; i++){
+		if(models[i]->report != NULL){
+			models[i]->report();
+		}
+	}
+	if(num_events != 0){
+		fprintf(stderr, "%d of %d checks passed\n", checks - failures, checks);
+	}
+}
+
+static void finish(const char *reason, int status){
+	static int finished;
+
+	if(__atomic_exchange_n(&finished, 1, __ATOMIC_SEQ_CST)){
+		return;
+	}
+	print_report(reason);
+	fflush(NULL);
+	exit(status != 0 || failures != 0 ? 1 : 0);
+}
+
+void sim_assert_failed(const char *file, int line){
+	fprintf(stderr, "\nCY_ASSERT failed at %s:%d\n", file, line);
+	finish("Stopped by CY_ASSERT", 1);
+}
+
+//-------------------------------------------------------------------------------------------
+// Interrupts
+//-------------------------------------------------------------------------------------------
+static void take_interrupts(void){
+	while(!primask && !in_handler){
+		sim_vector_t *best = NULL;
+		uint64_t start, cost;
+		int irq;
+
+		for(irq = 0; irq < SIM_NUM_IRQS; irq++){
+			sim_vector_t *v = &vectors[irq];
+
+			if(v->pending && v->enabled && v->handler != NULL &&
+			   (best == NULL || v->priority < best->priority)){
+				best = v;
+			}
+		}
+		if(best == NULL){
+			return;
+		}
+		best->pending = 0;
+		in_handler = 1;
+		start = cost_now();
+		best->handler();
+		cost = cost_now() - start;
+		in_handler = 0;
+
+		if(best->calls == 0 || cost < best->cost_min){
+			best->cost_min = cost;
+		}
+		if(cost > best->cost_max){
+			best->cost_max = cost;
+		}
+		best->cost_total += cost;
+		best->calls++;
+	}
+}
+
+void sim_irq_register(int irq, const char *name, void (*handler)(void), uint32_t priority){
+	size_t i;
+
+	if(irq < 0 || irq >= SIM_NUM_IRQS){
+		return;
+	}
+	if(name == NULL){
+		name = irq_names[irq];
+		snprintf(irq_names[irq], sizeof(irq_names[irq]), "irq %d", irq);
+		for(i = 0; i < sizeof(known_irqs) / sizeof(known_irqs[0]); i++){
+			if(known_irqs[i].irq == irq){
+				name = known_irqs[i].name;
+			}
+		}
+	}
+	vectors[irq].name = name;
+	vectors[irq].handler = handler;
+	vectors[irq].priority = priority;
+}
+
+void sim_irq_enable(int irq, int enable){
+	if(irq < 0 || irq >= SIM_NUM_IRQS){
+		return;
+	}
+	vectors[irq].enabled = (uint8_t)(enable != 0);
+	if(enable && vectors[irq].pending){
+		irqs_raised++;
+		take_interrupts();
+	}
+}
+
+// Pending stays set while the interrupt is disabled in the NVIC, as on the device
+void sim_irq_raise(int irq){
+	if(irq < 0 || irq >= SIM_NUM_IRQS){
+		return;
+	}
+	vectors[irq].pending = 1;
+	if(vectors[irq].enabled){
+		irqs_raised++;
+	}
+}
+
+void sim_irq_clear(int irq){
+	if(irq >= 0 && irq < SIM_NUM_IRQS){
+		vectors[irq].pending = 0;
+	}
+}
+
+uint32_t sim_irq_disable(void){
+	uint32_t old = primask;
+
+	primask = 1;
+	return old;
+}
+
+void sim_irq_restore(uint32_t value){
+	primask = value;
+	if(!value){
+		take_interrupts();
+	}
+}
+
+//-------------------------------------------------------------------------------------------
+// Virtual clock
+//-------------------------------------------------------------------------------------------
+static uint64_t next_event(void){
+	uint64_t next = end_ns;
+	size_t i;
+
+	if(next_trace_event < num_events && events[next_trace_event].time_ns < next){
+		next = events[next_trace_event].time_ns;
+	}
+	for(i = 0; i < NUM_MODELS; i++){
+		uint64_t t = models[i]->next_event();
+
+		if(t < next){
+			next = t;
+		}
+	}
+	return next < now_ns ? now_ns : next;
+}
+
+static void run_trace(void){
+	while(next_trace_event < num_events && events[next_trace_event].time_ns <= now_ns){
+		const sim_event_t *e = &events[next_trace_event++];
+
+		check_message[0] = '\0';
+		if(e->command->is_check){
+			checks++;
+		}
+		if(e->command->fn(e->argc, e->argv, 1) != 0){
+			failures++;
+			fprintf(stderr, "FAIL line %d at %.3f ms: %s\n", e->line, (double)now_ns / 1e6,
+			        check_message[0] ? check_message : e->argv[0]);
+		}
+		else if(sim_verbose && e->command->is_check){
+			sim_log("line %d: %s ok", e->line, e->argv[0]);
+		}
+	}
+}
+
+// Keep the simulated time from running ahead of real time by more than the slack
+static void pace(uint64_t time_ns){
+	uint64_t due, real;
+
+	if(pace_factor <= 0.0){
+		return;
+	}
+	due = real_start_ns + (uint64_t)((double)time_ns / pace_factor);
+	real = real_time_ns();
+	if(due <= real + PACE_SLACK_NS){
+		return;
+	}
+	while(due > real && !stop_requested){
+		sleep_ns(due - real < PACE_SLEEP_MAX_NS ? due - real : PACE_SLEEP_MAX_NS);
+		progress++;
+		real = real_time_ns();
+	}
+}
+
+void sim_advance_to(uint64_t time_ns){
+	uint64_t start = cost_now();
+	uint64_t handlers = 0;
+
+	while(now_ns < time_ns){
+		uint64_t next = next_event();
+		size_t i;
+
+		if(stop_requested){
+			finish("Interrupted", 0);
+		}
+		if(next > time_ns){
+			next = time_ns;
+		}
+		pace(next);
+		now_ns = next;
+		progress++;
+
+		run_trace();
+		for(i = 0; i < NUM_MODELS; i++){
+			models[i]->run(now_ns);
+		}
+		if(now_ns >= end_ns){
+			sim_cost += cost_now() - start - handlers;
+			finish("Finished", 0);
+		}
+		if(!primask && !in_handler){
+			uint64_t before = cost_now();
+
+			take_interrupts();
+			handlers += cost_now() - before;
+		}
+	}
+	sim_cost += cost_now() - start - handlers;
+	if(sim_rtos_preempt != NULL && !in_handler){
+		sim_rtos_preempt();
+	}
+}
+
+void sim_advance_by(uint64_t ns){
+	sim_advance_to(now_ns + ns);
+}
+
+void sim_wfi(void){
+	uint32_t raised = irqs_raised;
+
+	while(irqs_raised == raised){
+		uint64_t next = next_event();
+
+		if(next == SIM_NEVER){
+			finish("Nothing left to wait for", 0);
+		}
+		sim_advance_to(next > now_ns ? next : now_ns + 1);
+	}
+}
+
+void sim_wait(uint64_t limit){
+	uint64_t next = next_event();
+
+	if(next == SIM_NEVER && limit == SIM_NEVER){
+		finish("Nothing left to wait for", 0);
+	}
+	if(next > limit){
+		next = limit;
+	}
+	sim_advance_to(next > now_ns ? next : now_ns + 1);
+}
+
+//-------------------------------------------------------------------------------------------
+// Trace parsing
+//-------------------------------------------------------------------------------------------
+static int compare_events(const void *a, const void *b){
+	const sim_event_t *x = a, *y = b;
+
+	if(x->time_ns != y->time_ns){
+		return x->time_ns < y->time_ns ? -1 : 1;
+	}
+	return x->order < y->order ? -1 : (x->order > y->order);
+}
+
+// One trace line: <time_ms> <command> <args...>
+static int parse_line(char *text, int line, size_t *capacity){
+	char *words[MAX_WORDS];
+	int count = 0;
+	char *word, *end;
+	double time_ms;
+	size_t i;
+	sim_event_t *e;
+
+	for(word = strtok(text, " \t\r\n"); word != NULL && count < MAX_WORDS; word = strtok(NULL, " \t\r\n")){
+		if(word[0] == '#'){
+			break;
+		}
+		words[count++] = word;
+	}
+	if(count == 0){
+		return 0;
+	}
+	time_ms = strtod(words[0], &end);
+	if(count < 2 || *end != '\0' || time_ms < 0){
+		fprintf(stderr, "line %d: expected '<time_ms> <command> ...'\n", line);
+		return -1;
+	}
+	for(i = 0; i < NUM_COMMANDS; i++){
+		if(strcmp(words[1], commands[i].name) == 0){
+			break;
+		}
+	}
+	if(i == NUM_COMMANDS){
+		fprintf(stderr, "line %d: unknown command '%s'\n", line, words[1]);
+		return -1;
+	}
+	check_message[0] = '\0';
+	if(commands[i].fn(count - 1, &words[1], 0) != 0){
+		fprintf(stderr, "line %d: bad arguments to '%s'%s%s\n", line, words[1],
+		        check_message[0] ? ": " : "", check_message);
+		return -1;
+	}
+
+	if(num_events == *capacity){
+		*capacity = *capacity ? *capacity * 2 : 64;
+		events = realloc(events, *capacity * sizeof(sim_event_t));
+		if(events == NULL){
+			fprintf(stderr, "out of memory\n");
+			exit(2);
+		}
+	}
+	e = &events[num_events];
+	e->time_ns = (uint64_t)(time_ms * 1e6 + 0.5);
+	e->order = (uint32_t)num_events;
+	e->line = line;
+	e->command = &commands[i];
+	e->argc = count - 1;
+	e->argv = malloc((size_t)count * sizeof(char *));
+	if(e->argv == NULL){
+		fprintf(stderr, "out of memory\n");
+		exit(2);
+	}
+	for(int w = 1; w < count; w++){
+		e->argv[w - 1] = strdup(words[w]);
+	}
+	e->argv[count - 1] = NULL;
+	num_events++;
+	return 0;
+}
+
+static int load_trace(const char *path){
+	FILE *f = fopen(path, "r");
+	char text[TRACE_LINE_MAX];
+	size_t capacity = 0;
+	int line = 0;
+	int status = 0;
+
+	if(f == NULL){
+		perror(path);
+		return -1;
+	}
+	while(status == 0 && fgets(text, sizeof(text), f) != NULL){
+		status = parse_line(text, ++line, &capacity);
+	}
+	fclose(f);
+	qsort(events, num_events, sizeof(sim_event_t), compare_events);
+	return status;
+}
+
+//-------------------------------------------------------------------------------------------
+// Main
+//-------------------------------------------------------------------------------------------
+static void on_interrupt(int sig){
+	(void)sig;
+	stop_requested = 1;
+}
+
+// Application code takes no simulated time, so a loop that waits for an
+// interrupt without calling anything (the CAPSENSE main loop spins on a flag)
+// would hold the clock. The application is built with
+// -fsanitize-coverage=trace-pc, which calls this at every basic block. After
+// SPIN_BLOCKS blocks outside the simulator and the handlers the loop counts as
+// waiting, and the peripherals run up to the next interrupt, which then
+// preempts the loop as on the device. This runs on the application's thread
+// at a point its own code chose, not in a signal handler, and the count does
+// not depend on the host's speed or load, so every run is the same.
+__attribute__((no_instrument_function)) void __sanitizer_cov_trace_pc(void){
+	if(sim_depth != 0 || in_handler || ++app_blocks < SPIN_BLOCKS){
+		return;
+	}
+	spins++;
+	sim_wfi();                      // a simulator call, which restarts the count
+}
+
+// Gives up when the clock stands still for stall_s of real time: the
+// application or the simulator is stuck
+static void *watch(void *arg){
+	uint64_t seen = progress;
+	uint64_t still_ns = 0;
+
+	(void)arg;
+	for(;;){
+		sleep_ns(STALL_CHECK_NS);
+		if(progress != seen){
+			seen = progress;
+			still_ns = 0;
+			continue;
+		}
+		still_ns += STALL_CHECK_NS;
+		if(still_ns >= (uint64_t)stall_s * 1000000000ull){
+			fprintf(stderr, "\nno progress at %.3f ms simulated for %u s\n", (double)now_ns / 1e6, stall_s);
+			finish("Stalled", 1);
+		}
+	}
+	return NULL;
+}
+
+static void usage(const char *name){
+	fprintf(stderr, "usage: %s [-v] [-p] [-o uart_output] [-s factor] [-t ms] [-d ns] [-w s] [trace]\n", name);
+}
+
+// Not instrumented: the application it calls must run at depth 0
+__attribute__((no_instrument_function)) int main(int argc, char **argv){
+	const char *output = NULL;
+	int use_pty = 0;
+	double stop_ms = -1.0;
+	struct sigaction action;
+	pthread_t watcher;
+	int opt;
+
+	while((opt = getopt(argc, argv, "vpo:s:t:d:w:h")) != -1){
+		switch(opt){
+			case 'v': sim_verbose = 1; break;
+			case 'p': use_pty = 1; break;
+			case 'o': output = optarg; break;
+			case 's': pace_factor = strtod(optarg, NULL); break;
+			case 't': stop_ms = strtod(optarg, NULL); break;
+			case 'd': sim_delay_us_overhead_ns = strtoull(optarg, NULL, 10); break;
+			case 'w': stall_s = (uint32_t)strtoul(optarg, NULL, 10); break;
+			default: usage(argv[0]); return 2;
+		}
+	}
+	if(optind < argc - 1 || (stop_ms < 0.0 && stop_ms != -1.0)){
+		usage(argv[0]);
+		return 2;
+	}
+	if(optind == argc - 1 && load_trace(argv[optind]) != 0){
+		return 2;
+	}
+	if(stop_ms >= 0.0){
+		end_ns = (uint64_t)(stop_ms * 1e6 + 0.5);
+	}
+	else if(num_events != 0){
+		end_ns = events[num_events - 1].time_ns;
+	}
+	if(pace_factor < 0.0){
+		pace_factor = use_pty ? 1.0 : 0.0;
+	}
+	if(sim_uart_open(output, use_pty) != 0){
+		return 2;
+	}
+
+	memset(&action, 0, sizeof(action));
+	action.sa_handler = on_interrupt;
+	sigemptyset(&action.sa_mask);
+	sigaction(SIGINT, &action, NULL);
+	sigaction(SIGTERM, &action, NULL);
+	if(stall_s != 0 && pthread_create(&watcher, NULL, watch, NULL) != 0){
+		fprintf(stderr, "cannot start the watch thread\n");
+		return 2;
+	}
+
+	real_start_ns = real_time_ns();
+	run_cost_start = cost_now();
+	app_main();
+	finish("The application returned", 0);
+	return 0;
+}
@@ -0,0 +1,870 @@
+/***********************************************************
+Title: SAR ADC, DMAC and trigger models of psoc_sim.
+Description: The SAR scans its enabled channels, in the
+				order of their result registers, once per
+				period of the sample rate. The rate is per
+				scan, as in the HAL.
+				Timing at an 18 MHz SAR clock: a channel
+				takes its acquisition time rounded up to
+				clocks (at least 2) and 14 clocks of
+				conversion, times the average count when
+				its averaging is enabled.
+				cyhal_adc_set_sample_rate() refuses a
+				rate whose period is shorter than the scan.
+				A channel's input is sampled at the start of
+				its slot in the scan. At the end of the scan
+				the codes go to CHAN_RESULT and the end of
+				scan output triggers the DMAC channels
+				Cy_TrigMux_Connect() routed it to.
+				The inputs P10_0 ... P10_7 carry synthetic
+				waveforms: dc, sine, square, triangle, saw or
+				noise, with an offset and added noise from a
+				fixed pseudo-random sequence. By default
+				P10_n is a 1000 mV sine around 1650 mV at
+				(n + 1) kHz. Codes are 12 bits over 0 to
+				3300 mV (vref VDDA).
+				The DMAC executes the descriptors when
+				triggered, in zero time: single, 1D, 2D and
+				memory copy transfers, with the PDL's
+				trigger input, interrupt, chaining and
+				channel state semantics. A transfer from or
+				to NULL is a bus error and disables the
+				channel.
+				Trace command:
+				  signal <P10_n> <shape> [freq_hz] [amplitude_mv] [offset_mv] [noise_mv]
+************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "cyhal.h"
+#include "psoc_sim.h"
+
+#define SAR_CLOCK_HZ        18000000u
+#define SAR_MIN_ACQ_CLOCKS  2u
+#define SAR_CONV_CLOCKS     14u
+#define SAR_VREF_MV         3300.0
+#define SAR_DEFAULT_RATE_HZ 1000000u
+#define SAR_INPUTS          8u              // P10_0 ... P10_7
+#define SAR_SOURCE          ((uint32_t)TRIG_IN_MUX_10_PASS_TR_SAR_OUT)
+
+#define DMAC_CHAIN_MAX      64u             // descriptors one DESCR_CHAIN trigger runs at most
+
+SAR_Type sim_sar0;
+DMAC_Type sim_dmac0;
+
+//-------------------------------------------------------------------------------------------
+// Waveform sources
+//-------------------------------------------------------------------------------------------
+typedef enum {
+	SIGNAL_DC,
+	SIGNAL_SINE,
+	SIGNAL_SQUARE,
+	SIGNAL_TRIANGLE,
+	SIGNAL_SAW,
+	SIGNAL_NOISE
+} sim_shape_t;
+
+static const char *const shape_names[] = { "dc", "sine", "square", "triangle", "saw", "noise" };
+
+typedef struct {
+	sim_shape_t shape;
+	double freq_hz;
+	double amplitude_mv;
+	double offset_mv;
+	double noise_mv;
+} sim_source_t;
+
+static sim_source_t sources[SAR_INPUTS];
+static uint8_t sources_set;
+static uint64_t noise_state = 0x9E3779B97F4A7C15ull;
+
+static void sources_default(void){
+	for(uint32_t i = 0; i < SAR_INPUTS; i++){
+		sources[i].shape = SIGNAL_SINE;
+		sources[i].freq_hz = 1000.0 * (double)(i + 1u);
+		sources[i].amplitude_mv = 1000.0;
+		sources[i].offset_mv = 1650.0;
+		sources[i].noise_mv = 0.0;
+	}
+	sources_set = 1;
+}
+
+// -1 ... 1 from xorshift64
+static double noise(void){
+	noise_state ^= noise_state << 13;
+	noise_state ^= noise_state >> 7;
+	noise_state ^= noise_state << 17;
+	return (double)(noise_state >> 11) / (double)(1ull << 52) - 1.0;
+}
+
+static double source_mv(uint32_t input, uint64_t t_ns){
+	const sim_source_t *s = &sources[input];
+	double phase = fmod((double)t_ns * 1e-9 * s->freq_hz, 1.0);
+	double v = s->offset_mv;
+
+	switch(s->shape){
+		case SIGNAL_DC:       break;
+		case SIGNAL_SINE:     v += s->amplitude_mv * sin(2.0 * M_PI * phase); break;
+		case SIGNAL_SQUARE:   v += phase < 0.5 ? s->amplitude_mv : -s->amplitude_mv; break;
+		case SIGNAL_TRIANGLE: v += s->amplitude_mv * (phase < 0.5 ? 4.0 * phase - 1.0 : 3.0 - 4.0 * phase); break;
+		case SIGNAL_SAW:      v += s->amplitude_mv * (2.0 * phase - 1.0); break;
+		case SIGNAL_NOISE:    v += s->amplitude_mv * noise(); break;
+	}
+	if(s->noise_mv != 0.0){
+		v += s->noise_mv * noise();
+	}
+	return v;
+}
+
+static int input_of(cyhal_gpio_t pin){
+	return (pin >= P10_0 && pin <= P10_7) ? (int)(pin - P10_0) : -1;
+}
+
+//-------------------------------------------------------------------------------------------
+// SAR
+//-------------------------------------------------------------------------------------------
+typedef struct {
+	cyhal_adc_t *obj;                   // NULL while the SAR is free
+	uint32_t rate_hz;
+	uint64_t scan_ns;                   // one scan of the enabled channels
+	uint64_t offset_ns[CY_SAR_MAX_NUM_CHANNELS];   // slot of each channel in the scan
+	uint64_t start;                     // time of scan 0
+	uint64_t scan;                      // next scan to end
+	uint64_t next_eos;
+	uint32_t trigger_mask;              // DMAC channels the end of scan triggers
+	uint64_t scans;
+} sim_sar_t;
+
+static sim_sar_t sar = { .next_eos = SIM_NEVER };
+
+static uint32_t channel_clocks(const cyhal_adc_t *adc, const cyhal_adc_channel_t *ch){
+	uint32_t acq = (uint32_t)(((uint64_t)ch->minimum_acquisition_ns * SAR_CLOCK_HZ + 999999999ull) / 1000000000ull);
+	uint32_t clocks;
+
+	if(acq < SAR_MIN_ACQ_CLOCKS){
+		acq = SAR_MIN_ACQ_CLOCKS;
+	}
+	clocks = acq + SAR_CONV_CLOCKS;
+	if(ch->avg_enabled && adc->config.average_count > 1u){
+		clocks *= adc->config.average_count;
+	}
+	return clocks;
+}
+
+static uint64_t clocks_ns(uint64_t clocks){
+	return (clocks * 1000000000ull + SAR_CLOCK_HZ - 1u) / SAR_CLOCK_HZ;
+}
+
+// Scan length and channel slots; 0 without an enabled channel
+static uint64_t sar_timing(cyhal_adc_t *adc, uint64_t *offsets){
+	uint64_t clocks = 0;
+
+	for(uint32_t i = 0; i < CY_SAR_MAX_NUM_CHANNELS; i++){
+		const cyhal_adc_channel_t *ch = adc->channel_config[i];
+
+		if(ch != NULL && ch->enabled){
+			if(offsets != NULL){
+				offsets[i] = clocks_ns(clocks);
+			}
+			clocks += channel_clocks(adc, ch);
+		}
+	}
+	return clocks_ns(clocks);
+}
+
+static uint64_t scan_end(uint64_t scan){
+	return sar.start + (uint64_t)(((unsigned __int128)scan * 1000000000u) / sar.rate_hz) + sar.scan_ns;
+}
+
+// Scanning starts over after every change of the configuration
+static void sar_restart(void){
+	if(sar.obj == NULL){
+		return;
+	}
+	sar.scan_ns = sar_timing(sar.obj, sar.offset_ns);
+	sar.start = sim_now();
+	sar.scan = 0;
+	if(sar.scan_ns == 0 || !sar.obj->config.continuous_scanning){
+		sar.next_eos = SIM_NEVER;
+		return;
+	}
+	// A scan longer than the period delays the next one
+	if((uint64_t)sar.rate_hz * sar.scan_ns > 1000000000ull){
+		sar.rate_hz = (uint32_t)(1000000000ull / sar.scan_ns);
+	}
+	sar.next_eos = scan_end(0);
+}
+
+static int32_t channel_code(const cyhal_adc_t *adc, const cyhal_adc_channel_t *ch, uint64_t t){
+	uint32_t n = (ch->avg_enabled && adc->config.average_count > 1u) ? adc->config.average_count : 1u;
+	uint64_t step = clocks_ns(channel_clocks(adc, ch) / n);
+	int plus = input_of(ch->vplus);
+	int minus = input_of(ch->vminus);
+	double mv = 0.0;
+	int32_t code;
+
+	for(uint32_t i = 0; i < n; i++){
+		double v = source_mv((uint32_t)plus, t + i * step);
+
+		if(minus >= 0){
+			v -= source_mv((uint32_t)minus, t + i * step);
+		}
+		mv += v;
+	}
+	mv /= n;
+	if(minus >= 0){
+		code = (int32_t)floor(mv / SAR_VREF_MV * 2048.0);
+		return code < -2048 ? -2048 : (code > 2047 ? 2047 : code);
+	}
+	code = (int32_t)floor(mv / SAR_VREF_MV * 4096.0);
+	return code < 0 ? 0 : (code > 4095 ? 4095 : code);
+}
+
+static void dmac_trigger(uint32_t channel);
+
+static void sar_end_of_scan(uint64_t eos){
+	cyhal_adc_t *adc = sar.obj;
+	uint64_t start = eos - sar.scan_ns;
+
+	for(uint32_t i = 0; i < CY_SAR_MAX_NUM_CHANNELS; i++){
+		const cyhal_adc_channel_t *ch = adc->channel_config[i];
+
+		if(ch != NULL && ch->enabled){
+			sim_sar0.CHAN_RESULT[i] = (uint32_t)channel_code(adc, ch, start + sar.offset_ns[i]) & 0xFFFFu;
+			sim_sar0.CHAN_RESULT_UPDATED |= 1u << i;
+		}
+	}
+	sar.scans++;
+	if(adc->eos_output){
+		for(uint32_t ch = 0; ch < CY_DMAC_CH_NR; ch++){
+			if(sar.trigger_mask & (1u << ch)){
+				dmac_trigger(ch);
+			}
+		}
+	}
+}
+
+//-------------------------------------------------------------------------------------------
+// cyhal_adc
+//-------------------------------------------------------------------------------------------
+cy_rslt_t cyhal_adc_init(cyhal_adc_t *obj, cyhal_gpio_t pin, const cyhal_clock_t *clk){
+	(void)clk;
+	if(input_of(pin) < 0){
+		return CYHAL_RSLT_ERR_BAD_ARGUMENT;
+	}
+	if(sar.obj != NULL){
+		return CYHAL_RSLT_ERR_RESOURCE_IN_USE;
+	}
+	if(!sources_set){
+		sources_default();
+	}
+	memset(obj, 0, sizeof(*obj));
+	obj->base = SAR0;
+	obj->config.continuous_scanning = true;
+	obj->config.resolution = 12u;
+	obj->config.average_count = 1u;
+	obj->config.vneg = CYHAL_ADC_VNEG_VSSA;
+	obj->config.vref = CYHAL_ADC_REF_VDDA;
+	obj->config.ext_vref = NC;
+	obj->config.bypass_pin = NC;
+	obj->sample_rate_hz = SAR_DEFAULT_RATE_HZ;
+	sar.obj = obj;
+	sar.rate_hz = SAR_DEFAULT_RATE_HZ;
+	sar_restart();
+	return CY_RSLT_SUCCESS;
+}
+
+void cyhal_adc_free(cyhal_adc_t *obj){
+	if(sar.obj == obj){
+		sar.obj = NULL;
+		sar.next_eos = SIM_NEVER;
+	}
+}
+
+cy_rslt_t cyhal_adc_configure(cyhal_adc_t *obj, const cyhal_adc_config_t *config){
+	uint16_t n = config->average_count;
+
+	if(sar.obj != obj || config->resolution != 12u || n == 0u || n > 256u || (n & (n - 1u)) != 0u ||
+	   (n > 1u && !(config->average_mode_flags & CYHAL_ADC_AVG_MODE_AVERAGE))){
+		return CYHAL_RSLT_ERR_BAD_ARGUMENT;
+	}
+	obj->config = *config;
+	sar_restart();
+	return CY_RSLT_SUCCESS;
+}
+
+cy_rslt_t cyhal_adc_set_sample_rate(cyhal_adc_t *obj, uint32_t desired_sample_rate_hz){
+	uint64_t scan;
+
+	if(sar.obj != obj || desired_sample_rate_hz == 0u){
+		return CYHAL_RSLT_ERR_BAD_ARGUMENT;
+	}
+	scan = sar_timing(obj, NULL);
+	if((uint64_t)desired_sample_rate_hz * scan > 1000000000ull){
+		return CYHAL_RSLT_ERR_BAD_CLOCK;
+	}
+	obj->sample_rate_hz = desired_sample_rate_hz;
+	sar.rate_hz = desired_sample_rate_hz;
+	sar_restart();
+	return CY_RSLT_SUCCESS;
+}
+
+static cy_rslt_t channel_apply(cyhal_adc_channel_t *obj, const cyhal_adc_channel_config_t *cfg){
+	obj->enabled = cfg->enabled;
+	obj->avg_enabled = cfg->enable_averaging;
+	obj->minimum_acquisition_ns = cfg->min_acquisition_ns;
+	sar_restart();
+	return CY_RSLT_SUCCESS;
+}
+
+cy_rslt_t cyhal_adc_channel_init_diff(cyhal_adc_channel_t *obj, cyhal_adc_t *adc, cyhal_gpio_t vplus,
+                                      cyhal_gpio_t vminus, const cyhal_adc_channel_config_t *cfg){
+	if(sar.obj != adc || input_of(vplus) < 0 || (vminus != CYHAL_ADC_VNEG && input_of(vminus) < 0) || cfg == NULL){
+		return CYHAL_RSLT_ERR_BAD_ARGUMENT;
+	}
+	// The HAL takes the lowest free result register
+	for(uint32_t i = 0; i < CY_SAR_MAX_NUM_CHANNELS; i++){
+		if(adc->channel_config[i] == NULL){
+			memset(obj, 0, sizeof(*obj));
+			obj->adc = adc;
+			obj->vplus = vplus;
+			obj->vminus = vminus;
+			obj->channel_idx = (uint8_t)i;
+			adc->channel_config[i] = obj;
+			return channel_apply(obj, cfg);
+		}
+	}
+	return CYHAL_RSLT_ERR_RESOURCE_IN_USE;
+}
+
+cy_rslt_t cyhal_adc_channel_configure(cyhal_adc_channel_t *obj, const cyhal_adc_channel_config_t *config){
+	if(obj->adc == NULL || obj->adc->channel_config[obj->channel_idx] != obj || config == NULL){
+		return CYHAL_RSLT_ERR_BAD_ARGUMENT;
+	}
+	return channel_apply(obj, config);
+}
+
+void cyhal_adc_channel_free(cyhal_adc_channel_t *obj){
+	if(obj->adc != NULL && obj->adc->channel_config[obj->channel_idx] == obj){
+		obj->adc->channel_config[obj->channel_idx] = NULL;
+		obj->adc = NULL;
+		sar_restart();
+	}
+}
+
+// The latest result; without continuous scanning the read converts the channel now
+int32_t cyhal_adc_read(const cyhal_adc_channel_t *obj){
+	cyhal_adc_t *adc = obj->adc;
+
+	if(adc == NULL){
+		return 0;
+	}
+	if(!adc->config.continuous_scanning || !obj->enabled){
+		int32_t code = channel_code(adc, obj, sim_now());
+
+		sim_advance_by(clocks_ns(channel_clocks(adc, obj)));
+		return code;
+	}
+	if(sar.scans == 0 || sar.start + sar.scan_ns > sim_now()){
+		sim_advance_to(sar.next_eos);
+	}
+	return (int16_t)(sim_sar0.CHAN_RESULT[obj->channel_idx] & 0xFFFFu);
+}
+
+uint16_t cyhal_adc_read_u16(const cyhal_adc_channel_t *obj){
+	int32_t code = cyhal_adc_read(obj);
+
+	if(obj->vminus != CYHAL_ADC_VNEG){
+		code += 2048;
+	}
+	return (uint16_t)((uint32_t)code << 4 | (uint32_t)code >> 8);
+}
+
+int32_t cyhal_adc_read_uv(const cyhal_adc_channel_t *obj){
+	int32_t code = cyhal_adc_read(obj);
+	double full = obj->vminus != CYHAL_ADC_VNEG ? 2048.0 : 4096.0;
+
+	return (int32_t)((double)code * SAR_VREF_MV * 1000.0 / full);
+}
+
+cy_rslt_t cyhal_adc_enable_output(cyhal_adc_t *obj, cyhal_adc_output_t output, cyhal_source_t *source){
+	if(sar.obj != obj || output != CYHAL_ADC_OUTPUT_SCAN_COMPLETE){
+		return CYHAL_RSLT_ERR_BAD_ARGUMENT;
+	}
+	obj->eos_output = true;
+	if(source != NULL){
+		*source = SAR_SOURCE;
+	}
+	return CY_RSLT_SUCCESS;
+}
+
+cy_rslt_t cyhal_adc_disable_output(cyhal_adc_t *obj, cyhal_adc_output_t output){
+	if(sar.obj != obj || output != CYHAL_ADC_OUTPUT_SCAN_COMPLETE){
+		return CYHAL_RSLT_ERR_BAD_ARGUMENT;
+	}
+	obj->eos_output = false;
+	return CY_RSLT_SUCCESS;
+}
+
+//-------------------------------------------------------------------------------------------
+// Trigger multiplexer
+//-------------------------------------------------------------------------------------------
+cy_en_trigmux_status_t Cy_TrigMux_Connect(uint32_t inTrig, uint32_t outTrig, bool invert, en_trig_type_t trigType){
+	(void)trigType;
+	if(inTrig != SAR_SOURCE || invert || outTrig < TRIG_OUT_MUX_10_MDMA_TR_IN0 || outTrig > TRIG_OUT_MUX_10_MDMA_TR_IN3){
+		return CY_TRIGMUX_BAD_PARAM;
+	}
+	sar.trigger_mask |= 1u << (outTrig - TRIG_OUT_MUX_10_MDMA_TR_IN0);
+	return CY_TRIGMUX_SUCCESS;
+}
+
+cy_en_trigmux_status_t Cy_TrigMux_SwTrigger(uint32_t trigLine, uint32_t cycles){
+	(void)cycles;
+	if(trigLine < TRIG_OUT_MUX_10_MDMA_TR_IN0 || trigLine > TRIG_OUT_MUX_10_MDMA_TR_IN3){
+		return CY_TRIGMUX_BAD_PARAM;
+	}
+	dmac_trigger(trigLine - TRIG_OUT_MUX_10_MDMA_TR_IN0);
+	return CY_TRIGMUX_SUCCESS;
+}
+
+//-------------------------------------------------------------------------------------------
+// DMAC
+//-------------------------------------------------------------------------------------------
+typedef struct {
+	uint8_t enabled;
+	cy_stc_dmac_descriptor_t *current;
+	uint32_t x, y;                      // position in the current descriptor
+	uint32_t priority;
+	uint32_t status;
+	uint32_t mask;
+	uint64_t triggers;
+	uint64_t triggers_lost;             // while the block or the channel was disabled
+	uint64_t elements;
+	uint64_t descriptors;
+	uint64_t errors;
+} sim_dmac_channel_t;
+
+static sim_dmac_channel_t dmac[CY_DMAC_CH_NR];
+static uint8_t dmac_enabled;
+
+static uint32_t data_bytes(cy_en_dmac_data_size_t size){
+	return size == CY_DMAC_BYTE ? 1u : (size == CY_DMAC_HALFWORD ? 2u : 4u);
+}
+
+static uint32_t unit_bytes(const cy_stc_dmac_descriptor_t *d, cy_en_dmac_transfer_size_t transfer){
+	return transfer == CY_DMAC_TRANSFER_SIZE_WORD ? 4u : data_bytes(d->dataSize);
+}
+
+static void dmac_interrupt(uint32_t channel, uint32_t cause){
+	sim_dmac_channel_t *c = &dmac[channel];
+
+	c->status |= cause;
+	if(c->status & c->mask){
+		sim_irq_raise(cpuss_interrupts_dmac_0_IRQn + (int)channel);
+	}
+}
+
+static void dmac_error(uint32_t channel, uint32_t cause){
+	dmac[channel].errors++;
+	dmac[channel].enabled = 0;
+	dmac_interrupt(channel, cause);
+}
+
+static uint32_t read_unit(const uint8_t *p, uint32_t bytes){
+	uint32_t v = 0;
+
+	memcpy(&v, p, bytes);
+	return v;
+}
+
+// One element at the current position
+static int dmac_element(uint32_t channel){
+	sim_dmac_channel_t *c = &dmac[channel];
+	const cy_stc_dmac_descriptor_t *d = c->current;
+	uint32_t src_unit = unit_bytes(d, d->srcTransferSize);
+	uint32_t dst_unit = unit_bytes(d, d->dstTransferSize);
+	uint32_t size = data_bytes(d->dataSize);
+	intptr_t src_off = ((intptr_t)c->x * d->srcXincrement + (intptr_t)c->y * d->srcYincrement) * (intptr_t)src_unit;
+	intptr_t dst_off = ((intptr_t)c->x * d->dstXincrement + (intptr_t)c->y * d->dstYincrement) * (intptr_t)dst_unit;
+	uint32_t value;
+
+	if(d->src == NULL){
+		dmac_error(channel, CY_DMAC_INTR_SRC_BUS_ERROR);
+		return -1;
+	}
+	if(d->dst == NULL){
+		dmac_error(channel, CY_DMAC_INTR_DST_BUS_ERROR);
+		return -1;
+	}
+	value = read_unit((const uint8_t *)d->src + src_off, src_unit);
+	if(size < 4u){
+		value &= (1u << (size * 8u)) - 1u;
+	}
+	memcpy((uint8_t *)d->dst + dst_off, &value, dst_unit);
+	c->elements++;
+	return 0;
+}
+
+// Memory copy: xCount bytes at once
+static int dmac_copy(uint32_t channel){
+	sim_dmac_channel_t *c = &dmac[channel];
+	const cy_stc_dmac_descriptor_t *d = c->current;
+
+	if(d->src == NULL || d->dst == NULL){
+		dmac_error(channel, d->src == NULL ? CY_DMAC_INTR_SRC_BUS_ERROR : CY_DMAC_INTR_DST_BUS_ERROR);
+		return -1;
+	}
+	memmove(d->dst, d->src, d->xCount);
+	c->elements += d->xCount;
+	return 0;
+}
+
+// The current descriptor is done: interrupt, then the next one or the channel stops.
+// Returns 1 when the channel went on to another descriptor.
+static int dmac_descriptor_done(uint32_t channel){
+	sim_dmac_channel_t *c = &dmac[channel];
+	cy_stc_dmac_descriptor_t *d = c->current;
+	int chained = d->channelState == CY_DMAC_CHANNEL_ENABLED && d->next != NULL;
+
+	c->descriptors++;
+	c->current = d->next;
+	c->x = 0;
+	c->y = 0;
+	if(!chained){
+		c->enabled = 0;
+	}
+	if(d->interruptType == CY_DMAC_DESCR || (d->interruptType == CY_DMAC_DESCR_CHAIN && !chained)){
+		dmac_interrupt(channel, CY_DMAC_INTR_COMPLETION);
+	}
+	return chained;
+}
+
+// Run what one trigger of the channel transfers
+static void dmac_trigger(uint32_t channel){
+	sim_dmac_channel_t *c = &dmac[channel];
+	uint32_t descriptors = 0;
+
+	if(channel >= CY_DMAC_CH_NR){
+		return;
+	}
+	c->triggers++;
+	if(!dmac_enabled || !c->enabled){
+		c->triggers_lost++;
+		return;
+	}
+	if(c->current == NULL){
+		dmac_error(channel, CY_DMAC_INTR_CURR_PTR_NULL);
+		return;
+	}
+	for(;;){
+		cy_stc_dmac_descriptor_t *d = c->current;
+		cy_en_dmac_trigger_type_t in = d->triggerInType;
+		uint32_t x_count = d->descriptorType == CY_DMAC_SINGLE_TRANSFER ? 1u : d->xCount;
+		uint32_t y_count = d->descriptorType == CY_DMAC_2D_TRANSFER ? d->yCount : 1u;
+		int x_done = 0;
+
+		if(d->descriptorType == CY_DMAC_MEMORY_COPY){
+			if(dmac_copy(channel) != 0){
+				return;
+			}
+			c->x = x_count;
+			x_done = 1;
+		}
+		else{
+			do{
+				if(dmac_element(channel) != 0){
+					return;
+				}
+				if(d->interruptType == CY_DMAC_1ELEMENT){
+					dmac_interrupt(channel, CY_DMAC_INTR_COMPLETION);
+				}
+				c->x++;
+				x_done = c->x >= x_count;
+			}while(!x_done && in != CY_DMAC_1ELEMENT);
+		}
+		if(!x_done){
+			return;                     // one element per trigger
+		}
+		c->x = 0;
+		c->y++;
+		if(d->interruptType == CY_DMAC_X_LOOP){
+			dmac_interrupt(channel, CY_DMAC_INTR_COMPLETION);
+		}
+		if(c->y < y_count){
+			if(in == CY_DMAC_1ELEMENT || in == CY_DMAC_X_LOOP){
+				return;
+			}
+			continue;
+		}
+		if(!dmac_descriptor_done(channel) || in != CY_DMAC_DESCR_CHAIN || ++descriptors >= DMAC_CHAIN_MAX){
+			return;
+		}
+	}
+}
+
+static sim_dmac_channel_t *channel_of(const DMAC_Type *base, uint32_t channel){
+	return (base == DMAC && channel < CY_DMAC_CH_NR) ? &dmac[channel] : NULL;
+}
+
+cy_en_dmac_status_t Cy_DMAC_Descriptor_Init(cy_stc_dmac_descriptor_t *descriptor,
+                                            const cy_stc_dmac_descriptor_config_t *config){
+	if(descriptor == NULL || config == NULL || config->descriptorType == CY_DMAC_SCATTER_TRANSFER){
+		return CY_DMAC_BAD_PARAM;
+	}
+	if(config->descriptorType != CY_DMAC_SINGLE_TRANSFER &&
+	   (config->xCount == 0u || config->xCount > CY_DMAC_LOOP_COUNT_MAX)){
+		return CY_DMAC_BAD_PARAM;
+	}
+	if(config->descriptorType == CY_DMAC_2D_TRANSFER &&
+	   (config->yCount == 0u || config->yCount > CY_DMAC_LOOP_COUNT_MAX)){
+		return CY_DMAC_BAD_PARAM;
+	}
+	descriptor->interruptType = config->interruptType;
+	descriptor->channelState = config->channelState;
+	descriptor->triggerInType = config->triggerInType;
+	descriptor->dataSize = config->dataSize;
+	descriptor->srcTransferSize = config->srcTransferSize;
+	descriptor->dstTransferSize = config->dstTransferSize;
+	descriptor->descriptorType = config->descriptorType;
+	descriptor->src = config->srcAddress;
+	descriptor->dst = config->dstAddress;
+	descriptor->srcXincrement = config->srcXincrement;
+	descriptor->dstXincrement = config->dstXincrement;
+	descriptor->xCount = config->xCount;
+	descriptor->srcYincrement = config->srcYincrement;
+	descriptor->dstYincrement = config->dstYincrement;
+	descriptor->yCount = config->yCount;
+	descriptor->next = config->nextDescriptor;
+	return CY_DMAC_SUCCESS;
+}
+
+void Cy_DMAC_Descriptor_SetSrcAddress(cy_stc_dmac_descriptor_t *descriptor, const void *srcAddress){
+	descriptor->src = srcAddress;
+}
+
+void Cy_DMAC_Descriptor_SetDstAddress(cy_stc_dmac_descriptor_t *descriptor, const void *dstAddress){
+	descriptor->dst = (void *)(uintptr_t)dstAddress;
+}
+
+void Cy_DMAC_Descriptor_SetNextDescriptor(cy_stc_dmac_descriptor_t *descriptor,
+                                          const cy_stc_dmac_descriptor_t *nextDescriptor){
+	descriptor->next = (cy_stc_dmac_descriptor_t *)(uintptr_t)nextDescriptor;
+}
+
+void Cy_DMAC_Descriptor_SetXloopDataCount(cy_stc_dmac_descriptor_t *descriptor, uint32_t xCount){
+	descriptor->xCount = xCount;
+}
+
+void Cy_DMAC_Descriptor_SetYloopDataCount(cy_stc_dmac_descriptor_t *descriptor, uint32_t yCount){
+	descriptor->yCount = yCount;
+}
+
+cy_en_dmac_status_t Cy_DMAC_Channel_Init(DMAC_Type *base, uint32_t channel,
+                                         const cy_stc_dmac_channel_config_t *config){
+	sim_dmac_channel_t *c = channel_of(base, channel);
+
+	if(c == NULL || config == NULL || config->descriptor == NULL){
+		return CY_DMAC_BAD_PARAM;
+	}
+	c->current = config->descriptor;
+	c->x = 0;
+	c->y = 0;
+	c->priority = config->priority;
+	c->enabled = config->enable;
+	return CY_DMAC_SUCCESS;
+}
+
+void Cy_DMAC_Channel_DeInit(DMAC_Type *base, uint32_t channel){
+	sim_dmac_channel_t *c = channel_of(base, channel);
+
+	if(c != NULL){
+		c->enabled = 0;
+		c->current = NULL;
+		c->x = 0;
+		c->y = 0;
+		c->mask = 0;
+	}
+}
+
+void Cy_DMAC_Channel_SetDescriptor(DMAC_Type *base, uint32_t channel, const cy_stc_dmac_descriptor_t *descriptor){
+	sim_dmac_channel_t *c = channel_of(base, channel);
+
+	if(c != NULL){
+		c->current = (cy_stc_dmac_descriptor_t *)(uintptr_t)descriptor;
+		c->x = 0;
+		c->y = 0;
+	}
+}
+
+void Cy_DMAC_Channel_Enable(DMAC_Type *base, uint32_t channel){
+	sim_dmac_channel_t *c = channel_of(base, channel);
+
+	if(c != NULL){
+		c->enabled = 1;
+	}
+}
+
+void Cy_DMAC_Channel_Disable(DMAC_Type *base, uint32_t channel){
+	sim_dmac_channel_t *c = channel_of(base, channel);
+
+	if(c != NULL){
+		c->enabled = 0;
+	}
+}
+
+void Cy_DMAC_Channel_SetPriority(DMAC_Type *base, uint32_t channel, uint32_t priority){
+	sim_dmac_channel_t *c = channel_of(base, channel);
+
+	if(c != NULL){
+		c->priority = priority;
+	}
+}
+
+cy_stc_dmac_descriptor_t *Cy_DMAC_Channel_GetCurrentDescriptor(const DMAC_Type *base, uint32_t channel){
+	const sim_dmac_channel_t *c = channel_of(base, channel);
+
+	return c != NULL ? c->current : NULL;
+}
+
+uint32_t Cy_DMAC_Channel_GetInterruptStatus(const DMAC_Type *base, uint32_t channel){
+	const sim_dmac_channel_t *c = channel_of(base, channel);
+
+	return c != NULL ? c->status : 0u;
+}
+
+void Cy_DMAC_Channel_ClearInterrupt(DMAC_Type *base, uint32_t channel, uint32_t interrupt){
+	sim_dmac_channel_t *c = channel_of(base, channel);
+
+	if(c != NULL){
+		c->status &= ~interrupt;
+	}
+}
+
+void Cy_DMAC_Channel_SetInterrupt(DMAC_Type *base, uint32_t channel, uint32_t interrupt){
+	if(channel_of(base, channel) != NULL){
+		dmac_interrupt(channel, interrupt & CY_DMAC_INTR_MASK);
+	}
+}
+
+uint32_t Cy_DMAC_Channel_GetInterruptMask(const DMAC_Type *base, uint32_t channel){
+	const sim_dmac_channel_t *c = channel_of(base, channel);
+
+	return c != NULL ? c->mask : 0u;
+}
+
+void Cy_DMAC_Channel_SetInterruptMask(DMAC_Type *base, uint32_t channel, uint32_t interrupt){
+	sim_dmac_channel_t *c = channel_of(base, channel);
+
+	if(c != NULL){
+		c->mask = interrupt & CY_DMAC_INTR_MASK;
+		if(c->status & c->mask){
+			sim_irq_raise(cpuss_interrupts_dmac_0_IRQn + (int)channel);
+		}
+	}
+}
+
+uint32_t Cy_DMAC_Channel_GetInterruptStatusMasked(const DMAC_Type *base, uint32_t channel){
+	const sim_dmac_channel_t *c = channel_of(base, channel);
+
+	return c != NULL ? (c->status & c->mask) : 0u;
+}
+
+void Cy_DMAC_Enable(DMAC_Type *base){
+	if(base == DMAC){
+		dmac_enabled = 1;
+	}
+}
+
+void Cy_DMAC_Disable(DMAC_Type *base){
+	if(base == DMAC){
+		dmac_enabled = 0;
+	}
+}
+
+//-------------------------------------------------------------------------------------------
+// Trace command
+//-------------------------------------------------------------------------------------------
+int sim_adc_command_signal(int argc, char **argv, int apply){
+	double values[4] = { 1000.0, 1000.0, 1650.0, 0.0 };   // freq_hz amplitude_mv offset_mv noise_mv
+	int active_low, pin, input;
+	size_t shape;
+	char *end;
+
+	if(argc < 3 || argc > 7){
+		return -1;
+	}
+	pin = sim_parse_pin(argv[1], &active_low);
+	input = pin < 0 ? -1 : input_of((cyhal_gpio_t)pin);
+	if(input < 0){
+		sim_check_failed("%s is not an ADC input (P10_0 ... P10_7)", argv[1]);
+		return -1;
+	}
+	for(shape = 0; shape < sizeof(shape_names) / sizeof(shape_names[0]); shape++){
+		if(strcmp(argv[2], shape_names[shape]) == 0){
+			break;
+		}
+	}
+	if(shape == sizeof(shape_names) / sizeof(shape_names[0])){
+		sim_check_failed("unknown shape '%s'", argv[2]);
+		return -1;
+	}
+	for(int i = 3; i < argc; i++){
+		values[i - 3] = strtod(argv[i], &end);
+		if(*end != '\0' || values[i - 3] < 0.0){
+			sim_check_failed("bad number '%s'", argv[i]);
+			return -1;
+		}
+	}
+	if(apply){
+		if(!sources_set){
+			sources_default();
+		}
+		sources[input].shape = (sim_shape_t)shape;
+		sources[input].freq_hz = values[0];
+		sources[input].amplitude_mv = values[1];
+		sources[input].offset_mv = values[2];
+		sources[input].noise_mv = values[3];
+		if(sim_verbose){
+			sim_log("signal P10_%d %s %.3f Hz %.1f mV around %.1f mV, noise %.1f mV", input, shape_names[shape],
+			        values[0], values[1], values[2], values[3]);
+		}
+	}
+	return 0;
+}
+
+//-------------------------------------------------------------------------------------------
+// Model
+//-------------------------------------------------------------------------------------------
+static uint64_t adc_next_event(void){
+	return sar.next_eos;
+}
+
+static void adc_run(uint64_t now){
+	while(sar.obj != NULL && sar.next_eos <= now){
+		sar_end_of_scan(sar.next_eos);
+		sar.scan++;
+		sar.next_eos = scan_end(sar.scan);
+	}
+}
+
+static void adc_report(void){
+	if(sar.scans != 0){
+		fprintf(stderr, "sar: %llu scans at %u Hz, %llu ns each\n", (unsigned long long)sar.scans, sar.rate_hz,
+		        (unsigned long long)sar.scan_ns);
+	}
+	for(uint32_t i = 0; i < CY_DMAC_CH_NR; i++){
+		const sim_dmac_channel_t *c = &dmac[i];
+
+		if(c->triggers != 0){
+			fprintf(stderr, "dmac channel %u: %llu triggers (%llu while disabled), %llu elements, "
+			        "%llu descriptors, %llu errors\n", i, (unsigned long long)c->triggers,
+			        (unsigned long long)c->triggers_lost, (unsigned long long)c->elements,
+			        (unsigned long long)c->descriptors, (unsigned long long)c->errors);
+		}
+	}
+}
+
+const sim_model_t sim_adc_model = { "adc", adc_next_event, adc_run, adc_report };
@@ -0,0 +1,262 @@
+/***********************************************************
+Title: CAPSENSE model of psoc_sim.
+Description: The widgets of the CAPSENSE application's
+				design: Button0, Button1 and LinearSlider0
+				(positions 0 ... 300). A scan of all widgets
+				takes SIM_CAPSENSE_SCAN_US and samples the
+				touches of the trace at its end, when the CSD
+				interrupt is raised; the middleware's
+				interrupt handler ends the scan and calls the
+				end-of-scan callback, and processing the
+				widgets makes the sample their state. The
+				tuner over EZI2C gets the widget states from
+				Cy_CapSense_RunTuner(); no I2C master is
+				simulated.
+				Trace commands:
+				  touch <BUTTON0|BUTTON1> <0|1>
+				  slider <0 ... 300 | off>
+************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "cyhal.h"
+#include "cycfg_capsense.h"
+#include "psoc_sim.h"
+
+cy_stc_capsense_context_t cy_capsense_context;
+cy_stc_capsense_tuner_t cy_capsense_tuner;
+CSD_Type sim_csd0;
+
+static struct {
+	uint8_t button[2];                  // touches of the trace
+	int32_t slider;                     // -1 when not touched
+	uint8_t sampled_button[2];          // at the end of the last scan
+	int32_t sampled_slider;
+	cy_stc_capsense_context_t *scanning;
+	uint64_t scan_end;
+	uint64_t scans;
+	uint64_t touches;
+} csd = { .slider = -1, .sampled_slider = -1, .scan_end = SIM_NEVER };
+
+cy_capsense_status_t Cy_CapSense_Init(cy_stc_capsense_context_t *context){
+	if(context == NULL){
+		return CY_CAPSENSE_STATUS_BAD_PARAM;
+	}
+	memset(context, 0, sizeof(*context));
+	for(uint32_t i = 0; i < SIM_CAPSENSE_WIDGETS; i++){
+		context->touch[i].ptrPosition = &context->position[i];
+	}
+	return CY_CAPSENSE_STATUS_SUCCESS;
+}
+
+cy_capsense_status_t Cy_CapSense_Enable(cy_stc_capsense_context_t *context){
+	if(context == NULL){
+		return CY_CAPSENSE_STATUS_BAD_PARAM;
+	}
+	context->enabled = 1;
+	return CY_CAPSENSE_STATUS_SUCCESS;
+}
+
+cy_capsense_status_t Cy_CapSense_RegisterCallback(cy_en_capsense_callback_event_t callbackType,
+                                                  cy_capsense_callback_t callbackFunction,
+                                                  cy_stc_capsense_context_t *context){
+	if(context == NULL || callbackFunction == NULL){
+		return CY_CAPSENSE_STATUS_BAD_PARAM;
+	}
+	if(callbackType == CY_CAPSENSE_END_OF_SCAN_E){
+		context->end_of_scan = callbackFunction;
+	}
+	else if(callbackType == CY_CAPSENSE_START_SAMPLE_E){
+		context->start_sample = callbackFunction;
+	}
+	else{
+		return CY_CAPSENSE_STATUS_BAD_PARAM;
+	}
+	return CY_CAPSENSE_STATUS_SUCCESS;
+}
+
+cy_capsense_status_t Cy_CapSense_ScanAllWidgets(cy_stc_capsense_context_t *context){
+	if(context == NULL || !context->enabled){
+		return CY_CAPSENSE_STATUS_BAD_PARAM;
+	}
+	if(csd.scanning != NULL){
+		return CY_CAPSENSE_STATUS_HW_BUSY;
+	}
+	csd.scanning = context;
+	csd.scan_end = sim_now() + SIM_CAPSENSE_SCAN_US * SIM_NS_PER_US;
+	context->status |= CY_CAPSENSE_BUSY;
+	context->active_scan.widgetIndex = 0;
+	context->active_scan.sensorIndex = 0;
+	if(context->start_sample != NULL){
+		context->start_sample(&context->active_scan);
+	}
+	return CY_CAPSENSE_STATUS_SUCCESS;
+}
+
+uint32_t Cy_CapSense_IsBusy(const cy_stc_capsense_context_t *context){
+	if(context->status & CY_CAPSENSE_BUSY){
+		sim_advance_by(SIM_POLL_NS);
+		return CY_CAPSENSE_BUSY;
+	}
+	return CY_CAPSENSE_NOT_BUSY;
+}
+
+void Cy_CapSense_InterruptHandler(const CSD_Type *base, cy_stc_capsense_context_t *context){
+	(void)base;
+	if(csd.scanning != context || csd.scan_end != SIM_NEVER){
+		return;                         // no scan has ended
+	}
+	csd.scanning = NULL;
+	context->status &= ~(uint32_t)CY_CAPSENSE_BUSY;
+	context->active_scan.widgetIndex = SIM_CAPSENSE_WIDGETS - 1u;
+	if(context->end_of_scan != NULL){
+		context->end_of_scan(&context->active_scan);
+	}
+}
+
+cy_capsense_status_t Cy_CapSense_ProcessAllWidgets(cy_stc_capsense_context_t *context){
+	cy_stc_capsense_touch_t *slider = &context->touch[CY_CAPSENSE_LINEARSLIDER0_WDGT_ID];
+
+	if(context->status & CY_CAPSENSE_BUSY){
+		return CY_CAPSENSE_STATUS_HW_BUSY;
+	}
+	context->active[CY_CAPSENSE_BUTTON0_WDGT_ID] = csd.sampled_button[0];
+	context->active[CY_CAPSENSE_BUTTON1_WDGT_ID] = csd.sampled_button[1];
+	context->active[CY_CAPSENSE_LINEARSLIDER0_WDGT_ID] = csd.sampled_slider >= 0;
+	for(uint32_t i = 0; i < SIM_CAPSENSE_WIDGETS; i++){
+		context->touch[i].ptrPosition = &context->position[i];
+		context->touch[i].numPosition = (uint8_t)(context->active[i] != 0u);
+	}
+	// The slider keeps its last position when released
+	if(csd.sampled_slider >= 0){
+		slider->ptrPosition->x = (uint16_t)csd.sampled_slider;
+		slider->ptrPosition->z = 100u;
+	}
+	return CY_CAPSENSE_STATUS_SUCCESS;
+}
+
+uint32_t Cy_CapSense_IsSensorActive(uint32_t widgetId, uint32_t sensorId, const cy_stc_capsense_context_t *context){
+	(void)sensorId;
+	return widgetId < SIM_CAPSENSE_WIDGETS ? context->active[widgetId] : 0u;
+}
+
+uint32_t Cy_CapSense_IsWidgetActive(uint32_t widgetId, const cy_stc_capsense_context_t *context){
+	return widgetId < SIM_CAPSENSE_WIDGETS ? context->active[widgetId] : 0u;
+}
+
+cy_stc_capsense_touch_t *Cy_CapSense_GetTouchInfo(uint32_t widgetId, const cy_stc_capsense_context_t *context){
+	if(widgetId >= SIM_CAPSENSE_WIDGETS){
+		widgetId = 0;
+	}
+	return (cy_stc_capsense_touch_t *)(uintptr_t)&context->touch[widgetId];
+}
+
+uint32_t Cy_CapSense_RunTuner(cy_stc_capsense_context_t *context){
+	cy_capsense_tuner.status = context->status;
+	memcpy(cy_capsense_tuner.active, context->active, sizeof(cy_capsense_tuner.active));
+	memcpy(cy_capsense_tuner.position, context->position, sizeof(cy_capsense_tuner.position));
+	return CY_CAPSENSE_STATUS_SUCCESS;
+}
+
+//-------------------------------------------------------------------------------------------
+// EZI2C: the tuner's slave is configured, nothing talks to it
+//-------------------------------------------------------------------------------------------
+cy_rslt_t cyhal_ezi2c_init(cyhal_ezi2c_t *obj, cyhal_gpio_t sda, cyhal_gpio_t scl, const cyhal_clock_t *clk,
+                           const cyhal_ezi2c_cfg_t *cfg){
+	(void)clk;
+	if(obj == NULL || cfg == NULL || sda == NC || scl == NC || cfg->slave1_cfg.buf == NULL ||
+	   cfg->slave1_cfg.buf_rw_boundary > cfg->slave1_cfg.buf_size){
+		return CYHAL_RSLT_ERR_BAD_ARGUMENT;
+	}
+	obj->cfg = *cfg;
+	obj->sda = sda;
+	obj->scl = scl;
+	return CY_RSLT_SUCCESS;
+}
+
+void cyhal_ezi2c_free(cyhal_ezi2c_t *obj){
+	(void)obj;
+}
+
+//-------------------------------------------------------------------------------------------
+// Trace commands
+//-------------------------------------------------------------------------------------------
+int sim_capsense_command_touch(int argc, char **argv, int apply){
+	int button;
+
+	if(argc != 3 || (strcmp(argv[2], "0") != 0 && strcmp(argv[2], "1") != 0)){
+		return -1;
+	}
+	if(strcmp(argv[1], "BUTTON0") == 0){
+		button = 0;
+	}
+	else if(strcmp(argv[1], "BUTTON1") == 0){
+		button = 1;
+	}
+	else{
+		sim_check_failed("unknown button '%s'", argv[1]);
+		return -1;
+	}
+	if(apply){
+		csd.button[button] = (uint8_t)(argv[2][0] == '1');
+		csd.touches++;
+		if(sim_verbose){
+			sim_log("touch %s %s", argv[1], argv[2]);
+		}
+	}
+	return 0;
+}
+
+int sim_capsense_command_slider(int argc, char **argv, int apply){
+	long position = -1;
+	char *end;
+
+	if(argc != 2){
+		return -1;
+	}
+	if(strcmp(argv[1], "off") != 0){
+		position = strtol(argv[1], &end, 10);
+		if(*end != '\0' || position < 0 || position > (long)CY_CAPSENSE_LINEARSLIDER0_X_RESOLUTION){
+			sim_check_failed("slider position %s not in 0 ... %u", argv[1], CY_CAPSENSE_LINEARSLIDER0_X_RESOLUTION);
+			return -1;
+		}
+	}
+	if(apply){
+		csd.slider = (int32_t)position;
+		csd.touches++;
+		if(sim_verbose){
+			sim_log("slider %s", argv[1]);
+		}
+	}
+	return 0;
+}
+
+//-------------------------------------------------------------------------------------------
+// Model
+//-------------------------------------------------------------------------------------------
+static uint64_t capsense_next_event(void){
+	return csd.scan_end;
+}
+
+static void capsense_run(uint64_t now){
+	if(csd.scan_end > now){
+		return;
+	}
+	csd.sampled_button[0] = csd.button[0];
+	csd.sampled_button[1] = csd.button[1];
+	csd.sampled_slider = csd.slider;
+	csd.scan_end = SIM_NEVER;
+	csd.scans++;
+	sim_irq_raise(csd_interrupt_IRQn);
+}
+
+static void capsense_report(void){
+	if(csd.scans != 0){
+		fprintf(stderr, "capsense: %llu scans, %llu touches\n", (unsigned long long)csd.scans,
+		        (unsigned long long)csd.touches);
+	}
+}
+
+const sim_model_t sim_capsense_model = { "capsense", capsense_next_event, capsense_run, capsense_report };
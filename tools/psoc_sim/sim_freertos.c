@@ -0,0 +1,472 @@
+/***********************************************************
+Title: FreeRTOS model of psoc_sim.
+Description: The subset of FreeRTOS the DHT-11 application
+				uses. Every task is a host thread, but only the
+				one the scheduler made current runs; the others
+				wait on their condition variable, so the
+				application still executes one instruction
+				stream as on the CM4. The highest-priority
+				ready task runs; a task of higher priority
+				that became ready (its delay expired, a queue
+				it waits on changed, also from an interrupt
+				handler) takes the CPU at the next switch
+				point: a call into the RTOS or the end of an
+				advance of the clock. Ticks are 1 ms of
+				simulated time. When no task is ready the
+				idle task runs the peripherals up to the next
+				wake-up; with nothing left to wake a task the
+				run ends. A critical section masks the
+				interrupts and holds off task switches.
+************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+
+#include "FreeRTOS.h"
+#include "task.h"
+#include "queue.h"
+
+#define SIM_MAX_TASKS       16
+#define TICK_NS             (SIM_NS_PER_MS * 1000u / configTICK_RATE_HZ)
+
+typedef enum {
+	TASK_READY,
+	TASK_BLOCKED,
+	TASK_DELETED
+} sim_task_state_t;
+
+struct sim_task {
+	char name[16];
+	TaskFunction_t code;
+	void *parameters;
+	UBaseType_t priority;
+	sim_task_state_t state;
+	uint64_t wake;                      // end of a delay or timeout, SIM_NEVER if none
+	struct sim_queue *waiting;          // queue the task blocks on
+	uint32_t critical_nesting;
+	pthread_t thread;
+	pthread_cond_t cond;
+	uint32_t switches;                  // times the task got the CPU
+};
+
+struct sim_queue {
+	uint8_t *items;
+	UBaseType_t length;
+	UBaseType_t item_size;
+	UBaseType_t head;
+	UBaseType_t count;
+	uint32_t sent;
+	uint32_t full;                      // sends that found the queue full
+};
+
+static pthread_mutex_t cpu_lock = PTHREAD_MUTEX_INITIALIZER;
+static struct sim_task tasks[SIM_MAX_TASKS];
+static int num_tasks;
+static struct sim_task *current;
+static int scheduler_running;
+static int in_scheduler;
+static uint64_t idle_ns;
+static uint32_t critical_nesting;       // outside the tasks, before the scheduler runs
+
+//-------------------------------------------------------------------------------------------
+// Scheduler
+//-------------------------------------------------------------------------------------------
+static uint64_t ticks_from_now(TickType_t ticks){
+	return ticks == portMAX_DELAY ? SIM_NEVER : sim_now() + (uint64_t)ticks * TICK_NS;
+}
+
+static void wake_expired(void){
+	uint64_t now = sim_now();
+
+	for(int i = 0; i < num_tasks; i++){
+		if(tasks[i].state == TASK_BLOCKED && tasks[i].wake <= now){
+			tasks[i].state = TASK_READY;
+			tasks[i].waiting = NULL;
+		}
+	}
+}
+
+// Highest-priority ready task; among equal priorities the one after the
+// current task, so that yielding goes round
+static struct sim_task *pick(void){
+	struct sim_task *best = NULL;
+	int start = current != NULL ? (int)(current - tasks) + 1 : 0;
+
+	wake_expired();
+	for(int n = 0; n < num_tasks; n++){
+		struct sim_task *t = &tasks[(start + n) % num_tasks];
+
+		if(t->state == TASK_READY && (best == NULL || t->priority > best->priority)){
+			best = t;
+		}
+	}
+	return best;
+}
+
+static uint64_t earliest_wake(void){
+	uint64_t wake = SIM_NEVER;
+
+	for(int i = 0; i < num_tasks; i++){
+		if(tasks[i].state == TASK_BLOCKED && tasks[i].wake < wake){
+			wake = tasks[i].wake;
+		}
+	}
+	return wake;
+}
+
+// Give the CPU to 'next' and wait until the scheduler gives it back to 'self'
+static void switch_to(struct sim_task *self, struct sim_task *next){
+	if(next == self){
+		return;
+	}
+	current = next;
+	next->switches++;
+	pthread_cond_signal(&next->cond);
+	if(self == NULL){
+		return;
+	}
+	if(self->state == TASK_DELETED){
+		pthread_mutex_unlock(&cpu_lock);
+		pthread_exit(NULL);
+	}
+	while(current != self){
+		pthread_cond_wait(&self->cond, &cpu_lock);
+	}
+}
+
+// The current task blocked, yielded or ended: run the next one, idling
+// until one is ready
+static void schedule(void){
+	struct sim_task *self = current;
+	struct sim_task *next;
+
+	in_scheduler++;
+	while((next = pick()) == NULL){
+		uint64_t start = sim_now();
+
+		sim_wait(earliest_wake());
+		idle_ns += sim_now() - start;
+	}
+	in_scheduler--;
+	switch_to(self, next);
+}
+
+// Switch point: a task of higher priority than the current one is ready
+static void preempt_if_needed(void){
+	struct sim_task *next;
+
+	if(!scheduler_running || in_scheduler || current == NULL || current->critical_nesting != 0){
+		return;
+	}
+	next = pick();
+	if(next != NULL && next->priority > current->priority){
+		switch_to(current, next);
+	}
+}
+
+void sim_rtos_preempt(void){
+	preempt_if_needed();
+}
+
+// Not instrumented: the task code it calls must run at depth 0, see
+// __sanitizer_cov_trace_pc() in psoc_sim.c
+static __attribute__((no_instrument_function)) void *task_thread(void *arg){
+	struct sim_task *self = arg;
+
+	pthread_mutex_lock(&cpu_lock);
+	while(current != self){
+		pthread_cond_wait(&self->cond, &cpu_lock);
+	}
+	self->code(self->parameters);
+
+	// A FreeRTOS task must not return; delete it as the port's error hook would stop it
+	fprintf(stderr, "task '%s' returned\n", self->name);
+	vTaskDelete(NULL);
+	return NULL;
+}
+
+//-------------------------------------------------------------------------------------------
+// Tasks
+//-------------------------------------------------------------------------------------------
+BaseType_t xTaskCreate(TaskFunction_t pxTaskCode, const char *pcName, configSTACK_DEPTH_TYPE usStackDepth,
+                       void *pvParameters, UBaseType_t uxPriority, TaskHandle_t *pxCreatedTask){
+	struct sim_task *t;
+
+	(void)usStackDepth;
+	if(pxTaskCode == NULL || num_tasks == SIM_MAX_TASKS){
+		return pdFAIL;
+	}
+	t = &tasks[num_tasks];
+	memset(t, 0, sizeof(*t));
+	snprintf(t->name, sizeof(t->name), "%s", pcName != NULL ? pcName : "");
+	t->code = pxTaskCode;
+	t->parameters = pvParameters;
+	t->priority = uxPriority < configMAX_PRIORITIES ? uxPriority : configMAX_PRIORITIES - 1u;
+	t->state = TASK_READY;
+	t->wake = SIM_NEVER;
+	pthread_cond_init(&t->cond, NULL);
+	if(pthread_create(&t->thread, NULL, task_thread, t) != 0){
+		return pdFAIL;
+	}
+	pthread_detach(t->thread);
+	num_tasks++;
+	if(pxCreatedTask != NULL){
+		*pxCreatedTask = t;
+	}
+	preempt_if_needed();
+	return pdPASS;
+}
+
+void vTaskDelete(TaskHandle_t xTaskToDelete){
+	struct sim_task *t = xTaskToDelete != NULL ? xTaskToDelete : current;
+
+	if(t == NULL){
+		return;
+	}
+	t->state = TASK_DELETED;
+	if(t == current && scheduler_running){
+		schedule();
+	}
+}
+
+void vTaskStartScheduler(void){
+	struct sim_task *first;
+	pthread_cond_t never = PTHREAD_COND_INITIALIZER;
+
+	pthread_mutex_lock(&cpu_lock);
+	scheduler_running = 1;
+	critical_nesting = 0;
+	in_scheduler++;
+	while((first = pick()) == NULL){
+		sim_wait(earliest_wake());
+	}
+	in_scheduler--;
+	switch_to(NULL, first);
+
+	// The main thread is done; the run ends from a task or the idle loop
+	for(;;){
+		pthread_cond_wait(&never, &cpu_lock);
+	}
+}
+
+void vTaskDelay(TickType_t xTicksToDelay){
+	if(!scheduler_running || current == NULL){
+		return;
+	}
+	if(xTicksToDelay == 0){
+		vTaskYield();
+		return;
+	}
+	current->state = TASK_BLOCKED;
+	current->wake = ticks_from_now(xTicksToDelay);
+	schedule();
+}
+
+void vTaskDelayUntil(TickType_t *pxPreviousWakeTime, TickType_t xTimeIncrement){
+	uint64_t wake;
+
+	*pxPreviousWakeTime += xTimeIncrement;
+	wake = (uint64_t)*pxPreviousWakeTime * TICK_NS;
+	if(!scheduler_running || current == NULL || wake <= sim_now()){
+		return;
+	}
+	current->state = TASK_BLOCKED;
+	current->wake = wake;
+	schedule();
+}
+
+TickType_t xTaskGetTickCount(void){
+	return (TickType_t)(sim_now() / TICK_NS);
+}
+
+void vTaskYield(void){
+	struct sim_task *next;
+
+	if(!scheduler_running || current == NULL){
+		return;
+	}
+	next = pick();
+	if(next != NULL && next->priority == current->priority){
+		switch_to(current, next);
+	}
+	else{
+		preempt_if_needed();
+	}
+}
+
+void vTaskEnterCritical(void){
+	uint32_t *nesting = current != NULL ? &current->critical_nesting : &critical_nesting;
+
+	(void)sim_irq_disable();
+	(*nesting)++;
+}
+
+void vTaskExitCritical(void){
+	uint32_t *nesting = current != NULL ? &current->critical_nesting : &critical_nesting;
+
+	configASSERT(*nesting != 0);
+	if(--(*nesting) == 0){
+		sim_irq_restore(0U);
+		preempt_if_needed();
+	}
+}
+
+//-------------------------------------------------------------------------------------------
+// Queues
+//-------------------------------------------------------------------------------------------
+QueueHandle_t xQueueCreate(UBaseType_t uxQueueLength, UBaseType_t uxItemSize){
+	struct sim_queue *q;
+
+	if(uxQueueLength == 0){
+		return NULL;
+	}
+	q = calloc(1, sizeof(*q));
+	if(q == NULL){
+		return NULL;
+	}
+	q->items = calloc(uxQueueLength, uxItemSize != 0 ? uxItemSize : 1u);
+	if(q->items == NULL){
+		free(q);
+		return NULL;
+	}
+	q->length = uxQueueLength;
+	q->item_size = uxItemSize;
+	return q;
+}
+
+void vQueueDelete(QueueHandle_t xQueue){
+	if(xQueue != NULL){
+		free(xQueue->items);
+		free(xQueue);
+	}
+}
+
+// The queue changed: the tasks blocked on it try again. Returns whether
+// one of them has a higher priority than the current task.
+static int wake_waiting(struct sim_queue *q){
+	int higher = 0;
+
+	for(int i = 0; i < num_tasks; i++){
+		struct sim_task *t = &tasks[i];
+
+		if(t->state == TASK_BLOCKED && t->waiting == q){
+			t->state = TASK_READY;
+			t->waiting = NULL;
+			if(current == NULL || t->priority > current->priority){
+				higher = 1;
+			}
+		}
+	}
+	return higher;
+}
+
+static int put(struct sim_queue *q, const void *item, int front){
+	UBaseType_t slot;
+
+	if(q->count == q->length){
+		q->full++;
+		return 0;
+	}
+	if(front){
+		q->head = (q->head + q->length - 1u) % q->length;
+		slot = q->head;
+	}
+	else{
+		slot = (q->head + q->count) % q->length;
+	}
+	memcpy(&q->items[slot * q->item_size], item, q->item_size);
+	q->count++;
+	q->sent++;
+	return 1;
+}
+
+// Block the current task on 'q' until it changes or 'deadline' passes
+static void block_on(struct sim_queue *q, uint64_t deadline){
+	current->state = TASK_BLOCKED;
+	current->waiting = q;
+	current->wake = deadline;
+	schedule();
+}
+
+static BaseType_t send(QueueHandle_t q, const void *item, TickType_t ticks, int front){
+	uint64_t deadline = ticks_from_now(ticks);
+
+	for(;;){
+		if(put(q, item, front)){
+			if(wake_waiting(q)){
+				preempt_if_needed();
+			}
+			return pdPASS;
+		}
+		if(ticks == 0 || sim_now() >= deadline || !scheduler_running){
+			return errQUEUE_FULL;
+		}
+		block_on(q, deadline);
+	}
+}
+
+BaseType_t xQueueSendToBack(QueueHandle_t xQueue, const void *pvItemToQueue, TickType_t xTicksToWait){
+	configASSERT(xQueue != NULL);
+	return send(xQueue, pvItemToQueue, xTicksToWait, 0);
+}
+
+BaseType_t xQueueSendToFront(QueueHandle_t xQueue, const void *pvItemToQueue, TickType_t xTicksToWait){
+	configASSERT(xQueue != NULL);
+	return send(xQueue, pvItemToQueue, xTicksToWait, 1);
+}
+
+BaseType_t xQueueReceive(QueueHandle_t xQueue, void *pvBuffer, TickType_t xTicksToWait){
+	uint64_t deadline = ticks_from_now(xTicksToWait);
+	struct sim_queue *q = xQueue;
+
+	configASSERT(q != NULL);
+	for(;;){
+		if(q->count != 0){
+			memcpy(pvBuffer, &q->items[q->head * q->item_size], q->item_size);
+			q->head = (q->head + 1u) % q->length;
+			q->count--;
+			if(wake_waiting(q)){
+				preempt_if_needed();
+			}
+			return pdPASS;
+		}
+		if(xTicksToWait == 0 || sim_now() >= deadline || !scheduler_running){
+			return errQUEUE_EMPTY;
+		}
+		block_on(q, deadline);
+	}
+}
+
+// From a handler: the switch to a woken task happens when the handler returns
+BaseType_t xQueueSendFromISR(QueueHandle_t xQueue, const void *pvItemToQueue, BaseType_t *pxHigherPriorityTaskWoken){
+	configASSERT(xQueue != NULL);
+	if(!put(xQueue, pvItemToQueue, 0)){
+		return errQUEUE_FULL;
+	}
+	if(wake_waiting(xQueue) && pxHigherPriorityTaskWoken != NULL){
+		*pxHigherPriorityTaskWoken = pdTRUE;
+	}
+	return pdPASS;
+}
+
+UBaseType_t uxQueueMessagesWaiting(QueueHandle_t xQueue){
+	configASSERT(xQueue != NULL);
+	return xQueue->count;
+}
+
+//-------------------------------------------------------------------------------------------
+// Report
+//-------------------------------------------------------------------------------------------
+void sim_rtos_report(void){
+	uint64_t now = sim_now();
+
+	for(int i = 0; i < num_tasks; i++){
+		fprintf(stderr, "task %-16s priority %lu, %u switches in\n", tasks[i].name, tasks[i].priority,
+		        tasks[i].switches);
+	}
+	if(num_tasks != 0 && now != 0){
+		fprintf(stderr, "idle %.1f %% of the simulated time\n", 100.0 * (double)idle_ns / (double)now);
+	}
+}
@@ -0,0 +1,479 @@
+/***********************************************************
+Title: GPIO, PWM and DHT-11 models of psoc_sim.
+Description: Pin levels for cyhal_gpio and cyhal_pwm, and a
+				DHT-11 sensor that can sit on a pin.
+				A pin driven strongly shows what the
+				application writes; a pull-up or open-drain
+				pin shows a low the application writes, and
+				otherwise what is outside: the level a trace
+				'set' gave it, or the sensor. A PWM pin shows
+				its level for most of the period (high when
+				stopped: the LED of the kit is off).
+				The DHT-11 answers a low of at least 18 ms
+				followed by a release, with the timing of its
+				datasheet: 30 us high, 80 us low, 80 us high,
+				then 40 bits of 50 us low and 26 us (0) or
+				70 us (1) high, then 50 us low. The bytes are
+				the humidity, 0, the temperature, its tenths
+				and the checksum.
+				Trace commands:
+				  set <pin>=<on|off|0|1>...    input levels
+				  expect <pin>=<on|off|0|1>... check levels
+				  dht <pin> <humidity> <temperature> | dht <pin> off
+				on and off respect the active-low LEDs and
+				button of the board.
+************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "cyhal.h"
+#include "cybsp.h"
+#include "psoc_sim.h"
+
+#define DHT_START_LOW_NS    (18u * SIM_NS_PER_MS)
+#define DHT_EDGES           (3u + 2u * 40u + 1u)
+
+typedef struct {
+	uint8_t used;
+	uint8_t direction;
+	uint8_t drive;
+	uint8_t out;                        // what the application writes
+	int8_t ext;                         // level from the trace, -1 if none
+	const cyhal_pwm_t *pwm;             // the PWM driving the pin, if any
+	uint8_t level;                      // last level seen, for the change count
+	uint32_t changes;
+} sim_pin_t;
+
+typedef struct {
+	int pin;                            // -1 if no sensor
+	uint8_t bytes[5];
+	uint64_t low_since;                 // host pulled the line low here, SIM_NEVER if not
+	uint64_t edges[DHT_EDGES];          // answer in progress: the times the sensor toggles
+	uint32_t next_edge;                 // DHT_EDGES when not answering
+	uint32_t answers;
+	uint32_t short_starts;
+} sim_dht_t;
+
+typedef struct {
+	const char *name;
+	int pin;
+	int active_low;
+} sim_pin_alias_t;
+
+static const sim_pin_alias_t aliases[] = {
+	{ "USER_LED",  P13_7, 1 },
+	{ "USER_LED1", P13_7, 1 },
+	{ "LED4",      P13_7, 1 },
+	{ "USER_BTN",  P0_4,  1 },
+};
+
+static sim_pin_t pins[SIM_NUM_PINS] = { [0 ... SIM_NUM_PINS - 1] = { .ext = -1 } };
+static sim_dht_t dht = { .pin = -1, .low_since = SIM_NEVER, .next_edge = DHT_EDGES };
+
+static const char *pin_name(int pin){
+	static char name[32];
+	size_t i;
+
+	snprintf(name, sizeof(name), "P%d_%d", pin >> 3, pin & 7);
+	for(i = 0; i < sizeof(aliases) / sizeof(aliases[0]); i++){
+		if(aliases[i].pin == pin){
+			snprintf(name, sizeof(name), "P%d_%d (%s)", pin >> 3, pin & 7, aliases[i].name);
+			break;
+		}
+	}
+	return name;
+}
+
+int sim_parse_pin(const char *name, int *active_low){
+	unsigned int port, bit;
+	char end;
+	size_t i;
+
+	*active_low = 0;
+	for(i = 0; i < sizeof(aliases) / sizeof(aliases[0]); i++){
+		if(strcmp(name, aliases[i].name) == 0){
+			*active_low = aliases[i].active_low;
+			return aliases[i].pin;
+		}
+	}
+	if(sscanf(name, "P%u_%u%c", &port, &bit, &end) != 2 || port >= SIM_NUM_PINS / 8u || bit > 7u){
+		return -1;
+	}
+	if(port == 13u && bit == 7u){
+		*active_low = 1;
+	}
+	return (int)(port << 3 | bit);
+}
+
+//-------------------------------------------------------------------------------------------
+// DHT-11
+//-------------------------------------------------------------------------------------------
+static void dht_answer(uint64_t release){
+	uint64_t t = release;
+	uint32_t n = 0;
+
+	t += 30u * SIM_NS_PER_US;
+	dht.edges[n++] = t;                 // low: response
+	t += 80u * SIM_NS_PER_US;
+	dht.edges[n++] = t;                 // high: get ready
+	t += 80u * SIM_NS_PER_US;
+	dht.edges[n++] = t;                 // low: first bit
+	for(int i = 0; i < 40; i++){
+		int bit = (dht.bytes[i >> 3] >> (7 - (i & 7))) & 1;
+
+		t += 50u * SIM_NS_PER_US;
+		dht.edges[n++] = t;
+		t += (bit ? 70u : 26u) * SIM_NS_PER_US;
+		dht.edges[n++] = t;
+	}
+	t += 50u * SIM_NS_PER_US;
+	dht.edges[n++] = t;                 // released
+	dht.next_edge = 0;
+	dht.answers++;
+}
+
+// Line level the sensor drives, 1 when released
+static int dht_level(void){
+	uint64_t now = sim_now();
+	int level = 1;
+	uint32_t i;
+
+	if(dht.next_edge >= DHT_EDGES){
+		return 1;
+	}
+	for(i = 0; i < DHT_EDGES && dht.edges[i] <= now; i++){
+		level ^= 1;
+	}
+	if(i == DHT_EDGES){
+		dht.next_edge = DHT_EDGES;
+	}
+	return level;
+}
+
+// The host drove the line: a long enough low followed by a release starts an answer
+static void dht_host_write(int level){
+	uint64_t now = sim_now();
+
+	if(!level){
+		if(dht.low_since == SIM_NEVER){
+			dht.low_since = now;
+		}
+		dht.next_edge = DHT_EDGES;
+		return;
+	}
+	if(dht.low_since != SIM_NEVER){
+		if(now - dht.low_since >= DHT_START_LOW_NS){
+			dht_answer(now);
+		}
+		else{
+			dht.short_starts++;
+		}
+		dht.low_since = SIM_NEVER;
+	}
+}
+
+//-------------------------------------------------------------------------------------------
+// Levels
+//-------------------------------------------------------------------------------------------
+static int outside_level(int pin, int released){
+	const sim_pin_t *p = &pins[pin];
+
+	if(dht.pin == pin){
+		return dht_level();
+	}
+	if(p->ext >= 0){
+		return p->ext;
+	}
+	return released;
+}
+
+static int pin_level(int pin){
+	const sim_pin_t *p = &pins[pin];
+
+	if(p->pwm != NULL){
+		return !p->pwm->running || p->pwm->duty_cycle >= 50.0f;
+	}
+	if(!p->used || p->direction == CYHAL_GPIO_DIR_INPUT){
+		return outside_level(pin, p->drive == CYHAL_GPIO_DRIVE_PULLUP);
+	}
+	if(p->drive == CYHAL_GPIO_DRIVE_STRONG){
+		return p->out;
+	}
+	// Pull-up or open drain: a low written wins, otherwise the outside decides
+	if(!p->out){
+		return 0;
+	}
+	return outside_level(pin, 1);
+}
+
+// Count and log the changes of an output
+static void pin_update(int pin){
+	sim_pin_t *p = &pins[pin];
+	int level = pin_level(pin);
+
+	if(level == p->level){
+		return;
+	}
+	p->level = (uint8_t)level;
+	p->changes++;
+	if(sim_verbose){
+		int active_low = (pin == P13_7);
+
+		sim_log("%s %s", pin_name(pin), active_low ? (level ? "off" : "on") : (level ? "high" : "low"));
+	}
+}
+
+//-------------------------------------------------------------------------------------------
+// cyhal_gpio
+//-------------------------------------------------------------------------------------------
+cy_rslt_t cyhal_gpio_init(cyhal_gpio_t pin, cyhal_gpio_direction_t direction,
+                          cyhal_gpio_drive_mode_t drive_mode, bool init_val){
+	sim_pin_t *p;
+
+	if((unsigned int)pin >= SIM_NUM_PINS){
+		return CYHAL_RSLT_ERR_BAD_ARGUMENT;
+	}
+	p = &pins[pin];
+	if(p->used || p->pwm != NULL){
+		return CYHAL_RSLT_ERR_RESOURCE_IN_USE;
+	}
+	p->used = 1;
+	p->direction = (uint8_t)direction;
+	p->drive = (uint8_t)drive_mode;
+	p->out = init_val;
+	p->level = (uint8_t)pin_level(pin);
+	if(dht.pin == (int)pin){
+		dht_host_write(p->out);
+	}
+	return CY_RSLT_SUCCESS;
+}
+
+void cyhal_gpio_free(cyhal_gpio_t pin){
+	if((unsigned int)pin < SIM_NUM_PINS){
+		pins[pin].used = 0;
+	}
+}
+
+void cyhal_gpio_write(cyhal_gpio_t pin, bool value){
+	sim_pin_t *p;
+
+	if((unsigned int)pin >= SIM_NUM_PINS){
+		return;
+	}
+	p = &pins[pin];
+	p->out = value;
+	if(dht.pin == (int)pin && p->direction != CYHAL_GPIO_DIR_INPUT){
+		dht_host_write(value);
+	}
+	pin_update(pin);
+}
+
+bool cyhal_gpio_read(cyhal_gpio_t pin){
+	if((unsigned int)pin >= SIM_NUM_PINS){
+		return false;
+	}
+	return pin_level(pin) != 0;
+}
+
+void cyhal_gpio_toggle(cyhal_gpio_t pin){
+	if((unsigned int)pin < SIM_NUM_PINS){
+		cyhal_gpio_write(pin, !pins[pin].out);
+	}
+}
+
+//-------------------------------------------------------------------------------------------
+// cyhal_pwm
+//-------------------------------------------------------------------------------------------
+cy_rslt_t cyhal_pwm_init(cyhal_pwm_t *obj, cyhal_gpio_t pin, const cyhal_clock_t *clk){
+	(void)clk;
+	if((unsigned int)pin >= SIM_NUM_PINS){
+		return CYHAL_RSLT_ERR_BAD_ARGUMENT;
+	}
+	if(pins[pin].used || pins[pin].pwm != NULL){
+		return CYHAL_RSLT_ERR_RESOURCE_IN_USE;
+	}
+	obj->pin = pin;
+	obj->duty_cycle = 0.0f;
+	obj->frequency_hz = 0;
+	obj->running = false;
+	pins[pin].pwm = obj;
+	pins[pin].level = (uint8_t)pin_level(pin);
+	return CY_RSLT_SUCCESS;
+}
+
+void cyhal_pwm_free(cyhal_pwm_t *obj){
+	if((unsigned int)obj->pin < SIM_NUM_PINS){
+		pins[obj->pin].pwm = NULL;
+	}
+}
+
+cy_rslt_t cyhal_pwm_set_duty_cycle(cyhal_pwm_t *obj, float duty_cycle, uint32_t frequencyhal_hz){
+	if(duty_cycle < 0.0f || duty_cycle > 100.0f || frequencyhal_hz == 0){
+		return CYHAL_RSLT_ERR_BAD_ARGUMENT;
+	}
+	obj->duty_cycle = duty_cycle;
+	obj->frequency_hz = frequencyhal_hz;
+	pin_update(obj->pin);
+	return CY_RSLT_SUCCESS;
+}
+
+cy_rslt_t cyhal_pwm_start(cyhal_pwm_t *obj){
+	obj->running = true;
+	pin_update(obj->pin);
+	return CY_RSLT_SUCCESS;
+}
+
+cy_rslt_t cyhal_pwm_stop(cyhal_pwm_t *obj){
+	obj->running = false;
+	pin_update(obj->pin);
+	return CY_RSLT_SUCCESS;
+}
+
+//-------------------------------------------------------------------------------------------
+// Trace commands
+//-------------------------------------------------------------------------------------------
+// "<pin>=<on|off|0|1>": the pin and the line level
+static int parse_level(const char *arg, int *pin, int *level){
+	char name[32];
+	const char *eq = strchr(arg, '=');
+	int active_low;
+
+	if(eq == NULL || (size_t)(eq - arg) >= sizeof(name)){
+		return -1;
+	}
+	memcpy(name, arg, (size_t)(eq - arg));
+	name[eq - arg] = '\0';
+	*pin = sim_parse_pin(name, &active_low);
+	if(*pin < 0){
+		return -1;
+	}
+	if(strcmp(eq + 1, "1") == 0){
+		*level = 1;
+	}
+	else if(strcmp(eq + 1, "0") == 0){
+		*level = 0;
+	}
+	else if(strcmp(eq + 1, "on") == 0){
+		*level = !active_low;
+	}
+	else if(strcmp(eq + 1, "off") == 0){
+		*level = active_low;
+	}
+	else{
+		return -1;
+	}
+	return 0;
+}
+
+int sim_gpio_command_set(int argc, char **argv, int apply){
+	int pin, level;
+
+	if(argc < 2){
+		return -1;
+	}
+	for(int i = 1; i < argc; i++){
+		if(parse_level(argv[i], &pin, &level) != 0){
+			sim_check_failed("bad level '%s'", argv[i]);
+			return -1;
+		}
+		if(apply){
+			pins[pin].ext = (int8_t)level;
+			if(sim_verbose){
+				sim_log("set %s %d", pin_name(pin), level);
+			}
+		}
+	}
+	return 0;
+}
+
+int sim_gpio_command_expect(int argc, char **argv, int apply){
+	int pin, level;
+	int failed = 0;
+
+	if(argc < 2){
+		return -1;
+	}
+	for(int i = 1; i < argc; i++){
+		if(parse_level(argv[i], &pin, &level) != 0){
+			sim_check_failed("bad level '%s'", argv[i]);
+			return -1;
+		}
+		if(apply && pin_level(pin) != level && !failed){
+			sim_check_failed("%s is %d, expected %d", pin_name(pin), pin_level(pin), level);
+			failed = 1;
+		}
+	}
+	return failed ? -1 : 0;
+}
+
+int sim_gpio_command_dht(int argc, char **argv, int apply){
+	double humidity, temperature;
+	int active_low, pin;
+	char *end;
+
+	if(argc < 3 || (pin = sim_parse_pin(argv[1], &active_low)) < 0){
+		return -1;
+	}
+	if(argc == 3 && strcmp(argv[2], "off") == 0){
+		if(apply){
+			dht.pin = -1;
+			dht.next_edge = DHT_EDGES;
+		}
+		return 0;
+	}
+	if(argc != 4){
+		return -1;
+	}
+	humidity = strtod(argv[2], &end);
+	if(*end != '\0' || humidity < 0.0 || humidity > 100.0){
+		sim_check_failed("humidity %s not in 0..100", argv[2]);
+		return -1;
+	}
+	temperature = strtod(argv[3], &end);
+	if(*end != '\0' || temperature < 0.0 || temperature >= 60.0){
+		sim_check_failed("temperature %s not in 0..60", argv[3]);
+		return -1;
+	}
+	if(apply){
+		uint32_t tenths = (uint32_t)(temperature * 10.0 + 0.5);
+
+		dht.pin = pin;
+		dht.bytes[0] = (uint8_t)(humidity + 0.5);
+		dht.bytes[1] = 0;
+		dht.bytes[2] = (uint8_t)(tenths / 10u);
+		dht.bytes[3] = (uint8_t)(tenths % 10u);
+		dht.bytes[4] = (uint8_t)(dht.bytes[0] + dht.bytes[1] + dht.bytes[2] + dht.bytes[3]);
+		if(sim_verbose){
+			sim_log("dht on %s: %u %%, %u.%u C", pin_name(pin), dht.bytes[0], dht.bytes[2], dht.bytes[3]);
+		}
+	}
+	return 0;
+}
+
+//-------------------------------------------------------------------------------------------
+// Model
+//-------------------------------------------------------------------------------------------
+static uint64_t gpio_next_event(void){
+	return SIM_NEVER;
+}
+
+static void gpio_run(uint64_t now){
+	(void)now;
+}
+
+static void gpio_report(void){
+	for(int pin = 0; pin < (int)SIM_NUM_PINS; pin++){
+		if(pins[pin].changes != 0){
+			fprintf(stderr, "gpio %s: %u changes, ends %s\n", pin_name(pin), pins[pin].changes,
+			        pin_level(pin) ? "high" : "low");
+		}
+	}
+	if(dht.answers != 0 || dht.short_starts != 0){
+		fprintf(stderr, "dht11: %u answers, %u start pulses shorter than 18 ms\n", dht.answers,
+		        dht.short_starts);
+	}
+}
+
+const sim_model_t sim_gpio_model = { "gpio", gpio_next_event, gpio_run, gpio_report };
@@ -0,0 +1,322 @@
+/***********************************************************
+Title: Timer model of psoc_sim.
+Description: cyhal_timer on TCPWM counters clocked at the
+				frequency the application sets (1 MHz until
+				then). A counter with period P takes P + 1
+				clocks per cycle; counting up it reaches the
+				terminal count at P and wraps to 0, counting
+				down it reaches it at 0 and reloads P. The
+				terminal count and, in compare mode, the
+				compare match raise the counter's interrupt
+				(tcpwm_0_interrupts_0_IRQn + counter) with
+				the priority given to cyhal_timer_enable_event;
+				its handler calls the registered callback with
+				the events that happened. A one-shot counter
+				stops at the terminal count. Stopping keeps
+				the count, starting again continues from it.
+************************************************************/
+
+#include <stdio.h>
+#include <string.h>
+
+#include "cyhal.h"
+#include "psoc_sim.h"
+
+#define SIM_TIMERS          8
+#define TIMER_DEFAULT_HZ    1000000u
+
+typedef struct {
+	uint8_t used;
+	uint8_t running;
+	cyhal_timer_cfg_t cfg;
+	uint32_t frequency_hz;
+	uint32_t count;                     // counter value at 'start'
+	uint64_t start;                     // time 'count' was taken while running
+	uint64_t tc_tick;                   // clocks after 'start' of the next terminal count
+	uint64_t cc_tick;                   // and of the next compare match
+	cyhal_timer_event_callback_t callback;
+	void *callback_arg;
+	uint32_t events;                    // enabled events
+	uint32_t pending;                   // events the handler has not passed on yet
+	uint32_t priority;
+	uint32_t terminal_counts;
+	uint32_t compares;
+} sim_tcpwm_t;
+
+static sim_tcpwm_t timers[SIM_TIMERS];
+
+static uint64_t tick_time(const sim_tcpwm_t *t, uint64_t tick){
+	return t->start + (uint64_t)(((unsigned __int128)tick * 1000000000u) / t->frequency_hz);
+}
+
+static uint64_t ticks_since_start(const sim_tcpwm_t *t, uint64_t now){
+	return (uint64_t)(((unsigned __int128)(now - t->start) * t->frequency_hz) / 1000000000u);
+}
+
+static uint32_t current_count(const sim_tcpwm_t *t){
+	uint64_t cycle = (uint64_t)t->cfg.period + 1u;
+	uint64_t ticks;
+
+	if(!t->running){
+		return t->count;
+	}
+	ticks = ticks_since_start(t, sim_now()) % cycle;
+	if(t->cfg.direction == CYHAL_TIMER_DIR_DOWN){
+		return (uint32_t)(((uint64_t)t->count + cycle - ticks) % cycle);
+	}
+	return (uint32_t)(((uint64_t)t->count + ticks) % cycle);
+}
+
+// Clocks from 'from' to 'to' in the counting direction, 1 ... P + 1
+static uint64_t clocks_to(const sim_tcpwm_t *t, uint32_t from, uint32_t to){
+	uint64_t cycle = (uint64_t)t->cfg.period + 1u;
+	uint64_t n;
+
+	if(t->cfg.direction == CYHAL_TIMER_DIR_DOWN){
+		n = ((uint64_t)from + cycle - to) % cycle;
+	}
+	else{
+		n = ((uint64_t)to + cycle - from) % cycle;
+	}
+	return n == 0 ? cycle : n;
+}
+
+static void restart(sim_tcpwm_t *t){
+	uint32_t terminal = t->cfg.direction == CYHAL_TIMER_DIR_DOWN ? 0u : t->cfg.period;
+
+	t->start = sim_now();
+	t->tc_tick = clocks_to(t, t->count, terminal);
+	t->cc_tick = t->cfg.is_compare ? clocks_to(t, t->count, t->cfg.compare_value) : SIM_NEVER;
+}
+
+static void timer_handler(int index){
+	sim_tcpwm_t *t = &timers[index];
+	uint32_t events = t->pending & t->events;
+
+	t->pending = 0;
+	if(events != 0 && t->callback != NULL){
+		t->callback(t->callback_arg, (cyhal_timer_event_t)events);
+	}
+}
+
+#define TIMER_HANDLER(n) static void timer_handler_##n(void){ timer_handler(n); }
+TIMER_HANDLER(0) TIMER_HANDLER(1) TIMER_HANDLER(2) TIMER_HANDLER(3)
+TIMER_HANDLER(4) TIMER_HANDLER(5) TIMER_HANDLER(6) TIMER_HANDLER(7)
+
+static void (*const handlers[SIM_TIMERS])(void) = {
+	timer_handler_0, timer_handler_1, timer_handler_2, timer_handler_3,
+	timer_handler_4, timer_handler_5, timer_handler_6, timer_handler_7
+};
+
+static const char *const handler_names[SIM_TIMERS] = {
+	"tcpwm timer 0", "tcpwm timer 1", "tcpwm timer 2", "tcpwm timer 3",
+	"tcpwm timer 4", "tcpwm timer 5", "tcpwm timer 6", "tcpwm timer 7"
+};
+
+static sim_tcpwm_t *timer_of(const cyhal_timer_t *obj){
+	if(obj == NULL || obj->index < 0 || obj->index >= SIM_TIMERS || !timers[obj->index].used){
+		return NULL;
+	}
+	return &timers[obj->index];
+}
+
+//-------------------------------------------------------------------------------------------
+// cyhal_timer
+//-------------------------------------------------------------------------------------------
+cy_rslt_t cyhal_timer_init(cyhal_timer_t *obj, cyhal_gpio_t pin, const cyhal_clock_t *clk){
+	(void)pin;
+	for(int i = 0; i < SIM_TIMERS; i++){
+		sim_tcpwm_t *t = &timers[i];
+
+		if(!t->used){
+			memset(t, 0, sizeof(*t));
+			t->used = 1;
+			t->frequency_hz = clk != NULL && clk->frequency_hz != 0 ? clk->frequency_hz : TIMER_DEFAULT_HZ;
+			t->cfg.period = 0xFFFFFFFFu;
+			t->cfg.is_continuous = true;
+			obj->index = i;
+			return CY_RSLT_SUCCESS;
+		}
+	}
+	obj->index = -1;
+	return CYHAL_RSLT_ERR_RESOURCE_IN_USE;
+}
+
+void cyhal_timer_free(cyhal_timer_t *obj){
+	sim_tcpwm_t *t = timer_of(obj);
+
+	if(t != NULL){
+		sim_irq_enable(tcpwm_0_interrupts_0_IRQn + obj->index, 0);
+		t->used = 0;
+		t->running = 0;
+	}
+	obj->index = -1;
+}
+
+cy_rslt_t cyhal_timer_configure(cyhal_timer_t *obj, const cyhal_timer_cfg_t *cfg){
+	sim_tcpwm_t *t = timer_of(obj);
+
+	if(t == NULL || cfg == NULL || cfg->direction == CYHAL_TIMER_DIR_UP_DOWN || cfg->value > cfg->period ||
+	   (cfg->is_compare && cfg->compare_value > cfg->period)){
+		return CYHAL_RSLT_ERR_BAD_ARGUMENT;
+	}
+	t->cfg = *cfg;
+	t->count = cfg->value;
+	if(t->running){
+		restart(t);
+	}
+	return CY_RSLT_SUCCESS;
+}
+
+cy_rslt_t cyhal_timer_set_frequency(cyhal_timer_t *obj, uint32_t hz){
+	sim_tcpwm_t *t = timer_of(obj);
+
+	if(t == NULL || hz == 0){
+		return CYHAL_RSLT_ERR_BAD_ARGUMENT;
+	}
+	t->count = current_count(t);
+	t->frequency_hz = hz;
+	if(t->running){
+		restart(t);
+	}
+	return CY_RSLT_SUCCESS;
+}
+
+cy_rslt_t cyhal_timer_start(cyhal_timer_t *obj){
+	sim_tcpwm_t *t = timer_of(obj);
+
+	if(t == NULL){
+		return CYHAL_RSLT_ERR_BAD_ARGUMENT;
+	}
+	if(!t->running){
+		t->running = 1;
+		restart(t);
+	}
+	return CY_RSLT_SUCCESS;
+}
+
+cy_rslt_t cyhal_timer_stop(cyhal_timer_t *obj){
+	sim_tcpwm_t *t = timer_of(obj);
+
+	if(t == NULL){
+		return CYHAL_RSLT_ERR_BAD_ARGUMENT;
+	}
+	t->count = current_count(t);
+	t->running = 0;
+	return CY_RSLT_SUCCESS;
+}
+
+cy_rslt_t cyhal_timer_reset(cyhal_timer_t *obj){
+	sim_tcpwm_t *t = timer_of(obj);
+
+	if(t == NULL){
+		return CYHAL_RSLT_ERR_BAD_ARGUMENT;
+	}
+	t->count = t->cfg.value;
+	if(t->running){
+		restart(t);
+	}
+	return CY_RSLT_SUCCESS;
+}
+
+uint32_t cyhal_timer_read(const cyhal_timer_t *obj){
+	const sim_tcpwm_t *t = timer_of(obj);
+
+	return t != NULL ? current_count(t) : 0u;
+}
+
+void cyhal_timer_register_callback(cyhal_timer_t *obj, cyhal_timer_event_callback_t callback, void *callback_arg){
+	sim_tcpwm_t *t = timer_of(obj);
+
+	if(t != NULL){
+		t->callback = callback;
+		t->callback_arg = callback_arg;
+	}
+}
+
+void cyhal_timer_enable_event(cyhal_timer_t *obj, cyhal_timer_event_t event, uint8_t intr_priority, bool enable){
+	sim_tcpwm_t *t = timer_of(obj);
+	int irq;
+
+	if(t == NULL){
+		return;
+	}
+	irq = tcpwm_0_interrupts_0_IRQn + obj->index;
+	if(enable){
+		t->events |= (uint32_t)event;
+	}
+	else{
+		t->events &= ~(uint32_t)event;
+	}
+	t->priority = intr_priority;
+	sim_irq_register(irq, handler_names[obj->index], handlers[obj->index], intr_priority);
+	sim_irq_enable(irq, t->events != 0);
+}
+
+//-------------------------------------------------------------------------------------------
+// Model
+//-------------------------------------------------------------------------------------------
+static uint64_t next_tick(const sim_tcpwm_t *t){
+	return t->tc_tick < t->cc_tick ? t->tc_tick : t->cc_tick;
+}
+
+static uint64_t timer_next_event(void){
+	uint64_t next = SIM_NEVER;
+
+	for(int i = 0; i < SIM_TIMERS; i++){
+		const sim_tcpwm_t *t = &timers[i];
+
+		if(t->used && t->running){
+			uint64_t time = tick_time(t, next_tick(t));
+
+			if(time < next){
+				next = time;
+			}
+		}
+	}
+	return next;
+}
+
+static void timer_run(uint64_t now){
+	for(int i = 0; i < SIM_TIMERS; i++){
+		sim_tcpwm_t *t = &timers[i];
+		uint64_t cycle = (uint64_t)t->cfg.period + 1u;
+
+		while(t->used && t->running && tick_time(t, next_tick(t)) <= now){
+			uint64_t tick = next_tick(t);
+			uint32_t events = 0;
+
+			if(t->cc_tick == tick){
+				events |= CYHAL_TIMER_IRQ_CAPTURE_COMPARE;
+				t->cc_tick += cycle;
+				t->compares++;
+			}
+			if(t->tc_tick == tick){
+				events |= CYHAL_TIMER_IRQ_TERMINAL_COUNT;
+				t->tc_tick += cycle;
+				t->terminal_counts++;
+				if(!t->cfg.is_continuous){
+					t->count = t->cfg.direction == CYHAL_TIMER_DIR_DOWN ? 0u : t->cfg.period;
+					t->running = 0;
+				}
+			}
+			t->pending |= events;
+			if(events & t->events){
+				sim_irq_raise(tcpwm_0_interrupts_0_IRQn + i);
+			}
+		}
+	}
+}
+
+static void timer_report(void){
+	for(int i = 0; i < SIM_TIMERS; i++){
+		const sim_tcpwm_t *t = &timers[i];
+
+		if(t->used){
+			fprintf(stderr, "timer %d: %u Hz, period %u, %u terminal counts, %u compare matches\n", i,
+			        t->frequency_hz, t->cfg.period, t->terminal_counts, t->compares);
+		}
+	}
+}
+
+const sim_model_t sim_timer_model = { "timer", timer_next_event, timer_run, timer_report };
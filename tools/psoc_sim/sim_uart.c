@@ -0,0 +1,506 @@
+/***********************************************************
+Title: UART model of psoc_sim.
+Description: The debug UART of retarget-io and the cyhal_uart
+				calls on it. A byte takes 10 bit times at the
+				baud rate. Blocking output (printf, putc,
+				write) returns once what is left to send fits
+				the 128-byte TX FIFO; write_async returns at
+				once and the transfer stays active, refusing
+				another one, until its last byte is out. Its
+				buffer is read when the transfer ends, as the
+				DMA would. Polling cyhal_uart_is_tx_active()
+				takes SIM_POLL_NS.
+				Received bytes arrive at the byte time of the
+				baud rate into a 128-byte RX FIFO; bytes that
+				find it full are lost and counted.
+				getc() waits for ever with a timeout of 0.
+				The bytes come from the trace, or from a
+				pseudo-terminal (-p) that a terminal program
+				or the scope client opens like the kit's
+				KitProg3 port; what the UART sends goes there,
+				to a file (-o) or to the standard output.
+				Trace commands:
+				  send <text>   the text and CR LF arrive
+				  sent <text>   check that the UART sent the text
+				                since the last match; a space
+				                matches any run of spaces
+************************************************************/
+
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <termios.h>
+
+#include "cyhal.h"
+#include "cy_retarget_io.h"
+#include "psoc_sim.h"
+
+#undef printf
+
+#define UART_FIFO_BYTES     128u
+#define UART_PTY_POLL_NS    SIM_NS_PER_MS
+#define UART_LOG_MAX        (1u << 20)     // sent text kept for the 'sent' checks
+#define UART_PRINTF_MAX     1024u
+
+cyhal_uart_t cy_retarget_io_uart_obj;
+
+typedef struct {
+	uint64_t time;
+	uint8_t byte;
+} sim_rx_byte_t;
+
+static struct {
+	int fd;                             // where the sent bytes go, -1 for nowhere
+	int pty;
+	uint64_t next_poll;
+	uint64_t tx_free_at;                // the transmitter has sent everything queued
+	const uint8_t *async_data;          // transfer in progress, read when it ends
+	size_t async_length;
+	uint64_t async_end;
+	uint8_t rx_fifo[UART_FIFO_BYTES];
+	uint32_t rx_head, rx_count;
+	sim_rx_byte_t *rx_pending;          // bytes on the line, in arrival order
+	size_t rx_pending_count, rx_pending_first, rx_pending_size;
+	uint64_t rx_line_free_at;
+	char *log;                          // sent text for 'sent'
+	size_t log_length, log_checked;
+	uint64_t tx_bytes, tx_dropped, rx_bytes, rx_overruns;
+} uart = { .fd = -1, .async_end = SIM_NEVER };
+
+static uint64_t byte_ns(void){
+	uint32_t baud = cy_retarget_io_uart_obj.baud ? cy_retarget_io_uart_obj.baud : CY_RETARGET_IO_BAUDRATE;
+
+	return (10u * 1000000000ull + baud - 1u) / baud;
+}
+
+//-------------------------------------------------------------------------------------------
+// Backend
+//-------------------------------------------------------------------------------------------
+int sim_uart_open(const char *output_path, int use_pty){
+	if(use_pty){
+		struct termios raw;
+		int slave;
+
+		uart.fd = posix_openpt(O_RDWR | O_NOCTTY);
+		if(uart.fd < 0 || grantpt(uart.fd) != 0 || unlockpt(uart.fd) != 0){
+			perror("posix_openpt");
+			return -1;
+		}
+		// Kept open so the pty survives the terminal program closing it
+		slave = open(ptsname(uart.fd), O_RDWR | O_NOCTTY);
+		if(slave < 0 || tcgetattr(slave, &raw) != 0){
+			perror(ptsname(uart.fd));
+			return -1;
+		}
+		cfmakeraw(&raw);
+		tcsetattr(slave, TCSANOW, &raw);
+		fcntl(uart.fd, F_SETFL, fcntl(uart.fd, F_GETFL) | O_NONBLOCK);
+		uart.pty = 1;
+		fprintf(stderr, "uart: %s\n", ptsname(uart.fd));
+	}
+	else if(output_path != NULL){
+		uart.fd = open(output_path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+		if(uart.fd < 0){
+			perror(output_path);
+			return -1;
+		}
+	}
+	else{
+		uart.fd = STDOUT_FILENO;
+	}
+	return 0;
+}
+
+static void log_append(const uint8_t *data, size_t length){
+	if(uart.log == NULL){
+		uart.log = malloc(UART_LOG_MAX);
+		if(uart.log == NULL){
+			return;
+		}
+	}
+	if(length > UART_LOG_MAX / 2u){
+		data += length - UART_LOG_MAX / 2u;
+		length = UART_LOG_MAX / 2u;
+	}
+	// Full: keep the newer half
+	if(uart.log_length + length > UART_LOG_MAX){
+		size_t drop = uart.log_length - UART_LOG_MAX / 2u;
+
+		memmove(uart.log, uart.log + drop, uart.log_length - drop);
+		uart.log_length -= drop;
+		uart.log_checked = uart.log_checked > drop ? uart.log_checked - drop : 0u;
+	}
+	memcpy(uart.log + uart.log_length, data, length);
+	uart.log_length += length;
+}
+
+static void output(const uint8_t *data, size_t length){
+	uart.tx_bytes += length;
+	log_append(data, length);
+	while(uart.fd >= 0 && length != 0u){
+		ssize_t n = write(uart.fd, data, length);
+
+		if(n < 0){
+			if(errno == EINTR){
+				continue;
+			}
+			// A pty nobody reads: the bytes are lost, as on a port without a terminal
+			uart.tx_dropped += length;
+			return;
+		}
+		data += n;
+		length -= (size_t)n;
+	}
+}
+
+static void async_finish(void){
+	if(uart.async_data != NULL){
+		output(uart.async_data, uart.async_length);
+		uart.async_data = NULL;
+		uart.async_end = SIM_NEVER;
+	}
+}
+
+// Bytes arriving on the line after those already on their way
+static void rx_queue(const uint8_t *data, size_t length){
+	uint64_t t = uart.rx_line_free_at > sim_now() ? uart.rx_line_free_at : sim_now();
+
+	if(uart.rx_pending_count + length > uart.rx_pending_size){
+		size_t size = (uart.rx_pending_count + length) * 2u;
+		sim_rx_byte_t *pending = malloc(size * sizeof(sim_rx_byte_t));
+
+		if(pending == NULL){
+			return;
+		}
+		memcpy(pending, uart.rx_pending + uart.rx_pending_first, uart.rx_pending_count * sizeof(sim_rx_byte_t));
+		free(uart.rx_pending);
+		uart.rx_pending = pending;
+		uart.rx_pending_first = 0;
+		uart.rx_pending_size = size;
+	}
+	else if(uart.rx_pending_first + uart.rx_pending_count + length > uart.rx_pending_size){
+		memmove(uart.rx_pending, uart.rx_pending + uart.rx_pending_first,
+		        uart.rx_pending_count * sizeof(sim_rx_byte_t));
+		uart.rx_pending_first = 0;
+	}
+	for(size_t i = 0; i < length; i++){
+		sim_rx_byte_t *b = &uart.rx_pending[uart.rx_pending_first + uart.rx_pending_count++];
+
+		t += byte_ns();
+		b->time = t;
+		b->byte = data[i];
+	}
+	uart.rx_line_free_at = t;
+}
+
+static void poll_pty(void){
+	uint8_t buffer[256];
+	ssize_t n;
+
+	while((n = read(uart.fd, buffer, sizeof(buffer))) > 0){
+		rx_queue(buffer, (size_t)n);
+	}
+}
+
+//-------------------------------------------------------------------------------------------
+// Transmit
+//-------------------------------------------------------------------------------------------
+// Queue bytes behind those being sent and wait until the rest fits the FIFO
+static void transmit(const uint8_t *data, size_t length){
+	uint64_t now = sim_now();
+	uint64_t fifo = UART_FIFO_BYTES * byte_ns();
+	uint64_t start = uart.tx_free_at > now ? uart.tx_free_at : now;
+
+	if(!cy_retarget_io_uart_obj.open){
+		return;
+	}
+	async_finish();
+	output(data, length);
+	uart.tx_free_at = start + length * byte_ns();
+	if(uart.tx_free_at > now + fifo){
+		sim_advance_to(uart.tx_free_at - fifo);
+	}
+}
+
+int sim_uart_printf(const char *format, ...){
+	char text[UART_PRINTF_MAX];
+	va_list args;
+	int n;
+
+	va_start(args, format);
+	n = vsnprintf(text, sizeof(text), format, args);
+	va_end(args);
+	if(n > 0){
+		transmit((const uint8_t *)text, (size_t)n < sizeof(text) ? (size_t)n : sizeof(text) - 1u);
+	}
+	return n;
+}
+
+cy_rslt_t cyhal_uart_putc(cyhal_uart_t *obj, uint32_t value){
+	uint8_t byte = (uint8_t)value;
+
+	(void)obj;
+	transmit(&byte, 1);
+	return CY_RSLT_SUCCESS;
+}
+
+cy_rslt_t cyhal_uart_write(cyhal_uart_t *obj, void *tx, size_t *tx_length){
+	(void)obj;
+	transmit(tx, *tx_length);
+	return CY_RSLT_SUCCESS;
+}
+
+cy_rslt_t cyhal_uart_write_async(cyhal_uart_t *obj, void *tx, size_t length){
+	uint64_t now = sim_now();
+	uint64_t start = uart.tx_free_at > now ? uart.tx_free_at : now;
+
+	if(!obj->open){
+		return CYHAL_RSLT_ERR_BAD_ARGUMENT;
+	}
+	if(uart.async_data != NULL){
+		return CYHAL_RSLT_ERR_BUSY;
+	}
+	uart.async_data = tx;
+	uart.async_length = length;
+	uart.tx_free_at = start + length * byte_ns();
+	uart.async_end = uart.tx_free_at;
+	return CY_RSLT_SUCCESS;
+}
+
+bool cyhal_uart_is_tx_active(cyhal_uart_t *obj){
+	bool active = sim_now() < uart.tx_free_at;
+
+	(void)obj;
+	if(active){
+		sim_advance_by(SIM_POLL_NS);
+	}
+	return active;
+}
+
+uint32_t cyhal_uart_writable(cyhal_uart_t *obj){
+	uint64_t now = sim_now();
+	uint64_t queued;
+
+	(void)obj;
+	if(uart.tx_free_at <= now){
+		return UART_FIFO_BYTES;
+	}
+	queued = (uart.tx_free_at - now + byte_ns() - 1u) / byte_ns();
+	return queued >= UART_FIFO_BYTES ? 0u : UART_FIFO_BYTES - (uint32_t)queued;
+}
+
+//-------------------------------------------------------------------------------------------
+// Receive
+//-------------------------------------------------------------------------------------------
+uint32_t cyhal_uart_readable(cyhal_uart_t *obj){
+	(void)obj;
+	return uart.rx_count;
+}
+
+static uint8_t rx_pop(void){
+	uint8_t byte = uart.rx_fifo[uart.rx_head];
+
+	uart.rx_head = (uart.rx_head + 1u) % UART_FIFO_BYTES;
+	uart.rx_count--;
+	return byte;
+}
+
+cy_rslt_t cyhal_uart_getc(cyhal_uart_t *obj, uint8_t *value, uint32_t timeout){
+	uint64_t deadline = timeout == 0u ? SIM_NEVER : sim_now() + (uint64_t)timeout * SIM_NS_PER_MS;
+
+	(void)obj;
+	while(uart.rx_count == 0u){
+		if(sim_now() >= deadline){
+			return CYHAL_RSLT_ERR_TIMEOUT;
+		}
+		sim_wait(deadline);
+	}
+	*value = rx_pop();
+	return CY_RSLT_SUCCESS;
+}
+
+cy_rslt_t cyhal_uart_read(cyhal_uart_t *obj, void *rx, size_t *rx_length){
+	size_t n = 0;
+
+	(void)obj;
+	while(n < *rx_length && uart.rx_count != 0u){
+		((uint8_t *)rx)[n++] = rx_pop();
+	}
+	*rx_length = n;
+	return CY_RSLT_SUCCESS;
+}
+
+cy_rslt_t cyhal_uart_clear(cyhal_uart_t *obj){
+	(void)obj;
+	uart.rx_count = 0;
+	return CY_RSLT_SUCCESS;
+}
+
+//-------------------------------------------------------------------------------------------
+// Configuration and retarget-io
+//-------------------------------------------------------------------------------------------
+cy_rslt_t cyhal_uart_set_baud(cyhal_uart_t *obj, uint32_t baudrate, uint32_t *actualbaud){
+	if(baudrate == 0u){
+		return CYHAL_RSLT_ERR_BAD_ARGUMENT;
+	}
+	obj->baud = baudrate;
+	if(actualbaud != NULL){
+		*actualbaud = baudrate;
+	}
+	return CY_RSLT_SUCCESS;
+}
+
+cy_rslt_t cyhal_uart_set_async_mode(cyhal_uart_t *obj, cyhal_async_mode_t mode, uint8_t dma_priority){
+	(void)dma_priority;
+	obj->async_mode = mode;
+	return CY_RSLT_SUCCESS;
+}
+
+cy_rslt_t cy_retarget_io_init_fc(cyhal_gpio_t tx, cyhal_gpio_t rx, cyhal_gpio_t cts, cyhal_gpio_t rts,
+                                 uint32_t baudrate){
+	cyhal_uart_t *obj = &cy_retarget_io_uart_obj;
+
+	if(tx == NC || rx == NC || baudrate == 0u){
+		return CYHAL_RSLT_ERR_BAD_ARGUMENT;
+	}
+	obj->tx = tx;
+	obj->rx = rx;
+	obj->cts = cts;
+	obj->rts = rts;
+	obj->baud = baudrate;
+	obj->async_mode = CYHAL_ASYNC_SW;
+	obj->open = true;
+	return CY_RSLT_SUCCESS;
+}
+
+cy_rslt_t cy_retarget_io_init(cyhal_gpio_t tx, cyhal_gpio_t rx, uint32_t baudrate){
+	return cy_retarget_io_init_fc(tx, rx, NC, NC, baudrate);
+}
+
+void cy_retarget_io_deinit(void){
+	async_finish();
+	cy_retarget_io_uart_obj.open = false;
+}
+
+//-------------------------------------------------------------------------------------------
+// Trace commands
+//-------------------------------------------------------------------------------------------
+int sim_uart_command_send(int argc, char **argv, int apply){
+	if(apply){
+		for(int i = 1; i < argc; i++){
+			if(i > 1){
+				rx_queue((const uint8_t *)" ", 1);
+			}
+			rx_queue((const uint8_t *)argv[i], strlen(argv[i]));
+		}
+		rx_queue((const uint8_t *)"\r\n", 2);
+		if(sim_verbose){
+			sim_log("send %d words", argc - 1);
+		}
+	}
+	return 0;
+}
+
+// Length of the match of 'words' at 'text', 0 if none; a space between the
+// words matches any run of spaces or tabs
+static size_t match_at(const char *text, size_t length, int argc, char **argv){
+	size_t pos = 0;
+
+	for(int i = 1; i < argc; i++){
+		size_t n = strlen(argv[i]);
+
+		if(i > 1){
+			size_t spaces = 0;
+
+			while(pos + spaces < length && (text[pos + spaces] == ' ' || text[pos + spaces] == '\t')){
+				spaces++;
+			}
+			if(spaces == 0){
+				return 0;
+			}
+			pos += spaces;
+		}
+		if(pos + n > length || memcmp(text + pos, argv[i], n) != 0){
+			return 0;
+		}
+		pos += n;
+	}
+	return pos;
+}
+
+int sim_uart_command_sent(int argc, char **argv, int apply){
+	if(argc < 2){
+		return -1;
+	}
+	if(!apply){
+		return 0;
+	}
+	async_finish();
+	for(size_t at = uart.log_checked; at < uart.log_length; at++){
+		size_t n = match_at(uart.log + at, uart.log_length - at, argc, argv);
+
+		if(n != 0){
+			uart.log_checked = at + n;
+			return 0;
+		}
+	}
+	sim_check_failed("\"%s%s\" not sent since the last match", argv[1], argc > 2 ? " ..." : "");
+	return -1;
+}
+
+//-------------------------------------------------------------------------------------------
+// Model
+//-------------------------------------------------------------------------------------------
+static uint64_t uart_next_event(void){
+	uint64_t next = uart.async_end;
+
+	if(uart.rx_pending_count != 0u && uart.rx_pending[uart.rx_pending_first].time < next){
+		next = uart.rx_pending[uart.rx_pending_first].time;
+	}
+	if(uart.pty && uart.next_poll < next){
+		next = uart.next_poll;
+	}
+	return next;
+}
+
+static void uart_run(uint64_t now){
+	if(uart.async_end <= now){
+		async_finish();
+	}
+	if(uart.pty && uart.next_poll <= now){
+		poll_pty();
+		uart.next_poll = now + UART_PTY_POLL_NS;
+	}
+	while(uart.rx_pending_count != 0u && uart.rx_pending[uart.rx_pending_first].time <= now){
+		uint8_t byte = uart.rx_pending[uart.rx_pending_first].byte;
+
+		uart.rx_pending_first++;
+		uart.rx_pending_count--;
+		uart.rx_bytes++;
+		if(!cy_retarget_io_uart_obj.open || uart.rx_count == UART_FIFO_BYTES){
+			uart.rx_overruns++;
+			continue;
+		}
+		uart.rx_fifo[(uart.rx_head + uart.rx_count) % UART_FIFO_BYTES] = byte;
+		uart.rx_count++;
+	}
+}
+
+static void uart_report(void){
+	async_finish();
+	fprintf(stderr, "uart: %llu bytes sent at %u baud", (unsigned long long)uart.tx_bytes,
+	        cy_retarget_io_uart_obj.baud);
+	if(uart.tx_dropped != 0){
+		fprintf(stderr, " (%llu not read from the pty)", (unsigned long long)uart.tx_dropped);
+	}
+	fprintf(stderr, ", %llu received, %llu lost to a full FIFO\n", (unsigned long long)uart.rx_bytes,
+	        (unsigned long long)uart.rx_overruns);
+}
+
+const sim_model_t sim_uart_model = { "uart", uart_next_event, uart_run, uart_report };
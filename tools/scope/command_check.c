@@ -0,0 +1,259 @@
+/***********************************************************
+Title: Command sequence check for the oscilloscope's
+				runtime configuration.
+Description: Runs scripts of commands through
+				scope_command.c the way the firmware does:
+				the characters of every command go through
+				scope_command_input() with a CR LF ending,
+				the complete line through
+				scope_command_execute() on settings that
+				start at the firmware's reset values. Checks
+				every reply, what each command changed, and
+				that the trigger and the acquisition accept
+				the settings after every change. Exits with 1
+				on the first mismatch of a script.
+				Script lines:
+				  > <command>   send a command
+				  < <reply>     the reply expected to it
+				  = <changes>   expected changes: none, or any of
+				                capture acquire trigger output arm average
+				  # ...         comment
+Usage:
+				command_check [-v] script...
+				-v          print every command and reply
+************************************************************/
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <unistd.h>
+
+#include "scope_command.h"
+
+// Reset values of main.c
+#define RESET_RATE_HZ       500000u
+#define RESET_ACQUISITION   100u
+#define RESET_OUTPUT        SCOPE_OUTPUT_STREAM
+#define RESET_AUTO_MS       100u
+#define RESET_AVERAGE       SCOPE_AVERAGE_OFF
+#define RESET_AVERAGE_N     1u
+
+#define SCRIPT_LINE_MAX     512
+
+typedef struct {
+	const char *name;
+	uint32_t flag;
+} change_name_t;
+
+static const change_name_t change_names[] = {
+	{ "capture", SCOPE_COMMAND_CHANGED_CAPTURE },
+	{ "acquire", SCOPE_COMMAND_CHANGED_ACQUIRE },
+	{ "trigger", SCOPE_COMMAND_CHANGED_TRIGGER },
+	{ "output",  SCOPE_COMMAND_CHANGED_OUTPUT },
+	{ "arm",     SCOPE_COMMAND_ARM },
+	{ "average", SCOPE_COMMAND_CHANGED_AVERAGE },
+};
+
+static void settings_reset(scope_settings_t *settings){
+	const scope_trigger_config_t trigger = {
+		.type = SCOPE_TRIGGER_EDGE, .slope = SCOPE_TRIGGER_RISING, .mode = SCOPE_TRIGGER_AUTO,
+		.level = 2048, .hysteresis = 64, .pulse_min = 0, .pulse_max = 0,
+		.pre = 256, .post = 768, .auto_timeout = 0
+	};
+
+	settings->sample_rate_hz = RESET_RATE_HZ;
+	for(int i = 0; i < (int)SCOPE_COMMAND_SCAN_CHANNELS; i++){
+		settings->acquisition_ns[i] = RESET_ACQUISITION;
+	}
+	settings->averaging = 1;
+	settings->channel_mask = 1;
+	settings->output = RESET_OUTPUT;
+	scope_command_output_acquire(settings, settings->output);
+	settings->trigger = trigger;
+	settings->auto_ms = RESET_AUTO_MS;
+	settings->trigger.auto_timeout = scope_command_auto_samples(settings);
+	settings->average_mode = RESET_AVERAGE;
+	settings->average_frames = RESET_AVERAGE_N;
+}
+
+// "none" or a list of change names, -1 if a name is unknown
+static int64_t parse_changes(char *text){
+	uint32_t flags = 0;
+	char *word;
+
+	for(word = strtok(text, " \t"); word != NULL; word = strtok(NULL, " \t")){
+		size_t i;
+
+		if(strcmp(word, "none") == 0){
+			continue;
+		}
+		for(i = 0; i < sizeof(change_names) / sizeof(change_names[0]); i++){
+			if(strcmp(word, change_names[i].name) == 0){
+				flags |= change_names[i].flag;
+				break;
+			}
+		}
+		if(i == sizeof(change_names) / sizeof(change_names[0])){
+			return -1;
+		}
+	}
+	return flags;
+}
+
+// What the firmware does with a change, without the hardware
+static const char *apply_check(const scope_settings_t *settings, uint32_t changed){
+	static scope_trigger_t trigger;
+	static scope_average_t average;
+	scope_decimate_t decimate;
+
+	if(scope_trigger_init(&trigger, &settings->trigger) != 0){
+		return "trigger rejects the settings";
+	}
+	if(scope_decimate_init(&decimate, settings->acquire_mode, settings->acquire_factor) != 0){
+		return "acquisition rejects the settings";
+	}
+	if(scope_average_init(&average, settings->average_mode, settings->average_frames) != 0){
+		return "averaging rejects the settings";
+	}
+	if(settings->trigger.auto_timeout != scope_command_auto_samples(settings)){
+		return "AUTO timeout not updated";
+	}
+	if(settings->channel_mask == 0 || settings->averaging == 0){
+		return "no channel or no averaging";
+	}
+	if((changed & SCOPE_COMMAND_CHANGED_OUTPUT) && !(changed & SCOPE_COMMAND_CHANGED_ACQUIRE)){
+		return "output changed without the acquisition";
+	}
+	return NULL;
+}
+
+// Run one script, returns the number of failures
+static int run_script(const char *path, int verbose){
+	char line[SCRIPT_LINE_MAX];
+	char reply[SCOPE_COMMAND_REPLY_MAX];
+	scope_settings_t settings;
+	scope_command_t command;
+	uint32_t changed = 0;
+	int have_reply = 0;
+	int commands = 0;
+	int line_no = 0;
+	FILE *in;
+
+	in = fopen(path, "r");
+	if(in == NULL){
+		perror(path);
+		return 1;
+	}
+	settings_reset(&settings);
+	scope_command_init(&command);
+
+	while(fgets(line, sizeof(line), in) != NULL){
+		size_t len = strcspn(line, "\r\n");
+		char *arg = line + 1;
+
+		line[len] = '\0';
+		line_no++;
+		while(*arg == ' '){
+			arg++;
+		}
+
+		if(line[0] == '>'){
+			int complete = 0;
+			const char *p;
+
+			// Characters as the UART delivers them
+			for(p = arg; *p != '\0'; p++){
+				complete |= scope_command_input(&command, *p);
+			}
+			complete |= scope_command_input(&command, '\r');
+			complete |= scope_command_input(&command, '\n');
+			if(!complete){
+				snprintf(reply, sizeof(reply), "(no line)");
+				changed = 0;
+			}
+			else{
+				const char *error;
+
+				changed = scope_command_execute(&settings, command.line, reply);
+				error = apply_check(&settings, changed);
+				if(error != NULL){
+					fprintf(stderr, "%s:%d: \"%s\": %s\n", path, line_no, arg, error);
+					fclose(in);
+					return 1;
+				}
+			}
+			if(verbose){
+				printf("> %s\n< %s\n", arg, reply);
+			}
+			have_reply = 1;
+			commands++;
+		}
+		else if(line[0] == '<'){
+			if(!have_reply || strcmp(arg, reply) != 0){
+				fprintf(stderr, "%s:%d: expected \"%s\", got \"%s\"\n", path, line_no, arg,
+				        have_reply ? reply : "(no command)");
+				fclose(in);
+				return 1;
+			}
+		}
+		else if(line[0] == '='){
+			int64_t expected = parse_changes(arg);
+
+			if(expected < 0){
+				fprintf(stderr, "%s:%d: unknown change in \"%s\"\n", path, line_no, line);
+				fclose(in);
+				return 1;
+			}
+			if(!have_reply || (uint32_t)expected != changed){
+				fprintf(stderr, "%s:%d: expected changes 0x%02x, got 0x%02x\n", path, line_no,
+				        (unsigned int)expected, (unsigned int)changed);
+				fclose(in);
+				return 1;
+			}
+		}
+		else if(line[0] != '#' && line[0] != '\0'){
+			fprintf(stderr, "%s:%d: bad script line\n", path, line_no);
+			fclose(in);
+			return 1;
+		}
+	}
+	fclose(in);
+	printf("%s: %d commands ok\n", path, commands);
+	return 0;
+}
+
+static void usage(const char *prog){
+	fprintf(stderr, "usage: %s [-v] script...\n", prog);
+}
+
+int main(int argc, char *argv[]){
+	int verbose = 0;
+	int failed = 0;
+	int opt;
+	int i;
+
+	while((opt = getopt(argc, argv, "vh")) != -1){
+		switch(opt){
+			case 'v': verbose = 1; break;
+			default:
+				usage(argv[0]);
+				return 2;
+		}
+	}
+	if(optind == argc){
+		usage(argv[0]);
+		return 2;
+	}
+
+	for(i = optind; i < argc; i++){
+		failed += run_script(argv[i], verbose);
+	}
+	if(failed){
+		printf("%d of %d scripts failed\n", failed, argc - optind);
+		return 1;
+	}
+	return 0;
+}
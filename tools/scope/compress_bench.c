@@ -0,0 +1,312 @@
+/***********************************************************
+Title: Benchmark and round-trip check for the
+				oscilloscope's stream compression.
+Description: Runs scope_compress.c over synthetic waveforms
+				and recorded captures, split into stream
+				packets. For every waveform reports the
+				compression ratio against the samples packed
+				at 12 bits, bits per sample, the samples per
+				second the 1 Mbaud link carries either way,
+				and the cost per sample of compressing and
+				decompressing. Checks that every packet decodes
+				to its samples, that no compressed block
+				exceeds SCOPE_COMPRESS_BYTES_MAX() and that no
+				packet grows; exits with 1 otherwise.
+Usage:
+				compress_bench [options] [capture...]
+				-b          captures are raw binary (little-endian
+				            uint16 codes, scope_client -w)
+				-c <col>    CSV column holding the code (default 1,
+				            stream_decode -o)
+				-p <count>  samples per packet (default 512)
+				-r <count>  passes per timing run (default 200)
+************************************************************/
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <math.h>
+#include <time.h>
+#include <unistd.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define COST_UNIT "host cycles"
+#else
+#define COST_UNIT "host ns"
+#endif
+
+#include "scope_compress.h"
+#include "scope_stream.h"
+
+#define SAMPLE_RATE_HZ      500000.0
+#define ADC_MID             2048.0
+#define SYNTH_SAMPLES       65536
+#define CAPTURE_MAX         (1u << 22)
+#define LINK_BYTES_PER_S    100000.0    // 1 Mbaud, 10 bits per byte
+#define LINE_MAX            256
+#define PI                  3.14159265358979323846
+
+typedef struct {
+	const char *name;
+	uint16_t *samples;
+	size_t count;
+} waveform_t;
+
+typedef struct {
+	uint64_t packed_bytes;       // packets with the samples packed at 12 bits
+	uint64_t packet_bytes;       // packets as the link sends them
+	uint64_t payload_bytes;      // compressed samples alone
+	uint64_t compressed_packets;
+	uint64_t packets;
+	double encode_cost;          // per sample
+	double decode_cost;
+	int errors;
+} result_t;
+
+static uint64_t cost_now(void){
+#if defined(__x86_64__) || defined(__i386__)
+	return __rdtsc();
+#else
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+#endif
+}
+
+static uint16_t clamp_code(double v){
+	long code = lrint(v);
+
+	return (uint16_t)(code < 0 ? 0 : code > 4095 ? 4095 : code);
+}
+
+static int noise(int codes){
+	return (rand() % (2 * codes + 1)) - codes;
+}
+
+// Signals the scope sees at 500 kS/s, from best to worst case
+static void synth_dc(uint16_t *s, size_t n){
+	for(size_t i = 0; i < n; i++) s[i] = clamp_code(ADC_MID + noise(2));
+}
+
+static void synth_sine(uint16_t *s, size_t n){
+	for(size_t i = 0; i < n; i++) s[i] = clamp_code(ADC_MID + 1000.0 * sin(2.0 * PI * 1000.0 * i / SAMPLE_RATE_HZ) + noise(4));
+}
+
+static void synth_square(uint16_t *s, size_t n){
+	for(size_t i = 0; i < n; i++) s[i] = clamp_code(((i / 25) & 1 ? 3500.0 : 500.0) + noise(4));
+}
+
+static void synth_fast_sine(uint16_t *s, size_t n){
+	for(size_t i = 0; i < n; i++) s[i] = clamp_code(ADC_MID + 2000.0 * sin(2.0 * PI * 50000.0 * i / SAMPLE_RATE_HZ) + noise(4));
+}
+
+static void synth_random(uint16_t *s, size_t n){
+	for(size_t i = 0; i < n; i++) s[i] = (uint16_t)(rand() & 0xFFF);
+}
+
+static const struct {
+	const char *name;
+	void (*make)(uint16_t *, size_t);
+} synthetic[] = {
+	{ "dc +-2",            synth_dc },
+	{ "sine 1 kHz",        synth_sine },
+	{ "square 10 kHz",     synth_square },
+	{ "sine 50 kHz",       synth_fast_sine },
+	{ "random full scale", synth_random },
+};
+
+#define NUM_SYNTHETIC (sizeof(synthetic) / sizeof(synthetic[0]))
+
+static size_t load_binary(FILE *in, uint16_t *samples){
+	uint8_t pair[2];
+	size_t n = 0;
+
+	while(n < CAPTURE_MAX && fread(pair, 1, 2, in) == 2){
+		samples[n++] = (uint16_t)(pair[0] | (pair[1] << 8));
+	}
+	return n;
+}
+
+static size_t load_csv(FILE *in, uint16_t *samples, int column){
+	char line[LINE_MAX];
+	size_t n = 0;
+
+	while(n < CAPTURE_MAX && fgets(line, sizeof(line), in) != NULL){
+		char *p = line;
+		char *end;
+		long code;
+
+		for(int c = 0; c < column && p != NULL; c++){
+			p = strchr(p, ',');
+			p = p ? p + 1 : NULL;
+		}
+		if(p == NULL){
+			continue;
+		}
+		code = strtol(p, &end, 10);
+		if(end != p){
+			samples[n++] = (uint16_t)code;
+		}
+	}
+	return n;
+}
+
+static double cost_per_sample(uint64_t cost, size_t samples, long passes){
+	return (double)cost / ((double)samples * (double)passes);
+}
+
+static result_t run(const waveform_t *wave, uint32_t packet_samples, long passes){
+	static uint8_t packet[SCOPE_STREAM_PACKET_BYTES(SCOPE_STREAM_MAX_SAMPLES)];
+	static uint8_t payload[SCOPE_COMPRESS_BYTES_MAX(SCOPE_STREAM_MAX_SAMPLES)];
+	static uint16_t decoded[SCOPE_STREAM_MAX_SAMPLES];
+	result_t result = {0};
+	uint64_t start, encode = 0, decode = 0;
+	size_t at;
+
+	// Whole packets, the way scope_link.c sends them
+	for(at = 0; at < wave->count; at += packet_samples){
+		uint32_t n = (uint32_t)(wave->count - at < packet_samples ? wave->count - at : packet_samples);
+		scope_stream_header_t header = {
+			SCOPE_STREAM_FLAG_COMPRESSED, 0, (uint16_t)n, (uint32_t)SAMPLE_RATE_HZ, 1,
+			SCOPE_STREAM_NO_TRIGGER, (uint32_t)at
+		};
+		scope_stream_header_t back;
+		uint32_t length = scope_stream_encode(packet, &header, &wave->samples[at]);
+		uint32_t bound = scope_compress_encode(payload, sizeof(payload), &wave->samples[at], n);
+
+		result.packets++;
+		result.packed_bytes += SCOPE_STREAM_PACKET_BYTES(n);
+		result.packet_bytes += length;
+		result.payload_bytes += bound;
+		if(packet[3] & SCOPE_STREAM_FLAG_COMPRESSED){
+			result.compressed_packets++;
+		}
+		if(length > SCOPE_STREAM_PACKET_BYTES(n) || bound > SCOPE_COMPRESS_BYTES_MAX(n)){
+			fprintf(stderr, "%s: packet at %zu exceeds its bound\n", wave->name, at);
+			result.errors++;
+		}
+		if(scope_stream_decode(packet, length, &back, decoded) != (int32_t)length ||
+		   scope_compress_decode(payload, bound, decoded, n) != (int32_t)bound){
+			fprintf(stderr, "%s: packet at %zu does not decode\n", wave->name, at);
+			result.errors++;
+			continue;
+		}
+		for(uint32_t i = 0; i < n; i++){
+			if(decoded[i] != (wave->samples[at + i] & 0xFFFu)){
+				fprintf(stderr, "%s: sample %zu decodes to %u, not %u\n", wave->name, at + i,
+				        (unsigned int)decoded[i], (unsigned int)wave->samples[at + i]);
+				result.errors++;
+				break;
+			}
+		}
+	}
+
+	// The compressor and the decompressor alone
+	for(long pass = 0; pass < passes; pass++){
+		for(at = 0; at < wave->count; at += packet_samples){
+			uint32_t n = (uint32_t)(wave->count - at < packet_samples ? wave->count - at : packet_samples);
+			uint32_t length;
+
+			start = cost_now();
+			length = scope_compress_encode(payload, sizeof(payload), &wave->samples[at], n);
+			encode += cost_now() - start;
+			start = cost_now();
+			(void)scope_compress_decode(payload, length, decoded, n);
+			decode += cost_now() - start;
+		}
+	}
+	result.encode_cost = cost_per_sample(encode, wave->count, passes);
+	result.decode_cost = cost_per_sample(decode, wave->count, passes);
+	return result;
+}
+
+static void report(const waveform_t *wave, const result_t *r){
+	double ratio = (double)r->packed_bytes / (double)(r->packet_bytes ? r->packet_bytes : 1);
+
+	printf("%-24.24s %5.2fx %6.2f %9.0f %9.0f %5.1f%% %8.2f %8.2f\n", wave->name, ratio,
+	       8.0 * (double)r->payload_bytes / (double)wave->count,
+	       LINK_BYTES_PER_S * (double)wave->count / (double)r->packed_bytes,
+	       LINK_BYTES_PER_S * (double)wave->count / (double)r->packet_bytes,
+	       100.0 * (double)r->compressed_packets / (double)r->packets, r->encode_cost, r->decode_cost);
+}
+
+static void usage(const char *prog){
+	fprintf(stderr, "usage: %s [-b] [-c column] [-p packet_samples] [-r passes] [capture...]\n", prog);
+}
+
+int main(int argc, char *argv[]){
+	static uint16_t synth[SYNTH_SAMPLES];
+	uint16_t *capture;
+	int binary = 0;
+	int column = 1;
+	long packet_samples = 512;
+	long passes = 200;
+	int errors = 0;
+	int opt;
+
+	while((opt = getopt(argc, argv, "bc:p:r:h")) != -1){
+		switch(opt){
+			case 'b': binary = 1; break;
+			case 'c': column = atoi(optarg); break;
+			case 'p': packet_samples = atol(optarg); break;
+			case 'r': passes = atol(optarg); break;
+			default:
+				usage(argv[0]);
+				return 2;
+		}
+	}
+	if(column < 0 || packet_samples < 1 || packet_samples > (long)SCOPE_STREAM_MAX_SAMPLES || passes < 1){
+		usage(argv[0]);
+		return 2;
+	}
+
+	printf("%u samples per packet, ratio against the samples packed at 12 bits, cost in %s per sample\n\n",
+	       (unsigned int)packet_samples, COST_UNIT);
+	printf("%-24s %6s %6s %9s %9s %6s %8s %8s\n", "waveform", "ratio", "bits", "packed/s", "sent/s",
+	       "compr", "encode", "decode");
+
+	srand(1);
+	for(size_t w = 0; w < NUM_SYNTHETIC; w++){
+		waveform_t wave = { synthetic[w].name, synth, SYNTH_SAMPLES };
+		result_t r;
+
+		synthetic[w].make(synth, SYNTH_SAMPLES);
+		r = run(&wave, (uint32_t)packet_samples, passes);
+		report(&wave, &r);
+		errors += r.errors;
+	}
+
+	capture = malloc(CAPTURE_MAX * sizeof(uint16_t));
+	if(capture == NULL){
+		fprintf(stderr, "out of memory\n");
+		return 2;
+	}
+	for(int i = optind; i < argc; i++){
+		FILE *in = fopen(argv[i], binary ? "rb" : "r");
+		waveform_t wave = { argv[i], capture, 0 };
+		result_t r;
+
+		if(in == NULL){
+			perror(argv[i]);
+			free(capture);
+			return 2;
+		}
+		wave.count = binary ? load_binary(in, capture) : load_csv(in, capture, column);
+		fclose(in);
+		if(wave.count == 0){
+			fprintf(stderr, "%s: no samples\n", argv[i]);
+			errors++;
+			continue;
+		}
+		r = run(&wave, (uint32_t)packet_samples, passes);
+		report(&wave, &r);
+		errors += r.errors;
+	}
+	free(capture);
+
+	printf("\n%s\n", errors ? "FAIL" : "all packets decode to their samples within the bounds");
+	return errors ? 1 : 0;
+}
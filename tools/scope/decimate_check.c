@@ -0,0 +1,201 @@
+/***********************************************************
+Title: Glitch survival check for the oscilloscope
+				acquisition modes.
+Description: Builds a sine at the scope's sample rate with
+				short glitches at random positions, runs it
+				through scope_decimate.c in DMA-frame sized
+				chunks in every acquisition mode, and reports
+				for each mode how many glitches still show
+				their extreme value in the output, and the cost
+				per input sample. Exits with 1 if
+				the PEAK mode loses a glitch.
+Usage:
+				decimate_check [options]
+				-n <factor>  samples per bucket (default 20)
+				-f <count>   samples per frame (default 1024)
+				-l <count>   signal length in samples (default 5000000)
+				-g <count>   number of glitches (default 200)
+				-w <count>   glitch width in samples (default 1)
+				-r <count>   repeat the timed runs <count> times (default 1)
+************************************************************/
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <math.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "scope_decimate.h"
+
+#define SAMPLE_RATE_HZ   500000.0
+#define SIGNAL_HZ        1000.0
+#define SIGNAL_MID       2048.0
+#define SIGNAL_AMPLITUDE 1000.0
+#define NOISE_CODES      8
+#define GLITCH_CODES     1500
+#define ADC_MAX_CODE     4095
+#define PI               3.14159265358979323846
+
+static const char *mode_names[] = { "sample", "average", "peak" };
+
+static uint64_t now_ns(void){
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+// Decimate a whole signal frame by frame, as the firmware sees it
+static uint32_t decimate_frames(scope_decimate_mode_t mode, uint32_t factor, uint32_t frame,
+                                const uint16_t *in, uint32_t count, uint16_t *out){
+	scope_decimate_t decimate;
+	uint32_t produced = 0;
+	uint32_t i;
+
+	scope_decimate_init(&decimate, mode, factor);
+	for(i = 0; i < count; i += frame){
+		uint32_t n = (count - i < frame) ? count - i : frame;
+		produced += scope_decimate_run(&decimate, &in[i], n, &out[produced]);
+	}
+	return produced;
+}
+
+// A glitch is visible when the output of its bucket reaches the glitch's
+// extreme value (the maximum of an upward glitch, the minimum of a downward one)
+static int glitch_visible(scope_decimate_mode_t mode, const uint16_t *out, uint32_t bucket,
+                          int direction, uint16_t extreme){
+	uint32_t at = (mode == SCOPE_DECIMATE_PEAK) ? 2 * bucket + (direction > 0) : bucket;
+
+	return (direction > 0) ? (out[at] >= extreme) : (out[at] <= extreme);
+}
+
+static void usage(const char *prog){
+	fprintf(stderr,
+		"usage: %s [-n factor] [-f frame] [-l length] [-g glitches] [-w width] [-r repeat]\n", prog);
+}
+
+int main(int argc, char *argv[]){
+	long factor = 20;
+	long frame = 1024;
+	long length = 5000000;
+	long glitches = 200;
+	long width = 1;
+	long repeat = 1;
+	uint16_t *signal, *out;
+	uint16_t *glitch_extreme;
+	uint32_t *glitch_at;
+	int *glitch_dir;
+	uint32_t out_max;
+	uint32_t i;
+	long g, r;
+	int mode;
+	int opt;
+	int status = 0;
+
+	while((opt = getopt(argc, argv, "n:f:l:g:w:r:h")) != -1){
+		switch(opt){
+			case 'n': factor = atol(optarg); break;
+			case 'f': frame = atol(optarg); break;
+			case 'l': length = atol(optarg); break;
+			case 'g': glitches = atol(optarg); break;
+			case 'w': width = atol(optarg); break;
+			case 'r': repeat = atol(optarg); break;
+			default:
+				usage(argv[0]);
+				return 2;
+		}
+	}
+	if(optind != argc || factor < 1 || factor > (long)SCOPE_DECIMATE_MAX_FACTOR || frame < 1 ||
+	   length < factor || glitches < 0 || glitches > length / factor || width < 1 || width > factor ||
+	   repeat < 1){
+		usage(argv[0]);
+		return 2;
+	}
+
+	out_max = SCOPE_DECIMATE_OUT_MAX((uint32_t)length, (uint32_t)factor);
+	signal = malloc((size_t)length * sizeof(*signal));
+	out = malloc(out_max * sizeof(*out));
+	glitch_at = malloc(((size_t)glitches + 1) * sizeof(*glitch_at));
+	glitch_dir = malloc(((size_t)glitches + 1) * sizeof(*glitch_dir));
+	glitch_extreme = malloc(((size_t)glitches + 1) * sizeof(*glitch_extreme));
+	if(signal == NULL || out == NULL || glitch_at == NULL || glitch_dir == NULL ||
+	   glitch_extreme == NULL){
+		fprintf(stderr, "out of memory\n");
+		return 2;
+	}
+
+	srand(1);
+	for(i = 0; i < (uint32_t)length; i++){
+		double v = SIGNAL_MID + SIGNAL_AMPLITUDE * sin(2.0 * PI * SIGNAL_HZ * i / SAMPLE_RATE_HZ);
+
+		signal[i] = (uint16_t)(v + (rand() % (2 * NOISE_CODES + 1)) - NOISE_CODES);
+	}
+
+	// Glitches, alternately up and down, each within one bucket and at most
+	// one per bucket so that each one is judged on its own
+	for(g = 0; g < glitches; g++){
+		uint32_t buckets = (uint32_t)(length / factor);
+		uint32_t bucket = (uint32_t)(((uint64_t)rand() * RAND_MAX + rand()) % buckets);
+		uint32_t start = bucket * (uint32_t)factor + (uint32_t)(rand() % (factor - width + 1));
+		int dir = (g & 1) ? -1 : 1;
+		long k;
+
+		for(k = 0; k < g; k++){
+			if(glitch_at[k] / (uint32_t)factor == bucket){
+				break;
+			}
+		}
+		if(k < g){
+			g--;
+			continue;
+		}
+		glitch_at[g] = start;
+		glitch_dir[g] = dir;
+		glitch_extreme[g] = (dir > 0) ? 0 : ADC_MAX_CODE;
+		for(k = 0; k < width; k++){
+			int v = (int)signal[start + k] + dir * GLITCH_CODES;
+
+			signal[start + k] = (uint16_t)(v < 0 ? 0 : (v > ADC_MAX_CODE ? ADC_MAX_CODE : v));
+			if((dir > 0) ? (signal[start + k] > glitch_extreme[g]) : (signal[start + k] < glitch_extreme[g])){
+				glitch_extreme[g] = signal[start + k];
+			}
+		}
+	}
+
+	printf("samples:    %ld in frames of %ld\n", length, frame);
+	printf("factor:     %ld\n", factor);
+	printf("glitches:   %ld of %ld samples\n", glitches, width);
+
+	for(mode = SCOPE_DECIMATE_SAMPLE; mode <= SCOPE_DECIMATE_PEAK; mode++){
+		uint64_t elapsed = 0;
+		long visible = 0;
+
+		for(r = 0; r < repeat; r++){
+			uint64_t t0 = now_ns();
+
+			decimate_frames((scope_decimate_mode_t)mode, (uint32_t)factor, (uint32_t)frame,
+			                signal, (uint32_t)length, out);
+			elapsed += now_ns() - t0;
+		}
+
+		for(g = 0; g < glitches; g++){
+			visible += glitch_visible((scope_decimate_mode_t)mode, out, glitch_at[g] / (uint32_t)factor,
+			                          glitch_dir[g], glitch_extreme[g]);
+		}
+		printf("%-10s  %8.2f ns/sample  %ld/%ld glitches visible\n", mode_names[mode],
+		       (double)elapsed / ((double)length * repeat), visible, glitches);
+		if(mode == SCOPE_DECIMATE_PEAK && visible != glitches){
+			status = 1;
+		}
+	}
+	printf("peak:       %s\n", status ? "FAIL" : "all glitches kept");
+
+	free(glitch_extreme);
+	free(glitch_dir);
+	free(glitch_at);
+	free(out);
+	free(signal);
+	return status;
+}
@@ -0,0 +1,672 @@
+/***********************************************************
+Title: Host client for the oscilloscope's binary stream.
+Description: Reads the packets scope_link.c sends (format
+				in scope_stream.h) from a serial port, a pty or
+				a capture file. An I/O thread decodes them into
+				a lock-free ring; a worker thread takes them
+				from the ring, measures the waveform
+				(scope_measure.c), computes its spectrum
+				(scope_spectrum.c) and writes the captures.
+				Once a second the main thread prints the
+				stream statistics and the last results. Of
+				a multi-channel stream the client works on
+				the first channel; trigger windows are only
+				written to the captures.
+
+				The loopback generator stands in for the
+				board: it encodes a synthetic sine into packets
+				at the stream rate and feeds them to the I/O
+				thread through a pipe. The benchmark runs the
+				generator unpaced and reports the sustained
+				decoded and processed samples per second.
+Usage:
+				scope_client [options] <device|file>
+				scope_client -l [options]
+				-b <baud>     configure <device> as a raw serial port at
+				              <baud> (default: read as a plain file or pty)
+				-l            loopback generator instead of a device
+				-f <hz>       loopback sine frequency (default 1000)
+				-B <seconds>  benchmark: unpaced loopback for <seconds>
+				-o <file>     CSV capture, the lines of stream_decode -o
+				-w <file>     binary capture, little-endian 16-bit codes
+				              (adc_replay -b reads it)
+				-n <count>    stop after <count> packets
+				-q            no status lines
+				-v            report every error and gap
+************************************************************/
+
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <thread>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <termios.h>
+#include <unistd.h>
+
+extern "C" {
+#include "scope_stream.h"
+#include "scope_measure.h"
+#include "scope_spectrum.h"
+}
+
+#define READ_CHUNK        4096
+#define BUFFER_BYTES      (2 * SCOPE_STREAM_PACKET_BYTES(SCOPE_STREAM_MAX_SAMPLES) + READ_CHUNK)
+#define RING_SLOTS        64      // packets between the I/O and the worker thread, power of two
+#define ADC_FULL_SCALE_MV 3300
+#define ADC_BITS          12
+#define BIN_SCALE         2       // spectrum bins per ADC code, SCOPE_SPECTRUM_BIN_SCALE
+#define POLL_MS           100     // how often blocked threads look at the stop flag
+
+// Measurement and spectrum setup of the worker
+#define MEASURE_HYSTERESIS_CODES 64
+#define SPECTRUM_POINTS          2048
+#define SPECTRUM_AVERAGES        4
+
+// Loopback generator: the board's stream mode, 500 kS/s averaged by 10
+#define LOOPBACK_RATE_HZ       500000
+#define LOOPBACK_FACTOR        10
+#define LOOPBACK_SAMPLES       512
+#define LOOPBACK_AMPLITUDE     1000.0
+#define LOOPBACK_NOISE_CODES   4
+#define PI                     3.14159265358979323846
+
+typedef struct {
+	scope_stream_header_t header;
+	uint16_t samples[SCOPE_STREAM_MAX_SAMPLES];
+} packet_t;
+
+// Single producer (I/O thread), single consumer (worker thread). Each index
+// is only written by its owner; the release store of an index publishes the
+// slot, the acquire load of the other index sees it.
+typedef struct {
+	alignas(64) std::atomic<uint32_t> head;   // next slot to write, I/O thread
+	alignas(64) std::atomic<uint32_t> tail;   // next slot to read, worker thread
+	packet_t slots[RING_SLOTS];
+} packet_ring_t;
+
+typedef struct {
+	std::atomic<uint64_t> bytes;
+	std::atomic<uint64_t> skipped_bytes;
+	std::atomic<uint64_t> packets;
+	std::atomic<uint64_t> samples;            // decoded, before the ring
+	std::atomic<uint64_t> spectra;            // spectrum packets from the board
+	std::atomic<uint64_t> crc_errors;
+	std::atomic<uint64_t> header_errors;
+	std::atomic<uint64_t> lost_packets;
+	std::atomic<uint64_t> lost_samples;
+	std::atomic<uint64_t> ring_overruns;      // packets the worker had no room for
+	std::atomic<uint64_t> processed;          // samples the worker went through
+} client_stats_t;
+
+// Last results of the worker, for the status lines
+typedef struct {
+	std::mutex lock;
+	int have_record;
+	scope_measure_record_t record;
+	double peak_hz;
+	double peak_mv;
+	uint32_t stream_rate;                     // samples/s after decimation
+} client_results_t;
+
+typedef struct {
+	int fd;                                   // input of the I/O thread
+	long max_packets;
+	int verbose;
+	FILE *csv;
+	FILE *bin;
+} client_config_t;
+
+static packet_ring_t ring;
+static client_stats_t stats;
+static client_results_t results;
+static std::atomic<bool> stop_requested(false);
+static std::atomic<bool> io_done(false);
+
+static uint64_t now_ns(void){
+	return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+	        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static void on_signal(int signum){
+	(void)signum;
+	stop_requested.store(true);
+}
+
+static speed_t baud_constant(long baud){
+	switch(baud){
+		case 115200:  return B115200;
+		case 230400:  return B230400;
+		case 460800:  return B460800;
+		case 921600:  return B921600;
+		case 1000000: return B1000000;
+		case 2000000: return B2000000;
+		case 3000000: return B3000000;
+		default:      return B0;
+	}
+}
+
+static int open_serial(const char *path, long baud){
+	struct termios tio;
+	speed_t speed = baud_constant(baud);
+	int fd;
+
+	if(speed == B0){
+		fprintf(stderr, "unsupported baud rate %ld\n", baud);
+		return -1;
+	}
+	fd = open(path, O_RDONLY | O_NOCTTY);
+	if(fd < 0){
+		perror(path);
+		return -1;
+	}
+	if(tcgetattr(fd, &tio) != 0){
+		perror("tcgetattr");
+		close(fd);
+		return -1;
+	}
+	cfmakeraw(&tio);
+	cfsetispeed(&tio, speed);
+	cfsetospeed(&tio, speed);
+	tio.c_cflag |= CLOCAL | CREAD;
+	tio.c_cc[VMIN] = 1;
+	tio.c_cc[VTIME] = 0;
+	if(tcsetattr(fd, TCSANOW, &tio) != 0){
+		perror("tcsetattr");
+		close(fd);
+		return -1;
+	}
+	tcflush(fd, TCIFLUSH);
+	return fd;
+}
+
+// Wait up to POLL_MS for 'fd' to become ready; 0 on timeout
+static int wait_fd(int fd, short events){
+	struct pollfd pfd = { fd, events, 0 };
+
+	return poll(&pfd, 1, POLL_MS);
+}
+
+/*
+ * Loopback generator: packets of a sine with a little noise, sent at the
+ * stream rate or, for the benchmark, as fast as the pipe takes them.
+ */
+static void generator_thread(int fd, double hz, bool paced){
+	static uint8_t packet[SCOPE_STREAM_PACKET_BYTES(LOOPBACK_SAMPLES)];
+	static uint16_t samples[LOOPBACK_SAMPLES];
+	const double rate = (double)LOOPBACK_RATE_HZ / LOOPBACK_FACTOR;
+	const double step = hz / rate;
+	scope_stream_header_t header;
+	double phase = 0.0;
+	uint32_t position = 0;
+	uint16_t sequence = 0;
+	uint64_t t0 = now_ns();
+
+	while(!stop_requested.load(std::memory_order_relaxed)){
+		uint32_t length;
+		uint32_t sent = 0;
+
+		for(uint32_t i = 0; i < LOOPBACK_SAMPLES; i++){
+			double v = 2048.0 + LOOPBACK_AMPLITUDE * sin(2.0 * PI * phase);
+
+			samples[i] = (uint16_t)(lrint(v) + (rand() % (2 * LOOPBACK_NOISE_CODES + 1)) - LOOPBACK_NOISE_CODES);
+			phase += step;
+			phase -= floor(phase);
+		}
+		header.flags = 1 | SCOPE_STREAM_FLAG_COMPRESSED;   // SCOPE_DECIMATE_AVERAGE, as the board sends
+		header.sequence = sequence++;
+		header.count = LOOPBACK_SAMPLES;
+		header.sample_rate_hz = LOOPBACK_RATE_HZ;
+		header.factor = LOOPBACK_FACTOR;
+		header.trigger_index = SCOPE_STREAM_NO_TRIGGER;
+		header.position = position;
+		length = scope_stream_encode(packet, &header, samples);
+		position += LOOPBACK_SAMPLES;
+
+		while(sent < length && !stop_requested.load(std::memory_order_relaxed)){
+			ssize_t done;
+
+			if(wait_fd(fd, POLLOUT) <= 0){
+				continue;
+			}
+			done = write(fd, &packet[sent], length - sent);
+			if(done < 0){
+				stop_requested.store(true);   // reader gone
+				break;
+			}
+			sent += (uint32_t)done;
+		}
+
+		if(paced){
+			uint64_t due = t0 + (uint64_t)((double)position * 1e9 / rate);
+			uint64_t now = now_ns();
+
+			if(due > now){
+				std::this_thread::sleep_for(std::chrono::nanoseconds(due - now));
+			}
+		}
+	}
+	close(fd);
+}
+
+// Hand a decoded packet to the worker; never blocks the reader
+static void ring_push(const packet_t *packet){
+	uint32_t head = ring.head.load(std::memory_order_relaxed);
+	uint32_t tail = ring.tail.load(std::memory_order_acquire);
+	packet_t *slot;
+
+	if(head - tail == RING_SLOTS){
+		stats.ring_overruns.fetch_add(1, std::memory_order_relaxed);
+		return;
+	}
+	slot = &ring.slots[head & (RING_SLOTS - 1)];
+	slot->header = packet->header;
+	memcpy(slot->samples, packet->samples, packet->header.count * sizeof(uint16_t));
+	ring.head.store(head + 1, std::memory_order_release);
+}
+
+// The oldest packet in the ring, or NULL; ring_pop() releases it
+static const packet_t *ring_peek(void){
+	uint32_t tail = ring.tail.load(std::memory_order_relaxed);
+
+	if(ring.head.load(std::memory_order_acquire) == tail){
+		return NULL;
+	}
+	return &ring.slots[tail & (RING_SLOTS - 1)];
+}
+
+static void ring_pop(void){
+	ring.tail.store(ring.tail.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+}
+
+// Samples per channel of a packet; a multi-channel stream carries one block
+// per channel and the client works on the first
+static uint32_t channel_block(const scope_stream_header_t *header){
+	return header->count / SCOPE_STREAM_CHANNELS(header->flags);
+}
+
+/*
+ * I/O thread: read, resync on the sync word, check CRC, sequence numbers
+ * and positions, and push every good packet into the ring.
+ */
+static void io_thread(const client_config_t *config){
+	static uint8_t buffer[BUFFER_BYTES];
+	static packet_t packet;
+	uint32_t expected_sequence = 0;
+	uint32_t expected_position = 0;
+	uint64_t packets = 0;
+	uint64_t samples = 0;
+	size_t fill = 0;
+
+	while(!stop_requested.load(std::memory_order_relaxed)){
+		ssize_t got;
+		size_t at = 0;
+		int ready = wait_fd(config->fd, POLLIN);
+
+		if(ready == 0){
+			continue;
+		}
+		got = (ready < 0) ? -1 : read(config->fd, &buffer[fill], READ_CHUNK);
+		if(got <= 0){
+			break;
+		}
+		fill += (size_t)got;
+		stats.bytes.fetch_add((uint64_t)got, std::memory_order_relaxed);
+
+		while(at < fill){
+			int32_t result = scope_stream_decode(&buffer[at], (uint32_t)(fill - at), &packet.header,
+			                                     packet.samples);
+			uint32_t seq_gap, pos_gap = 0;
+
+			if(result == SCOPE_STREAM_NEED_MORE){
+				break;
+			}
+			if(result < 0){
+				if(result == SCOPE_STREAM_BAD_CRC){
+					stats.crc_errors.fetch_add(1, std::memory_order_relaxed);
+				}
+				else if(result == SCOPE_STREAM_BAD_HEADER){
+					stats.header_errors.fetch_add(1, std::memory_order_relaxed);
+				}
+				if(config->verbose && result != SCOPE_STREAM_BAD_SYNC){
+					fprintf(stderr, "byte %llu: %s\n",
+					        (unsigned long long)(stats.bytes.load(std::memory_order_relaxed) - (fill - at)),
+					        result == SCOPE_STREAM_BAD_CRC ? "CRC error" : "bad header");
+				}
+				stats.skipped_bytes.fetch_add(1, std::memory_order_relaxed);
+				at++;
+				continue;
+			}
+
+			seq_gap = packets ? (uint16_t)(packet.header.sequence - expected_sequence) : 0;
+			expected_sequence = (uint16_t)(packet.header.sequence + 1u);
+			stats.lost_packets.fetch_add(seq_gap, std::memory_order_relaxed);
+			if(packet.header.flags & SCOPE_STREAM_FLAG_SPECTRUM){
+				stats.spectra.fetch_add(1, std::memory_order_relaxed);
+			}
+			else if(packet.header.flags & (SCOPE_STREAM_FLAG_TRIGGERED | SCOPE_STREAM_FLAG_FORCED)){
+				// Trigger windows, their positions jump from window to window
+			}
+			else{
+				uint32_t block = channel_block(&packet.header);
+
+				pos_gap = samples ? packet.header.position - expected_position : 0;
+				expected_position = packet.header.position + block;
+				samples += block;
+				stats.lost_samples.fetch_add(pos_gap, std::memory_order_relaxed);
+				stats.samples.fetch_add(block, std::memory_order_relaxed);
+			}
+			if(config->verbose && (seq_gap || pos_gap)){
+				fprintf(stderr, "packet %u: %u packets and %u samples lost\n",
+				        (unsigned int)packet.header.sequence, (unsigned int)seq_gap, (unsigned int)pos_gap);
+			}
+			ring_push(&packet);
+			packets++;
+			stats.packets.fetch_add(1, std::memory_order_relaxed);
+			at += (size_t)result;
+			if(config->max_packets && packets >= (uint64_t)config->max_packets){
+				break;
+			}
+		}
+		memmove(buffer, &buffer[at], fill - at);
+		fill -= at;
+		if(config->max_packets && packets >= (uint64_t)config->max_packets){
+			break;
+		}
+	}
+	io_done.store(true, std::memory_order_release);
+}
+
+static void write_csv(FILE *out, const packet_t *packet){
+	const scope_stream_header_t *header = &packet->header;
+
+	if(header->flags & SCOPE_STREAM_FLAG_SPECTRUM){
+		double bin_hz = (double)header->sample_rate_hz / (header->factor ? header->factor : 1) /
+		                (2.0 * (header->count ? header->count : 1));
+
+		for(uint32_t i = 0; i < header->count; i++){
+			fprintf(out, "%u,%u,%.1f,%.2f\n", (unsigned int)header->position, (unsigned int)i, i * bin_hz,
+			        (double)packet->samples[i] * ADC_FULL_SCALE_MV / BIN_SCALE / (1 << ADC_BITS));
+		}
+		return;
+	}
+	for(uint32_t i = 0; i < channel_block(header); i++){
+		fprintf(out, "%u,%u,%d\n", (unsigned int)(header->position + i), (unsigned int)packet->samples[i],
+		        (int)(((int32_t)packet->samples[i] * ADC_FULL_SCALE_MV) >> ADC_BITS));
+	}
+}
+
+static void write_binary(FILE *out, const packet_t *packet){
+	uint8_t bytes[2 * SCOPE_STREAM_MAX_SAMPLES];
+
+	if(packet->header.flags & SCOPE_STREAM_FLAG_SPECTRUM){
+		return;
+	}
+	for(uint32_t i = 0; i < channel_block(&packet->header); i++){
+		bytes[2 * i] = (uint8_t)packet->samples[i];
+		bytes[2 * i + 1] = (uint8_t)(packet->samples[i] >> 8);
+	}
+	fwrite(bytes, 2, channel_block(&packet->header), out);
+}
+
+static void publish_peak(const uint16_t *bins, uint32_t count, double bin_hz){
+	uint16_t amplitude;
+	uint32_t peak = scope_spectrum_peak(bins, count, &amplitude);
+	std::lock_guard<std::mutex> guard(results.lock);
+
+	results.peak_hz = peak * bin_hz / 256.0;
+	results.peak_mv = (double)amplitude * ADC_FULL_SCALE_MV / BIN_SCALE / (1 << ADC_BITS);
+}
+
+/*
+ * Worker thread: measurements per packet and a spectrum of the samples,
+ * restarted at every gap or change of the stream rate, and the captures.
+ */
+static void worker_thread(const client_config_t *config){
+	static scope_measure_t measure;
+	static scope_spectrum_t spectrum;
+	static uint16_t bins[SPECTRUM_POINTS / 2];
+	uint32_t stream_rate = 0;
+	uint32_t expected_position = 0;
+
+	if(scope_spectrum_init(&spectrum, SPECTRUM_POINTS, SPECTRUM_AVERAGES) != 0){
+		stop_requested.store(true);
+		return;
+	}
+
+	for(;;){
+		const packet_t *packet = ring_peek();
+		const scope_stream_header_t *header;
+
+		if(packet == NULL){
+			if(io_done.load(std::memory_order_acquire) && ring_peek() == NULL){
+				break;
+			}
+			std::this_thread::sleep_for(std::chrono::microseconds(200));
+			continue;
+		}
+		header = &packet->header;
+
+		if(config->csv != NULL){
+			write_csv(config->csv, packet);
+		}
+		if(config->bin != NULL){
+			write_binary(config->bin, packet);
+		}
+
+		if(header->flags & (SCOPE_STREAM_FLAG_TRIGGERED | SCOPE_STREAM_FLAG_FORCED)){
+			// Trigger windows are only captured
+		}
+		else if(header->flags & SCOPE_STREAM_FLAG_SPECTRUM){
+			// Bin k of 'count' bins lies at k * rate / factor / (2 * count)
+			publish_peak(packet->samples, header->count, (double)header->sample_rate_hz /
+			             (header->factor ? header->factor : 1) / (2.0 * (header->count ? header->count : 1)));
+		}
+		else{
+			uint32_t rate = header->sample_rate_hz / (header->factor ? header->factor : 1);
+			uint32_t block = channel_block(header);
+			scope_measure_record_t record;
+			uint32_t done = 0;
+
+			if(rate != stream_rate){
+				const scope_measure_config_t measure_config = {
+					rate, ADC_FULL_SCALE_MV, ADC_BITS, 0, MEASURE_HYSTERESIS_CODES
+				};
+
+				scope_measure_init(&measure, &measure_config);
+				scope_spectrum_reset(&spectrum);
+				stream_rate = rate;
+			}
+			else if(header->position != expected_position){
+				scope_measure_reset(&measure);
+				scope_spectrum_reset(&spectrum);
+			}
+			expected_position = header->position + block;
+
+			scope_measure_frame(&measure, packet->samples, block, &record);
+			while(done < block){
+				done += scope_spectrum_feed(&spectrum, &packet->samples[done], block - done);
+				if(scope_spectrum_read(&spectrum, bins) == 0){
+					publish_peak(bins, SPECTRUM_POINTS / 2, (double)rate / SPECTRUM_POINTS);
+				}
+			}
+			stats.processed.fetch_add(block, std::memory_order_relaxed);
+
+			std::lock_guard<std::mutex> guard(results.lock);
+			results.record = record;
+			results.have_record = 1;
+			results.stream_rate = rate;
+		}
+		ring_pop();
+	}
+}
+
+static void print_status(double seconds, uint64_t samples){
+	scope_measure_record_t record;
+	int have_record;
+	double peak_hz, peak_mv;
+
+	{
+		std::lock_guard<std::mutex> guard(results.lock);
+		record = results.record;
+		have_record = results.have_record;
+		peak_hz = results.peak_hz;
+		peak_mv = results.peak_mv;
+	}
+	printf("%7.1f s  %9.0f samples/s  lost %llu  errors %llu  overruns %llu",
+	       seconds, (double)samples / (seconds > 0.0 ? seconds : 1.0),
+	       (unsigned long long)stats.lost_samples.load(std::memory_order_relaxed),
+	       (unsigned long long)(stats.crc_errors.load(std::memory_order_relaxed) +
+	                            stats.header_errors.load(std::memory_order_relaxed)),
+	       (unsigned long long)stats.ring_overruns.load(std::memory_order_relaxed));
+	if(have_record){
+		printf("  Vpp %ld mV  RMS %ld mV  %.3f Hz  duty %.1f%%", (long)record.vpp_mv, (long)record.rms_mv,
+		       record.frequency_mhz / 1000.0, record.duty_permille / 10.0);
+	}
+	if(peak_mv > 0.0){
+		printf("  peak %.1f Hz %.1f mV", peak_hz, peak_mv);
+	}
+	printf("\n");
+	fflush(stdout);
+}
+
+static void usage(const char *prog){
+	fprintf(stderr, "usage: %s [-b baud] [-o csv] [-w bin] [-n packets] [-q] [-v] device|file\n"
+	                "       %s -l [-f hz] [-B seconds] [-o csv] [-w bin] [-n packets] [-q] [-v]\n", prog, prog);
+}
+
+int main(int argc, char *argv[]){
+	client_config_t config = { -1, 0, 0, NULL, NULL };
+	long baud = 0;
+	int loopback = 0;
+	double loopback_hz = 1000.0;
+	double bench_seconds = 0.0;
+	int quiet = 0;
+	const char *csv_path = NULL;
+	const char *bin_path = NULL;
+	std::thread generator, io, worker;
+	uint64_t t0, elapsed, last_status;
+	int opt;
+
+	while((opt = getopt(argc, argv, "b:lf:B:o:w:n:qvh")) != -1){
+		switch(opt){
+			case 'b': baud = atol(optarg); break;
+			case 'l': loopback = 1; break;
+			case 'f': loopback_hz = atof(optarg); break;
+			case 'B': bench_seconds = atof(optarg); loopback = 1; break;
+			case 'o': csv_path = optarg; break;
+			case 'w': bin_path = optarg; break;
+			case 'n': config.max_packets = atol(optarg); break;
+			case 'q': quiet = 1; break;
+			case 'v': config.verbose = 1; break;
+			default:
+				usage(argv[0]);
+				return 2;
+		}
+	}
+	if(optind != argc - (loopback ? 0 : 1) || config.max_packets < 0 || bench_seconds < 0.0 ||
+	   loopback_hz <= 0.0 || loopback_hz >= (double)LOOPBACK_RATE_HZ / LOOPBACK_FACTOR / 2.0){
+		usage(argv[0]);
+		return 2;
+	}
+
+	if(loopback){
+		int fds[2];
+
+		if(pipe(fds) != 0){
+			perror("pipe");
+			return 2;
+		}
+		config.fd = fds[0];
+		generator = std::thread(generator_thread, fds[1], loopback_hz, bench_seconds == 0.0);
+	}
+	else{
+		config.fd = baud ? open_serial(argv[optind], baud) : open(argv[optind], O_RDONLY | O_NOCTTY);
+		if(config.fd < 0){
+			if(!baud){
+				perror(argv[optind]);
+			}
+			return 2;
+		}
+	}
+	if(csv_path != NULL && (config.csv = fopen(csv_path, "w")) == NULL){
+		perror(csv_path);
+		return 2;
+	}
+	if(bin_path != NULL && (config.bin = fopen(bin_path, "wb")) == NULL){
+		perror(bin_path);
+		return 2;
+	}
+
+	signal(SIGINT, on_signal);
+	signal(SIGTERM, on_signal);
+	signal(SIGPIPE, SIG_IGN);
+
+	t0 = now_ns();
+	last_status = t0;
+	io = std::thread(io_thread, &config);
+	worker = std::thread(worker_thread, &config);
+
+	while(!io_done.load(std::memory_order_acquire)){
+		uint64_t now;
+
+		std::this_thread::sleep_for(std::chrono::milliseconds(POLL_MS));
+		now = now_ns();
+		if(bench_seconds > 0.0 && (double)(now - t0) >= bench_seconds * 1e9){
+			stop_requested.store(true);
+		}
+		if(!quiet && now - last_status >= 1000000000ull){
+			print_status((double)(now - t0) / 1e9, stats.samples.load(std::memory_order_relaxed));
+			last_status = now;
+		}
+	}
+	elapsed = now_ns() - t0;
+	io.join();
+	worker.join();
+	stop_requested.store(true);
+	if(generator.joinable()){
+		generator.join();
+	}
+	close(config.fd);
+	if(config.csv != NULL){
+		fclose(config.csv);
+	}
+	if(config.bin != NULL){
+		fclose(config.bin);
+	}
+
+	printf("bytes:      %llu (%llu skipped)\n", (unsigned long long)stats.bytes.load(),
+	       (unsigned long long)stats.skipped_bytes.load());
+	printf("packets:    %llu (%llu CRC errors, %llu bad headers, %llu lost, %llu ring overruns)\n",
+	       (unsigned long long)stats.packets.load(), (unsigned long long)stats.crc_errors.load(),
+	       (unsigned long long)stats.header_errors.load(), (unsigned long long)stats.lost_packets.load(),
+	       (unsigned long long)stats.ring_overruns.load());
+	printf("samples:    %llu (%llu lost, %llu processed)\n", (unsigned long long)stats.samples.load(),
+	       (unsigned long long)stats.lost_samples.load(), (unsigned long long)stats.processed.load());
+	if(stats.spectra.load()){
+		printf("spectra:    %llu\n", (unsigned long long)stats.spectra.load());
+	}
+	if(results.have_record){
+		printf("last:       Vpp %ld mV, mean %ld mV, RMS %ld mV, AC RMS %ld mV, %.3f Hz, duty %.1f%%\n",
+		       (long)results.record.vpp_mv, (long)results.record.mean_mv, (long)results.record.rms_mv,
+		       (long)results.record.ac_rms_mv, results.record.frequency_mhz / 1000.0,
+		       results.record.duty_permille / 10.0);
+	}
+	if(results.peak_mv > 0.0){
+		printf("spectrum:   peak %.1f Hz, %.1f mV\n", results.peak_hz, results.peak_mv);
+	}
+	if(bench_seconds > 0.0 || baud || loopback){
+		double seconds = (double)(elapsed ? elapsed : 1) / 1e9;
+
+		printf("decoded:    %.0f samples/s, %.2f MB/s\n", (double)stats.samples.load() / seconds,
+		       (double)stats.bytes.load() / seconds / 1e6);
+		printf("processed:  %.0f samples/s\n", (double)stats.processed.load() / seconds);
+	}
+	return (stats.crc_errors.load() || stats.header_errors.load()) ? 1 : 0;
+}
@@ -0,0 +1,167 @@
+/***********************************************************
+Title: Benchmark and accuracy check for the oscilloscope
+				spectrum mode.
+Description: Runs scope_spectrum.c (portable fixed-point
+				FFT) over synthetic tones at the scope's sample
+				rate for every FFT length from 512 to 4096
+				points. Reports the FFT throughput and, for
+				every tone, the frequency and amplitude of the
+				interpolated peak against the tone. Exits with
+				1 if a peak is off by more than half a bin or
+				its amplitude by more than the tolerance.
+Usage:
+				spectrum_bench [options]
+				-a <count>   spectra averaged (default 4)
+				-A <codes>   tone amplitude in ADC codes (default 1000)
+				-r <count>   blocks per timing run (default 200)
+				-t <percent> amplitude tolerance (default 10)
+************************************************************/
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <math.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "scope_spectrum.h"
+
+#define SAMPLE_RATE_HZ  500000.0
+#define FRAME_SAMPLES   1024
+#define ADC_MID         2048.0
+#define NOISE_CODES     4
+#define PI              3.14159265358979323846
+
+static scope_spectrum_t spectrum;
+
+// Tones in Hz, on and between bins, low and close to Nyquist
+static const double tones_hz[] = { 1000.0, 12345.6, 50000.0, 100700.0, 187500.3, 240000.0 };
+
+#define NUM_TONES (sizeof(tones_hz) / sizeof(tones_hz[0]))
+
+static uint64_t now_ns(void){
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+static void make_tone(uint16_t *samples, size_t count, double hz, double amplitude){
+	size_t i;
+
+	for(i = 0; i < count; i++){
+		double v = ADC_MID + amplitude * sin(2.0 * PI * hz * (double)i / SAMPLE_RATE_HZ);
+
+		samples[i] = (uint16_t)(lrint(v) + (rand() % (2 * NOISE_CODES + 1)) - NOISE_CODES);
+	}
+}
+
+// Feed a signal frame by frame until a spectrum is ready
+static int run_spectrum(const uint16_t *samples, size_t count, uint16_t *bins){
+	size_t at = 0;
+
+	while(at < count){
+		size_t n = (count - at < FRAME_SAMPLES) ? count - at : FRAME_SAMPLES;
+
+		at += scope_spectrum_feed(&spectrum, &samples[at], (uint32_t)n);
+		if(scope_spectrum_read(&spectrum, bins) == 0){
+			return 0;
+		}
+	}
+	return -1;
+}
+
+static void usage(const char *prog){
+	fprintf(stderr, "usage: %s [-a averages] [-A amplitude] [-r blocks] [-t tolerance]\n", prog);
+}
+
+int main(int argc, char *argv[]){
+	long averages = 4;
+	double amplitude = 1000.0;
+	long blocks = 200;
+	double tolerance = 10.0;
+	uint16_t *samples;
+	uint16_t bins[SCOPE_SPECTRUM_MAX_POINTS / 2];
+	uint32_t points;
+	int failures = 0;
+	int opt;
+
+	while((opt = getopt(argc, argv, "a:A:r:t:h")) != -1){
+		switch(opt){
+			case 'a': averages = atol(optarg); break;
+			case 'A': amplitude = atof(optarg); break;
+			case 'r': blocks = atol(optarg); break;
+			case 't': tolerance = atof(optarg); break;
+			default:
+				usage(argv[0]);
+				return 2;
+		}
+	}
+	if(optind != argc || averages < 1 || amplitude <= 0.0 || amplitude > 2047.0 || blocks < 1){
+		usage(argv[0]);
+		return 2;
+	}
+
+	samples = malloc((size_t)SCOPE_SPECTRUM_MAX_POINTS * (size_t)(averages > blocks ? averages : blocks) *
+	                 sizeof(*samples));
+	if(samples == NULL){
+		fprintf(stderr, "out of memory\n");
+		return 2;
+	}
+	srand(1);
+
+	printf("sample rate: %.0f Hz, tone amplitude %.0f codes, %ld averages\n",
+	       SAMPLE_RATE_HZ, amplitude, averages);
+	for(points = SCOPE_SPECTRUM_MIN_POINTS; points <= SCOPE_SPECTRUM_MAX_POINTS; points *= 2){
+		double bin_hz = SAMPLE_RATE_HZ / points;
+		size_t count = (size_t)points * (size_t)blocks;
+		uint64_t t0, elapsed;
+		size_t at = 0;
+		size_t t;
+
+		// Throughput: one spectrum per block, so every block is transformed and read
+		if(scope_spectrum_init(&spectrum, points, 1) != 0){
+			fprintf(stderr, "init failed for %u points\n", (unsigned int)points);
+			return 2;
+		}
+		make_tone(samples, count, tones_hz[0], amplitude);
+		t0 = now_ns();
+		while(at < count){
+			at += scope_spectrum_feed(&spectrum, &samples[at], (uint32_t)(count - at));
+			scope_spectrum_read(&spectrum, bins);
+		}
+		elapsed = now_ns() - t0;
+		printf("\n%4u points: %8.1f us/block, %6.1f Msamples/s (%.0fx the ADC rate), bin %.1f Hz\n",
+		       (unsigned int)points, (double)elapsed / 1000.0 / (double)blocks,
+		       (double)count * 1e3 / (double)elapsed, (double)count * 1e9 / (double)elapsed / SAMPLE_RATE_HZ,
+		       bin_hz);
+
+		scope_spectrum_init(&spectrum, points, (uint32_t)averages);
+		for(t = 0; t < NUM_TONES; t++){
+			uint16_t peak_amplitude;
+			uint32_t peak;
+			double peak_hz, bin_error, amplitude_error;
+			int ok;
+
+			make_tone(samples, (size_t)points * (size_t)averages, tones_hz[t], amplitude);
+			if(run_spectrum(samples, (size_t)points * (size_t)averages, bins) != 0){
+				fprintf(stderr, "no spectrum\n");
+				return 2;
+			}
+			peak = scope_spectrum_peak(bins, points / 2, &peak_amplitude);
+			peak_hz = (double)peak / 256.0 * bin_hz;
+			bin_error = (peak_hz - tones_hz[t]) / bin_hz;
+			amplitude_error = 100.0 * ((double)peak_amplitude / SCOPE_SPECTRUM_BIN_SCALE - amplitude) / amplitude;
+			ok = fabs(bin_error) <= 0.5 && fabs(amplitude_error) <= tolerance;
+			failures += !ok;
+			printf("  tone %9.1f Hz: peak %9.1f Hz (%+5.2f bins), amplitude %6.1f codes (%+5.1f%%) %s\n",
+			       tones_hz[t], peak_hz, bin_error, (double)peak_amplitude / SCOPE_SPECTRUM_BIN_SCALE,
+			       amplitude_error, ok ? "ok" : "FAIL");
+		}
+	}
+
+	free(samples);
+	printf("\n%s\n", failures ? "FAIL" : "all peaks within tolerance");
+	return failures ? 1 : 0;
+}
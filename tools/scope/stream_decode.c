@@ -0,0 +1,306 @@
+/***********************************************************
+Title: Host decoder for the oscilloscope's binary stream.
+Description: Reads the packets scope_link.c sends
+				(format in scope_stream.h) from a serial port
+				or a capture file, checks sync, CRC, sequence
+				numbers and stream positions, and writes the
+				samples as CSV. Reports packets, CRC errors,
+				lost packets and lost samples, and the sample
+				rate received. Trigger windows (output window)
+				are written with the positions of their
+				samples and are not checked for gaps.
+Usage:
+				stream_decode [options] <device|file>
+				-b <baud>   configure <device> as a raw serial port at
+				            <baud> (default: read as a plain file)
+				-o <file>   write "position,code,millivolts" lines to <file>;
+				            spectra as "spectrum,bin,hz,amplitude_mv" lines
+				-c <chan>   channel of a multi-channel stream to write,
+				            0 for the first scanned input (default)
+				-n <count>  stop after <count> packets
+				-v          report every error and gap
+************************************************************/
+
+#define _DEFAULT_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <fcntl.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "scope_stream.h"
+
+#define READ_CHUNK        4096
+#define BUFFER_BYTES      (2 * SCOPE_STREAM_PACKET_BYTES(SCOPE_STREAM_MAX_SAMPLES) + READ_CHUNK)
+#define ADC_FULL_SCALE_MV 3300
+#define ADC_BITS          12
+#define BIN_SCALE         2     // spectrum bins per ADC code, SCOPE_SPECTRUM_BIN_SCALE
+
+typedef struct {
+	uint64_t packets;
+	uint64_t samples;
+	uint64_t spectra;
+	uint64_t windows;          // packets of trigger windows
+	uint64_t bytes;
+	uint64_t skipped_bytes;
+	uint64_t crc_errors;
+	uint64_t header_errors;
+	uint64_t lost_packets;
+	uint64_t lost_samples;
+} decode_stats_t;
+
+static uint64_t now_ns(void){
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+static speed_t baud_constant(long baud){
+	switch(baud){
+		case 115200:  return B115200;
+		case 230400:  return B230400;
+		case 460800:  return B460800;
+		case 921600:  return B921600;
+		case 1000000: return B1000000;
+		case 2000000: return B2000000;
+		case 3000000: return B3000000;
+		default:      return B0;
+	}
+}
+
+static int open_serial(const char *path, long baud){
+	struct termios tio;
+	speed_t speed = baud_constant(baud);
+	int fd;
+
+	if(speed == B0){
+		fprintf(stderr, "unsupported baud rate %ld\n", baud);
+		return -1;
+	}
+	fd = open(path, O_RDONLY | O_NOCTTY);
+	if(fd < 0){
+		perror(path);
+		return -1;
+	}
+	if(tcgetattr(fd, &tio) != 0){
+		perror("tcgetattr");
+		close(fd);
+		return -1;
+	}
+	cfmakeraw(&tio);
+	cfsetispeed(&tio, speed);
+	cfsetospeed(&tio, speed);
+	tio.c_cflag |= CLOCAL | CREAD;
+	tio.c_cc[VMIN] = 1;
+	tio.c_cc[VTIME] = 0;
+	if(tcsetattr(fd, TCSANOW, &tio) != 0){
+		perror("tcsetattr");
+		close(fd);
+		return -1;
+	}
+	tcflush(fd, TCIFLUSH);
+	return fd;
+}
+
+// A packet of several channels holds 'count / channels' samples of each, one
+// block after the other; all blocks start at the packet's position
+static void write_samples(FILE *out, const scope_stream_header_t *header, const uint16_t *samples,
+                          uint32_t channel){
+	uint32_t channels = SCOPE_STREAM_CHANNELS(header->flags);
+	uint32_t block = header->count / channels;
+	uint32_t i;
+
+	if(out == NULL || channel >= channels){
+		return;
+	}
+	samples += channel * block;
+	for(i = 0; i < block; i++){
+		fprintf(out, "%u,%u,%d\n", (unsigned int)(header->position + i), (unsigned int)samples[i],
+		        (int)(((int32_t)samples[i] * ADC_FULL_SCALE_MV) >> ADC_BITS));
+	}
+}
+
+// Bin k of a spectrum of 'count' bins lies at k * rate / factor / (2 * count)
+static void write_spectrum(FILE *out, const scope_stream_header_t *header, const uint16_t *bins){
+	double bin_hz = (double)header->sample_rate_hz / (header->factor ? header->factor : 1) /
+	                (2.0 * (header->count ? header->count : 1));
+	uint32_t i;
+
+	if(out == NULL){
+		return;
+	}
+	for(i = 0; i < header->count; i++){
+		fprintf(out, "%u,%u,%.1f,%.2f\n", (unsigned int)header->position, (unsigned int)i, i * bin_hz,
+		        (double)bins[i] * ADC_FULL_SCALE_MV / BIN_SCALE / (1 << ADC_BITS));
+	}
+}
+
+static void usage(const char *prog){
+	fprintf(stderr, "usage: %s [-b baud] [-o output] [-c channel] [-n packets] [-v] device|file\n", prog);
+}
+
+int main(int argc, char *argv[]){
+	static uint8_t buffer[BUFFER_BYTES];
+	static uint16_t samples[SCOPE_STREAM_MAX_SAMPLES];
+	long baud = 0;
+	long max_packets = 0;
+	long channel = 0;
+	int verbose = 0;
+	const char *output_path = NULL;
+	FILE *out = NULL;
+	decode_stats_t stats = {0};
+	scope_stream_header_t header;
+	uint32_t expected_sequence = 0;
+	uint32_t expected_position = 0;
+	uint32_t sample_rate = 0;
+	uint32_t factor = 1;
+	uint32_t channels = 1;
+	size_t fill = 0;
+	uint64_t t0, elapsed;
+	int fd;
+	int opt;
+
+	while((opt = getopt(argc, argv, "b:o:c:n:vh")) != -1){
+		switch(opt){
+			case 'b': baud = atol(optarg); break;
+			case 'o': output_path = optarg; break;
+			case 'c': channel = atol(optarg); break;
+			case 'n': max_packets = atol(optarg); break;
+			case 'v': verbose = 1; break;
+			default:
+				usage(argv[0]);
+				return 2;
+		}
+	}
+	if(optind != argc - 1 || max_packets < 0 || channel < 0 ||
+	   channel >= (long)SCOPE_STREAM_CHANNELS(SCOPE_STREAM_FLAG_CHANNELS_MASK)){
+		usage(argv[0]);
+		return 2;
+	}
+
+	fd = baud ? open_serial(argv[optind], baud) : open(argv[optind], O_RDONLY);
+	if(fd < 0){
+		if(!baud){
+			perror(argv[optind]);
+		}
+		return 2;
+	}
+	if(output_path != NULL){
+		out = fopen(output_path, "w");
+		if(out == NULL){
+			perror(output_path);
+			return 2;
+		}
+	}
+
+	t0 = now_ns();
+	for(;;){
+		ssize_t got;
+		size_t at = 0;
+		uint32_t seq_gap, pos_gap;
+
+		got = read(fd, &buffer[fill], READ_CHUNK);
+		if(got <= 0){
+			break;
+		}
+		fill += (size_t)got;
+		stats.bytes += (uint64_t)got;
+
+		// Decode every complete packet in the buffer, resyncing byte by byte
+		while(at < fill){
+			int32_t result = scope_stream_decode(&buffer[at], (uint32_t)(fill - at), &header, samples);
+
+			if(result == SCOPE_STREAM_NEED_MORE){
+				break;
+			}
+			if(result < 0){
+				if(result == SCOPE_STREAM_BAD_CRC){
+					stats.crc_errors++;
+				}
+				else if(result == SCOPE_STREAM_BAD_HEADER){
+					stats.header_errors++;
+				}
+				if(verbose && result != SCOPE_STREAM_BAD_SYNC){
+					printf("byte %llu: %s\n", (unsigned long long)(stats.bytes - (fill - at)),
+					       result == SCOPE_STREAM_BAD_CRC ? "CRC error" : "bad header");
+				}
+				stats.skipped_bytes++;
+				at++;
+				continue;
+			}
+
+			seq_gap = stats.packets ? (uint16_t)(header.sequence - expected_sequence) : 0;
+			expected_sequence = (uint16_t)(header.sequence + 1u);
+			stats.lost_packets += seq_gap;
+			pos_gap = 0;
+			if(header.flags & SCOPE_STREAM_FLAG_SPECTRUM){
+				write_spectrum(out, &header, samples);
+				stats.spectra++;
+			}
+			else if(header.flags & (SCOPE_STREAM_FLAG_TRIGGERED | SCOPE_STREAM_FLAG_FORCED)){
+				stats.windows++;
+				sample_rate = header.sample_rate_hz;
+				factor = header.factor ? header.factor : 1;
+				write_samples(out, &header, samples, 0);
+			}
+			else{
+				uint32_t block = header.count / SCOPE_STREAM_CHANNELS(header.flags);
+
+				pos_gap = stats.samples ? header.position - expected_position : 0;
+				expected_position = header.position + block;
+				stats.lost_samples += pos_gap;
+				stats.samples += block;
+				channels = SCOPE_STREAM_CHANNELS(header.flags);
+				sample_rate = header.sample_rate_hz;
+				factor = header.factor ? header.factor : 1;
+				write_samples(out, &header, samples, (uint32_t)channel);
+			}
+			if(verbose && (seq_gap || pos_gap)){
+				printf("packet %u: %u packets and %u samples lost\n",
+				       (unsigned int)header.sequence, (unsigned int)seq_gap, (unsigned int)pos_gap);
+			}
+			stats.packets++;
+			at += (size_t)result;
+			if(max_packets && stats.packets >= (uint64_t)max_packets){
+				break;
+			}
+		}
+		memmove(buffer, &buffer[at], fill - at);
+		fill -= at;
+		if(max_packets && stats.packets >= (uint64_t)max_packets){
+			break;
+		}
+	}
+	elapsed = now_ns() - t0;
+	close(fd);
+	if(out != NULL){
+		fclose(out);
+	}
+
+	printf("bytes:      %llu (%llu skipped)\n", (unsigned long long)stats.bytes,
+	       (unsigned long long)stats.skipped_bytes);
+	printf("packets:    %llu (%llu CRC errors, %llu bad headers, %llu lost)\n",
+	       (unsigned long long)stats.packets, (unsigned long long)stats.crc_errors,
+	       (unsigned long long)stats.header_errors, (unsigned long long)stats.lost_packets);
+	printf("samples:    %llu (%llu lost)\n", (unsigned long long)stats.samples,
+	       (unsigned long long)stats.lost_samples);
+	if(stats.spectra){
+		printf("spectra:    %llu\n", (unsigned long long)stats.spectra);
+	}
+	if(stats.windows){
+		printf("windows:    %llu packets\n", (unsigned long long)stats.windows);
+	}
+	if(sample_rate != 0){
+		printf("stream:     %u samples/s (ADC %u samples/s / %u) on %u channel%s\n",
+		       (unsigned int)(sample_rate / factor), (unsigned int)sample_rate, (unsigned int)factor,
+		       (unsigned int)channels, channels == 1 ? "" : "s");
+	}
+	if(baud){
+		printf("received:   %.0f samples/s\n", (double)stats.samples * 1e9 / (double)(elapsed ? elapsed : 1));
+	}
+	return (stats.crc_errors || stats.header_errors) ? 1 : 0;
+}
@@ -0,0 +1,534 @@
+/***********************************************************
+Title: Trigger check for the oscilloscope.
+Description: Runs scope_trigger.c over a test signal (rails,
+				noise with bit 15 set now and then, a sine,
+				pulse trains of every width from 1 to 24 in
+				both polarities and a ramp) for every trigger
+				type, slope and mode, thresholds from 0 to
+				0x7FFF with and without hysteresis, several
+				pre/post splits, PULSE width limits and AUTO
+				timeouts. Every configuration is compared with
+				a plain model that tests one sample at a time:
+				the signal is fed in frames of several sizes,
+				at every alignment of the first frame to the
+				four-sample blocks of the packed search, and
+				each window must match the model's in trigger
+				position, trigger index, length, forced flag
+				and contents, including windows that wrap
+				around the history. A few hand-made cases also
+				check the model against known positions (step
+				edge, pre-trigger gate, AUTO deadline, pulse
+				width limits, wrapped window, thresholds at 0
+				and 0x7FFF). Exits with 1 on any mismatch.
+Usage:
+				trigger_check [-v]
+				-v          print every case
+************************************************************/
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <math.h>
+#include <unistd.h>
+
+#include "scope_trigger.h"
+
+#define SIGNAL_LENGTH   6000u
+#define MAX_WINDOWS     (SIGNAL_LENGTH + 1u)
+#define PI              3.14159265358979323846
+
+typedef struct {
+	uint32_t position;
+	uint8_t forced;
+} window_t;
+
+// Frame plans: size of the first frame (0 = a full frame), then full frames
+typedef struct {
+	uint32_t first;
+	uint32_t frame;
+} plan_t;
+
+static plan_t plans[64];
+static uint32_t num_plans;
+
+static uint16_t test_signal[SIGNAL_LENGTH];
+static scope_trigger_t trigger;
+static window_t expected[MAX_WINDOWS];
+static uint16_t window_samples[SCOPE_TRIGGER_HISTORY];
+
+static int verbose;
+static int failures;
+static int checks;
+static uint32_t runs;
+
+static const char *const type_names[] = { "edge", "level", "pulse" };
+static const char *const slope_names[] = { "rising", "falling" };
+static const char *const mode_names[] = { "single", "normal", "auto" };
+
+static void describe(char *text, size_t size, const scope_trigger_config_t *c){
+	snprintf(text, size, "%s %s %s level %u hyst %u pre %u post %u pulse %u..%u auto %u",
+	         type_names[c->type], slope_names[c->slope], mode_names[c->mode], c->level, c->hysteresis,
+	         c->pre, c->post, c->pulse_min, c->pulse_max, c->auto_timeout);
+}
+
+//-------------------------------------------------------------------------------------------
+// Model: the trigger condition as plain compares, fed one sample at a time
+//-------------------------------------------------------------------------------------------
+enum { MODEL_ARM, MODEL_FIRE, MODEL_PULSE_END };
+
+static uint8_t beyond_band(const scope_trigger_config_t *c, int32_t v){
+	return (c->slope == SCOPE_TRIGGER_RISING) ? v < (int32_t)c->level - (int32_t)c->hysteresis :
+	                                            v >= (int32_t)c->level + (int32_t)c->hysteresis;
+}
+
+static uint8_t at_level(const scope_trigger_config_t *c, int32_t v){
+	return (c->slope == SCOPE_TRIGGER_RISING) ? v >= (int32_t)c->level : v < (int32_t)c->level;
+}
+
+// Windows the trigger must produce when every window is read as soon as it
+// is ready and a SINGLE trigger is armed again right after the read
+static uint32_t model_run(const scope_trigger_config_t *c, const uint16_t *x, uint32_t length, window_t *out){
+	const uint64_t deadline = (uint64_t)c->pre + c->auto_timeout;
+	uint32_t windows = 0;
+	uint32_t pos = 0;
+	uint32_t since_arm = 0;
+	uint32_t pulse_start = 0;
+	uint32_t post_left = 0;
+	uint32_t trigger_pos = 0;
+	uint8_t forced = 0;
+	uint8_t phase = (c->type == SCOPE_TRIGGER_LEVEL) ? MODEL_FIRE : MODEL_ARM;
+	enum { ARMED, TRIGGERED, READY } state = ARMED;
+
+	for(;;){
+		if(state == READY){
+			out[windows].position = trigger_pos;
+			out[windows].forced = forced;
+			windows++;
+			phase = (c->type == SCOPE_TRIGGER_LEVEL) ? MODEL_FIRE : MODEL_ARM;
+			since_arm = 0;
+			state = ARMED;
+		}
+		if(pos == length){
+			break;
+		}
+		if(state == TRIGGERED){
+			pos++;
+			since_arm++;
+			if(--post_left == 0){
+				state = READY;
+			}
+			continue;
+		}
+
+		// Armed: the AUTO deadline comes before the sample is looked at
+		int32_t v = x[pos] & 0x7FFF;
+		uint8_t fire = 0;
+
+		forced = 0;
+		if(c->mode == SCOPE_TRIGGER_AUTO && since_arm >= deadline){
+			fire = 1;
+			forced = 1;
+		}
+		else if(phase == MODEL_ARM){
+			if(beyond_band(c, v)){
+				phase = MODEL_FIRE;
+			}
+		}
+		else if(phase == MODEL_FIRE){
+			if(at_level(c, v)){
+				if(c->type == SCOPE_TRIGGER_PULSE){
+					pulse_start = pos;
+					phase = MODEL_PULSE_END;
+				}
+				else{
+					phase = (c->type == SCOPE_TRIGGER_EDGE) ? MODEL_ARM : MODEL_FIRE;
+					fire = since_arm >= c->pre;
+				}
+			}
+		}
+		else if(beyond_band(c, v)){
+			uint32_t width = pos - pulse_start;
+
+			phase = MODEL_FIRE;
+			fire = width >= c->pulse_min && width <= c->pulse_max && since_arm >= c->pre;
+		}
+
+		if(fire){
+			// The trigger sample is the first of the post-trigger samples
+			trigger_pos = pos;
+			post_left = c->post;
+			state = (post_left != 0) ? TRIGGERED : READY;
+			continue;
+		}
+		pos++;
+		since_arm++;
+	}
+	return windows;
+}
+
+//-------------------------------------------------------------------------------------------
+// Trigger under test
+//-------------------------------------------------------------------------------------------
+static void check(int ok, const char *name, const scope_trigger_config_t *c, const plan_t *plan, const char *what,
+                  uint32_t index){
+	char text[160];
+
+	checks++;
+	if(ok){
+		return;
+	}
+	failures++;
+	describe(text, sizeof(text), c);
+	printf("FAIL %s: %s, frames %u then %u: window %u: %s\n", name, text, plan->first, plan->frame, index, what);
+}
+
+// Reads the ready window and checks it against the model's; returns 0 on a mismatch
+static int read_window(const char *name, const scope_trigger_config_t *c, const plan_t *plan, const uint16_t *x,
+                       const window_t *want, uint32_t num_want, uint32_t *windows){
+	scope_trigger_window_t w;
+	const uint32_t index = *windows;
+	int ok;
+
+	ok = scope_trigger_read(&trigger, window_samples, &w) == 0;
+	check(ok, name, c, plan, "not readable", index);
+	if(!ok){
+		return 0;
+	}
+	(*windows)++;
+	check(ok = index < num_want, name, c, plan, "more windows than the model", index);
+	if(!ok){
+		return 0;
+	}
+	check(ok = w.position == want[index].position, name, c, plan, "trigger position", index);
+	if(ok){
+		check(ok = w.forced == want[index].forced, name, c, plan, "forced flag", index);
+	}
+	if(ok){
+		check(ok = w.trigger_index == c->pre && w.count == c->pre + c->post, name, c, plan,
+		      "trigger index or length", index);
+	}
+	if(ok){
+		check(ok = memcmp(window_samples, &x[w.position - c->pre], w.count * sizeof(uint16_t)) == 0,
+		      name, c, plan, "window contents", index);
+	}
+	if(ok && c->mode == SCOPE_TRIGGER_SINGLE){
+		check(ok = scope_trigger_state(&trigger) == SCOPE_TRIGGER_STOPPED, name, c, plan,
+		      "single trigger not stopped after the read", index);
+		scope_trigger_arm(&trigger);
+	}
+	return ok;
+}
+
+static void device_run(const char *name, const scope_trigger_config_t *c, const plan_t *plan, const uint16_t *x,
+                       uint32_t length, const window_t *want, uint32_t num_want){
+	uint32_t done = 0;
+	uint32_t chunk = (plan->first != 0) ? plan->first : plan->frame;
+	uint32_t windows = 0;
+
+	runs++;
+	if(scope_trigger_init(&trigger, c) != 0){
+		check(0, name, c, plan, "configuration refused", 0);
+		return;
+	}
+	scope_trigger_arm(&trigger);
+	while(done < length){
+		uint32_t n = (chunk < length - done) ? chunk : length - done;
+		uint32_t used = 0;
+
+		while(used < n){
+			uint32_t fed = scope_trigger_feed(&trigger, &x[done + used], n - used);
+
+			used += fed;
+			if(scope_trigger_state(&trigger) == SCOPE_TRIGGER_READY){
+				if(!read_window(name, c, plan, x, want, num_want, &windows)){
+					return;
+				}
+			}
+			else if(used < n){
+				check(0, name, c, plan, "samples refused without a ready window", windows);
+				return;
+			}
+		}
+		done += n;
+		chunk = plan->frame;
+	}
+	check(windows == num_want, name, c, plan, "fewer windows than the model", windows);
+}
+
+// The model's windows, checked against 'known' if given, then the trigger
+// against the model for every frame plan
+static void run_case(const char *name, const scope_trigger_config_t *c, const uint16_t *x, uint32_t length,
+                     const window_t *known, uint32_t num_known){
+	static const plan_t whole = { 0, 0 };
+	uint32_t num = model_run(c, x, length, expected);
+	char text[160];
+
+	if(verbose){
+		describe(text, sizeof(text), c);
+		printf("%-28s %s: %u windows\n", name, text, num);
+	}
+	if(known != NULL){
+		int ok = num == num_known;
+
+		for(uint32_t i = 0; ok && i < num; i++){
+			ok = expected[i].position == known[i].position && expected[i].forced == known[i].forced;
+		}
+		check(ok, name, c, &whole, "model differs from the known windows", num);
+	}
+	for(uint32_t p = 0; p < num_plans; p++){
+		device_run(name, c, &plans[p], x, length, expected, num);
+	}
+}
+
+//-------------------------------------------------------------------------------------------
+// Signals and cases
+//-------------------------------------------------------------------------------------------
+static uint32_t random_state = 12345u;
+
+static uint32_t random_next(void){
+	random_state = random_state * 1664525u + 1013904223u;
+	return random_state >> 8;
+}
+
+// Rails, noise (bit 15 set now and then), sine, pulse trains, ramp
+static void make_signal(uint16_t *x){
+	uint32_t i;
+	uint32_t width = 1;
+	uint32_t left = 0;
+	uint8_t high = 0;
+
+	for(i = 0; i < 500; i++){
+		x[i] = 0;
+	}
+	for(; i < 1000; i++){
+		x[i] = 0x7FFF;
+	}
+	for(; i < 2000; i++){
+		x[i] = (uint16_t)(random_next() & 0x7FFF);
+		if((random_next() & 15u) == 0){
+			x[i] |= 0x8000;
+		}
+	}
+	for(; i < 3000; i++){
+		x[i] = (uint16_t)lrint(16384.0 + 12000.0 * sin(2.0 * PI * i / 97.0));
+	}
+	// Pulses of width 1, 2, ... 24 with a gap of 13 samples, positive then negative
+	for(; i < 5000; i++){
+		if(left == 0){
+			high = !high;
+			left = high ? width : 13;
+			if(high && ++width > 24){
+				width = 1;
+			}
+		}
+		left--;
+		x[i] = (i < 4000) ? (high ? 20000 : 1000) : (high ? 1000 : 20000);
+	}
+	for(; i < SIGNAL_LENGTH; i++){
+		uint32_t t = i % 400;
+
+		x[i] = (uint16_t)((t < 200 ? t : 400 - t) * 163);
+	}
+}
+
+static void make_plans(void){
+	static const uint32_t aligned_frames[] = { 5, 64 };
+	static const uint32_t frames[] = { 1, 4, 1024, SIGNAL_LENGTH };
+
+	for(size_t f = 0; f < sizeof(aligned_frames) / sizeof(aligned_frames[0]); f++){
+		for(uint32_t first = 0; first < 8; first++){
+			plans[num_plans].first = first;
+			plans[num_plans].frame = aligned_frames[f];
+			num_plans++;
+		}
+	}
+	for(size_t f = 0; f < sizeof(frames) / sizeof(frames[0]); f++){
+		plans[num_plans].first = 0;
+		plans[num_plans].frame = frames[f];
+		num_plans++;
+	}
+}
+
+static scope_trigger_config_t config(scope_trigger_type_t type, scope_trigger_slope_t slope, scope_trigger_mode_t mode,
+                                     uint16_t level, uint16_t hysteresis, uint32_t pre, uint32_t post){
+	scope_trigger_config_t c;
+
+	memset(&c, 0, sizeof(c));
+	c.type = type;
+	c.slope = slope;
+	c.mode = mode;
+	c.level = level;
+	c.hysteresis = hysteresis;
+	c.pulse_min = 0;
+	c.pulse_max = UINT32_MAX;
+	c.pre = pre;
+	c.post = post;
+	c.auto_timeout = 500;
+	return c;
+}
+
+// Cases with windows worked out by hand
+static void known_cases(void){
+	static const window_t none[1];
+	static uint16_t x[SIGNAL_LENGTH];
+	scope_trigger_config_t c;
+	uint32_t i;
+
+	// Rising edge on a step at 1000
+	for(i = 0; i < 2000; i++){
+		x[i] = (i < 1000) ? 100 : 3000;
+	}
+	{
+		static const window_t want[] = { { 1000, 0 } };
+		c = config(SCOPE_TRIGGER_EDGE, SCOPE_TRIGGER_RISING, SCOPE_TRIGGER_NORMAL, 1000, 50, 100, 50);
+		run_case("step edge", &c, x, 2000, want, 1);
+	}
+
+	// Pre-trigger gate: a step at 50 comes before the 100 pre-trigger samples.
+	// The edge is passed over; a level fires once they are in and again after
+	// every window (post 10).
+	for(i = 0; i < 400; i++){
+		x[i] = (i < 50) ? 100 : 3000;
+	}
+	{
+		static const window_t want[] = { { 100, 0 }, { 210, 0 }, { 320, 0 } };
+		c = config(SCOPE_TRIGGER_EDGE, SCOPE_TRIGGER_RISING, SCOPE_TRIGGER_NORMAL, 1000, 50, 100, 10);
+		run_case("pre gate, edge", &c, x, 400, none, 0);
+		c.type = SCOPE_TRIGGER_LEVEL;
+		c.mode = SCOPE_TRIGGER_SINGLE;
+		run_case("pre gate, level", &c, x, 400, want, 3);
+	}
+
+	// AUTO deadline: no trigger, a forced window pre + auto_timeout samples
+	// after every arming
+	for(i = 0; i < 1600; i++){
+		x[i] = (uint16_t)(500 + i % 7);
+	}
+	{
+		static const window_t want[] = { { 510, 1 }, { 1040, 1 }, { 1570, 1 } };
+		c = config(SCOPE_TRIGGER_EDGE, SCOPE_TRIGGER_RISING, SCOPE_TRIGGER_AUTO, 1000, 50, 10, 20);
+		run_case("auto deadline", &c, x, 1600, want, 3);
+	}
+
+	// Pulse widths 5, 10, 20, 12 and 13 against limits 8..12
+	for(i = 0; i < 600; i++){
+		x[i] = ((i >= 100 && i < 105) || (i >= 200 && i < 210) || (i >= 300 && i < 320) ||
+		        (i >= 400 && i < 412) || (i >= 500 && i < 513)) ? 1000 : 0;
+	}
+	{
+		static const window_t want[] = { { 210, 0 }, { 412, 0 } };
+		c = config(SCOPE_TRIGGER_PULSE, SCOPE_TRIGGER_RISING, SCOPE_TRIGGER_NORMAL, 500, 0, 50, 10);
+		c.pulse_min = 8;
+		c.pulse_max = 12;
+		run_case("pulse width limits", &c, x, 600, want, 2);
+	}
+
+	// Window of 4000 samples from 2000, wrapping around the 4096-sample history
+	for(i = 0; i < SIGNAL_LENGTH; i++){
+		x[i] = (uint16_t)((i < 5000) ? i % 1000 : 3000 + i % 100);
+	}
+	{
+		static const window_t want[] = { { 5000, 0 } };
+		c = config(SCOPE_TRIGGER_LEVEL, SCOPE_TRIGGER_RISING, SCOPE_TRIGGER_SINGLE, 2000, 0, 3000, 1000);
+		run_case("wrapped window", &c, x, SIGNAL_LENGTH, want, 1);
+	}
+
+	// Thresholds at the ends of the code range; bit 15 is not part of a code
+	for(i = 0; i < 10; i++){
+		x[i] = (uint16_t)(i * 1000);
+	}
+	{
+		static const window_t every[] = {
+			{ 0, 0 }, { 1, 0 }, { 2, 0 }, { 3, 0 }, { 4, 0 }, { 5, 0 }, { 6, 0 }, { 7, 0 }, { 8, 0 }, { 9, 0 }
+		};
+		c = config(SCOPE_TRIGGER_LEVEL, SCOPE_TRIGGER_RISING, SCOPE_TRIGGER_NORMAL, 0, 0, 0, 1);
+		run_case("level 0 rising", &c, x, 10, every, 10);
+		c.slope = SCOPE_TRIGGER_FALLING;
+		run_case("level 0 falling", &c, x, 10, none, 0);
+		c.type = SCOPE_TRIGGER_EDGE;
+		c.slope = SCOPE_TRIGGER_RISING;
+		run_case("edge at 0", &c, x, 10, none, 0);
+	}
+	x[0] = 0x7FFE;
+	x[1] = 0x7FFF;
+	x[2] = 0xFFFF;
+	x[3] = 0x8000;
+	x[4] = 5;
+	{
+		static const window_t want[] = { { 1, 0 }, { 2, 0 } };
+		c = config(SCOPE_TRIGGER_LEVEL, SCOPE_TRIGGER_RISING, SCOPE_TRIGGER_NORMAL, 0x7FFF, 0, 0, 1);
+		run_case("level 0x7fff", &c, x, 5, want, 2);
+	}
+}
+
+// Every type, slope and mode over the test signal
+static void signal_cases(void){
+	static const struct {
+		uint16_t level;
+		uint16_t hysteresis;
+	} thresholds[] = {
+		{ 0, 0 }, { 0, 50 }, { 1, 0 }, { 0x4000, 0 }, { 0x4000, 300 }, { 10000, 20000 },
+		{ 30000, 5000 }, { 0x7FFF, 0 }, { 0x7FFF, 10 },
+	};
+	static const struct {
+		uint32_t pre;
+		uint32_t post;
+	} splits[] = { { 0, 1 }, { 1, 0 }, { 100, 200 }, { 3000, 1096 } };
+	static const struct {
+		uint32_t min;
+		uint32_t max;
+	} widths[] = { { 0, UINT32_MAX }, { 8, 12 }, { 5, 5 } };
+	static const uint32_t timeouts[] = { 0, 700 };
+
+	make_signal(test_signal);
+	for(int type = SCOPE_TRIGGER_EDGE; type <= SCOPE_TRIGGER_PULSE; type++){
+		for(int slope = SCOPE_TRIGGER_RISING; slope <= SCOPE_TRIGGER_FALLING; slope++){
+			for(int mode = SCOPE_TRIGGER_SINGLE; mode <= SCOPE_TRIGGER_AUTO; mode++){
+				for(size_t t = 0; t < sizeof(thresholds) / sizeof(thresholds[0]); t++){
+					for(size_t s = 0; s < sizeof(splits) / sizeof(splits[0]); s++){
+						size_t num_widths = (type == SCOPE_TRIGGER_PULSE) ? sizeof(widths) / sizeof(widths[0]) : 1;
+						size_t num_timeouts = (mode == SCOPE_TRIGGER_AUTO) ? sizeof(timeouts) / sizeof(timeouts[0]) : 1;
+
+						for(size_t w = 0; w < num_widths; w++){
+							for(size_t a = 0; a < num_timeouts; a++){
+								scope_trigger_config_t c = config((scope_trigger_type_t)type,
+								                                  (scope_trigger_slope_t)slope,
+								                                  (scope_trigger_mode_t)mode, thresholds[t].level,
+								                                  thresholds[t].hysteresis, splits[s].pre,
+								                                  splits[s].post);
+
+								c.pulse_min = widths[w].min;
+								c.pulse_max = widths[w].max;
+								c.auto_timeout = timeouts[a];
+								run_case("signal", &c, test_signal, SIGNAL_LENGTH, NULL, 0);
+							}
+						}
+					}
+				}
+			}
+		}
+	}
+}
+
+int main(int argc, char *argv[]){
+	int opt;
+
+	while((opt = getopt(argc, argv, "vh")) != -1){
+		switch(opt){
+			case 'v': verbose = 1; break;
+			default:
+				fprintf(stderr, "usage: %s [-v]\n", argv[0]);
+				return 2;
+		}
+	}
+
+	make_plans();
+	known_cases();
+	signal_cases();
+
+	printf("%u runs, %d of %d checks passed\n", runs, checks - failures, checks);
+	return failures != 0;
+}